@@ -63,6 +63,25 @@ __CRT_ALIAS __JMPSTUB__(( FUNCTION = seekdir ))
 void __cdecl __MINGW_NOTHROW seekdir (DIR *__dir, long __loc)
 { return __mingw_seekdir (__dir, __loc); }
 
+/* POSIX.1-2008 scandir(), and its alphasort() comparison function;
+ * note that the entries returned by scandir() are allocated with only
+ * sufficient space to accommodate their names, (as d_reclen indicates),
+ * rather than the full FILENAME_MAX characters of d_name.
+ */
+int __cdecl __MINGW_NOTHROW __mingw_scandir (const char *, struct dirent ***,
+  int (*)(const struct dirent *), int (*)(const struct dirent **, const struct dirent **));
+int __cdecl __MINGW_NOTHROW __mingw_alphasort (const struct dirent **, const struct dirent **);
+
+__CRT_ALIAS __JMPSTUB__(( FUNCTION = scandir ))
+int __cdecl __MINGW_NOTHROW scandir (const char *__dirname, struct dirent ***__namelist,
+  int (*__filter)(const struct dirent *),
+  int (*__compare)(const struct dirent **, const struct dirent **))
+{ return __mingw_scandir (__dirname, __namelist, __filter, __compare); }
+
+__CRT_ALIAS __JMPSTUB__(( FUNCTION = alphasort ))
+int __cdecl __MINGW_NOTHROW alphasort (const struct dirent **__a, const struct dirent **__b)
+{ return __mingw_alphasort (__a, __b); }
+
 
 /* wide char versions */
 
@@ -111,6 +130,20 @@ __CRT_ALIAS __JMPSTUB__(( FUNCTION = _wseekdir ))
 void __cdecl __MINGW_NOTHROW _wseekdir (_WDIR *__dir, long __loc)
 { return __mingw__wseekdir (__dir, __loc); }
 
+int __cdecl __MINGW_NOTHROW __mingw__wscandir (const wchar_t *, struct _wdirent ***,
+  int (*)(const struct _wdirent *), int (*)(const struct _wdirent **, const struct _wdirent **));
+int __cdecl __MINGW_NOTHROW __mingw__walphasort (const struct _wdirent **, const struct _wdirent **);
+
+__CRT_ALIAS __JMPSTUB__(( FUNCTION = _wscandir ))
+int __cdecl __MINGW_NOTHROW _wscandir (const wchar_t *__dirname, struct _wdirent ***__namelist,
+  int (*__filter)(const struct _wdirent *),
+  int (*__compare)(const struct _wdirent **, const struct _wdirent **))
+{ return __mingw__wscandir (__dirname, __namelist, __filter, __compare); }
+
+__CRT_ALIAS __JMPSTUB__(( FUNCTION = _walphasort ))
+int __cdecl __MINGW_NOTHROW _walphasort (const struct _wdirent **__a, const struct _wdirent **__b)
+{ return __mingw__walphasort (__a, __b); }
+
 _END_C_DECLS
 
 #if defined(_BSD_SOURCE) || defined(_WIN32)
@@ -0,0 +1,75 @@
+#ifndef _FNMATCH_H
+/*
+ * fnmatch.h
+ *
+ * Header file supporting a MinGW implementation of the POSIX fnmatch()
+ * file name, (or path name), pattern matching function.
+ *
+ * $Id$
+ *
+ * Copyright (C) 2026, MinGW.org Project.
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR THE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OF OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+#define _FNMATCH_H  1
+#pragma GCC system_header
+
+/* All MinGW.org system headers are required to include <_mingw.h>.
+ */
+#include <_mingw.h>
+
+#ifndef RC_INVOKED
+
+/* Flags which may be combined, by bitwise OR, to control the operation
+ * of fnmatch(); the first three are specified by POSIX.
+ */
+#define FNM_PATHNAME	(1 << 0)  /* wild cards never match a separator   */
+#define FNM_NOESCAPE	(1 << 1)  /* backslash is not an escape character  */
+#define FNM_PERIOD	(1 << 2)  /* leading period must be matched exactly */
+
+#if defined _GNU_SOURCE || defined _BSD_SOURCE || ! defined __STRICT_ANSI__
+/* GNU extensions; of these, FNM_CASEFOLD is particularly useful, when
+ * matching names within the case-insensitive MS-Windows file system.
+ */
+#define FNM_FILE_NAME	FNM_PATHNAME
+#define FNM_LEADING_DIR (1 << 3)  /* also match any leading directory	   */
+#define FNM_CASEFOLD	(1 << 4)  /* perform case insensitive matching	   */
+
+#endif	/* _GNU_SOURCE || _BSD_SOURCE || !__STRICT_ANSI__ */
+
+/* The value returned by fnmatch(), when the string does not match.
+ */
+#define FNM_NOMATCH	(1)
+
+_BEGIN_C_DECLS
+
+/* Note that, when FNM_PATHNAME is specified, either '/' or '\' will be
+ * recognized as a directory separator, within the string to be matched;
+ * however, unless FNM_NOESCAPE is also specified, '\' in the pattern is
+ * interpreted as an escape, and will thus not match a separator.
+ */
+int fnmatch (const char *, const char *, int);
+
+_END_C_DECLS
+
+#endif /* ! RC_INVOKED */
+#endif /* !_FNMATCH_H: $RCSfile$: end of file */
@@ -8,7 +8,7 @@
  * $Id$
  *
  * Written by Colin Peters <colin@bird.fu.is.saga-u.ac.jp>
- * Copyright (C) 1997-1999, 2001-2005, 2007, 2018, MinGW.org Project.
+ * Copyright (C) 1997-1999, 2001-2005, 2007, 2018, 2026, MinGW.org Project.
  *
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
@@ -208,6 +208,93 @@ __CRT_ALIAS __LIBIMPL__(( FUNCTION = mingw_aligned_realloc ))
 void *__mingw_aligned_realloc( void *__ptr, size_t __want, size_t __aligned )
 { return __mingw_aligned_offset_realloc( __ptr, __want, __aligned, (size_t)(0) ); }
 
+/* Heap instrumentation, as provided in libmingwex.a; in common with GNU's
+ * function of the same name, malloc_usable_size() returns the number of
+ * bytes which may be stored in any heap block, (which may exceed the size
+ * originally requested).  Unlike _msize(), it may be applied to any block
+ * allocated by any MinGW.org heap allocator, including the aligned heap
+ * allocators, and the thread caching allocator.
+ */
+__cdecl __MINGW_NOTHROW  size_t malloc_usable_size (void *);
+
+struct mallinfo2
+{ /* Structure returned by mallinfo2(); its fields follow GNU's layout,
+   * but their interpretation is adapted to the MinGW.org heap, which is
+   * the MSVCRT.DLL heap, supplemented by the thread caching allocator's
+   * arena, (which is represented as a single directly mapped region).
+   */
+  size_t	 arena; 	/* bytes in MSVCRT.DLL heap entries	    */
+  size_t	 ordblks;	/* number of free MSVCRT.DLL heap entries   */
+  size_t	 smblks;	/* number of free small blocks, in arena    */
+  size_t	 hblks; 	/* number of mapped regions, (0 or 1)	    */
+  size_t	 hblkhd;	/* bytes committed in mapped regions	    */
+  size_t	 usmblks;	/* always zero, (as in GNU's implementation) */
+  size_t	 fsmblks;	/* bytes in free small blocks, in arena     */
+  size_t	 uordblks;	/* total bytes in allocated blocks	    */
+  size_t	 fordblks;	/* total bytes in free blocks		    */
+  size_t	 keepcost;	/* always zero				    */
+};
+
+/* mallinfo2() walks the entire MSVCRT.DLL heap; it is intended for
+ * diagnostic use, and should not be called in performance critical code.
+ */
+__cdecl __MINGW_NOTHROW  struct mallinfo2 mallinfo2 (void);
+
+/* Optional per-thread allocation counters; when enabled, these record
+ * the number of blocks allocated, and released, by each thread, through
+ * any of the MinGW.org heap allocation functions, (including malloc(),
+ * and calloc(), only when they are redirected to __mingw_malloc(), and
+ * __mingw_calloc(), by the __USE_MINGW_MALLOC feature test), together
+ * with the number of bytes in use, its peak value, and a histogram of
+ * the (usable) sizes of allocated blocks.  Each thread updates only its
+ * own counters, without any lock, or interlocked operation.
+ */
+#define __MINGW_HEAP_STATS_BINS 	20
+
+struct __mingw_heap_stats
+{ /* Aggregated counters, as returned by __mingw_heap_stats(); "bytes"
+   * and "peak" are net of releases, (which may be performed by threads
+   * other than those which allocated the blocks); thus, "peak" is the
+   * sum of the individual peaks, for each thread, and may overstate the
+   * true peak usage, for the process as a whole.  Element "n" of the
+   * histogram counts blocks of no more than (16 << n) bytes, (but not
+   * fewer than (8 << n) bytes, for n > 0), except that the final element
+   * counts all larger blocks.
+   *
+   * Note that releases cannot be attributed to the allocator which
+   * produced each block; thus, every block which is passed to free(),
+   * realloc(), or __mingw_free(), (or their redirected equivalents),
+   * while counting is enabled, is counted as released, even if it was
+   * allocated by an uncounted function, (e.g. by malloc(), or calloc(),
+   * when __USE_MINGW_MALLOC is not in effect), or before counting was
+   * enabled.  In such cases, "releases" may exceed "allocations", and
+   * "bytes" may wrap below zero; the counters are exact only when every
+   * block is allocated, and released, through the counted functions,
+   * while counting is enabled.
+   */
+  size_t	 allocations;
+  size_t	 releases;
+  size_t	 bytes;
+  size_t	 peak;
+  size_t	 histogram[__MINGW_HEAP_STATS_BINS];
+};
+
+/* Flags, which may be combined, to be passed to __mingw_heap_stats_enable();
+ * it returns the flags which were previously in effect.  Counting may be
+ * suspended, (but counts already recorded are retained), by passing zero.
+ */
+#define __MINGW_HEAP_STATS_ENABLE	1
+#define __MINGW_HEAP_STATS_AT_EXIT	2
+
+__cdecl __MINGW_NOTHROW  unsigned int __mingw_heap_stats_enable (unsigned int);
+__cdecl __MINGW_NOTHROW  void __mingw_heap_stats (struct __mingw_heap_stats *);
+
+/* Write a report of the counters, for each thread, and in aggregate, to
+ * stderr; (this is also called at exit, if __MINGW_HEAP_STATS_AT_EXIT is
+ * in effect).
+ */
+__cdecl __MINGW_NOTHROW  void __mingw_heap_stats_dump (void);
+
 _END_C_DECLS
 
 #endif	/* ! RC_INVOKED */
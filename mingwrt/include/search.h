@@ -6,7 +6,7 @@
  * $Id$
  *
  * Written by Danny Smith <dannysmith@users.sourceforge.net>
- * Copyright (C) 2003, 2004, 2007, 2016, 2018, MinGW.org Project.
+ * Copyright (C) 2003, 2004, 2007, 2016, 2018, 2026, MinGW.org Project.
  *
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
@@ -102,8 +102,24 @@ typedef
 struct node
 { const void	*key;
   struct node 	*llink, *rlink;
+  int		 height;
 } node_t;
 
+/* The trees maintained by tsearch() and tdelete() are AVL balanced;
+ * each node records the height of the subtree of which it is the root,
+ * and this private helper restores the balance of such a subtree, after
+ * insertion or deletion of any node within it.  It returns non-zero if
+ * the height of the subtree has changed, as a result of the operation.
+ */
+__cdecl int __mingw_tbalance (node_t **);
+
+/* Neither tsearch() nor tdelete() uses recursion, to traverse a tree;
+ * rather, they record each link which they follow, in a local array of
+ * this size, which must be at least the maximum height of any possible
+ * AVL tree, (i.e. 1.44 times the number of bits in a pointer).
+ */
+#define __MINGW_TSEARCH_MAXHEIGHT  (3 * 8 * sizeof (void *) / 2)
+
 /* Suppress non-null argument annotations, when building the tsearch(),
  * tfind(), tdelete(), and twalk() implementations, to ensure that GCC
  * does not optimize away internal argument validation checks.
@@ -129,6 +145,33 @@ __MINGW_ATTRIB_NONNULL(1) __MINGW_ATTRIB_NONNULL(2);
 __cdecl  void  insque (void *, void *);
 __cdecl  void  remque (void *);
 
+__cdecl  int    hcreate (size_t);
+__cdecl  void   hdestroy (void);
+__cdecl  ENTRY *hsearch (ENTRY, ACTION);
+
+#if defined _GNU_SOURCE || defined _BSD_SOURCE || ! defined __STRICT_ANSI__
+/* GNU extension: tdestroy() releases all nodes of a tree, after first
+ * passing the key associated with each, to a user specified function.
+ */
+__cdecl  void  tdestroy (void *, void (*)(void *))
+__MINGW_ATTRIB_NONNULL(2);
+
+/* GNU extension: reentrant counterparts of hcreate(), hsearch(), and
+ * hdestroy(), each operating on a hash table which is identified by a
+ * user supplied descriptor; this must be zero-initialized, before it
+ * is first passed to hcreate_r().
+ */
+struct hsearch_data
+{ struct __hsearch_entry	*table;
+  unsigned int			 size;
+  unsigned int			 filled;
+};
+
+__cdecl  int   hcreate_r (size_t, struct hsearch_data *);
+__cdecl  void  hdestroy_r (struct hsearch_data *);
+__cdecl  int   hsearch_r (ENTRY, ACTION, ENTRY **, struct hsearch_data *);
+#endif
+
 #endif	/* _POSIX_C_SOURCE */
 
 #if !defined _NO_OLDNAMES || defined _POSIX_C_SOURCE
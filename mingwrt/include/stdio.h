@@ -7,7 +7,7 @@
  * $Id$
  *
  * Written by Colin Peters <colin@bird.fu.is.saga-u.ac.jp>
- * Copyright (C) 1997-2005, 2007-2010, 2014-2019, MinGW.org Project.
+ * Copyright (C) 1997-2005, 2007-2010, 2014-2019, 2026, MinGW.org Project.
  *
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
@@ -348,6 +348,27 @@ extern int __mingw_stdio_redirect__(vprintf)(const char*, __VALIST);
 extern int __mingw_stdio_redirect__(vsprintf)(char*, const char*, __VALIST);
 extern int __mingw_stdio_redirect__(vsnprintf)(char*, size_t, const char*, __VALIST);
 
+/* Formatted Input
+ *
+ * As for formatted output, the MSVCRT implementations are not ANSI C99
+ * conformant, (e.g. they support neither the "hh", "j", "z", nor "t"
+ * length modifiers, nor any "%a" conversion); libmingwex.a provides
+ * conforming alternatives, (of which the ISO-C99 vfscanf(), vscanf(),
+ * and vsscanf() functions are aliases), with gnu_scanf -Wformat checking.
+ */
+#define __Wformat_mingw_scanf(F,A) __attribute__((__format__(__gnu_scanf__,F,A)))
+
+#define __Wformat_scanf 	__Wformat_mingw_scanf(1,2)
+#define __Wformat_fscanf	__Wformat_mingw_scanf(2,3)
+#define __Wformat_sscanf	__Wformat_mingw_scanf(2,3)
+#define __Wformat_vscanf	__Wformat_mingw_scanf(1,0)
+#define __Wformat_vfscanf	__Wformat_mingw_scanf(2,0)
+#define __Wformat_vsscanf	__Wformat_mingw_scanf(2,0)
+
+extern int __mingw_stdio_redirect__(vfscanf)(FILE*__restrict__, const char*__restrict__, __VALIST);
+extern int __mingw_stdio_redirect__(vscanf)(const char*__restrict__, __VALIST);
+extern int __mingw_stdio_redirect__(vsscanf)(const char*__restrict__, const char*__restrict__, __VALIST);
+
 /* When using these C99 conforming alternatives, we may wish to support
  * some of Microsoft's quirky formatting options, even when they violate
  * strict C99 conformance.
@@ -375,6 +396,49 @@ extern int __mingw_stdio_redirect__(vsnprintf)(char*, size_t, const char*, __VAL
  */
 extern unsigned int _mingw_output_format_control( unsigned int, unsigned int );
 
+/* Where any one format string is to be used repeatedly, the overhead of
+ * interpreting it afresh, on each use, may be avoided by compiling it,
+ * once only, to an opaque "plan", which may then be passed to either of
+ * the following plan consuming variants of vfprintf() or vsnprintf();
+ * __mingw_pformat_compile() returns NULL, if insufficient memory is
+ * available, and __mingw_pformat_release() discards the plan, when it
+ * is no longer required.
+ */
+typedef struct __mingw_pformat_plan __mingw_pformat_plan_t;
+
+extern __cdecl __MINGW_NOTHROW
+__mingw_pformat_plan_t *__mingw_pformat_compile (const char *);
+
+extern __cdecl __MINGW_NOTHROW
+int __mingw_vfprintf_plan (FILE *, const __mingw_pformat_plan_t *, __VALIST);
+
+extern __cdecl __MINGW_NOTHROW
+int __mingw_vsnprintf_plan (char *, size_t, const __mingw_pformat_plan_t *, __VALIST);
+
+extern __cdecl __MINGW_NOTHROW
+void __mingw_pformat_release (__mingw_pformat_plan_t *);
+
+/* The following pair of functions format their output, in a single pass,
+ * into a heap buffer, which they allocate, (and expand as necessary), to
+ * accommodate it; the caller must free() the buffer, when it is no longer
+ * required.  They are also known by their GNU, and BSD, names, (without
+ * the __mingw_ prefix), when the appropriate feature tests are enabled.
+ */
+extern __cdecl __MINGW_NOTHROW __Wformat_mingw_printf(2,3)
+int __mingw_asprintf (char **, const char *, ...);
+
+extern __cdecl __MINGW_NOTHROW __Wformat_mingw_printf(2,0)
+int __mingw_vasprintf (char **, const char *, __VALIST);
+
+#if ! defined __STRICT_ANSI__ || defined _GNU_SOURCE || defined _BSD_SOURCE
+extern __cdecl __MINGW_NOTHROW __Wformat_mingw_printf(2,3)
+int asprintf (char **, const char *, ...);
+
+extern __cdecl __MINGW_NOTHROW __Wformat_mingw_printf(2,0)
+int vasprintf (char **, const char *, __VALIST);
+
+#endif	/* !__STRICT_ANSI__ || _GNU_SOURCE || _BSD_SOURCE */
+
 #if __USE_MINGW_ANSI_STDIO || defined _ISOC99_SOURCE
 /* User has expressed a preference for C99 conformance...
  */
@@ -455,6 +519,39 @@ int vsprintf (char *__stream, const char *__format, __VALIST __local_argv)
   return __mingw_vsprintf( __stream, __format, __local_argv );
 }
 
+/* Similarly, the MinGW ISO-C conforming implementations of the scanf()
+ * family of functions replace the Microsoft implementations.
+ */
+__mingw_stdio_redirect__ __Wformat_fscanf
+int fscanf (FILE *__stream, const char *__format, ...)
+{
+  register int __retval;
+  __builtin_va_list __local_argv; __builtin_va_start( __local_argv, __format );
+  __retval = __mingw_vfscanf( __stream, __format, __local_argv );
+  __builtin_va_end( __local_argv );
+  return __retval;
+}
+
+__mingw_stdio_redirect__ __Wformat_scanf
+int scanf (const char *__format, ...)
+{
+  register int __retval;
+  __builtin_va_list __local_argv; __builtin_va_start( __local_argv, __format );
+  __retval = __mingw_vscanf( __format, __local_argv );
+  __builtin_va_end( __local_argv );
+  return __retval;
+}
+
+__mingw_stdio_redirect__ __Wformat_sscanf
+int sscanf (const char *__buf, const char *__format, ...)
+{
+  register int __retval;
+  __builtin_va_list __local_argv; __builtin_va_start( __local_argv, __format );
+  __retval = __mingw_vsscanf( __buf, __format, __local_argv );
+  __builtin_va_end( __local_argv );
+  return __retval;
+}
+
 #else	/* !__USE_MINGW_ANSI_STDIO */
 /* Default configuration: simply direct all calls to MSVCRT...
  */
@@ -465,6 +562,10 @@ _CRTIMP __cdecl __MINGW_NOTHROW  int vfprintf (FILE *, const char *, __VALIST);
 _CRTIMP __cdecl __MINGW_NOTHROW  int vprintf (const char *, __VALIST);
 _CRTIMP __cdecl __MINGW_NOTHROW  int vsprintf (char *, const char *, __VALIST);
 
+_CRTIMP __cdecl __MINGW_NOTHROW  int fscanf (FILE *, const char *, ...);
+_CRTIMP __cdecl __MINGW_NOTHROW  int scanf (const char *, ...);
+_CRTIMP __cdecl __MINGW_NOTHROW  int sscanf (const char *, const char *, ...);
+
 #endif	/* !__USE_MINGW_ANSI_STDIO */
 
 #if __GNUC__ && defined _ISOC99_SOURCE
@@ -539,13 +640,13 @@ int snprintf (char *, size_t, const char *, ...);
 __cdecl __MINGW_NOTHROW __Wformat_vsnprintf
 int vsnprintf (char *, size_t, const char *, __VALIST);
 
-__cdecl __MINGW_NOTHROW
+__cdecl __MINGW_NOTHROW __Wformat_vscanf
 int vscanf (const char * __restrict__, __VALIST);
 
-__cdecl __MINGW_NOTHROW
+__cdecl __MINGW_NOTHROW __Wformat_vfscanf
 int vfscanf (FILE * __restrict__, const char * __restrict__, __VALIST);
 
-__cdecl __MINGW_NOTHROW
+__cdecl __MINGW_NOTHROW __Wformat_vsscanf
 int vsscanf (const char * __restrict__, const char * __restrict__, __VALIST);
 
 #endif  /* _ISOC99_SOURCE */
@@ -692,13 +793,60 @@ __cdecl __MINGW_NOTHROW ssize_t getline
 { return getdelim( __l, __n, '\n', __s ); }
 
 #endif  /* !__NO_INLINE__ */
-#endif  /* POSIX.1-2008 */
 
-/* Formatted Input
+#if ! defined __STRICT_ANSI__ || defined _GNU_SOURCE || defined _BSD_SOURCE
+/* As MinGW extensions, getdelim_unlocked() and getline_unlocked() are
+ * equivalent to getdelim() and getline() respectively, except that they
+ * do not acquire the stream lock; they are suitable for use only when the
+ * caller ensures that no other thread may access the stream concurrently.
  */
-_CRTIMP __cdecl __MINGW_NOTHROW  int    fscanf (FILE *, const char *, ...);
-_CRTIMP __cdecl __MINGW_NOTHROW  int    scanf (const char *, ...);
-_CRTIMP __cdecl __MINGW_NOTHROW  int    sscanf (const char *, const char *, ...);
+__cdecl __MINGW_NOTHROW ssize_t getdelim_unlocked
+(char ** __restrict__, size_t * __restrict__, int, FILE * __restrict__);
+
+__cdecl __MINGW_NOTHROW ssize_t getline_unlocked
+(char ** __restrict__, size_t * __restrict__, FILE * __restrict__);
+
+#ifndef __NO_INLINE__
+__CRT_ALIAS __LIBIMPL__(( FUNCTION = getline_unlocked ))
+__cdecl __MINGW_NOTHROW ssize_t getline_unlocked
+( char **__restrict__ __l, size_t *__restrict__ __n, FILE *__restrict__ __s )
+{ return getdelim_unlocked( __l, __n, '\n', __s ); }
+
+#endif  /* !__NO_INLINE__ */
+#endif  /* !__STRICT_ANSI__ || _GNU_SOURCE || _BSD_SOURCE */
+
+/* POSIX.1-2008 also added open_memstream(), and fmemopen(), which create
+ * streams whose content is held in memory.  MSVCRT has no provision for
+ * such streams, so libmingwex.a represents them as string streams, (like
+ * those used internally by MSVCRT's sprintf(), and sscanf() functions).
+ * Any stdio function may read, or write, within the stream buffer, but
+ * only the MinGW printf() family of functions may expand the buffer of
+ * an open_memstream() stream; none of the "+" update modes are supported
+ * by fmemopen(), and memory streams do not support seeking.
+ */
+__cdecl __MINGW_NOTHROW  FILE *open_memstream (char **, size_t *);
+__cdecl __MINGW_NOTHROW  FILE *fmemopen
+(void *__restrict__, size_t, const char *__restrict__);
+
+/* Memory streams must be synchronized, and released, by fflush(), and
+ * fclose(); these must be redirected, through libmingwex.a, to achieve
+ * this, while deferring to MSVCRT for any other stream.  The jump stubs
+ * ensure that this redirection also applies to references which are not
+ * inlined, (e.g. through function pointers, or from objects compiled
+ * without POSIX.1-2008 visibility).
+ */
+__cdecl __MINGW_NOTHROW  int __mingw_fflush (FILE *);
+__cdecl __MINGW_NOTHROW  int __mingw_fclose (FILE *);
+
+__JMPSTUB__(( FUNCTION = fflush ))
+__CRT_ALIAS __cdecl __MINGW_NOTHROW  int fflush (FILE *__fp)
+{ return __mingw_fflush (__fp); }
+
+__JMPSTUB__(( FUNCTION = fclose ))
+__CRT_ALIAS __cdecl __MINGW_NOTHROW  int fclose (FILE *__fp)
+{ return __mingw_fclose (__fp); }
+
+#endif  /* POSIX.1-2008 */
 
 /* Character Input and Output Functions
  */
@@ -7,7 +7,7 @@
  * $Id$
  *
  * Written by Colin Peters <colin@bird.fu.is.saga-u.ac.jp>
- * Copyright (C) 1997-2009, 2011, 2014-2016, 2018, 2020, MinGW.org Project.
+ * Copyright (C) 1997-2009, 2011, 2014-2016, 2018, 2020, 2026, MinGW.org Project.
  *
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
@@ -541,6 +541,18 @@ _CRTIMP __cdecl __MINGW_NOTHROW  int rand_s (unsigned int *);
 #endif	/* Win-Vista || MSVCR80.DLL || later */
 #endif	/* _CRT_RAND_S enabled */
 
+#if defined _GNU_SOURCE || defined _BSD_SOURCE || ! defined __STRICT_ANSI__
+/* As an alternative to rand_s(), which is available on all versions of
+ * Windows, MinGW.org provides the BSD arc4random() family of functions;
+ * these deliver output from a per-thread, ChaCha20 based, generator,
+ * which is seeded, and periodically reseeded, from the wincrypt API.
+ */
+__cdecl __MINGW_NOTHROW  unsigned int arc4random (void);
+__cdecl __MINGW_NOTHROW  void arc4random_buf (void *, size_t);
+__cdecl __MINGW_NOTHROW  unsigned int arc4random_uniform (unsigned int);
+
+#endif	/* _GNU_SOURCE || _BSD_SOURCE || !__STRICT_ANSI__ */
+
 _CRTIMP __cdecl __MINGW_NOTHROW  void abort (void) __MINGW_ATTRIB_NORETURN;
 _CRTIMP __cdecl __MINGW_NOTHROW  void exit (int) __MINGW_ATTRIB_NORETURN;
 
@@ -589,6 +601,30 @@ __JMPSTUB__(( LIB = memalign, FUNCTION = realloc ))
 __CRT_ALIAS __cdecl __MINGW_NOTHROW  void *realloc (void *__ptr, size_t __want)
 { return __mingw_realloc (__ptr, __want); }
 
+/* MinGW.org also provides a thread caching allocator, which serves small
+ * blocks from per-thread caches, without contending for the lock on the
+ * process heap; it delegates larger blocks to MSVCRT.DLL's malloc(), and
+ * any block which it allocates may be resized, or freed, by the preceding
+ * pair of functions, (but NOT by their MSVCRT.DLL counterparts, and NOT
+ * by _msize(); use malloc_usable_size(), from <malloc.h>, instead).  It
+ * is always available as __mingw_malloc(), and as __mingw_calloc()...
+ */
+__cdecl __MINGW_NOTHROW  void *__mingw_malloc (size_t) __MINGW_ATTRIB_MALLOC;
+__cdecl __MINGW_NOTHROW  void *__mingw_calloc (size_t, size_t) __MINGW_ATTRIB_MALLOC;
+
+#ifdef __USE_MINGW_MALLOC
+/* ...while, when the user defines the __USE_MINGW_MALLOC feature test,
+ * malloc() and calloc() are themselves redirected to it; (as for qsort(),
+ * we provide no external equivalents of these inline functions, since
+ * they would conflict with the MSVCRT.DLL implementations).
+ */
+__CRT_ALIAS __cdecl __MINGW_NOTHROW  void *malloc (size_t __want)
+{ return __mingw_malloc (__want); }
+
+__CRT_ALIAS __cdecl __MINGW_NOTHROW  void *calloc (size_t __n, size_t __sz)
+{ return __mingw_calloc (__n, __sz); }
+#endif
+
 #if __STDC_VERSION__ >= 201112L || __cplusplus >= 201703L
 /* ISO-C99 adds support for over-aligned heap memory allocation, by use
  * of the aligned_alloc() function, (which was subsequently incorporated
@@ -652,6 +688,66 @@ _CRTIMP __cdecl  void *bsearch
 _CRTIMP __cdecl  void qsort
 (void *, size_t, size_t, int (*)(const void *, const void *));
 
+/* MinGW.org also provides its own implementation of qsort(), (which is
+ * a pattern-defeating quicksort, generally outperforming MSVCRT.DLL's);
+ * it is always available as __mingw_qsort(), together with variants
+ * which pass an additional user specified context argument through to
+ * the comparator, in the style of GNU's qsort_r(), and Microsoft's
+ * qsort_s() respectively.
+ */
+extern __cdecl  void __mingw_qsort
+(void *, size_t, size_t, int (*)(const void *, const void *));
+
+extern __cdecl  void __mingw_qsort_r
+(void *, size_t, size_t, int (*)(const void *, const void *, void *), void *);
+
+extern __cdecl  void __mingw_qsort_s
+(void *, size_t, size_t, int (*)(void *, const void *, const void *), void *);
+
+#ifdef __USE_MINGW_QSORT
+/* When the user defines the __USE_MINGW_QSORT feature test, we redirect
+ * qsort() itself to the MinGW.org implementation; (as in the case of
+ * strtod(), we provide no external equivalent of this inline function,
+ * since it would conflict with the MSVCRT.DLL implementation).
+ */
+__CRT_ALIAS __cdecl  void qsort
+(void *__base, size_t __n, size_t __sz, int (*__cmp)(const void *, const void *))
+{ __mingw_qsort (__base, __n, __sz, __cmp); }
+#endif
+
+#if defined _GNU_SOURCE || ! defined __STRICT_ANSI__
+/* GNU extension: qsort_r() passes a user specified context argument,
+ * (as its third argument), to the comparator; MSVCRT.DLL provides no
+ * such function, so we always direct it to our own implementation.
+ */
+__cdecl  void qsort_r
+(void *, size_t, size_t, int (*)(const void *, const void *, void *), void *);
+
+__CRT_ALIAS __JMPSTUB__(( FUNCTION = qsort_r ))
+__cdecl  void qsort_r (void *__base, size_t __n, size_t __sz,
+  int (*__cmp)(const void *, const void *, void *), void *__ctx)
+{ __mingw_qsort_r (__base, __n, __sz, __cmp, __ctx); }
+#endif
+
+#if ! defined __USE_MINGW_QSORT \
+ && (__MSVCRT_VERSION__ >= __MSVCR80_DLL || _WIN32_WINNT >= _WIN32_WINNT_VISTA)
+/* MSVCR80.DLL introduced qsort_s(), which is similar to qsort_r(), but
+ * it passes the context argument FIRST, to the comparator; it was later
+ * retrofitted to MSVCRT.DLL, from the release of Windows-Vista onwards.
+ */
+_CRTIMP __cdecl  void qsort_s
+(void *, size_t, size_t, int (*)(void *, const void *, const void *), void *);
+
+#elif ! defined __STRICT_ANSI__
+/* For the benefit of pre-Vista MSVCRT.DLL users, (or when the user has
+ * requested __USE_MINGW_QSORT), we provide an inline implementation of
+ * qsort_s(), in terms of our own __mingw_qsort_s() function.
+ */
+__CRT_ALIAS __cdecl  void qsort_s (void *__base, size_t __n, size_t __sz,
+  int (*__cmp)(void *, const void *, const void *), void *__ctx)
+{ __mingw_qsort_s (__base, __n, __sz, __cmp, __ctx); }
+#endif
+
 _CRTIMP __cdecl __MINGW_NOTHROW  int abs (int) __MINGW_ATTRIB_CONST;
 _CRTIMP __cdecl __MINGW_NOTHROW  long labs (long) __MINGW_ATTRIB_CONST;
 
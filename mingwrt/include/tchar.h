@@ -254,6 +254,8 @@ typedef wchar_t _TCHAR;
 #define _trewinddir	_wrewinddir
 #define _ttelldir	_wtelldir
 #define _tseekdir	_wseekdir
+#define _tscandir	_wscandir
+#define _talphasort	_walphasort
 
 #else	/* Not _UNICODE */
 
@@ -470,6 +472,8 @@ typedef char	_TCHAR;
 #define _trewinddir	rewinddir
 #define _ttelldir	telldir
 #define _tseekdir	seekdir
+#define _tscandir	scandir
+#define _talphasort	alphasort
 
 #endif	/* Not _UNICODE */
 
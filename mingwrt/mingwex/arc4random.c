@@ -0,0 +1,226 @@
+/*
+ * arc4random.c
+ *
+ * Implementation of a per-thread, buffered, cryptographically secure
+ * pseudo-random number generator, based on the ChaCha20 stream cipher,
+ * and seeded from the wincrypt API; this furnishes the BSD arc4random()
+ * family of functions, together with an internal __mingw_arc4random_buf()
+ * helper, which reports, rather than aborts on, failure to seed.
+ *
+ * $Id$
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR THE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * The design follows that of OpenBSD's arc4random: each thread generates
+ * ChaCha20 keystream, a buffer full at a time, and immediately replaces
+ * its key, and IV, with the leading bytes of each buffer full, (so that
+ * previously delivered output cannot be reconstructed, even if the state
+ * is later compromised); after delivering ARC4RANDOM_RESEED bytes, fresh
+ * entropy is drawn from CryptGenRandom(), and mixed into the state.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define ARC4RANDOM_KEYSZ	32
+#define ARC4RANDOM_IVSZ 	 8
+#define ARC4RANDOM_SEEDSZ	(ARC4RANDOM_KEYSZ + ARC4RANDOM_IVSZ)
+#define ARC4RANDOM_BLOCKSZ	64
+#define ARC4RANDOM_BUFSZ	(16 * ARC4RANDOM_BLOCKSZ)
+#define ARC4RANDOM_RESEED	(1024 * 1024)
+
+/* The ultimate entropy source is the wincrypt API, as it is used for
+ * the same purpose within memcrypt.c
+ */
+void *__mingw_crypto_randomize( void *, size_t );
+
+static __thread struct
+{ uint32_t	 input[16];
+  size_t	 have;
+  size_t	 count;
+  int		 seeded;
+  unsigned char  buf[ARC4RANDOM_BUFSZ];
+} rs;
+
+#define ROTL32(V, N)  (((V) << (N)) | ((V) >> (32 - (N))))
+#define QUARTERROUND(A, B, C, D) \
+  x[A] += x[B]; x[D] = ROTL32( x[D] ^ x[A], 16 ); \
+  x[C] += x[D]; x[B] = ROTL32( x[B] ^ x[C], 12 ); \
+  x[A] += x[B]; x[D] = ROTL32( x[D] ^ x[A],  8 ); \
+  x[C] += x[D]; x[B] = ROTL32( x[B] ^ x[C],  7 )
+
+static void chacha_block( uint32_t *input, unsigned char *output )
+{
+  /* Generate one 64-byte block of ChaCha20 keystream, from the state
+   * in "input", then advance its 64-bit block counter.
+   */
+  uint32_t x[16];
+  int i;
+
+  memcpy( x, input, sizeof( x ) );
+  for( i = 0; i < 10; i++ )
+  { QUARTERROUND( 0, 4,  8, 12 ); QUARTERROUND( 1, 5,  9, 13 );
+    QUARTERROUND( 2, 6, 10, 14 ); QUARTERROUND( 3, 7, 11, 15 );
+    QUARTERROUND( 0, 5, 10, 15 ); QUARTERROUND( 1, 6, 11, 12 );
+    QUARTERROUND( 2, 7,  8, 13 ); QUARTERROUND( 3, 4,  9, 14 );
+  }
+  for( i = 0; i < 16; i++ )
+  { uint32_t v = x[i] + input[i];
+    output[4 * i] = v; output[4 * i + 1] = v >> 8;
+    output[4 * i + 2] = v >> 16; output[4 * i + 3] = v >> 24;
+  }
+  if( ++input[12] == 0 ) ++input[13];
+}
+
+static void chacha_keysetup( const unsigned char *seed )
+{
+  /* Initialize the ChaCha20 state, from ARC4RANDOM_SEEDSZ bytes of key,
+   * and IV, material; ("expand 32-byte k" is the standard constant).
+   */
+  static const uint32_t sigma[4] =
+  { 0x61707865, 0x3320646E, 0x79622D32, 0x6B206574 };
+  int i;
+
+  memcpy( rs.input, sigma, sizeof( sigma ) );
+  for( i = 0; i < 8; i++ )
+    rs.input[4 + i] = seed[4 * i] | (seed[4 * i + 1] << 8)
+      | (seed[4 * i + 2] << 16) | ((uint32_t)(seed[4 * i + 3]) << 24);
+  rs.input[12] = rs.input[13] = 0;
+  for( i = 0; i < 2; i++ )
+    rs.input[14 + i] = seed[32 + 4 * i] | (seed[33 + 4 * i] << 8)
+      | (seed[34 + 4 * i] << 16) | ((uint32_t)(seed[35 + 4 * i]) << 24);
+}
+
+static void arc4random_rekey( const unsigned char *data, size_t datalen )
+{
+  /* Refill the keystream buffer, optionally mixing in additional seed
+   * material, then immediately replace the key, and IV, with the first
+   * ARC4RANDOM_SEEDSZ bytes of the new keystream, which are then erased,
+   * and never delivered.
+   */
+  size_t i;
+
+  for( i = 0; i < ARC4RANDOM_BUFSZ; i += ARC4RANDOM_BLOCKSZ )
+    chacha_block( rs.input, rs.buf + i );
+
+  if( data != NULL )
+  { if( datalen > ARC4RANDOM_SEEDSZ ) datalen = ARC4RANDOM_SEEDSZ;
+    for( i = 0; i < datalen; i++ ) rs.buf[i] ^= data[i];
+  }
+  chacha_keysetup( rs.buf );
+  memset( rs.buf, 0, ARC4RANDOM_SEEDSZ );
+  rs.have = ARC4RANDOM_BUFSZ - ARC4RANDOM_SEEDSZ;
+}
+
+static int arc4random_stir( void )
+{
+  /* Draw fresh entropy from the wincrypt API; on first use, by each
+   * thread, this initializes the generator state, while subsequently,
+   * it is mixed into the existing state.  Returns zero on success, or
+   * -1 if entropy could not be obtained.
+   */
+  unsigned char seed[ARC4RANDOM_SEEDSZ];
+
+  if( __mingw_crypto_randomize( seed, sizeof( seed ) ) == NULL )
+    return -1;
+
+  if( ! rs.seeded )
+  { chacha_keysetup( seed );
+    rs.seeded = 1;
+  }
+  else
+    arc4random_rekey( seed, sizeof( seed ) );
+  memset( seed, 0, sizeof( seed ) );
+
+  /* Discard any keystream remaining from before the reseed, and
+   * schedule the next reseed.
+   */
+  memset( rs.buf, 0, sizeof( rs.buf ) );
+  rs.have = 0;
+  rs.count = ARC4RANDOM_RESEED;
+  return 0;
+}
+
+void *__mingw_arc4random_buf( void *buf, size_t len )
+{
+  /* Fill "buf" with "len" bytes drawn from the calling thread's
+   * generator, returning "buf", or NULL if the generator could not be
+   * seeded; (in the latter case, the content of "buf" is undefined).
+   */
+  unsigned char *p = buf;
+
+  if( ! rs.seeded || (rs.count <= len) )
+  { if( arc4random_stir() != 0 ) return NULL;
+  }
+  else
+    rs.count -= len;
+
+  while( len > 0 )
+  { if( rs.have > 0 )
+    { /* Deliver keystream from the unused tail of the buffer, erasing
+       * each byte as it is delivered.
+       */
+      size_t take = (len < rs.have) ? len : rs.have;
+      unsigned char *ks = rs.buf + ARC4RANDOM_BUFSZ - rs.have;
+      memcpy( p, ks, take ); memset( ks, 0, take );
+      p += take; len -= take; rs.have -= take;
+    }
+    if( rs.have == 0 ) arc4random_rekey( NULL, 0 );
+  }
+  return buf;
+}
+
+void arc4random_buf( void *buf, size_t len )
+{
+  /* The BSD API provides no means of reporting failure; if we cannot
+   * obtain entropy, then we must not return predictable data.
+   */
+  if( __mingw_arc4random_buf( buf, len ) == NULL )
+    abort();
+}
+
+uint32_t arc4random( void )
+{
+  uint32_t retval;
+  arc4random_buf( &retval, sizeof( retval ) );
+  return retval;
+}
+
+uint32_t arc4random_uniform( uint32_t upper_bound )
+{
+  /* Return a uniformly distributed random number, less than the given
+   * upper bound, avoiding modulo bias by rejecting those values, below
+   * 2**32 % upper_bound, which would be over-represented; (at most half
+   * of all possible values are rejected, and typically far fewer).
+   */
+  uint32_t r, min;
+
+  if( upper_bound < 2 ) return 0;
+  min = -upper_bound % upper_bound;
+  do r = arc4random(); while( r < min );
+  return r % upper_bound;
+}
+
+/* $RCSfile$: end of file */
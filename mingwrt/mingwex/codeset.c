@@ -3,12 +3,13 @@
  *
  * Provides implementation-private helper functions, to identify the
  * code page which is associated with the active process locale, and to
- * establish the effective MB_CUR_MAX value for this code page.
+ * establish the effective MB_CUR_MAX value for this code page; each is
+ * cached, per thread, until the active LC_CTYPE locale changes.
  *
  * $Id$
  *
  * Written by Keith Marshall <keith@users.osdn.me>
- * Copyright (C) 2019, 2020, MinGW.org Project
+ * Copyright (C) 2019, 2020, 2026, MinGW.org Project
  *
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
@@ -34,12 +35,123 @@
 #include <locale.h>
 #include <stdlib.h>
 #include <string.h>
-#include <winnls.h>
+#include <windows.h>
 
 unsigned int __mb_codeset_for_locale( void );
 unsigned int __mb_cur_max_for_codeset( unsigned int );
+void __mb_codeset_invalidate( void );
 
-unsigned int __mb_codeset_for_locale( void )
+/* Identifying the codeset for the active locale is expensive; it may
+ * require two setlocale() calls, up to three getenv() calls, and a
+ * GetCPInfo() call.  Since the multibyte conversion functions need
+ * this information on every call, we cache it, for each thread, and
+ * revalidate the cached state by comparison with the code page, and
+ * locale handle, which the runtime DLL records for the active LC_CTYPE
+ * locale category.  These must be retrieved by the runtime's accessor
+ * functions, which consult the calling thread's locale, when it has
+ * one of its own, by virtue of _configthreadlocale(); the process global
+ * data, from which they are otherwise taken, would then be stale.
+ */
+#if __MSVCRT_VERSION__ < __MSVCR70_DLL
+/* MSVCRT.DLL exports the accessors only from WinXP onwards, so we must
+ * resolve them at run time; earlier versions support no per-thread
+ * locales, so their process global data, (which they export), serves
+ * equally well, in the event that the accessors are unavailable.
+ */
+__MINGW_IMPORT unsigned int __lc_codepage;
+__MINGW_IMPORT LCID __lc_handle[];
+
+static unsigned int __cdecl mb_global_codepage( void ){ return __lc_codepage; }
+static LCID * __cdecl mb_global_handle( void ){ return __lc_handle; }
+
+static unsigned int (__cdecl *volatile mb_codepage_fn)( void ) = NULL;
+static LCID *(__cdecl *volatile mb_handle_fn)( void ) = NULL;
+
+static unsigned int mb_locale_resolve( void )
+{
+  /* Resolve both accessors, on first use; there is no harm if several
+   * threads race to do this, since all will find the same result.  We
+   * assign the handle accessor first, so that it is always available to
+   * any thread which sees the code page accessor.
+   */
+  HMODULE crt = GetModuleHandleA( "msvcrt.dll" );
+  FARPROC codepage = (crt != NULL) ? GetProcAddress( crt, "___lc_codepage_func" ) : NULL;
+  FARPROC handle = (crt != NULL) ? GetProcAddress( crt, "___lc_handle_func" ) : NULL;
+
+  if( (codepage == NULL) || (handle == NULL) )
+  { mb_handle_fn = mb_global_handle; mb_codepage_fn = mb_global_codepage; }
+  else
+  { mb_handle_fn = (LCID *(__cdecl *)( void ))(handle);
+    mb_codepage_fn = (unsigned int (__cdecl *)( void ))(codepage);
+  }
+  return mb_codepage_fn();
+}
+
+#define mb_locale_codepage()  \
+  ((mb_codepage_fn != NULL) ? mb_codepage_fn() : mb_locale_resolve())
+#define mb_locale_handle()    mb_handle_fn()[LC_CTYPE]
+
+#else
+/* All non-free runtimes export the accessors, so we may simply import
+ * them; (note that mb_locale_codepage() must always be evaluated before
+ * mb_locale_handle(), for consistency with the MSVCRT.DLL case above).
+ */
+_CRTIMP __cdecl unsigned int ___lc_codepage_func( void );
+#define mb_locale_codepage()  ___lc_codepage_func()
+
+#if __MSVCRT_VERSION__ < __MSVCR110_DLL
+_CRTIMP __cdecl LCID *___lc_handle_func( void );
+#define mb_locale_handle()    ___lc_handle_func()[LC_CTYPE]
+
+#else
+/* MSVCR110.DLL, and later, identify locales by name, rather than by
+ * LCID; in this case, we rely on the code page alone.
+ */
+#define mb_locale_handle()    (LCID)(0)
+#endif
+#endif
+
+/* The cached state is also invalidated whenever this process global
+ * generation count is advanced; this happens when setenv() modifies
+ * the environment, from which the default locale may be inferred.
+ * Note that the count starts at one, so that the zero-initialized
+ * cache of each new thread is initially invalid.
+ *
+ * LIMITATION: only setenv(), and unsetenv(), advance the count; if the
+ * LC_ALL, LC_CTYPE, or LANG environment variable is changed by putenv(),
+ * or by _putenv(), while the active locale is the system default, then
+ * the cached codeset will not reflect the change, until the LC_CTYPE
+ * locale itself changes, (e.g. by a setlocale() call).  We do not check
+ * the environment on every call, since that would incur three getenv()
+ * calls, for each multibyte conversion.  (SetEnvironmentVariable() has
+ * no such effect, since it does not update the runtime's own copy of
+ * the environment, from which getenv() reads).
+ */
+static volatile LONG mb_generation = 1;
+
+static __thread struct
+{ LONG		generation;
+  unsigned int	codepage;
+  LCID		handle;
+  unsigned int	codeset;
+  unsigned int	cur_max;
+} mb_cache;
+
+void __mb_codeset_invalidate( void )
+{ InterlockedIncrement( &mb_generation ); }
+
+static unsigned int mb_cur_max_lookup( unsigned int codeset )
+{
+  /* Identify the length of the longest valid multibyte character encoding
+   * sequence, used within the specified MS-Windows code page, by consulting
+   * the relevant Win32 API database.  Returns the appropriate byte count,
+   * or zero if the codeset identifier is not valid.
+   */
+  CPINFO codeset_info;
+  return (GetCPInfo( codeset, &codeset_info )) ? codeset_info.MaxCharSize : 0;
+}
+
+static unsigned int mb_codeset_lookup( void )
 {
   /* Extract the code page identification string (if any) from the LC_CTYPE
    * identification string, as returned in "language[_region[.codeset]]", or
@@ -87,7 +199,7 @@ unsigned int __mb_codeset_for_locale( void )
        * value, for validation and return.
        */
       unsigned int retval = (unsigned int)(atoi( codeset_string + 1 ));
-      if( __mb_cur_max_for_codeset( retval ) > 0 ) return retval;
+      if( mb_cur_max_lookup( retval ) > 0 ) return retval;
     }
   }
   /* In the event that LC_CTYPE doesn't include a codeset identification,
@@ -97,15 +209,42 @@ unsigned int __mb_codeset_for_locale( void )
   return 0;
 }
 
+unsigned int __mb_codeset_for_locale( void )
+{
+  /* Return the codeset for the active locale, from the calling thread's
+   * cache, after first refreshing the cache if the LC_CTYPE category of
+   * the active locale, or the environment, has changed since it was last
+   * updated; in the steady state, this requires just a few comparisons.
+   */
+  LONG generation = mb_generation;
+  unsigned int codepage = mb_locale_codepage();
+  LCID handle = mb_locale_handle();
+
+  if( (mb_cache.generation != generation)
+  ||  (mb_cache.codepage != codepage) || (mb_cache.handle != handle) )
+  {
+    /* The cache is stale; (note that we captured the validation state
+     * BEFORE performing the lookup, so that any change which occurs
+     * concurrently will be detected on the next call).
+     */
+    mb_cache.codeset = mb_codeset_lookup();
+    mb_cache.cur_max = mb_cur_max_lookup( mb_cache.codeset );
+    mb_cache.codepage = codepage; mb_cache.handle = handle;
+    mb_cache.generation = generation;
+  }
+  return mb_cache.codeset;
+}
+
 unsigned int __mb_cur_max_for_codeset( unsigned int codeset )
 {
-  /* Identify the length of the longest valid multibyte character encoding
-   * sequence, used within the specified MS-Windows code page, by consulting
-   * the relevant Win32 API database.  Returns the appropriate byte count,
-   * or zero if the codeset identifier is not valid.
+  /* Return the effective MB_CUR_MAX for the specified codeset; this is
+   * invariant, for any given codeset, so we may return the cached value
+   * whenever the cache is valid for the same codeset, (as it normally
+   * will be, since callers typically ask about the active codeset).
    */
-  CPINFO codeset_info;
-  return (GetCPInfo( codeset, &codeset_info )) ? codeset_info.MaxCharSize : 0;
+  if( (mb_cache.generation != 0) && (mb_cache.codeset == codeset) )
+    return mb_cache.cur_max;
+  return mb_cur_max_lookup( codeset );
 }
 
 /* $RCSfile$: end of file */
@@ -38,68 +38,55 @@
 
 #define CRYPTO_INLINE  static __inline__ __attribute__((__always_inline__))
 
-void *__mingw_crypto_randomize( void *, size_t );
+/* Random bytes are drawn from the calling thread's buffered ChaCha20
+ * generator, (see arc4random.c), which is itself seeded, and reseeded
+ * periodically, from the wincrypt API; this avoids the cost of a call
+ * to CryptGenRandom() for each individual character.
+ */
+void *__mingw_arc4random_buf( void *, size_t );
 CRYPTO_INLINE void *crypto_randomize( void *buf, size_t buflen )
-{ return __mingw_crypto_randomize( buf, buflen ); }
-
-CRYPTO_INLINE
-unsigned char *crypto_random_filename_char( unsigned char *caret )
-{
-  /* Helper to generate a random sequence of characters, suitable for
-   * use in file names; although there are other valid possibilities, we
-   * restrict this to the set of lower case ASCII alpha-numerics, giving
-   * us 36 degrees of freedom for each character; (note that we cannot
-   * gain additional degrees of freedom by using mixed case, because
-   * the MS-Windows file system is case-insensitive).
-   */
-  const unsigned char span = 'z' - 'a' + 1 + '9' - '0' + 1;
-
-  /* We also wish to ensure that each of the possible 36 characters has
-   * an equal probability of selection; thus, of the UCHAR_MAX possible
-   * raw byte selections, we want to consider at most the largest even
-   * multiple of the 36 character span, which lies below the UCHAR_MAX
-   * limit, (which, since zero is a valid choice, is one less than the
-   * result of discounting the remainder from modulo division).
-   */
-  const unsigned char max = UCHAR_MAX - (UCHAR_MAX % span) - 1;
+{ return __mingw_arc4random_buf( buf, buflen ); }
 
-  /* Deposit randomly selected characters at the "caret" location...
-   */
-  do { if( crypto_randomize( caret, sizeof( unsigned char ) ) == NULL )
-	 /*
-	  * ...bailing out, on any failure of the sequence generator...
-	  */
-         return NULL;
+/* Candidate file names are restricted to the set of lower case ASCII
+ * alpha-numerics, giving us 36 degrees of freedom for each character;
+ * (note that we cannot gain additional degrees of freedom by using mixed
+ * case, because the MS-Windows file system is case-insensitive).
+ */
+#define CRYPTO_FILENAME_SPAN  ('z' - 'a' + 1 + '9' - '0' + 1)
 
-       /* ...until we get one which is within the largest possible
-	* subset which yields equal probabilty to each outcome, when
-	* reduced modulo the 36 available degrees of freedom.
-	*/
-     } while( *caret > max );
+/* We also wish to ensure that each of the possible 36 characters has
+ * an equal probability of selection; thus, of the UCHAR_MAX possible
+ * raw byte selections, we want to consider at most the largest even
+ * multiple of the 36 character span, which lies below the UCHAR_MAX
+ * limit, (which, since zero is a valid choice, is one less than the
+ * result of discounting the remainder from modulo division).
+ */
+#define CRYPTO_FILENAME_MAX \
+  (UCHAR_MAX - (UCHAR_MAX % CRYPTO_FILENAME_SPAN) - 1)
 
-  /* Perform the modulo 36 reduction, and offset the result into the
+CRYPTO_INLINE
+unsigned char crypto_filename_char( unsigned char c )
+{
+  /* Helper to map a random byte value, which has already been accepted
+   * as no greater than CRYPTO_FILENAME_MAX, to its equivalent character;
+   * perform the modulo 36 reduction, and offset the result into the
    * alpha-numeric character range...
    */
-  *caret = '0' + (*caret % span);
+  c = '0' + (c % CRYPTO_FILENAME_SPAN);
   /*
    * ...while discounting those unsuitable characters which lie within
    * the range, between '9' and 'a' exclusively.
    */
-  if( *caret > '9' ) *caret += 'a' - '9' - 1;
-
-  /* Finally, return the "caret" location, indicating the successful
-   * transformation of the character in that position.
-   */
-  return caret;
+  return (c > '9') ? c + 'a' - '9' - 1 : c;
 }
 
 char *__mingw_crypto_tmpname( char *template )
 {
-  /* Helper function, based on Microsoft's wincrypt API, to construct
-   * the candidate names for temporary files, both in a less predictable
-   * manner than Microsoft's _mktemp() function, and without suffering
-   * its inherent limitation of allowing no more than 26 file names
-   * per template per process thread.
+  /* Helper function, based on a cryptographically secure generator, to
+   * construct the candidate names for temporary files, both in a less
+   * predictable manner than Microsoft's _mktemp() function, and without
+   * suffering its inherent limitation of allowing no more than 26 file
+   * names per template per process thread.
    *
    * We begin by locating the position, within the given template,
    * where the string of six replaceable 'XXXXXX's should begin.
@@ -111,21 +98,40 @@ char *__mingw_crypto_tmpname( char *template )
    */
   if( (char *)(tail) >= template )
   {
-    /* ...then, walk over each of the six bytes of the "tail", until
-     * we reach the NUL terminator...
+    /* ...then, we must first check that each of the six bytes of the
+     * "tail" is initially ASCII 'X', as POSIX requires them to be; (note
+     * that we don't consider that these may be MBCS trail bytes, since
+     * the required 'X' is a single byte in an MBCS representation)...
      */
-    while( *tail )
-    {
-      /* ...checking that each byte is initially ASCII 'X', as POSIX
-       * requires them to be; (note that we don't consider that these
-       * may be MBCS trail bytes, since the required 'X' is a single
-       * byte in an MBCS representation anyway)...
-       */
-      if( (*tail != 'X') || (crypto_random_filename_char( tail++ ) == NULL) )
+    unsigned char *caret;
+    for( caret = tail; *caret; caret++ )
+      if( *caret != 'X' )
 	/*
 	 * ...bailing out, and returning nothing, if not.
 	 */
 	return NULL;
+
+    /* We then draw sufficient random bytes, to replace all six of the
+     * 'XXXXXX's, (with a margin to accommodate some rejections), in a
+     * single request; only when more than this margin of bytes must be
+     * rejected, (which is improbable), do we draw another batch.
+     */
+    while( *tail )
+    { unsigned char pool[16], *ref = pool;
+      if( crypto_randomize( pool, sizeof( pool ) ) == NULL )
+	/*
+	 * Bail out, on any failure of the sequence generator.
+	 */
+	return NULL;
+
+      /* Replace each 'X' in turn, by a character derived from the
+       * next byte value which lies within the largest possible subset
+       * yielding equal probability to each outcome, when reduced modulo
+       * the 36 available degrees of freedom.
+       */
+      do { if( *ref <= CRYPTO_FILENAME_MAX )
+	     *tail++ = crypto_filename_char( *ref );
+	 } while( *tail && (++ref < pool + sizeof( pool )) );
     }
   }
   /* Finally, when we have successfully replaced all six 'XXXXXX's,
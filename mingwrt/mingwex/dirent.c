@@ -18,7 +18,7 @@
  * Further significantly revised for improved memory utilisation,
  * efficiency in operation, and better POSIX standards compliance
  * by Keith Marshall <keithmarshall@users.sourceforge.net>
- * Copyright (C) 1997, 2001-2006, 2014, 2017, MinGW.org Project
+ * Copyright (C) 1997, 2001-2006, 2014, 2017, 2026, MinGW.org Project
  *
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
@@ -40,8 +40,17 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OF OR OTHER
  * DEALINGS IN THE SOFTWARE.
  *
+ *
+ * Each directory stream caches the entries which it has retrieved from
+ * the file system, in a compact list which is owned by the stream; this
+ * list is extended in batches, as readdir() consumes it, so that telldir()
+ * and seekdir() may simply index into it, and scandir() may use it to
+ * size its result list, before it allocates any entry.
+ *
  */
 #include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
 #include <errno.h>
 #include <string.h>
 #include <dirent.h>
@@ -64,6 +73,56 @@
 #define DIRENT_REJECT( chk, err, rtn )	\
   do { if( chk ){ errno = (err); return rtn; }} while(0)
 
+/* Directory entries are retrieved from a "directory source", which is
+ * described by a table of the following functions; the default source,
+ * used by opendir(), is the MS-Windows FindFile API, but an alternative
+ * source, (e.g. a synthetic directory, for testing), may be attached to
+ * a directory stream by calling the internal opendir_source() function,
+ * in place of opendir().  Each function takes, or yields, an opaque
+ * handle, and each entry retrieved is represented in WIN32_FIND_DATA
+ * form, of which only the cFileName and dwFileAttributes fields are
+ * required to be valid.
+ */
+typedef
+struct dirent_source
+{ /* Begin the search, as specified by the given look-up pattern,
+   * retrieving the first entry; returns a handle for use by the
+   * following functions, or INVALID_HANDLE_VALUE, with errno set,
+   * on failure.
+   */
+  void *(*findfirst)( const _TCHAR *, WIN32_FIND_DATA * );
+
+  /* Retrieve the next entry; returns a positive value on success,
+   * zero when there are no more entries, or a negative value, with
+   * errno set, when any other error occurs.
+   */
+  int (*findnext)( void *, WIN32_FIND_DATA * );
+
+  /* Release the handle; returns non-zero on success, or zero on
+   * failure.
+   */
+  int (*findclose)( void * );
+} dirent_source;
+
+/* Each entry retrieved from the directory source is cached, within the
+ * directory stream, as one of these records; the entry names are stored
+ * separately, NUL terminated, in a pool of characters which is owned by
+ * the stream, at the offsets recorded here.
+ */
+typedef
+struct dirent_entry
+{ size_t		de_offset;
+  unsigned short	de_namlen;
+  unsigned		de_type;
+} dirent_entry;
+
+/* The initial allocations, which will be expanded geometrically, as
+ * required, for the entry list, and its associated name pool; the first
+ * of these is also the number of entries retrieved, in each batch.
+ */
+#define DIRENT_BATCH_SIZE	128
+#define DIRENT_POOL_SIZE	(DIRENT_BATCH_SIZE * 32)
+
 struct __dirstream_t
 {
   /* Actual (private) declaration for opaque data type "DIR". */
@@ -74,18 +133,41 @@ struct __dirstream_t
    */
   struct dirent 	dd_dirent;
 
-  /* Handle, for use when performing FindFirstFile()/FindNextFile()
-   * file system searches.
+  /* Handle, and function table, for the directory source, (normally
+   * the FindFirstFile()/FindNextFile() API), from which entries are
+   * retrieved; the handle is set to INVALID_HANDLE_VALUE, and the
+   * source is released, as soon as it has been exhausted.
    */
   void *		dd_handle;
+  const dirent_source * dd_source;
+
+  /* The errno value reported by the source, if it failed before it was
+   * exhausted, (or zero if it did not); since the source is released on
+   * failure, this is retained, to be reported by readdir() whenever any
+   * entry beyond the point of failure is required.
+   */
+  int			dd_error;
 
-  /* Index for next FindFirstFile()/FindNextFile() entry:
-   *   0 = not started yet (next entry to read is first entry);
-   *   positive value = 0 based index of next entry to be read;
-   *   set to -1 when no more matching entries to be read.
+  /* Index, within the cached entry list, of the next entry to be
+   * returned by readdir(); this is also the telldir() location.
    */
   int			dd_index;
 
+  /* The cached entry list; "dd_count" entries have been retrieved, of
+   * a total "dd_limit" which may be stored without reallocation.
+   */
+  int			dd_count;
+  int			dd_limit;
+  dirent_entry *	dd_entry;
+
+  /* The pool in which the names of the cached entries are stored;
+   * "dd_poolsize" characters are allocated, of which "dd_poolused"
+   * have been filled.
+   */
+  size_t		dd_poolsize;
+  size_t		dd_poolused;
+  char *		dd_pool;
+
   /* File name pattern to be matched in FindFirstFile() file system
    * search; note that the actual size will be adjusted at run time,
    * causing the DIR struct to grow to accommodate the pattern.
@@ -103,17 +185,26 @@ struct __wdirstream_t
    */
   struct _wdirent	dd_dirent;
 
-  /* Handle, for use when performing FindFirstFile()/FindNextFile()
-   * file system searches.
+  /* Handle, and function table, for the directory source; as for
+   * the DIR struct, above.
    */
   void *		dd_handle;
+  const dirent_source * dd_source;
+  int			dd_error;
 
-  /* Index for next FindFirstFile()/FindNextFile() entry:
-   *   0 = not started yet (next entry to read is first entry);
-   *   positive value = 0 based index of next entry to be read;
-   *   set to -1 when no more matching entries to be read.
+  /* Index of the next entry to be returned by _wreaddir(), and the
+   * cached entry list; again, as for the DIR struct.
    */
   int			dd_index;
+  int			dd_count;
+  int			dd_limit;
+  dirent_entry *	dd_entry;
+
+  /* Pool of wide character entry names.
+   */
+  size_t		dd_poolsize;
+  size_t		dd_poolused;
+  wchar_t *		dd_pool;
 
   /* File name pattern to be matched in FindFirstFile() file system
    * search; note that the actual size will be adjusted at run time,
@@ -160,43 +251,42 @@ struct __wdirstream_t
  */
 #define NUL		((_TCHAR)(0))
 
-static
-void dirent_update( struct _tdirent *dd, WIN32_FIND_DATA *fd )
-{
-  /* Helper function, used by dirent_findfirst() and dirent_findnext(),
-   * to transfer all relevant data from their respective WIN32_FIND_DATA
-   * buffers to the specified dirent structure; in the case of the d_name
-   * field, we want the effect of a snprintf() string transfer, but to
-   * avoid the (perceptually significant) overhead of format parsing,
-   * we simulate it with an inline character-by-character counted
-   * string copy loop...
-   */
-  _TCHAR *d_name = dd->d_name;
-  for( dd->d_namlen = 0; (*d_name = fd->cFileName[dd->d_namlen]) != NUL; )
-    /*
-     * ...continuing to count input characters, until the terminal NUL,
-     * but declining to store any character beyond the physical end of
-     * the d_name field buffer.
-     */
-    if( ++dd->d_namlen < FILENAME_MAX ) ++d_name;
-
-  /* Store only those file attribute bits which are valid for d_type.
-   */
-  if( (dd->d_type = fd->dwFileAttributes & DT_VALID_BITS) > DT_DIR )
-    dd->d_type = DT_UNKNOWN;
-}
+/* From Windows-7 onwards, FindFirstFileEx() supports a "basic" info
+ * level, which omits the look-up of the 8.3 alternate file name, and a
+ * "large fetch" option, which directs FindNextFile() to retrieve entries
+ * from the file system in larger batches; neither is yet described in
+ * the w32api headers, so we must define them here.
+ */
+#define DIRENT_FIND_EX_INFO_BASIC	((FINDEX_INFO_LEVELS)(1))
+#ifndef FIND_FIRST_EX_LARGE_FETCH
+#define FIND_FIRST_EX_LARGE_FETCH	0x00000002
+#endif
 
 static
-void *dirent_findfirst( const _TCHAR *lookup, struct _tdirent *dd )
+void *dirent_findfirst( const _TCHAR *lookup, WIN32_FIND_DATA *fd )
 {
-  /* Replacement for Microsoft's _findfirst() function; it temporarily
-   * captures the result of a FindFirstFile() call in a local buffer,
-   * whence it updates the specified dirent structure, before returning
-   * an opaque handle for subsequent use by FindNextFile().
-   */
-  void *fd;
-  WIN32_FIND_DATA buf;
-  if( (fd = FindFirstFile( lookup, &buf )) == INVALID_HANDLE_VALUE )
+  /* Replacement for Microsoft's _findfirst() function; it captures the
+   * result of a FindFirstFileEx() call, in the WIN32_FIND_DATA buffer
+   * provided by the caller, before returning an opaque handle for use
+   * by FindNextFile().  Versions of Windows which predate Windows-7 will
+   * reject the basic info level, and large fetch option, as invalid; in
+   * this case, we remember that they are unsupported, and fall back to
+   * an ordinary FindFirstFile() call.
+   */
+  static int findex_unsupported = 0;
+  void *handle = INVALID_HANDLE_VALUE;
+
+  if( ! findex_unsupported
+  &&  ((handle = FindFirstFileEx( lookup, DIRENT_FIND_EX_INFO_BASIC, fd,
+	    FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH
+	  )) == INVALID_HANDLE_VALUE)
+  &&  (GetLastError() == ERROR_INVALID_PARAMETER)  )
+    findex_unsupported = 1;
+
+  if( findex_unsupported )
+    handle = FindFirstFile( lookup, fd );
+
+  if( handle == INVALID_HANDLE_VALUE )
   {
     /* The look-up failed: set errno accordingly; (note that this
      * requires mapping of some system error codes to the equivalent
@@ -211,59 +301,37 @@ void *dirent_findfirst( const _TCHAR *lookup, struct _tdirent *dd )
     else if( errno != ENOENT )
       errno = EINVAL;
   }
-  else
-    /* The look-up was successful: update the dirent structure.
-     */
-    dirent_update( dd, &buf );
 
   /* Ultimately, return the (possibly invalid) search handle
-   * which FindFirstFile() has given us.
+   * which FindFirstFileEx() has given us.
    */
-  return fd;
+  return handle;
 }
 
-#define DIRENT_OPEN(D)	\
-    ((D)->dd_handle = dirent_findfirst((D)->dd_name, &((D)->dd_dirent)))
-
 static
-int dirent_findnext( void *fd, struct _tdirent *dd )
+int dirent_findnext( void *handle, WIN32_FIND_DATA *fd )
 {
-  /* Replacement for Microsoft's _findnext() function; it temporarily
-   * captures the result of calling FindNextFile() in a local buffer,
-   * whence it updates the specified dirent structure, before returning
-   * an appropriate status value.
-   */
-  int status;
-  WIN32_FIND_DATA buf;
-  if( (status = FindNextFile( fd, &buf )) != 0 )
-  {
-    /* The look-up was successful; update the dirent structure, and
-     * immediately return the (non-zero) status.
-     */
-    dirent_update( dd, &buf );
-    return status;
-  }
+  /* Replacement for Microsoft's _findnext() function; it captures the
+   * result of calling FindNextFile(), in the WIN32_FIND_DATA buffer
+   * provided by the caller, before returning an appropriate status.
+   */
+  if( FindNextFile( handle, fd ) )
+    return 1;
 
   /* If we get to here, the look-up was unsuccessful.  This may be
    * simply because there are no more files to find...
    */
-  else if( (status = GetLastError()) != ERROR_NO_MORE_FILES )
-    /*
-     * ...but in any other case, we must update errno to reflect
-     * an invalid position within the directory stream; (POSIX
-     * prescribes ENOENT, for this error condition).
-     */
-    errno = ENOENT;
+  if( GetLastError() == ERROR_NO_MORE_FILES )
+    return 0;
 
-  /* In any case, for an unsuccessful look-up we always return
-   * an effective status code of zero.
+  /* ...but in any other case, we must update errno to reflect
+   * an invalid position within the directory stream; (POSIX
+   * prescribes ENOENT, for this error condition).
    */
-  return 0;
+  errno = ENOENT;
+  return -1;
 }
 
-#define DIRENT_UPDATE(D)  \
-    dirent_findnext( (D)->dd_handle, &((D)->dd_dirent) )
-
 /* For consistency, we also provide this simple wrapper for Microsoft's
  * FindClose() function, to clean up residual context from our replaced
  * _findfirst() and _findnext() functions.
@@ -271,6 +339,173 @@ int dirent_findnext( void *fd, struct _tdirent *dd )
 static __inline__ __attribute__((__always_inline__))
 int dirent_findclose( void *fd ){ return FindClose( fd ); }
 
+/* Collectively, the preceding functions represent the default directory
+ * source, which is used by opendir().
+ */
+static const dirent_source dirent_findfile =
+{ dirent_findfirst, dirent_findnext, dirent_findclose };
+
+/* The internal opendir_source() function has distinct names, in each
+ * of the ASCII, and UTF-16LE, builds of this module.
+ */
+#ifdef _UNICODE
+# define _topendir_source  _wopendir_source
+#else
+# define _topendir_source  opendir_source
+#endif
+
+static
+int dirent_reserve( _TDIR *dirp )
+{
+  /* Helper function, to ensure that the cached entry list, and its name
+   * pool, can each accommodate at least one more entry, (with a name of
+   * the greatest length which WIN32_FIND_DATA can represent); returns
+   * zero on success, or -1, with errno set to ENOMEM, on failure.
+   */
+  if( dirp->dd_count == dirp->dd_limit )
+  {
+    /* The entry list is full; double its allocation.
+     */
+    int limit = (dirp->dd_limit > 0) ? dirp->dd_limit << 1 : DIRENT_BATCH_SIZE;
+    dirent_entry *entry = realloc( dirp->dd_entry, limit * sizeof( dirent_entry ) );
+    DIRENT_REJECT( (entry == NULL), ENOMEM, -1 );
+    dirp->dd_entry = entry; dirp->dd_limit = limit;
+  }
+  if( (dirp->dd_poolsize - dirp->dd_poolused) < MAX_PATH )
+  {
+    /* The name pool may be unable to accommodate another name; again,
+     * double its allocation.
+     */
+    size_t size = (dirp->dd_poolsize > 0) ? dirp->dd_poolsize << 1 : DIRENT_POOL_SIZE;
+    _TCHAR *pool = realloc( dirp->dd_pool, size * sizeof( _TCHAR ) );
+    DIRENT_REJECT( (pool == NULL), ENOMEM, -1 );
+    dirp->dd_pool = pool; dirp->dd_poolsize = size;
+  }
+  return 0;
+}
+
+static
+void dirent_store( _TDIR *dirp, WIN32_FIND_DATA *fd )
+{
+  /* Helper function, to append the entry described by a WIN32_FIND_DATA
+   * record, (as retrieved from the directory source), to the cached entry
+   * list; the caller must have reserved space for it, by dirent_reserve().
+   */
+  dirent_entry *entry = dirp->dd_entry + dirp->dd_count++;
+  size_t namlen = _tcslen( fd->cFileName );
+
+  entry->de_offset = dirp->dd_poolused;
+  entry->de_namlen = namlen;
+  memcpy( dirp->dd_pool + dirp->dd_poolused, fd->cFileName,
+      (namlen + 1) * sizeof( _TCHAR )
+    );
+  dirp->dd_poolused += namlen + 1;
+
+  /* Store only those file attribute bits which are valid for d_type.
+   */
+  if( (entry->de_type = fd->dwFileAttributes & DT_VALID_BITS) > DT_DIR )
+    entry->de_type = DT_UNKNOWN;
+}
+
+static
+int dirent_release( _TDIR *dirp )
+{
+  /* Helper function, to release the directory source, if it remains
+   * active; returns the status reported by the source, (i.e. non-zero
+   * on success), or one, if the source had already been released.
+   */
+  int status = 1;
+  if( dirp->dd_handle != INVALID_HANDLE_VALUE )
+  { status = dirp->dd_source->findclose( dirp->dd_handle );
+    dirp->dd_handle = INVALID_HANDLE_VALUE;
+  }
+  return status;
+}
+
+static
+int dirent_fetch( _TDIR *dirp, int want )
+{
+  /* Helper function, to retrieve entries from the directory source,
+   * appending them to the cached entry list, until at least "want"
+   * entries are cached, or the source is exhausted, (whereupon it is
+   * released immediately).  Returns zero on success, or -1, with errno
+   * set, if the cache cannot grow, or if fewer than "want" entries are
+   * available because the source reported an error, (whether during
+   * this call, or any earlier call).
+   */
+  WIN32_FIND_DATA fd;
+  while( (dirp->dd_count < want) && (dirp->dd_handle != INVALID_HANDLE_VALUE) )
+  {
+    int status;
+    if( dirent_reserve( dirp ) != 0 )
+      return -1;
+
+    if( (status = dirp->dd_source->findnext( dirp->dd_handle, &fd )) > 0 )
+      dirent_store( dirp, &fd );
+
+    else
+    { dirent_release( dirp );
+      if( status < 0 ) dirp->dd_error = errno;
+    }
+  }
+  if( (dirp->dd_count < want) && (dirp->dd_error != 0) )
+  { errno = dirp->dd_error;
+    return -1;
+  }
+  return 0;
+}
+
+static
+int dirent_open( _TDIR *dirp )
+{
+  /* Helper function, used by opendir() and rewinddir(), to discard any
+   * previously cached entries, (while retaining their storage), then to
+   * (re)start the search of the directory source, retrieving the first
+   * entry, and as many of those following, as will complete the first
+   * batch; returns zero on success, or -1, with errno set, on failure.
+   */
+  WIN32_FIND_DATA fd;
+  dirp->dd_index = dirp->dd_count = 0;
+  dirp->dd_poolused = 0;
+  dirp->dd_error = 0;
+
+  if( dirent_reserve( dirp ) != 0 )
+    return -1;
+
+  if( (dirp->dd_handle = dirp->dd_source->findfirst( dirp->dd_name, &fd ))
+      == INVALID_HANDLE_VALUE  )
+    return -1;
+
+  /* We have the first entry; (any failure in retrieving the remainder of
+   * the first batch need not be reported yet; dirent_fetch() records it,
+   * and readdir() will report it, only when the failed entry is required).
+   */
+  dirent_store( dirp, &fd );
+  dirent_fetch( dirp, DIRENT_BATCH_SIZE );
+  return 0;
+}
+
+static
+struct _tdirent *dirent_update( _TDIR *dirp, int index )
+{
+  /* Helper function, used by readdir() and scandir(), to transfer all
+   * relevant data for the cached entry at "index", to the dirent struct
+   * which is encapsulated within the directory stream; since the length
+   * of the name is already known, (and cannot exceed the FILENAME_MAX
+   * capacity of d_name, since cFileName is limited to MAX_PATH, which
+   * is the same), it may be copied in its entirety, by memcpy().
+   */
+  dirent_entry *entry = dirp->dd_entry + index;
+  struct _tdirent *dd = &dirp->dd_dirent;
+
+  dd->d_namlen = entry->de_namlen;
+  dd->d_type = entry->de_type;
+  memcpy( dd->d_name, dirp->dd_pool + entry->de_offset,
+      (entry->de_namlen + 1) * sizeof( _TCHAR )
+    );
+  return dd;
+}
+
 
 /*****
  *
@@ -281,7 +516,8 @@ int dirent_findclose( void *fd ){ return FindClose( fd ); }
  *
  */
 _TDIR *
-__mingw_impl__(_topendir)( const _TCHAR *path_name )
+__mingw_impl__(_topendir_source)
+( const _TCHAR *path_name, const dirent_source *source )
 {
   _TDIR *nd;
   _TCHAR abs_path[MAX_PATH];
@@ -344,34 +580,33 @@ __mingw_impl__(_topendir)( const _TCHAR *path_name )
   DIRENT_REJECT( (nd == NULL), ENOMEM, (_TDIR *)(NULL) );
 
   /* Copy the extended absolute path name string into place
-   * within the allocated space for the DIR structure.
+   * within the allocated space for the DIR structure, attach
+   * the directory source, and mark the entry cache as empty,
+   * (with no storage yet allocated).
    */
   _tcscpy( nd->dd_name, abs_path );
+  nd->dd_source = source;
+  nd->dd_entry = NULL; nd->dd_limit = 0;
+  nd->dd_pool = NULL; nd->dd_poolsize = 0;
 
-  /* Initialize the "directory stream", by calling dirent_findfirst()
-   * on it; this leaves the data for the first directory entry in the
-   * internal dirent buffer, ready to be retrieved by readdir().
+  /* Initialize the "directory stream", by calling dirent_open() on
+   * it; this leaves the data for the first batch of directory entries
+   * in the entry cache, with the location index set to zero, so that
+   * readdir() will begin by returning the first entry.
    */
-  if( DIRENT_OPEN( nd ) == INVALID_HANDLE_VALUE )
+  if( dirent_open( nd ) != 0 )
     {
-      /* The dirent_findfirst() call, (implied by DIRENT_OPEN), failed;
-       * this will already have set errno appropriately, and we should
-       * now prepare to return a NULL "directory stream" pointer; since
-       * this implies that we will lose our reference pointer to the
-       * block of memory we allocated for the stream, we must free
-       * that before we bail out.
+      /* The dirent_open() call failed; this will already have set
+       * errno appropriately, and we should now prepare to return a
+       * NULL "directory stream" pointer; since this implies that we
+       * will lose our reference pointer to the block of memory we
+       * allocated for the stream, (and to any cache storage), we
+       * must free that before we bail out.
        */
-      free( nd );
+      free( nd->dd_entry ); free( nd->dd_pool ); free( nd );
       return (_TDIR *)(NULL);
     }
 
-  /* Initialize the status, (i.e. the location index), so that readdir()
-   * will simply return the first directory entry, which has already been
-   * fetched by dirent_findfirst(), without performing an intervening
-   * dirent_findnext() call.
-   */
-  nd->dd_index = 0;
-
   /* The d_ino field has no relevance in MS-Windows; initialize it
    * to zero, as a one-time assignment for this DIR instance, and
    * henceforth forget them; (users should simply ignore it).
@@ -395,6 +630,15 @@ __mingw_impl__(_topendir)( const _TCHAR *path_name )
   return nd;
 }
 
+_TDIR *
+__mingw_impl__(_topendir)( const _TCHAR *path_name )
+{
+  /* The standard opendir() API retrieves directory entries from the
+   * default FindFirstFile()/FindNextFile() directory source.
+   */
+  return __mingw_impl__(_topendir_source)( path_name, &dirent_findfile );
+}
+
 
 /*****
  *
@@ -414,22 +658,22 @@ __mingw_impl__(_treaddir)( _TDIR *dirp )
    */
   DIRENT_REJECT( (dirp == NULL), EBADF, (struct _tdirent *)(NULL) );
 
-  /* Okay to proceed.  Unless this is the first readdir() request
-   * following an opendir(), or a rewinddir(), (in which case the
-   * current location index will be zero, and the requisite return
-   * information will have been established already), we need to
-   * update the DIR stream data, retrieving the data for the next
-   * directory entry...
+  /* Okay to proceed.  If we have already returned every cached entry,
+   * then we must retrieve another batch from the directory source...
    */
-  if( (dirp->dd_index++ > 0) && (DIRENT_UPDATE( dirp ) == 0) )
-    /*
-     * ...bailing out, if no such data is retrievable...
-     */
+  if( dirp->dd_index >= dirp->dd_count )
+    dirent_fetch( dirp, dirp->dd_index + DIRENT_BATCH_SIZE );
+
+  /* ...bailing out, if no further entry is retrievable; (if this is
+   * because the source failed, dirent_fetch() has set errno, so that
+   * the caller may distinguish this from the end of the stream)...
+   */
+  if( dirp->dd_index >= dirp->dd_count )
     return (struct _tdirent *)(NULL);
 
   /* ...otherwise, returning the requisite data pointer.
    */
-  return &dirp->dd_dirent;
+  return dirent_update( dirp, dirp->dd_index++ );
 }
 
 
@@ -450,14 +694,15 @@ __mingw_impl__(_tclosedir)( _TDIR * dirp )
    * anomalous use of EFAULT in this context.
    */
   DIRENT_REJECT(
-      ((dirp == NULL) || (dirent_findclose( dirp->dd_handle ) == 0)),
-	EBADF, -1
+      ((dirp == NULL) || (dirent_release( dirp ) == 0)), EBADF, -1
     );
 
   /* If we didn't bail out above, we have a valid DIR structure
    * with which we have finished; release the memory allocated
-   * to it, before returning "success".
+   * to it, and to its entry cache, before returning "success".
    */
+  free( dirp->dd_entry );
+  free( dirp->dd_pool );
   free( dirp );
   return 0;
 }
@@ -468,9 +713,10 @@ __mingw_impl__(_tclosedir)( _TDIR * dirp )
  * rewinddir()
  *
  * Return to the beginning of the directory "stream".  We simply call
- * dirent_findclose(), to clear prior context, then dirent_findfirst()
- * to restart the directory search, resetting the location index as it
- * would have been left by opendir().
+ * dirent_release(), to clear prior context, then dirent_open() to
+ * restart the directory search, discarding all cached entries, so
+ * that the stream will reflect the current state of the directory,
+ * as POSIX requires.
  *
  */
 void
@@ -484,17 +730,15 @@ __mingw_impl__(_trewinddir)( _TDIR * dirp )
    * than the EFAULT of previous versions.
    */
   DIRENT_REJECT(
-      ((dirp == NULL) || (dirent_findclose( dirp->dd_handle ) == 0)),
+      ((dirp == NULL) || (dirent_release( dirp ) == 0)),
 	EBADF, DIRENT_RETURN_NOTHING
     );
 
-  /* We successfully closed the prior search context; reopen...
+  /* We successfully closed the prior search context; reopen it, (and
+   * should this fail, the entry cache will have been left empty, so any
+   * subsequent readdir() will simply report the end of the stream).
    */
-  if( DIRENT_OPEN( dirp ) != INVALID_HANDLE_VALUE )
-    /*
-     * ...and, on success, reset the location index.
-     */
-    dirp->dd_index = 0;
+  dirent_open( dirp );
 }
 
 
@@ -528,13 +772,13 @@ __mingw_impl__(_ttelldir)( _TDIR * dirp )
  *
  * seekdir()
  *
- * Seek to an entry previously returned by telldir().  We rewind
- * the "directory stream", then repeatedly call dirent_findnext()
- * while incrementing its internal location index until it matches
- * the position requested, or we reach the end of the stream.  This
- * is not perfect, in that the directory may have changed while we
- * weren't looking, but it is the best we can achieve, and may
- * likely reproduce the behaviour of other implementations.
+ * Seek to an entry previously returned by telldir().  Since every
+ * entry which has been read remains in the entry cache, and telldir()
+ * cannot have returned a location beyond the end of the cache, we may
+ * simply reset the location index; however, for robustness, we also
+ * accept a location beyond the cache, retrieving further entries as
+ * necessary, and stopping at the end of the stream, should the given
+ * location lie beyond it.
  *
  */
 void
@@ -546,21 +790,123 @@ __mingw_impl__(_tseekdir)( _TDIR * dirp, long loc )
    */
   DIRENT_REJECT( (loc < 0L), EINVAL, DIRENT_RETURN_NOTHING );
 
-  /* Other than this, we simply accept any error condition
-   * which arises as we "rewind" the "directory stream"...
+  /* ...and, as elsewhere, we reject a NULL stream as EBADF.
+   */
+  DIRENT_REJECT( (dirp == NULL), EBADF, DIRENT_RETURN_NOTHING );
+
+  if( loc > dirp->dd_count )
+    dirent_fetch( dirp, (loc < INT_MAX) ? (int)(loc) : INT_MAX );
+
+  dirp->dd_index = (loc < dirp->dd_count) ? (int)(loc) : dirp->dd_count;
+}
+
+
+/*****
+ *
+ * scandir()
+ *
+ * Scan an entire directory, returning a list of those entries which
+ * are selected by a filter function, optionally sorted into the order
+ * determined by a comparison function.
+ *
+ */
+int
+__mingw_impl__(_tscandir)
+( const _TCHAR *path_name, struct _tdirent ***namelist,
+  int (*filter)( const struct _tdirent * ),
+  int (*compare)( const struct _tdirent **, const struct _tdirent ** )
+)
+{
+  struct _tdirent **list = NULL;
+  int count = 0, index, status = 0, errcode;
+  _TDIR *dirp;
+
+  /* As for opendir(), we reject a NULL pointer for the result list,
+   * rather than allowing a segmentation fault.
    */
-  __mingw_impl__(_trewinddir)( dirp );
+  DIRENT_REJECT( (namelist == NULL), EINVAL, -1 );
+
+  if( (dirp = __mingw_impl__(_topendir)( path_name )) == NULL )
+    return -1;
 
-  /* ...and, if this is successful...
+  /* Retrieve every entry into the cache of the directory stream; this
+   * costs no more than reading the directory by readdir(), but it tells
+   * us how many entries there are, so that we may allocate the result
+   * list, (sufficient for the case that every entry is selected), before
+   * we allocate storage for any individual entry.
    */
-  if( (loc > 0) && (dirp->dd_handle != INVALID_HANDLE_VALUE) )
-    /*
-     * ...seek forward until the location index within
-     * the DIR structure matches the requested location.
+  if( (dirent_fetch( dirp, INT_MAX ) != 0)
+  ||  ((list = malloc( (dirp->dd_count + 1) * sizeof( *list ) )) == NULL)  )
+    status = -1;
+
+  else for( index = 0; index < dirp->dd_count; index++ )
+  {
+    /* Offer each cached entry to the filter, (in the same dirent form
+     * as readdir() would have returned it), and store each selected
+     * entry, in a dirent struct which is truncated to the length of its
+     * name; (d_reclen reflects the truncated size).
      */
-    while( (++dirp->dd_index < loc)
-      &&   (DIRENT_UPDATE( dirp ) != 0)  )
-      ;
+    struct _tdirent *dd = dirent_update( dirp, index ), *entry;
+    size_t size = offsetof( struct _tdirent, d_name )
+      + (dd->d_namlen + 1) * sizeof( _TCHAR );
+
+    if( (filter != NULL) && (filter( dd ) == 0) )
+      continue;
+
+    if( (entry = malloc( size )) == NULL )
+    { status = -1;
+      break;
+    }
+    memcpy( entry, dd, size );
+    entry->d_reclen = size;
+    list[count++] = entry;
+  }
+
+  /* We have no further use for the directory stream; (if the malloc()
+   * failure case above left errno set to ENOMEM, then we must preserve
+   * that, through the closedir() call).
+   */
+  errcode = errno;
+  __mingw_impl__(_tclosedir)( dirp );
+  errno = errcode;
+
+  if( status != 0 )
+  { /* We failed to allocate storage for the result list, or for any
+     * of its entries; we must release any storage which we did manage
+     * to allocate, before bailing out.
+     */
+    while( count > 0 ) free( list[--count] );
+    free( list );
+    return -1;
+  }
+
+  /* When a comparison function has been specified, sort the result
+   * list, (using our own qsort() implementation); finally, return it,
+   * and the count of the entries which it contains.
+   */
+  if( (compare != NULL) && (count > 1) )
+    __mingw_qsort( list, count, sizeof( *list ),
+	(int (*)(const void *, const void *))(compare)
+      );
+
+  *namelist = list;
+  return count;
+}
+
+
+/*****
+ *
+ * alphasort()
+ *
+ * Comparison function, for use with scandir(); it orders entries
+ * by their names, in the collating sequence of the current locale.
+ *
+ */
+int
+__mingw_impl__(_talphasort)
+( const struct _tdirent **a, const struct _tdirent **b )
+{
+  return _tcscoll( (*a)->d_name, (*b)->d_name );
 }
 
 /* $RCSfile$: end of file */
@@ -7,7 +7,7 @@
  * $Id$
  *
  * Written by Keith Marshall <keith@users.osdn.me>
- * Copyright (C) 2014, 2021, MinGW.org Project
+ * Copyright (C) 2014, 2021, 2026, MinGW.org Project
  *
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
@@ -42,6 +42,7 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <limits.h>
 
 /* In addition to normal C runtime services, this implementation requires
@@ -257,6 +258,157 @@ typedef struct dltab
  */
 static dltab rtld = { 0, NULL, NULL };
 
+/* Access to the global modules list, and to the symbol cache which is
+ * associated with it, (see below), is serialized by this simple spin
+ * lock; note that we never hold it while calling any function, such as
+ * LoadLibrary(), FreeLibrary(), or GetProcAddress(), which may acquire
+ * the MS-Windows loader lock, since a DllMain() function, running with
+ * the loader lock held, may itself call dlsym().
+ */
+static volatile LONG dlfcn_lock_state = 0;
+
+static __inline__ void dlfcn_lock( void )
+{ while( InterlockedCompareExchange( &dlfcn_lock_state, 1, 0 ) != 0 ) Sleep( 0 ); }
+
+static __inline__ void dlfcn_unlock( void )
+{ InterlockedExchange( &dlfcn_lock_state, 0 ); }
+
+/* The results of RTLD_DEFAULT, and RTLD_ALL_GLOBAL, searches are cached
+ * in an open addressed hash table, keyed on the symbol name, and on the
+ * class of search; each entry records the slot, in the global modules
+ * list, of the module in which the symbol was found, (or rtld.slots, if
+ * it was not found), so that any subsequent RTLD_NEXT search may resume
+ * from the following slot.  Every entry is invalidated, whenever dlopen()
+ * or dlclose() modifies the global modules list; however, since we have
+ * no knowledge of any module which the application may unload, without
+ * dlclose(), a symbol which was found in a module which we did not load
+ * is cached together with the handle of the module which maps it, and
+ * it is reused only after verifying that this module still maps it.
+ */
+typedef struct dlsym_cache_entry
+{ char		*name;
+  uint32_t	 hash;
+  unsigned char  exclude;
+  unsigned int	 index;
+  void		*symbol;
+  HMODULE	 owner;
+} dlsym_cache_entry;
+
+typedef
+/* A pointer type, representing a reference to the GetModuleHandleExW()
+ * function, (which is not available before WinXP, so must be resolved
+ * at run time), through which such verification is performed.
+ */
+BOOL WINAPI (*owner_fn)( DWORD, LPCWSTR, HMODULE * );
+
+static owner_fn dlsym_owner_fn = NULL;
+
+static HMODULE dlsym_owner( void *symbol )
+{
+  /* Helper to identify the module which maps the address of "symbol",
+   * without changing its reference count; returns NULL, if there is no
+   * such module, or if GetModuleHandleExW() is unavailable.  This calls
+   * into the loader, so must not be called while holding the dlfcn lock.
+   */
+  HMODULE owner;
+  if( (dlsym_owner_fn != NULL) && dlsym_owner_fn(
+	GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS
+	| GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+	(LPCWSTR)(symbol), &owner )  )
+    return owner;
+  return NULL;
+}
+
+#define DLSYM_CACHE_MINSIZE	64
+
+static struct
+{ unsigned int		 size;
+  unsigned int		 used;
+  unsigned int		 generation;
+  dlsym_cache_entry	*entry;
+} dlsym_cache = { 0, 0, 0, NULL };
+
+static uint32_t dlsym_hash( const char *name )
+{
+  /* Compute the (32-bit FNV-1a) hash of a symbol name, for indexing
+   * into the symbol cache.
+   */
+  uint32_t hash = 2166136261U;
+  while( *name != '\0' ) hash = (hash ^ (unsigned char)(*name++)) * 16777619U;
+  return hash;
+}
+
+static dlsym_cache_entry *dlsym_cache_slot
+( const char *name, uint32_t hash, unsigned char exclude )
+{
+  /* Locate the symbol cache entry for the given name, and class of
+   * search, or the vacant slot in which it should be stored; the cache
+   * must have been allocated, and never becomes more than half full, so
+   * there is always a vacant slot, at which the probe will terminate.
+   */
+  unsigned int mask = dlsym_cache.size - 1, index = hash & mask;
+  dlsym_cache_entry *entry;
+  while( (entry = dlsym_cache.entry + index)->name != NULL )
+  { if( (entry->hash == hash) && (entry->exclude == exclude)
+    &&  (strcmp( entry->name, name ) == 0)  ) return entry;
+    index = (index + 1) & mask;
+  }
+  return entry;
+}
+
+static void dlsym_cache_store
+( const char *name, uint32_t hash, unsigned char exclude, unsigned int index,
+  void *symbol, HMODULE owner
+)
+{
+  /* Record the result of a global symbol search, in the symbol cache;
+   * (since the cache serves only to accelerate subsequent searches, any
+   * failure to allocate memory for it may be silently ignored).
+   */
+  dlsym_cache_entry *entry;
+  if( (2 * (dlsym_cache.used + 1)) > dlsym_cache.size )
+  {
+    /* Adding an entry would cause the cache to become more than half
+     * full; double its size, and rehash all existing entries.
+     */
+    unsigned int size = dlsym_cache.size, slot;
+    dlsym_cache_entry *old = dlsym_cache.entry;
+    if( (entry = calloc( size ? size << 1 : DLSYM_CACHE_MINSIZE,
+	    sizeof( dlsym_cache_entry ) )) == NULL  )
+      return;
+
+    dlsym_cache.entry = entry;
+    dlsym_cache.size = size ? size << 1 : DLSYM_CACHE_MINSIZE;
+    for( slot = 0; slot < size; slot++ )
+      if( old[slot].name != NULL )
+	*dlsym_cache_slot( old[slot].name, old[slot].hash, old[slot].exclude )
+	  = old[slot];
+    free( old );
+  }
+  if( (entry = dlsym_cache_slot( name, hash, exclude ))->name == NULL )
+  { if( (entry->name = strdup( name )) == NULL ) return;
+    ++dlsym_cache.used;
+  }
+  entry->hash = hash; entry->exclude = exclude;
+  entry->index = index; entry->symbol = symbol; entry->owner = owner;
+}
+
+static void dlsym_cache_flush( void )
+{
+  /* Invalidate all symbol cache entries, (retaining the memory which
+   * has been allocated for the cache itself, for reuse); the generation
+   * count identifies any search which was in progress, at the time of
+   * invalidation, so that its result will not be cached.
+   */
+  unsigned int slot;
+  for( slot = 0; slot < dlsym_cache.size; slot++ )
+  { free( dlsym_cache.entry[slot].name );
+    dlsym_cache.entry[slot].name = NULL;
+  }
+  dlsym_cache.used = 0;
+  ++dlsym_cache.generation;
+}
+
 /* Microsoft's LoadLibrary() API is explicitly documented as being
  * unable to handle regular slashes as directory separators in module
  * path names, (in spite of their validity elsewhere), thus...
@@ -320,8 +472,9 @@ static void *dlopen_internal( const char *name, int mode )
      * that it is allocated a slot in our global symbol table, but we
      * must first check that it isn't already present.
      */
-    int index, insertion_point = rtld.slots;
-    for( index = 0; index < rtld.slots; index++ )
+    int index, insertion_point;
+    dlfcn_lock();
+    for( index = 0, insertion_point = rtld.slots; index < rtld.slots; index++ )
     {
       /* As we scan the list of already loaded modules, check for any
        * existing slot which may be vacant...
@@ -336,19 +489,22 @@ static void *dlopen_internal( const char *name, int mode )
       }
       else if( module == rtld.modules[index] )
       {
-	/* The requested module appears to be loaded already; calling
-	 * LoadLibrary() will have increased its reference count, but
-	 * our management strategy doesn't require this; reduce it...
+	/* The requested module appears to be loaded already; promote
+	 * its existing status to RTLD_GLOBAL, if that is indicated as
+	 * required by the requested mode, (and this is a change, which
+	 * must invalidate the symbol cache)...
 	 */
-	FreeLibrary( module );
+	if( (mode & RTLD_GLOBAL & ~rtld.flags[index]) != 0 )
+	{ rtld.flags[index] |= RTLD_GLOBAL;
+	  dlsym_cache_flush();
+	}
+	dlfcn_unlock();
 	/*
-	 * ...but promote its existing status to RTLD_GLOBAL, if that
-	 * is indicated as required by the requested mode...
-	 */
-	rtld.flags[index] |= mode & RTLD_GLOBAL;
-	/*
-	 * ...and immediately return the module handle.
+	 * ...while noting that calling LoadLibrary() will have increased
+	 * its reference count, but our management strategy doesn't require
+	 * this; reduce it, and immediately return the module handle.
 	 */
+	FreeLibrary( module );
 	return module;
       }
     }
@@ -440,6 +596,7 @@ static void *dlopen_internal( const char *name, int mode )
 	 * record an appropriate diagnostic message, (but we note that
 	 * this may also fail, due to insufficient memory).
 	 */
+	dlfcn_unlock();
 	FreeLibrary( module );
 	dlopen_store_error_message( name, ERROR_OUTOFMEMORY );
 	return NULL;
@@ -452,6 +609,12 @@ static void *dlopen_internal( const char *name, int mode )
      */
     rtld.flags[insertion_point] = RTLD_EXPLICIT | mode;
     rtld.modules[insertion_point] = module;
+
+    /* Since the content of the global modules list has now changed, we
+     * must also invalidate the symbol cache.
+     */
+    dlsym_cache_flush();
+    dlfcn_unlock();
   }
   /* Finally, we return whatever module handle we got from LoadLibrary(),
    * (which may be NULL, if this failed).
@@ -459,14 +622,85 @@ static void *dlopen_internal( const char *name, int mode )
   return module;
 }
 
+/* Symbols are looked up by reading the export directory of a module
+ * directly, (see peexport.c), rather than by GetProcAddress(), only when
+ * that module was loaded by dlopen(), (i.e. it has the RTLD_EXPLICIT
+ * attribute); we then hold a reference to it, which dlclose() will not
+ * release until after the module has been removed from the global list,
+ * so its export directory cannot be unmapped while we read it.  Modules
+ * which were enumerated by dlfcn_init() carry no such guarantee, (since
+ * the application may unload any of them, by FreeLibrary()), so for these,
+ * as for forwarded symbols, and any symbol which is specified by ordinal,
+ * rather than by name, (i.e. with a "name" pointer whose high order 16-bits
+ * are zero), we must defer to GetProcAddress().
+ */
+void *__mingw_pe_export_lookup( const void *, const char *, const char ** );
+#define DLSYM_IS_ORDINAL( NAME )  ((((uintptr_t)(NAME)) >> 16) == 0)
+
+/* The state of the most recent global search, within each thread, from
+ * which a subsequent RTLD_NEXT search may continue.
+ */
+static __thread struct
+{ const char	*name;
+  unsigned int	 index;
+  unsigned char  exclude;
+} dlsym_next = { NULL, 0, 0 };
+
+static int dlsym_explicit( void *module )
+{
+  /* Helper to check whether a module handle is listed as active, in the
+   * global modules list, with the RTLD_EXPLICIT attribute; (the caller
+   * must hold the dlfcn lock).
+   */
+  unsigned int index;
+  for( index = 0; index < rtld.slots; index++ )
+    if( ((rtld.flags[index] & RTLD_EXPLICIT) == RTLD_EXPLICIT)
+    &&  (module == rtld.modules[index])  )
+      return 1;
+  return 0;
+}
+
+static void *dlsym_search
+( const char *name, unsigned int *index, unsigned char exclude, HMODULE *defer )
+{
+  /* Helper to perform an in-order traversal of the global modules list,
+   * starting from slot "*index", and considering only those modules which
+   * have the RTLD_GLOBAL attribute, and none of the "exclude" attributes,
+   * until the named symbol is found, (whereupon "*index" identifies the
+   * slot in which it was found), or all modules have been searched.  The
+   * caller must hold the dlfcn lock; should it be necessary to resolve the
+   * symbol by GetProcAddress(), which may not be called while that lock is
+   * held, (as it must be for any module without the RTLD_EXPLICIT attribute),
+   * NULL is returned, with the module handle stored in "*defer".
+   */
+  const char *forwarder;
+  for( *defer = NULL; *index < rtld.slots; ++*index )
+    if( ((exclude & rtld.flags[*index]) == 0)
+    &&  ((rtld.flags[*index] & RTLD_GLOBAL) == RTLD_GLOBAL)  )
+    {
+      void *rtn;
+      if( DLSYM_IS_ORDINAL( name )
+      ||  ((rtld.flags[*index] & RTLD_EXPLICIT) != RTLD_EXPLICIT)  )
+	return (*defer = rtld.modules[*index]), NULL;
+
+      if( (rtn = __mingw_pe_export_lookup( rtld.modules[*index], name,
+	      &forwarder )) != NULL  )
+	return rtn;
+
+      if( forwarder != NULL )
+	return (*defer = rtld.modules[*index]), NULL;
+    }
+  return NULL;
+}
+
 static void *dlsym_internal( void *module, const char *name )
 {
   /* This is the formal implementation of the public dlsym() function.
    */
-  static unsigned int index = 0;
-  static const char *last_named_symbol = NULL;
-  static unsigned char rtld_exclude = 0;
-  void *rtn;
+  unsigned int index = 0;
+  unsigned char rtld_exclude = 0;
+  HMODULE defer = NULL;
+  void *rtn = NULL;
 
   if( module == RTLD_NEXT )
   {
@@ -475,12 +709,13 @@ static void *dlsym_internal( void *module, const char *name )
      * POSIX doesn't require this to be supported yet, but reserves it
      * for future use; it should cause dlsym() to repeat its search for
      * the named symbol, (provided it remains the same as last named in
-     * a global search), continuing from the next module in the current
-     * search order, following that in which the symbol was previously
-     * found; (this permits us to locate symbols which may defined in
-     * more than one loaded module).
+     * a global search, by the calling thread), continuing from the next
+     * module in the current search order, following that in which the
+     * symbol was previously found; (this permits us to locate symbols
+     * which may defined in more than one loaded module).
      */
-    index = (name == last_named_symbol) ? index + 1 : 0;
+    index = (name == dlsym_next.name) ? dlsym_next.index + 1 : 0;
+    rtld_exclude = dlsym_next.exclude;
     module = RTLD_ALL_GLOBAL;
   }
   else if( module == RTLD_DEFAULT )
@@ -497,13 +732,7 @@ static void *dlsym_internal( void *module, const char *name )
      */
     module = RTLD_ALL_GLOBAL;
     rtld_exclude = RTLD_EXPLICIT;
-    index = 0;
   }
-  else
-    /* Neither RTLD_DEFAULT, nor RTLD_NEXT was specified; we must reset
-     * the RTLD_GLOBAL search index, and cancel all search exclusions.
-     */
-    index = rtld_exclude = 0;
 
   if( module == RTLD_ALL_GLOBAL )
   {
@@ -512,31 +741,103 @@ static void *dlsym_internal( void *module, const char *name )
      * address space, either implicitly loaded, or explicitly loaded
      * with the RTLD_GLOBAL mode attribute, either until the named
      * symbol is found, or all such modules have been searched
-     * without finding it.
-     */ 
-    for( rtn = NULL; (rtn == NULL) && (index < rtld.slots); index++ )
-      if( ((rtld_exclude & rtld.flags[index]) == 0)
-      &&  ((rtld.flags[index] & RTLD_GLOBAL) == RTLD_GLOBAL)  )
-	rtn = GetProcAddress( rtld.modules[index], name );
-
-    /* Note the symbol named in the current search, so that we may
-     * check for consistency in the event that the next search is
-     * invoked as an RTLD_NEXT request.
+     * without finding it.  Unless this continues a previous search,
+     * (or the symbol is specified by ordinal), the result may already
+     * be available, in the symbol cache.
+     */
+    int cacheable = (index == 0) && ! DLSYM_IS_ORDINAL( name );
+    uint32_t hash = cacheable ? dlsym_hash( name ) : 0;
+    unsigned int generation;
+    dlsym_cache_entry *entry;
+    HMODULE owner = NULL;
+    int cached = 0;
+
+    dlfcn_lock();
+    if( cacheable && (dlsym_cache.size > 0)
+    &&  ((entry = dlsym_cache_slot( name, hash, rtld_exclude ))->name != NULL)  )
+    { rtn = entry->symbol;
+      index = entry->index;
+      owner = entry->owner;
+      cached = 1;
+    }
+    dlfcn_unlock();
+
+    /* A cached symbol, which was found in a module which we did not
+     * load, may be reused only if that module still maps it; (this is
+     * a single call, in place of the GetProcAddress() call for each
+     * module, which would otherwise be required to repeat the search).
      */
-    last_named_symbol = name;
+    if( cached && (owner != NULL) && (dlsym_owner( rtn ) != owner) )
+    { rtn = NULL; index = 0; owner = NULL; cached = 0;
+    }
+
+    if( ! cached )
+    { /* The result is not cached; we must perform the search, (which
+       * we may need to suspend, while we release the lock, to resolve
+       * a deferred symbol by GetProcAddress()), and cache its result,
+       * unless the cache was invalidated while the lock was released;
+       * a symbol which was found in a module which we did not load,
+       * (and which may thus be unloaded without our knowledge), may be
+       * cached only if we can identify the module which maps it.
+       */
+      dlfcn_lock();
+      generation = dlsym_cache.generation;
+      while( ((rtn = dlsym_search( name, &index, rtld_exclude, &defer )) == NULL)
+      &&  (defer != NULL)  )
+      { dlfcn_unlock();
+	if( (rtn = GetProcAddress( defer, name )) != NULL )
+	  owner = dlsym_owner( rtn );
+	dlfcn_lock();
+	if( rtn != NULL ) break;
+	++index;
+      }
+      if( (rtn != NULL) && ((rtld.flags[index] & RTLD_EXPLICIT) == RTLD_EXPLICIT) )
+	owner = NULL;
+      else if( (rtn != NULL) && (owner == NULL) )
+	cacheable = 0;
+      if( cacheable && (generation == dlsym_cache.generation) )
+	dlsym_cache_store( name, hash, rtld_exclude, index, rtn, owner );
+      dlfcn_unlock();
+    }
+
+    /* Note the symbol named in the current search, and the module in
+     * which it was found, so that we may check for consistency, and
+     * continue the search, in the event that the next search, by this
+     * thread, is invoked as an RTLD_NEXT request.
+     */
+    dlsym_next.name = name;
+    dlsym_next.index = index;
+    dlsym_next.exclude = rtld_exclude;
+    if( rtn == NULL ) SetLastError( ERROR_PROC_NOT_FOUND );
   }
   else
   { /* When a specific module reference is specified, confine the
-     * search to the specified module alone...
+     * search to the specified module alone; we may read its export
+     * directory directly, only if it is listed in the global modules
+     * list, as having been loaded by dlopen(), (which assures us that
+     * it is a valid module handle, and that it will remain mapped).
      */
-    rtn = GetProcAddress( (HMODULE)(module), name );
+    defer = module;
+    if( ! DLSYM_IS_ORDINAL( name ) )
+    { const char *forwarder = NULL;
+      dlfcn_lock();
+      if( dlsym_explicit( module ) )
+      { rtn = __mingw_pe_export_lookup( module, name, &forwarder );
+	if( forwarder == NULL ) defer = NULL;
+      }
+      dlfcn_unlock();
+    }
+    if( defer != NULL )
+      rtn = GetProcAddress( defer, name );
+    else if( rtn == NULL )
+      SetLastError( ERROR_PROC_NOT_FOUND );
 
-    /* ...and inhibit any attempt to follow this search with one
-     * specifying RTLD_NEXT; (this would not be valid, since there
-     * is no concept of a "next" module to be searched, when not
-     * searching through an ordered list of modules).
+    /* In any case, inhibit any attempt to follow this search with one
+     * specifying RTLD_NEXT; (this would not be valid, since there is
+     * no concept of a "next" module to be searched, when not searching
+     * through an ordered list of modules).
      */
-    last_named_symbol = NULL;
+    dlsym_next.name = NULL;
   }
 
   if( rtn == NULL )
@@ -581,7 +882,8 @@ static int dlclose_internal( void *module )
    * module handle, provided this is listed in the global module table as
    * having been explicitly opened by our dlopen() function.
    */
-  int index;
+  int index, unload = 0;
+  dlfcn_lock();
   for( index = 0; index < rtld.slots; index++ )
     if( module == rtld.modules[index] )
     {
@@ -590,24 +892,30 @@ static int dlclose_internal( void *module )
        * prudent to do so in respect of implicitly loaded modules, but for
        * those which we have explicitly loaded...
        */
-      if( ((rtld.flags[index] & RTLD_EXPLICIT) == RTLD_EXPLICIT)
-      /*
-       * ...and which can be successfully released by FreeLibrary()...
-       */
-      &&  (dlclose_internal_check_for_error( FreeLibrary( module )) == 0)  )
-	/*
-	 * ...we mark them as no longer available for dlsym() processing,
-	 * and return immediately, indicating success...
+      if( (unload = ((rtld.flags[index] & RTLD_EXPLICIT) == RTLD_EXPLICIT)) )
+      {
+	/* ...we mark them as no longer available for dlsym() processing,
+	 * (invalidating the symbol cache accordingly), BEFORE we release
+	 * them, so that no concurrent dlsym() call may attempt to read the
+	 * export directory of a module which is being unmapped...
 	 */
-	return rtld.flags[index] = 0;
-
-      /* ...but when we didn't successfully release the module, we have
-       * no need to continue the search for its handle in the global list
-       * of modules, (because we've already found it); we may immediately
-       * abandon the search.
+	rtld.flags[index] = 0;
+	dlsym_cache_flush();
+      }
+      /* ...and, in any case, we have no need to continue the search for
+       * its handle in the global list of modules, (because we've already
+       * found it); we may immediately abandon the search.
        */
       break;
     }
+  dlfcn_unlock();
+
+  /* Having released the lock, we may now release an explicitly loaded
+   * module, returning immediately, and indicating success, if this is
+   * successful...
+   */
+  if( unload && (dlclose_internal_check_for_error( FreeLibrary( module )) == 0) )
+    return 0;
 
   /* If we get to here, we either didn't find the specified module handle in
    * the global list of modules, or we found it but were unable to release
@@ -624,6 +932,15 @@ static void dlfcn_init( void )
    * enumerate the implicitly loaded process modules, so that
    * they may be searched implicitly by dlsym().
    */
+  HMODULE kernel32 = GetModuleHandleA( "kernel32.dll" );
+  if( kernel32 != NULL )
+    /* KERNEL32.DLL is always implicitly loaded; when it provides
+     * GetModuleHandleExW(), (i.e. on WinXP and later), dlsym() may
+     * use it to verify cached references to symbols in modules which
+     * it did not load; otherwise, it will not cache such symbols.
+     */
+    dlsym_owner_fn = (owner_fn)(GetProcAddress( kernel32, "GetModuleHandleExW" ));
+
   if( psapi_lookup_fn_init() == NULL )
   {
     /* Initialization of the PSAPI.DLL interface failed.  Record
@@ -0,0 +1,550 @@
+/*
+ * fnmatch.c
+ *
+ * Implementation of the POSIX fnmatch() function, together with the
+ * private pattern compiler, and matcher, on which it is based; these
+ * are shared with the MinGW implementation of glob().
+ *
+ * $Id$
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR THE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OF OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * Patterns are compiled, once, into a compact program, in which:
+ *
+ *   - each run of literal characters becomes a single operation, which
+ *     is matched by memcmp(); (for case insensitive matching, literals
+ *     are folded to lower case when compiled, and the subject string is
+ *     folded, just once, before matching begins);
+ *
+ *   - each run of '?' becomes a single operation, matching that number
+ *     of arbitrary characters;
+ *
+ *   - each bracketed character set becomes a 256-bit bitmap, (with any
+ *     negation, range expansion, and case folding already applied), so
+ *     that set membership is tested by a single bit lookup;
+ *
+ *   - each run of '*' becomes a single operation, which partitions the
+ *     program into fixed width segments.
+ *
+ * Since the segments between '*' operations have fixed width, the leading
+ * segment is anchored at the start of the string, and the trailing segment
+ * at its end; each intervening segment is matched at the leftmost position
+ * where it fits, (which is always sufficient, and never requires any
+ * backtracking), skipping directly to candidate positions, by memchr(),
+ * when the segment begins with a literal.
+ *
+ * Note that this implementation differs from GNU's fnmatch(), in that:
+ *
+ *   - within a bracket expression, collating symbols, equivalence classes,
+ *     and character classes, (i.e. "[.x.]", "[=x=]", and "[:class:]"), are
+ *     not supported;
+ *
+ *   - only '!' negates a bracket expression; a leading '^' is interpreted
+ *     as a literal member of the set;
+ *
+ *   - a range may be specified in either ascending, or descending order,
+ *     (e.g. "[z-a]" is equivalent to "[a-z]"), whereas GNU's fnmatch()
+ *     matches nothing, for a descending range;
+ *
+ *   - an escape character at the end of the pattern is matched literally,
+ *     whereas GNU's fnmatch() reports that the pattern does not match;
+ *
+ *   - when FNM_PATHNAME is in effect, an escaped directory separator, (e.g.
+ *     "\/"), remains a directory separator, (subject to all FNM_PATHNAME
+ *     rules), whereas GNU's fnmatch() matches it as an ordinary literal.
+ *
+ */
+#define _GNU_SOURCE
+#include <fnmatch.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+
+#if defined _WIN32 || defined __MS_DOS__
+/*
+ * As in glob(), for the Microsoft platforms, we treat '\' and '/'
+ * interchangeably as directory separator characters...
+ */
+# define fnmatch_is_dirsep( c )  (((c) == '/') || ((c) == '\\'))
+#else
+/* ...whereas elsewhere, only '/' is a directory separator.
+ */
+# define fnmatch_is_dirsep( c )  ((c) == '/')
+#endif
+
+/* Operation codes, from which compiled programs are constructed.
+ */
+enum
+{ FNMATCH_LITERAL,	/* match "len" characters from the literal pool */
+  FNMATCH_ANY,		/* match any "len" characters			*/
+  FNMATCH_SET,		/* match any one character in bitmap "arg"	*/
+  FNMATCH_STAR,		/* match any sequence of characters		*/
+  FNMATCH_SEP,		/* match a directory separator (FNM_PATHNAME)	*/
+  FNMATCH_END		/* marks the end of the program 		*/
+};
+
+typedef
+struct fnmatch_op
+{ unsigned int	 type;
+  unsigned int	 arg;	/* offset into literal pool, or bitmap index	*/
+  unsigned int	 len;	/* number of characters matched, if fixed	*/
+} fnmatch_op;
+
+typedef
+struct fnmatch_program
+{ /* A compiled program comprises this header, and its array of
+   * operations, followed by the character set bitmaps, and the pool
+   * of literal characters, to which these operations refer.
+   */
+  int		 flags;
+  unsigned int	 nops;
+  unsigned int	 nsets;
+  unsigned int	 npool;
+  fnmatch_op	 op[];
+} fnmatch_program;
+
+#define FNMATCH_SETWORDS	(256 / 32)
+#define FNMATCH_SETS( P )	((uint32_t *)((P)->op + (P)->nops))
+#define FNMATCH_POOL( P )  \
+  ((unsigned char *)(FNMATCH_SETS( P ) + (P)->nsets * FNMATCH_SETWORDS))
+
+/* Size of the local buffers, in which fnmatch() compiles its pattern,
+ * and in which the subject string is folded, for FNM_CASEFOLD; either
+ * is allocated on the heap, when a larger buffer is required.
+ */
+#define FNMATCH_BUFSIZ		512
+
+#define FNMATCH_IN_SET( B, C )	((B)[(C) >> 5] & (1U << ((C) & 31)))
+#define FNMATCH_ADD_SET( B, C ) ((B)[(C) >> 5] |= (1U << ((C) & 31)))
+
+static __inline__ __attribute__((__always_inline__))
+unsigned char fnmatch_tolower( unsigned char c )
+{
+  /* Case folding helper; since the vast majority of file names comprise
+   * only ASCII characters, we avoid the overhead of calling tolower(),
+   * except in the case of characters outside the ASCII range.
+   */
+  if( c < 0x80 ) return ((unsigned char)(c - 'A') < 26) ? c + 'a' - 'A' : c;
+  return tolower( c );
+}
+
+static __inline__ __attribute__((__always_inline__))
+unsigned char fnmatch_fold( int flags, unsigned char c )
+{ return (flags & FNM_CASEFOLD) ? fnmatch_tolower( c ) : c; }
+
+static const unsigned char *fnmatch_parse_set
+( const unsigned char *p, int flags, int escape, uint32_t *bits )
+{
+  /* Parse a bracketed character set specification; on entry, "p" refers
+   * to the character following the opening '['.  Returns a pointer to
+   * the character following the closing ']', or NULL if the set is not
+   * closed, (in which case the '[' must be interpreted literally).  When
+   * "bits" is not NULL, the set is also compiled into the bitmap which
+   * it designates.
+   *
+   * Within the set, ']' or '-' are taken literally when they appear as
+   * the first character, (following any '!' which negates the set), as
+   * is '-' when it appears as the last; a range may be specified in
+   * either ascending, or descending, collating order.  As in GNU's
+   * fnmatch(), when FNM_CASEFOLD is in effect, only the bounds of a
+   * range are folded, (so "[A-a]" matches only 'a', or 'A', but not
+   * any of the intervening characters); since the subject string is
+   * also folded, no member of the set is folded individually.
+   */
+  int negate = 0, first = 1, i;
+  uint32_t set[FNMATCH_SETWORDS] = { 0 };
+
+  if( *p == '!' ) { negate = 1; ++p; }
+  while( first || (*p != ']') )
+  { unsigned int lo, hi;
+
+    if( *p == '\0' ) return NULL;
+    if( (*p == escape) && (p[1] != '\0') ) ++p;
+    hi = lo = *p++;
+
+    if( (*p == '-') && (p[1] != ']') && (p[1] != '\0') )
+    { /* This is a range specification; identify its upper bound,
+       * (which may itself be escaped).
+       */
+      if( (*++p == escape) && (p[1] != '\0') ) ++p;
+      hi = *p++;
+    }
+    lo = fnmatch_fold( flags, lo ); hi = fnmatch_fold( flags, hi );
+    if( hi < lo ) { unsigned int tmp = hi; hi = lo; lo = tmp; }
+    for( ; lo <= hi; lo++ )
+      /*
+       * A set member which is a directory separator can never be
+       * matched, when FNM_PATHNAME is in effect.
+       */
+      if( ! ((flags & FNM_PATHNAME) && fnmatch_is_dirsep( lo )) )
+	FNMATCH_ADD_SET( set, lo );
+    first = 0;
+  }
+  if( bits != NULL )
+    for( i = 0; i < FNMATCH_SETWORDS; i++ )
+      bits[i] = negate ? ~set[i] : set[i];
+  return ++p;
+}
+
+static void fnmatch_parse
+( fnmatch_program *prog, const char *pattern, int flags, int escape )
+{
+  /* Parse "pattern", counting the operations, character sets, and
+   * literal characters which are required to represent it; when "prog"
+   * already records these counts, (from a previous pass), the program
+   * itself is also emitted.
+   */
+  const unsigned char *p = (const unsigned char *)(pattern);
+  unsigned int nops = 0, nsets = 0, npool = 0, last = FNMATCH_END;
+  fnmatch_op *op = (prog->nops > 0) ? prog->op : NULL;
+  unsigned char *pool = (op != NULL) ? FNMATCH_POOL( prog ) : NULL;
+  const unsigned char *q;
+
+  if( flags & FNM_NOESCAPE ) escape = -1;
+
+# define FNMATCH_EMIT( TYPE, ARG, LEN )				\
+  do { if( op != NULL )						\
+	 { op[nops].type = (TYPE);					\
+	   op[nops].arg = (ARG); op[nops].len = (LEN); 		\
+	 }								\
+       ++nops; last = (TYPE);					\
+     } while( 0 )
+
+  while( *p != '\0' )
+  { unsigned char c = *p++;
+
+    if( c == '*' )
+    { /* Consecutive '*' are equivalent to just one.
+       */
+      if( last != FNMATCH_STAR ) FNMATCH_EMIT( FNMATCH_STAR, 0, 0 );
+      continue;
+    }
+    if( c == '?' )
+    { /* Consecutive '?' are accumulated into a single operation.
+       */
+      if( last != FNMATCH_ANY ) FNMATCH_EMIT( FNMATCH_ANY, 0, 1 );
+      else if( op != NULL ) ++op[nops - 1].len;
+      continue;
+    }
+    if( (c == '[')
+    &&  ((q = fnmatch_parse_set( p, flags, escape, NULL )) != NULL)  )
+    { /* A well formed character set; (one which is not closed is
+       * handled below, as a literal '[').
+       */
+      if( op != NULL )
+	fnmatch_parse_set( p, flags, escape,
+	    FNMATCH_SETS( prog ) + nsets * FNMATCH_SETWORDS
+	  );
+      FNMATCH_EMIT( FNMATCH_SET, nsets, 1 );
+      ++nsets; p = q;
+      continue;
+    }
+    if( (c == escape) && (*p != '\0') )
+      /*
+       * An escaped character is always interpreted literally, (except
+       * that an escaped directory separator remains a separator).
+       */
+      c = *p++;
+
+    if( (flags & FNM_PATHNAME) && fnmatch_is_dirsep( c ) )
+      FNMATCH_EMIT( FNMATCH_SEP, 0, 0 );
+
+    else
+    { /* Any other character is a literal; consecutive literals are
+       * accumulated into a single run, in the literal pool.
+       */
+      if( last != FNMATCH_LITERAL ) FNMATCH_EMIT( FNMATCH_LITERAL, npool, 1 );
+      else if( op != NULL ) ++op[nops - 1].len;
+      if( pool != NULL ) pool[npool] = fnmatch_fold( flags, c );
+      ++npool;
+    }
+  }
+  FNMATCH_EMIT( FNMATCH_END, 0, 0 );
+# undef FNMATCH_EMIT
+
+  prog->flags = flags;
+  prog->nops = nops; prog->nsets = nsets; prog->npool = npool;
+}
+
+size_t __mingw_fnmatch_compile
+( void *buf, const char *pattern, int flags, int escape )
+{
+  /* Compile "pattern", for matching under control of the FNM_* "flags",
+   * interpreting "escape" as the escape character, (unless FNM_NOESCAPE
+   * is specified); returns the size of the compiled program, which is
+   * stored in "buf", (which must be suitably aligned, for any pointer),
+   * unless "buf" is NULL, in which case only the size is computed.
+   */
+  fnmatch_program counts = { 0, 0, 0, 0 }, *prog = buf;
+  size_t size;
+
+  fnmatch_parse( &counts, pattern, flags, escape );
+  size = sizeof( fnmatch_program ) + counts.nops * sizeof( fnmatch_op )
+    + counts.nsets * sizeof( uint32_t[FNMATCH_SETWORDS] ) + counts.npool;
+
+  if( prog != NULL )
+  { *prog = counts;
+    fnmatch_parse( prog, pattern, flags, escape );
+  }
+  return size;
+}
+
+static size_t fnmatch_width( const fnmatch_op *op, const fnmatch_op *end )
+{
+  /* Compute the number of characters which must be matched by a fixed
+   * width sequence of operations.
+   */
+  size_t width = 0;
+  while( op < end ) width += (op++)->len;
+  return width;
+}
+
+static int fnmatch_fixed
+( const fnmatch_program *prog, const fnmatch_op *op, const fnmatch_op *end,
+  const unsigned char *text
+)
+{
+  /* Match a fixed width sequence of operations at "text", which the
+   * caller has verified to be of sufficient length.
+   */
+  for( ; op < end; text += (op++)->len )
+    switch( op->type )
+    { /* (Note that FNMATCH_ANY needs no check; we simply advance
+       * over the requisite number of characters).
+       */
+      case FNMATCH_LITERAL:
+	if( memcmp( text, FNMATCH_POOL( prog ) + op->arg, op->len ) != 0 )
+	  return 0;
+	break;
+
+      case FNMATCH_SET:
+	if( ! FNMATCH_IN_SET( FNMATCH_SETS( prog ) + op->arg * FNMATCH_SETWORDS,
+	      *text )
+	  ) return 0;
+    }
+  return 1;
+}
+
+static int fnmatch_component
+( const fnmatch_program *prog, const fnmatch_op *op, const fnmatch_op *end,
+  const unsigned char *text, const unsigned char *text_end
+)
+{
+  /* Match the sequence of operations from "op" to "end", (which contains
+   * no FNMATCH_SEP), to the entire string from "text" to "text_end";
+   * returns non-zero for a match.
+   */
+  const fnmatch_op *first, *last;
+  size_t head, tail;
+
+  /* When FNM_PERIOD is in effect, a leading period must be matched by
+   * an explicit literal period.
+   */
+  if( (prog->flags & FNM_PERIOD) && (text < text_end) && (*text == '.')
+  &&  ! ((op < end) && (op->type == FNMATCH_LITERAL)
+	&& (FNMATCH_POOL( prog )[op->arg] == '.'))  )
+    return 0;
+
+  /* Locate the first, and the last, '*' operations; in the absence of
+   * any such, the entire sequence must match the string exactly.
+   */
+  for( first = op; (first < end) && (first->type != FNMATCH_STAR); first++ )
+    ;
+  if( first == end )
+    return (fnmatch_width( op, end ) == (size_t)(text_end - text))
+      && fnmatch_fixed( prog, op, end, text );
+
+  for( last = end - 1; last->type != FNMATCH_STAR; last-- )
+    ;
+
+  /* Anchor the leading segment at the start of the string, and the
+   * trailing segment at its end.
+   */
+  head = fnmatch_width( op, first );
+  tail = fnmatch_width( last + 1, end );
+  if( (head + tail) > (size_t)(text_end - text)
+  ||  ! fnmatch_fixed( prog, op, first, text )
+  ||  ! fnmatch_fixed( prog, last + 1, end, text_end - tail )  )
+    return 0;
+
+  text += head; text_end -= tail;
+  while( first < last )
+  { /* Match each intervening segment at the leftmost position, at
+     * which it fits, within the remaining string.
+     */
+    const fnmatch_op *seg = first + 1;
+    const unsigned char *limit;
+    size_t width;
+
+    for( first = seg; first->type != FNMATCH_STAR; first++ )
+      ;
+    if( (width = fnmatch_width( seg, first )) > (size_t)(text_end - text) )
+      return 0;
+
+    limit = text_end - width;
+    if( seg->type == FNMATCH_LITERAL )
+    { /* Skip directly to each candidate position, at which the first
+       * literal character of the segment appears.
+       */
+      int c = FNMATCH_POOL( prog )[seg->arg];
+      while( ((text = memchr( text, c, limit - text + 1 )) != NULL)
+      &&  ! fnmatch_fixed( prog, seg, first, text ) )
+	if( text++ == limit ) return 0;
+      if( text == NULL ) return 0;
+    }
+    else
+      while( ! fnmatch_fixed( prog, seg, first, text ) )
+	if( text++ == limit ) return 0;
+
+    text += width;
+  }
+  return 1;
+}
+
+static int fnmatch_text
+( const fnmatch_program *prog, const unsigned char *text, size_t len )
+{
+  /* Match "text", of length "len", (already folded, if necessary), to
+   * the compiled program; returns zero for a match, or FNM_NOMATCH.
+   */
+  const fnmatch_op *op = prog->op, *end;
+  const unsigned char *text_end = text + len;
+
+  if( (prog->flags & FNM_PATHNAME) == 0 )
+    return fnmatch_component( prog, op, prog->op + prog->nops - 1,
+	text, text_end ) ? 0 : FNM_NOMATCH;
+
+  /* When FNM_PATHNAME is in effect, each directory separator in the
+   * string must be matched by a separator in the pattern; we match each
+   * component, between separators, independently.
+   */
+  while( 1 )
+  { const unsigned char *sep = text;
+    for( end = op; (end->type != FNMATCH_SEP) && (end->type != FNMATCH_END); end++ )
+      ;
+    while( (sep < text_end) && ! fnmatch_is_dirsep( *sep ) ) ++sep;
+    if( ! fnmatch_component( prog, op, end, text, sep ) )
+      return FNM_NOMATCH;
+
+    if( end->type == FNMATCH_END )
+      return (sep == text_end) ? 0 : FNM_NOMATCH;
+    if( sep == text_end )
+      return FNM_NOMATCH;
+    op = end + 1; text = sep + 1;
+  }
+}
+
+int __mingw_fnmatch_exec( const void *program, const char *string, size_t len )
+{
+  /* Match "string", of length "len", to a compiled program; returns
+   * zero for a match, FNM_NOMATCH otherwise, or -1 if storage for the
+   * folded string cannot be allocated.
+   */
+  const fnmatch_program *prog = program;
+  const fnmatch_op *op = prog->op;
+  const unsigned char *text = (const unsigned char *)(string);
+  unsigned char buf[FNMATCH_BUFSIZ], *folded;
+  size_t i;
+  int status;
+
+  if( op->type == FNMATCH_LITERAL )
+  { /* When the pattern begins with a literal, (as is common), we may
+     * reject most non-matching strings by checking just this prefix,
+     * before we incur the cost of any further preparation.
+     */
+    const unsigned char *prefix = FNMATCH_POOL( prog ) + op->arg;
+    if( op->len > len ) return FNM_NOMATCH;
+    for( i = 0; i < op->len; i++ )
+      if( fnmatch_fold( prog->flags, text[i] ) != prefix[i] )
+	return FNM_NOMATCH;
+
+    /* Furthermore, when the prefix is followed only by a trailing '*',
+     * then the match is complete, (provided that, for FNM_PATHNAME, no
+     * directory separator follows the prefix).
+     */
+    if( (op[1].type == FNMATCH_STAR) && (op[2].type == FNMATCH_END) )
+    { if( prog->flags & FNM_PATHNAME )
+	while( i < len )
+	  if( fnmatch_is_dirsep( text[i++] ) ) return FNM_NOMATCH;
+      return 0;
+    }
+  }
+
+  if( (prog->flags & FNM_CASEFOLD) == 0 )
+    return fnmatch_text( prog, text, len );
+
+  /* For case insensitive matching, fold the entire string, just once,
+   * to match the folding of the compiled pattern; (the local buffer is
+   * sufficient for any typical file name, but we must not let a long
+   * string overflow the stack).  The ASCII range is folded arithmetically,
+   * (in a loop which the compiler may vectorize), with tolower() applied
+   * in a second pass, only if any non-ASCII character is present.
+   */
+  if( (folded = (len < sizeof( buf )) ? buf : malloc( len )) == NULL )
+    return -1;
+  else
+  { unsigned char high = 0;
+    for( i = 0; i < len; i++ )
+    { unsigned char c = text[i]; high |= c;
+      folded[i] = ((unsigned char)(c - 'A') < 26) ? c + 'a' - 'A' : c;
+    }
+    if( high & 0x80 )
+      for( i = 0; i < len; i++ )
+	if( text[i] & 0x80 ) folded[i] = tolower( text[i] );
+  }
+  status = fnmatch_text( prog, folded, len );
+  if( folded != buf ) free( folded );
+  return status;
+}
+
+int fnmatch( const char *pattern, const char *string, int flags )
+{
+  /* Public entry point; the pattern is compiled into a local buffer,
+   * (or on the heap, if it is too large), on each call, then matched
+   * to the entire string, or when the GNU FNM_LEADING_DIR option is
+   * specified, to any initial substring which is followed by a directory
+   * separator.  Returns -1, if the requisite storage is unavailable.
+   */
+  size_t len = strlen( string );
+  size_t size = __mingw_fnmatch_compile( NULL, pattern, flags, '\\' );
+  void *buf[FNMATCH_BUFSIZ / sizeof( void * )], *prog;
+  int status;
+
+  if( (prog = (size <= sizeof( buf )) ? buf : malloc( size )) == NULL )
+    return -1;
+
+  __mingw_fnmatch_compile( prog, pattern, flags, '\\' );
+  if( ((status = __mingw_fnmatch_exec( prog, string, len )) == FNM_NOMATCH)
+  &&  (flags & FNM_LEADING_DIR)  )
+  { size_t i;
+    for( i = 0; (status == FNM_NOMATCH) && (i < len); i++ )
+      if( fnmatch_is_dirsep( string[i] ) )
+	status = __mingw_fnmatch_exec( prog, string, i );
+  }
+  if( prog != buf ) free( prog );
+  return status;
+}
+
+/* $RCSfile$: end of file */
@@ -112,6 +112,18 @@ extern char*	__g_dfmt   (char*, double*, int, size_t);
 extern char*	__g_ffmt   (char*, float*,  int, size_t);
 extern char*	__g_xfmt   (char*, void*,   int, size_t);
 
+/* MinGW extension: a table of truncated, normalized 128-bit mantissas
+ * for the powers of ten, 10^__MINGW_POW10_MIN .. 10^__MINGW_POW10_MAX,
+ * (see pow10tab.c), supporting fast, bignum free, conversions between
+ * double and decimal representations; the binary exponent associated
+ * with the entry for 10^s is __mingw_pow10_log2(s) - 127.
+ */
+#define __MINGW_POW10_MIN	(-342)
+#define __MINGW_POW10_MAX	340
+#define __mingw_pow10_log2(s)	((217706 * (s)) >> 16)
+
+extern const unsigned long long __mingw_pow10_128[][2];
+
 #ifdef __cplusplus
 }
 #endif
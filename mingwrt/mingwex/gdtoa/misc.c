@@ -108,6 +108,16 @@ static void dtoa_unlock (int n)
 
 #include "gdtoaimp.h"
 
+/* Bigint storage is carved from a process-wide pool, (or obtained
+ * from malloc(), when that is exhausted), under protection of lock 0;
+ * blocks which are released are NOT returned to the pool, but are
+ * retained on free lists, indexed by size class, for reuse.  In the
+ * multithreaded case, each thread keeps a small private cache of such
+ * free blocks, which it may service without acquiring the lock; only
+ * when a thread's cache for any size class is either exhausted, (on
+ * allocation), or full, (on release), must it fall back to the shared
+ * free lists, and hence to the lock.
+ */
 static Bigint *freelist[Kmax+1];
 #ifndef Omit_Private_Memory
 #ifndef PRIVATE_MEM
@@ -117,6 +127,22 @@ static Bigint *freelist[Kmax+1];
 static double private_mem[PRIVATE_mem], *pmem_next = private_mem;
 #endif
 
+#if defined(MULTIPLE_THREADS) && defined(__GNUC__)
+/* Blocks held in a per-thread cache are abandoned, when the thread
+ * terminates; to limit this loss, we cache only the smaller size
+ * classes, (which account for the vast majority of requests), and
+ * we cap the depth of each such cache.
+ */
+#ifndef Kmax_cached
+#define Kmax_cached 5
+#endif
+#ifndef Bigint_cache_depth
+#define Bigint_cache_depth 4
+#endif
+static __thread Bigint *thread_freelist[Kmax_cached+1];
+static __thread unsigned char thread_freecount[Kmax_cached+1];
+#endif
+
 Bigint *Balloc (int k)
 {
 	int x;
@@ -125,6 +151,17 @@ Bigint *Balloc (int k)
 	unsigned int len;
 #endif
 
+#ifdef Kmax_cached
+	/* Fast path: reuse a block from this thread's own cache; since
+	 * no other thread can see this, no lock is required.
+	 */
+	if (k <= Kmax_cached && (rv = thread_freelist[k]) != 0) {
+		thread_freelist[k] = rv->next;
+		--thread_freecount[k];
+		rv->sign = rv->wds = 0;
+		return rv;
+	}
+#endif
 	ACQUIRE_DTOA_LOCK(0);
 	/* The k > Kmax case does not need ACQUIRE_DTOA_LOCK(0), */
 	/* but this case seems very unlikely. */
@@ -136,7 +173,10 @@ Bigint *Balloc (int k)
 #ifdef Omit_Private_Memory
 		rv = (Bigint *)MALLOC(sizeof(Bigint) + (x-1)*sizeof(ULong));
     if (rv == NULL)
-      return NULL;
+      {
+	FREE_DTOA_LOCK(0);
+	return NULL;
+      }
 #else
 		len = (sizeof(Bigint) + (x-1)*sizeof(ULong) + sizeof(double) - 1)
 			/sizeof(double);
@@ -148,7 +188,10 @@ Bigint *Balloc (int k)
       {
 			rv = (Bigint*)MALLOC(len*sizeof(double));
       if (rv == NULL)
-        return NULL;
+        {
+	  FREE_DTOA_LOCK(0);
+	  return NULL;
+        }
       }
 #endif
 		rv->k = k;
@@ -164,6 +207,17 @@ void Bfree (Bigint *v)
 	if (v) {
 		if (v->k > Kmax)
 			free((void*)v);
+#ifdef Kmax_cached
+		else if (v->k <= Kmax_cached
+		&& thread_freecount[v->k] < Bigint_cache_depth) {
+			/* Fast path: retain the block in this thread's own
+			 * cache, again without any need to acquire the lock.
+			 */
+			v->next = thread_freelist[v->k];
+			thread_freelist[v->k] = v;
+			++thread_freecount[v->k];
+		}
+#endif
 		else {
 			ACQUIRE_DTOA_LOCK(0);
 			v->next = freelist[v->k];
@@ -422,6 +476,27 @@ Bigint *mult (Bigint *a, Bigint *b)
 
 static Bigint *p5s;
 
+#ifdef MULTIPLE_THREADS
+/* p5_publish(): Attach the newly computed power of five, p, to the
+ * shared cache, at *where, unless another thread has already done so;
+ * in that case, discard p, in favour of the other thread's result.
+ * Since the cache only ever grows, and its entries are never freed,
+ * readers need never lock it; an interlocked exchange suffices to
+ * ensure that each entry is published exactly once.
+ */
+static Bigint *p5_publish (Bigint **where, Bigint *p)
+{
+	Bigint *q;
+
+	p->next = 0;
+	if ((q = InterlockedCompareExchangePointer ((PVOID *)(where), p, 0)) != 0) {
+		Bfree(p);
+		return q;
+	}
+	return p;
+}
+#endif
+
 Bigint *pow5mult (Bigint *b, int k)
 {
 	Bigint *b1, *p5, *p51;
@@ -439,19 +514,13 @@ Bigint *pow5mult (Bigint *b, int k)
 		return b;
 	if ((p5 = p5s) == 0) {
 		/* first time */
-#ifdef MULTIPLE_THREADS
-		ACQUIRE_DTOA_LOCK(1);
-		if (!(p5 = p5s)) {
-			p5 = p5s = i2b(625);
-      if (p5 == NULL)
-        return NULL;
-			p5->next = 0;
-		}
-		FREE_DTOA_LOCK(1);
-#else
-		p5 = p5s = i2b(625);
+		p5 = i2b(625);
     if (p5 == NULL)
       return NULL;
+#ifdef MULTIPLE_THREADS
+		p5 = p5_publish(&p5s, p5);
+#else
+		p5s = p5;
 		p5->next = 0;
 #endif
 	}
@@ -466,19 +535,13 @@ Bigint *pow5mult (Bigint *b, int k)
 		if (!(k >>= 1))
 			break;
 		if ((p51 = p5->next) == 0) {
-#ifdef MULTIPLE_THREADS
-			ACQUIRE_DTOA_LOCK(1);
-			if (!(p51 = p5->next)) {
-				p51 = p5->next = mult(p5,p5);
-        if (p51 == NULL)
-          return NULL;
-				p51->next = 0;
-			}
-			FREE_DTOA_LOCK(1);
-#else
-			p51 = p5->next = mult(p5,p5);
+			p51 = mult(p5,p5);
       if (p51 == NULL)
         return NULL;
+#ifdef MULTIPLE_THREADS
+			p51 = p5_publish(&p5->next, p51);
+#else
+			p5->next = p51;
 			p51->next = 0;
 #endif
 		}
@@ -266,6 +266,93 @@ static int mantbits (dbl_union *d)
 	return P - 32 - lo0bits(&L);
 }
 
+#ifdef ULLong
+/* Eisel-Lemire fast path: for round-nearest conversion of a decimal
+ * significand w, of no more than 19 digits, times 10^q, to a normal
+ * binary value of at most 64 bits precision.  The 128-bit truncated
+ * mantissa of 10^q is taken from __mingw_pow10_128[] (see pow10tab.c);
+ * the product w * T, truncated to 192 bits, is then low by less than
+ * 2^64, so only when the bits between the rounding bit and bit 64 are
+ * all ones can the rounding decision be in doubt.  Similarly, when
+ * those bits, and all of p0, are zero, we cannot tell whether the
+ * product is exact, so the inexact flags would be in doubt.  In
+ * either case, or if the result would be subnormal or out of range,
+ * we return zero, and the caller falls back to the (exact) bignum
+ * based conversion.  The STRTOG_Inexlo, or STRTOG_Inexhi flag which
+ * we return in *inexp describes the rounding of w * 10^q itself.
+ */
+
+ static ULLong
+umul64(ULLong a, ULLong b, ULLong *hi)
+{
+	ULLong ll, lh, hl, mid;
+
+	ll = (a & 0xffffffffUL) * (b & 0xffffffffUL);
+	lh = (a & 0xffffffffUL) * (b >> 32);
+	hl = (a >> 32) * (b & 0xffffffffUL);
+	mid = (ll >> 32) + (lh & 0xffffffffUL) + (hl & 0xffffffffUL);
+	*hi = (a >> 32) * (b >> 32) + (lh >> 32) + (hl >> 32) + (mid >> 32);
+	return (mid << 32) | (ll & 0xffffffffUL);
+}
+
+ static int
+eisel_lemire(ULLong w, int q, int nbits,
+		ULLong *mp, int *ep, int *inexp)
+{
+	const ULLong *T;
+	ULLong m, mask, p0, p1, p2, t;
+	int e, exact, lz, r, rbit, sticky;
+
+	if (!w || q < __MINGW_POW10_MIN || q > __MINGW_POW10_MAX)
+		return 0;
+	T = __mingw_pow10_128[q - __MINGW_POW10_MIN];
+	exact = q >= 0 && q <= 55;
+	lz = __builtin_clzll(w);
+	w <<= lz;
+
+	/* (p2:p1:p0) = w * T; since both factors are normalized, the
+	 * most significant bit of p2 is either bit 63, or bit 62.
+	 */
+	p0 = umul64(w, T[1], &t);
+	p1 = umul64(w, T[0], &p2);
+	if ((p1 += t) < t)
+		p2++;
+
+	/* r is the rounding bit position, within the 128-bit (p2:p1).
+	 */
+	r = (int)(p2 >> 63) + 126 - nbits;
+	if (r < 64) {
+		mask = ((ULLong)1 << r) - 1;
+		m = (p2 << (63 - r)) | (p1 >> r >> 1);
+		rbit = (int)(p1 >> r) & 1;
+		sticky = (p1 & mask) || p0;
+		if (!exact && ((p1 & mask) == mask || !sticky))
+			return 0;
+	}
+	else {
+		mask = ((ULLong)1 << (r - 64)) - 1;
+		m = p2 >> (r - 64) >> 1;
+		rbit = (int)(p2 >> (r - 64)) & 1;
+		sticky = (p2 & mask) || p1 || p0;
+		if (!exact && (((p2 & mask) == mask && p1 == ~(ULLong)0)
+		 || !sticky))
+			return 0;
+	}
+	e = r + __mingw_pow10_log2(q) - 62 - lz;
+	*inexp = rbit | sticky ? STRTOG_Inexlo : 0;
+	if (rbit && (sticky || (m & 1))) {
+		*inexp = STRTOG_Inexhi;
+		if (!++m || (nbits < 64 && m >> nbits)) {
+			m = (ULLong)1 << (nbits - 1);
+			e++;
+		}
+	}
+	*mp = m;
+	*ep = e;
+	return 1;
+}
+#endif /* ULLong */
+
 int __strtodg (const char *s00, char **se, FPI *fpi, Long *exp, ULong *bits)
 {
 	int abe, abits, asub;
@@ -494,6 +581,49 @@ int __strtodg (const char *s00, char **se, FPI *fpi, Long *exp, ULong *bits)
 
 	if (!nd0)
 		nd0 = nd;
+#ifdef ULLong
+	if (!rd && nbits <= 64) {
+		/* Try the Eisel-Lemire fast path, on the leading 19 digits;
+		 * if more digits follow, and any are nonzero, the result is
+		 * valid only if w and w + 1 round to the same value, and the
+		 * true value, which lies strictly between them, is then known
+		 * to have been rounded up only if w + 1 is at or below that
+		 * value, or down only if w is at or above it; otherwise, the
+		 * direction is in doubt, and we must fall back.
+		 */
+		ULLong m, m1, w;
+		int above, e3, ex, inex1;
+
+		for(w = i = 0, s1 = s0; i < nd && i < 19; i++, s1++) {
+			if (i == nd0)
+				s1 += dplen;
+			w = 10*w + *s1 - '0';
+		}
+		for(above = 0, j = i; j < nd; j++, s1++) {
+			if (j == nd0)
+				s1 += dplen;
+			if (*s1 != '0') {
+				above = 1;
+				break;
+			}
+		}
+		e3 = e + nd - i;
+		if (eisel_lemire(w, e3, nbits, &m, &ex, &inex)
+		 && ex >= fpi->emin && ex <= fpi->emax
+		 && (!above
+		  || (eisel_lemire(w + 1, e3, nbits, &m1, &e2, &inex1)
+		   && m1 == m && e2 == ex
+		   && (inex = inex1 != STRTOG_Inexlo ? STRTOG_Inexhi
+			: inex != STRTOG_Inexhi ? STRTOG_Inexlo : 0)))) {
+			bits[0] = (ULong)m;
+			if (nbits > 32)
+				bits[1] = (ULong)(m >> 32);
+			*exp = ex;
+			irv = STRTOG_Normal | inex;
+			goto ret;
+		}
+	}
+#endif
 	k = nd < DBL_DIG + 1 ? nd : DBL_DIG + 1;
 	dval(&rv) = y;
 	if (k > 9)
@@ -31,7 +31,7 @@
  *
  */
 #include <glob.h>
-#include <ctype.h>
+#include <fnmatch.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
@@ -189,322 +189,6 @@ static int is_glob_pattern( const char *pattern, int flags )
   return 0;
 }
 
-static const char *glob_set_adjusted( const char *pattern, int flags )
-{
-  /* Adjust the globbing pattern pointer, to make it refer to the
-   * next character (if any) following a character set specification;
-   * this adjustment is required when pattern matching is to resume
-   * after matching a set specification, irrespective of whether the
-   * match was successful or not; (a failed match is the desired
-   * outcome for an excluded character set).
-   */
-  register const char *p = pattern;
-
-  /* We need to move the pointer forward, until we find the ']'
-   * which marks the end of the set specification.
-   */
-  while( *p != ']' )
-  {
-    /* We haven't found it yet; advance by one character...
-     */
-    if( (*p == glob_escape_char) && ((flags & GLOB_NOESCAPE) == 0) )
-      /*
-       * ...or maybe even two, when we identify a need to
-       * step over any character which has been escaped...
-       */
-      p++;
-
-    if( *p++ == '\0' )
-      /*
-       * ...but if we find a NUL on the way, then the pattern
-       * is malformed, so we return NULL to report a bad match.
-       */
-      return NULL;
-  }
-  /* We found the expected ']'; return a pointer to the NEXT
-   * character, (which may be ANYTHING; even NUL is okay).
-   */
-  return ++p;
-}
-
-GLOB_INLINE int glob_case_match( int flags, int check, int match )
-{
-  /* Local helper function, used to facilitate the case insensitive
-   * glob character matching appropriate for MS-Windows systems.
-   */
-  return (flags & GLOB_CASEMATCH) ? check - match
-    : tolower( check ) - tolower( match );
-}
-
-static const char *glob_in_set( const char *set, int test, int flags )
-{
-  /* Check if the single character "test" is present in the set
-   * of characters represented by "set", (a specification of the
-   * form "[SET]", or "[!SET]" in the case of an excluded set).
-   *
-   * On entry, "set" always points to the first character in the
-   * set to be tested, i.e. the character FOLLOWING the '[' which
-   * opens an inclusive set, or FOLLOWING the initial '!' which
-   * marks the set as exclusive.
-   *
-   * Matching is ALWAYS performed as if checking an inclusive set;
-   * return value is a pointer to the globbing pattern character
-   * following the closing ']' of "set", when "test" IS in "set",
-   * or NULL when it is not.  Caller performing an inclusive match
-   * should handle NULL as a failed match, and non-NULL as success.
-   * Caller performing an exclusive match should handle non-NULL as
-   * a failed match, with NULL indicating success, and should call
-   * glob_set_adjusted() before resuming pattern matching in the
-   * case of a successful match.
-   */
-  register int c, lastc;
-  if( ((lastc = *set) == ']') || (lastc == '-') )
-  {
-    /* This is the special case of matching ']' or '-' as the
-     * first character in the set, where it must match literally...
-     */
-    if( lastc == test )
-      /*
-       * ...which it does, so immediately report it so.
-       */
-      return glob_set_adjusted( ++set, flags );
-
-    /* ...otherwise we didn't match this special case of ']' or '-',
-     * so we simply ignore this special set entry, thus handling it
-     * as an implicitly escaped literal which has not been matched.
-     */
-    set++;
-  }
-  while( (c = *set++) != ']' )
-  {
-    /* We are still scanning the set, and have not yet reached the
-     * closing ']' sentinel character.
-     */
-    if( (c == '-') && (*set != ']') && ((c = *set++) != '\0') )
-    {
-      /* Since the current character is a '-', and is not immediately
-       * followed by the set's closing sentinel, nor is it at the end
-       * of the (malformed) pattern, it specifies a character range,
-       * running from the last character scanned...
-       */
-      while( lastc < c )
-      {
-	/* ...in incremental collating sequence order, to the next
-	 * character following the '-'...
-	 */
-	if( glob_case_match( flags, lastc++, test ) == 0 )
-	  /*
-	   * ...returning immediately on a successful match...
-	   */
-	  return glob_set_adjusted( set, flags );
-      }
-      while( lastc > c )
-      {
-	/* ...or failing that, consider the possibility that the
-	 * range may have been specified in decrementing collating
-	 * sequence order...
-	 */
-	if( glob_case_match( flags, lastc--, test ) == 0 )
-	  /*
-	   * ...once again, return immediately on a successful match.
-	   */
-	  return glob_set_adjusted( set, flags );
-      }
-    }
-
-    if( (c == '\0')
-      /*
-       * This is a malformed set; (not closed before the end of
-       * the pattern)...
-       */
-    ||  glob_is_dirsep( c )  )
-      /*
-       * ...or it attempts to explicitly match a directory separator,
-       * which is invalid in this context.  We MUST fail it, in either
-       * case, reporting a mismatch.
-       */
-      return NULL;
-
-    if( glob_case_match( flags, c, test ) == 0 )
-      /*
-       * We found the test character within the set; adjust the pattern
-       * reference, to resume after the end of the set, and return the
-       * successful match.
-       */
-      return glob_set_adjusted( set, flags );
-
-    /* If we get to here, we haven't yet found the test character within
-     * this set; remember the character within the set which we just tried
-     * to match, as it may represent the start of a character range, then
-     * continue the scan, until we exhaust the set.
-     */
-    lastc = c;
-  }
-  /* Having exhausted the set, without finding a match, we return NULL
-   * to indicate that the test character was NOT found in the set.
-   */
-  return NULL;
-}
-
-static int glob_strcmp( const char *pattern, const char *text, int flags )
-{
-  /* Compare "text" to a specified globbing "pattern" using semantics
-   * comparable to "strcmp()"; returns zero for a complete match, else
-   * non-zero for a mismatch.
-   *
-   * Within "pattern":
-   *   '?'     matches any one character in "text" (except '\0')
-   *   '*'     matches any sequence of zero or more characters in "text"
-   *   [SET]   matches any one character in "text" which is also in "SET"
-   *   [!SET]  matches any one character in "text" which is NOT in "SET"
-   */
-  register const char *p = pattern, *t = text;
-  register int c;
-
-  if( (*t == '.') && (*p != '.') && ((flags & GLOB_PERIOD) == 0) )
-    /*
-     * The special GNU extension allowing wild cards to match a period
-     * as first character is NOT in effect; "text" DOES have an initial
-     * period character AND "pattern" DOES NOT match it EXPLICITLY, so
-     * this comparison must report a MISMATCH.
-     */
-    return *p - *t;
-
-  /* Attempt to match "pattern", character by character...
-   */
-  while( (c = *p++) != '\0' )
-  {
-    /* ...so long as we haven't exhausted it...
-     */
-    switch( c )
-    {
-      case '?':
-	/* Match any one character...
-	 */
-	if( *t++ == '\0' )
-	  /* ...but when there isn't one left to be matched,
-	   * then we must report a mismatch.
-	   */
-	  return '?';
-	break;
-
-      case '*':
-	/* Match any sequence of zero or more characters...
-	 */
-	while( *p == '*' )
-	  /*
-	   * ...ignoring any repeated '*' in the pattern...
-	   */
-	  p++;
-
-	/* ...and if we've exhausted the pattern...
-	 */
-	if( *p == '\0' )
-	  /*
-	   * ...then we simply match all remaining characters,
-	   * to the end of "text", so we may return immediately,
-	   * reporting a successful match.
-	   */
-	  return 0;
-
-	/* When we haven't exhausted the pattern, then we may
-	 * attempt to recursively match the remainder of the
-	 * pattern to some terminal substring of "text"; we do
-	 * this iteratively, stepping over as many characters
-	 * of "text" as necessary, (and which thus match the '*'
-	 * in "pattern"), until we either find the start of this
-	 * matching substring, or we exhaust "text" without any
-	 * possible match...
-	 */
-	do { c = glob_strcmp( p, t, flags | GLOB_PERIOD );
-	   } while( (c != 0) && (*t++ != '\0') );
-	/*
-	 * ...and ultimately, we return the result of this
-	 * recursive attempt to find a match.
-	 */
-	return c;
-
-      case '[':
-	/* Here we need to match (or not match) exactly one
-	 * character from the candidate text with any one of
-	 * a set of characters in the pattern...
-	 */
-	if( (c = *t++) == '\0' )
-	  /*
-	   * ...but, we must return a mismatch if there is no
-	   * candidate character left to match.
-	   */
-	  return '[';
-
-	if( *p == '!' )
-	{
-	  /* Match any one character which is NOT in the SET
-	   * specified by [!SET].
-	   */
-	  if( glob_in_set( ++p, c, flags ) == NULL )
-	  {
-	    if( *p == ']' )
-	      p++;
-	    p = glob_set_adjusted( p, flags );
-	  }
-	}
-	else
-	{ /* Match any one character which IS in the SET
-	   * specified by [SET].
-	   */
-	  p = glob_in_set( p, c, flags );
-	}
-	if( p == NULL )
-	  /*
-	   * The character under test didn't satisfy the SET
-	   * matching criterion; return as unmatched.
-	   */
-	  return ']';
-	break;
-
-      default:
-	/* The escape character cannot be handled as a regular
-	 * switch case, because the escape character is specified
-	 * as a variable, (to better support Microsoft nuisances).
-	 * The escape mechanism may have been disabled within the
-	 * glob() call...
-	 */
-	if(  ((flags & GLOB_NOESCAPE) == 0)
-	  /*
-	   * ...but when it is active, and we find an escape
-	   * character without exhausting the pattern...
-	   */
-	&& (c == glob_escape_char) && ((c = *p) != 0)  )
-	  /*
-	   * ...then we handle the escaped character here, as
-	   * a literal, and step over it, within the pattern.
-	   */
-	  ++p;
-
-	/* When we get to here, a successful match requires that
-	 * the current pattern character "c" is an exact literal
-	 * match for the next available character "t", if any,
-	 * in the candidate text string...
-	 */
-	if( (*t == '\0') || (glob_case_match( flags, c, *t ) != 0) )
-	  /*
-	   * ...otherwise we return a mismatch.
-	   */
-	  return c - *t;
-
-	/* No mismatch yet; proceed to test the following character
-	 * within the candidate text string.
-	 */
-	t++;
-    }
-  }
-  /* When we've exhausted the pattern, then this final check will return
-   * a match if we've simultaneously exhausted the candidate text string,
-   * or a mismatch otherwise.
-   */
-  return c - *t;
-}
-
 #ifdef DT_DIR
 /*
  * When this is defined, we assume that we can safely interrogate
@@ -543,6 +227,23 @@ static int glob_strcmp( const char *pattern, const char *text, int flags )
 # define D_NAMLEN( entry )  (strlen( (entry)->d_name ))
 #endif
 
+/* The gl_pathv vector is grown geometrically, so that the cost of
+ * storing each globbed path name, when amortized over a large number of
+ * matches, remains constant; since the glob_t structure offers us no
+ * field in which to record the allocated size, the allocation is always
+ * chosen as the smallest power of two, (subject to a lower bound), which
+ * accommodates the slots in use, so that it may be deduced again, from
+ * gl_offs and gl_pathc, whenever another path name is to be added.
+ */
+#define GLOB_PATHV_MINSLOTS	16
+
+GLOB_INLINE size_t glob_pathv_slots( size_t required )
+{
+  size_t slots = GLOB_PATHV_MINSLOTS;
+  while( slots < required ) slots <<= 1;
+  return slots;
+}
+
 static int glob_initialise( glob_t *gl_data )
 {
   /* Helper routine to initialise a glob_t structure
@@ -554,7 +255,7 @@ static int glob_initialise( glob_t *gl_data )
      * defined as a glob_t structure; allocate space on the heap,
      * for storage of the globbed paths vector...
      */
-    int entries = gl_data->gl_offs + 1;
+    size_t entries = glob_pathv_slots( gl_data->gl_offs + 1 );
     if( (gl_data->gl_pathv = malloc( entries * sizeof( char ** ) )) == NULL )
       /*
        * ...bailing out, if insufficient free heap memory.
@@ -575,33 +276,42 @@ static int glob_initialise( glob_t *gl_data )
   return GLOB_SUCCESS;
 }
 
-GLOB_INLINE int glob_expand( glob_t *gl_buf )
-{
-  /* Inline helper to compute the new size allocation required
-   * for buf->gl_pathv, prior to adding a new glob result.
-   */
-  return ((2 + gl_buf->gl_pathc + gl_buf->gl_offs) * sizeof( char ** ));
-}
-
 static int glob_store_entry( char *path, glob_t *gl_buf )
 {
   /* Local helper routine to add a single path name entity
    * to the globbed path vector, after first expanding the
-   * allocated memory space to accommodate it.
+   * allocated memory space, if necessary, to accommodate it.
    */
-  char **pathv;
-  if(  (path != NULL)  &&  (gl_buf != NULL)
-  &&  ((pathv = realloc( gl_buf->gl_pathv, glob_expand( gl_buf ))) != NULL)  )
+  if( (path != NULL) && (gl_buf != NULL) )
   {
-    /* Memory expansion was successful; store the new path name
-     * in place of the former NULL pointer at the end of the old
-     * vector...
+    /* Count the slots presently in use, (including the terminating
+     * NULL pointer); if the current allocation, which we may deduce
+     * from this count, has no vacant slot remaining...
+     */
+    size_t used = gl_buf->gl_offs + gl_buf->gl_pathc + 1;
+    if( used == glob_pathv_slots( used ) )
+    {
+      /* ...then we must double its size, (guarding against arithmetic
+       * overflow, when computing the size of the new allocation).
+       */
+      char **pathv;
+      size_t slots = glob_pathv_slots( used + 1 );
+      if( (slots < used) || (slots > ((size_t)(-1) / sizeof( char ** )))
+      ||  ((pathv = realloc( gl_buf->gl_pathv, slots * sizeof( char ** ))) == NULL)  )
+	/*
+	 * We were unable to expand the vector; bail out.
+	 */
+	return GLOB_ABORTED;
+
+      gl_buf->gl_pathv = pathv;
+    }
+    /* We now have a vacant slot; store the new path name in place of
+     * the former NULL pointer at the end of the old vector...
      */
-    gl_buf->gl_pathv = pathv;
     gl_buf->gl_pathv[gl_buf->gl_offs + gl_buf->gl_pathc++] = path;
     /*
-     * ...then place a further NULL pointer into the newly allocated
-     * slot, to mark the new end of the vector...
+     * ...then place a further NULL pointer into the following slot,
+     * to mark the new end of the vector...
      */
     gl_buf->gl_pathv[gl_buf->gl_offs + gl_buf->gl_pathc] = NULL;
     /*
@@ -614,107 +324,30 @@ static int glob_store_entry( char *path, glob_t *gl_buf )
   return GLOB_ABORTED;
 }
 
-struct glob_collator
-{
-  /* A private data structure, used to keep an ordered collection
-   * of globbed path names in collated sequence within a (possibly
-   * unbalanced) binary tree.
-   */
-  struct glob_collator	*prev;
-  struct glob_collator	*next;
-  char  		*entry;
-};
-
-GLOB_INLINE struct glob_collator
-*glob_collate_entry( struct glob_collator *collator, char *entry, int flags )
+static int glob_collate_compare( const void *a, const void *b, void *flags )
 {
-  /* Inline helper function to construct a binary tree representation
-   * of a collated collection of globbed path name entities.
+  /* Comparison function, for use with __mingw_qsort_r(), when sorting
+   * globbed path names into collating sequence order; the glob flags
+   * are passed as context, to determine whether comparisons should be
+   * case sensitive, or not.
    */
-  int seq = 0;
-  struct glob_collator *ref = collator;
-  struct glob_collator *lastref = collator;
-  while( ref != NULL )
-  {
-    /* Walk the tree, to find the leaf node representing the insertion
-     * point, in correctly collated sequence order, for the new entry,
-     * noting whether we must insert the new entry before or after the
-     * original entry at that leaf.
-     */
-    lastref = ref;
-    if( flags & GLOB_CASEMATCH )
-      seq = strcoll( entry, ref->entry );
-    else
-      seq = stricoll( entry, ref->entry );
-    ref = (seq > 0) ? ref->next : ref->prev;
-  }
-  /* Allocate storage for a new leaf node, and if successful...
-   */
-  if( (ref = malloc( sizeof( struct glob_collator ))) != NULL )
-  {
-    /* ...place the new entry on this new leaf...
-     */
-    ref->entry = entry;
-    ref->prev = ref->next = NULL;
-
-    /* ...and attach it to the tree...
-     */
-    if( lastref != NULL )
-    {
-      /* ...either...
-       */
-      if( seq > 0 )
-	/*
-	 * ...after...
-	 */
-	lastref->next = ref;
-
-      else
-	/* ...or before...
-	 */
-	lastref->prev = ref;
-
-      /* ...the original leaf,as appropriate. */
-    }
-  }
-  /* When done, return a pointer to the root node of the resultant tree.
-   */
-  return (collator == NULL) ? ref : collator;
+  if( *(int *)(flags) & GLOB_CASEMATCH )
+    return strcoll( *(char * const *)(a), *(char * const *)(b) );
+  return stricoll( *(char * const *)(a), *(char * const *)(b) );
 }
 
-static void
-glob_store_collated_entries( struct glob_collator *collator, glob_t *gl_buf )
+GLOB_INLINE void glob_collate_entries( glob_t *gl_buf, size_t first, int flags )
 {
-  /* A local helper routine to store a collated collection of globbed
-   * path name entities into the path vector within a glob_t structure;
-   * it performs a recursive inorder traversal of a glob_collator tree,
-   * deleting it leaf by leaf, branch by branch, as it stores the path
-   * data contained thereon.
-   */
-  if( collator->prev != NULL )
-    /*
-     * Recurse into the sub-tree of entries which collate before the
-     * root of the current (sub-)tree.
-     */
-    glob_store_collated_entries( collator->prev, gl_buf );
-
-  /* Store the path name entry at the root of the current (sub-)tree.
-   */
-  glob_store_entry( collator->entry, gl_buf );
-
-  if( collator->next != NULL )
-    /*
-     * Recurse into the sub-tree of entries which collate after the
-     * root of the current (sub-)tree.
-     */
-    glob_store_collated_entries( collator->next, gl_buf );
-
-  /* Finally, delete the root node of the current (sub-)tree; since
-   * recursion visits every node of the tree, ultimately considering
-   * each leaf as a sub-tree of only one node, unwinding recursion
-   * will cause this to delete the entire tree.
+  /* Inline helper to sort those path names which have been added to
+   * gl_buf->gl_pathv, since its gl_pathc counter had the value given by
+   * "first", into collating sequence order; (this collect-then-sort
+   * strategy guarantees O(n log n) performance, even when, as is usual
+   * for NTFS, the directory has delivered its entries already sorted).
    */
-  free( collator );
+  if( gl_buf->gl_pathc > first )
+    __mingw_qsort_r( gl_buf->gl_pathv + gl_buf->gl_offs + first,
+	gl_buf->gl_pathc - first, sizeof( char * ), glob_collate_compare, &flags
+      );
 }
 
 GLOB_INLINE int
@@ -854,32 +487,80 @@ glob_brace_expand( char *dest, const char *src, const char **resume )
   return level;
 }
 
+static int glob_match( const char *, int, int (*)(), glob_t * );
+
+GLOB_INLINE int glob_status_merge( int status, int update )
+{
+  /* Helper to combine the status codes reported by glob matching of
+   * alternative patterns; an abort overrides any other status, while
+   * exhaustion of heap memory overrides any successful match, which in
+   * turn overrides failure to match.
+   */
+  static const unsigned char rank[] =
+  { /* GLOB_SUCCESS */ 1, /* GLOB_ABORTED */ 3,
+    /* GLOB_NOMATCH */ 0, /* GLOB_NOSPACE */ 2
+  };
+  return (rank[update] > rank[status]) ? update : status;
+}
+
+GLOB_INLINE int glob_has_prefix( const char *pattern, const char *dir )
+{
+  /* The original "pattern" argument may have included a path name
+   * prefix, which we used "dirname()" to isolate, as "dir".  If there
+   * was no such prefix, then "dirname()" would have reported an effective
+   * prefix which is identically equal to "."; however, this would also
+   * be the case if the prefix was "./" (or ".\\" in the case of a WIN32
+   * host).  Thus, we may deduce that there is a prefix, when "dir" is
+   * not reported as ".", or even if it is, when the original pattern
+   * had "./" (or ".\\") as the prefix.
+   */
+  return glob_is_dirsep( pattern[1] ) || (strcmp( dir, "." ) != 0);
+}
+
+/* The pattern compiler, and matcher, are shared with fnmatch().
+ */
+size_t __mingw_fnmatch_compile( void *, const char *, int, int );
+int __mingw_fnmatch_exec( const void *, const char *, size_t );
+
+static void *glob_compile( const char *pattern, int flags )
+{
+  /* Helper to compile the final path name component of a glob pattern,
+   * into a program for the matcher which is shared with fnmatch(); this
+   * is performed once only, for each pattern, so that each directory
+   * entry may be checked without any repeated interpretation of the
+   * pattern.  Returns NULL, if there is insufficient heap memory.
+   */
+  void *program;
+  int fnm_flags = FNM_PATHNAME;
+
+  if( (flags & GLOB_CASEMATCH) == 0 ) fnm_flags |= FNM_CASEFOLD;
+  if( (flags & GLOB_PERIOD) == 0 ) fnm_flags |= FNM_PERIOD;
+  if( (flags & GLOB_NOESCAPE) != 0 ) fnm_flags |= FNM_NOESCAPE;
+
+  if( (program = malloc( __mingw_fnmatch_compile( NULL, pattern, fnm_flags,
+	    glob_escape_char ))) != NULL
+    ) __mingw_fnmatch_compile( program, pattern, fnm_flags, glob_escape_char );
+  return program;
+}
+
 static int
-glob_match( const char *pattern, int flags, int (*errfn)(), glob_t *gl_buf )
+glob_brace_collect( const char *pattern, int flags, glob_t *alternatives )
 {
-  /* Local helper function; it provides the backbone of the glob()
-   * implementation, recursively decomposing the pattern into separate
-   * globbable path components, to collect the union of all possible
-   * matches to the pattern, in all possible matching directories.
+  /* Local helper function, to handle the GNU specific GLOB_BRACE option;
+   * we recursively parse the original pattern, so as to decompose it into
+   * a series of substitute patterns, each of which represents one pattern
+   * expansion, to which glob matching is to be applied, such that the
+   * aggregate of matches for the series represents all possible matches
+   * for all possible expansions of the original pattern.  Rather than
+   * performing glob matching for each expansion immediately, we collect
+   * them all, in order, into the gl_pathv list of "alternatives", so that
+   * glob_match_list() may match all of those which share a common prefix
+   * directory in a single scan of each directory.
    *
    * At the outset, assume that this will succeed.
    */
   int status = GLOB_SUCCESS;
-
-  /* To handle the GNU specific GLOB_BRACE option, we need a
-   * recursive preamble to the bare glob_match() strategy; when
-   * GLOB_BRACE expansion is specified...
-   */
-  int brace_option;
-  if( (brace_option = flags & GLOB_BRACE) == GLOB_BRACE )
   {
-    /* ...we recursively parse the original pattern, so as to
-     * decompose it into a series of substitute patterns, each
-     * of which represents one pattern expansion to which glob
-     * matching is applied in turn, such that the aggregate of
-     * matches for the series represents all possible matches
-     * for all possible expansions of the original pattern.
-     */
     const char *src = pattern;
     char c, sub_pattern[1 + strlen( pattern )], *dest = sub_pattern;
 
@@ -1010,12 +691,7 @@ glob_match( const char *pattern, int flags, int (*errfn)(), glob_t *gl_buf )
 	      * embedded brace bounded sub-expressions; recurse
 	      * to achieve full expansion...
 	      */
-	     status = glob_match( sub_pattern, flags, errfn, gl_buf );
-	     /*
-	      * ...and ensure that matches to all expansions
-	      * after the first, will be appended.
-	      */
-	     flags |= GLOB_APPEND;
+	     status = glob_brace_collect( sub_pattern, flags, alternatives );
 	   }
 	   else
 	   { /* Brace expansion failed, (which implies an opening
@@ -1033,155 +709,192 @@ glob_match( const char *pattern, int flags, int (*errfn)(), glob_t *gl_buf )
 	    * for the current expression have been processed, (or
 	    * aborted).
 	    */
-	 } while( (status != GLOB_ABORTED) && (*src == ',') );
+	 } while( (status == GLOB_SUCCESS) && (*src == ',') );
 
     else
-      /* The current brace expression has been reduced to its final
-       * form, (with no further expansion pending); release it for
-       * fall-through glob matching.
+    { /* The current brace expression has been reduced to its final
+       * form, (with no further expansion pending); add it to the list
+       * of alternatives.
        */
-      brace_option = 0;
+      char *alternative;
+      if( ((alternative = strdup( pattern )) == NULL)
+      ||  (glob_store_entry( alternative, alternatives ) != GLOB_SUCCESS)  )
+      { free( alternative ); status = GLOB_NOSPACE; }
+    }
   }
+  return status;
+}
 
-  /* On falling through brace expansion, (if any)...
+static int glob_match_group
+( const char *dir, int has_prefix, const char **patterns, size_t count,
+  int flags, int (*errfn)(), glob_t *gl_buf
+)
+{
+  /* Local helper function; it provides the backbone of the glob()
+   * implementation, collecting all possible matches for each of "count"
+   * alternative patterns, which share the common path name prefix "dir",
+   * in all possible matching directories.  Each matching directory is
+   * scanned only once, with each entry checked against each alternative
+   * pattern in turn; however, the matches for each alternative are kept
+   * in a separate bucket, (just as if each had been matched separately),
+   * so that they are ultimately stored in order of alternatives.
    */
-  if( brace_option == 0 )
-  {
-    /* ...we have exactly one pattern, with no possible expansions
-     * of brace expressions, to be globbed; (alternate expansions of
-     * any brace expressions are processed in alternative recursive
-     * invocations of this function).
+  int status, scan = 0;
+  size_t k;
+  glob_t local_gl_buf, buckets[count], *bucket[count];
+  const char *tail[count];
+  char **dirp, preferred_dirsep[count];
+  void *program[count];
+
+  /* Initialise a temporary local glob_t structure, to capture the
+   * intermediate results at the current level of recursion...
+   */
+  local_gl_buf.gl_offs = 0;
+  if( (status = glob_initialise( &local_gl_buf )) != GLOB_SUCCESS )
+    /*
+     * ...bailing out if unsuccessful.
      */
-    glob_t local_gl_buf;
+    return status;
 
-    /* Begin by separating out any path prefix from the glob pattern.
+  /* Check if there are any globbing tokens in the path prefix...
+   */
+  if( is_glob_pattern( dir, flags ) )
+    /*
+     * ...and recurse to identify all possible matching prefixes,
+     * as may be necessary...
      */
-    char dirbuf[1 + strlen( pattern )];
-    const char *dir = dirname( memcpy( dirbuf, pattern, sizeof( dirbuf )) );
-    char **dirp, preferred_dirsep = GLOB_DIRSEP;
+    status = glob_match( dir, flags | GLOB_DIRONLY, errfn, &local_gl_buf );
 
-    /* Initialise a temporary local glob_t structure, to capture the
-     * intermediate results at the current level of recursion...
+  else
+    /* ...or simply store the current prefix, if not.
      */
-    local_gl_buf.gl_offs = 0;
-    if( (status = glob_initialise( &local_gl_buf )) != GLOB_SUCCESS )
-      /*
-       * ...bailing out if unsuccessful.
-       */
-      return status;
+    status = glob_store_entry( glob_strdup( dir ), &local_gl_buf );
 
-    /* Check if there are any globbing tokens in the path prefix...
+  /* Check nothing has gone wrong, so far...
+   */
+  if( status != GLOB_SUCCESS )
+  { /* ...and bail out if necessary.
      */
-    if( is_glob_pattern( dir, flags ) )
-      /*
-       * ...and recurse to identify all possible matching prefixes,
-       * as may be necessary...
-       */
-      status = glob_match( dir, flags | GLOB_DIRONLY, errfn, &local_gl_buf );
-
-    else
-      /* ...or simply store the current prefix, if not.
-       */
-      status = glob_store_entry( glob_strdup( dir ), &local_gl_buf );
+    for( dirp = local_gl_buf.gl_pathv; *dirp != NULL; free( *dirp++ ) )
+      ;
+    free( local_gl_buf.gl_pathv );
+    return status;
+  }
 
-    /* Check nothing has gone wrong, so far...
+  /* We now have a globbed list of prefix directories, returned from
+   * recursive processing, in local_gl_buf.gl_pathv; at the outset, we
+   * have yet to match any alternative pattern to anything.
+   */
+  status = GLOB_NOMATCH;
+  for( k = 0; k < count; k++ )
+  {
+    /* When there is only one alternative, its matches may be stored
+     * directly into gl_buf; otherwise, each must be collected into its
+     * own separate bucket.
      */
-    if( status != GLOB_SUCCESS )
-      /*
-       * ...and bail out if necessary.
-       */
-      return status;
-
-    /* The original "pattern" argument may have included a path name
-     * prefix, which we used "dirname()" to isolate.  If there was no
-     * such prefix, then "dirname()" would have reported an effective
-     * prefix which is identically equal to "."; however, this would
-     * also be the case if the prefix was "./" (or ".\\" in the case
-     * of a WIN32 host).  Thus, we may deduce that...
+    bucket[k] = &buckets[k];
+    if( count == 1 ) bucket[k] = gl_buf;
+    else
+    { buckets[k].gl_offs = 0;
+      if( glob_initialise( bucket[k] ) != GLOB_SUCCESS )
+      { /* We cannot proceed, without an allocation for every bucket;
+	 * release any which we did allocate, and bail out.
+	 */
+	while( k-- > 0 ) free( buckets[k].gl_pathv );
+	for( dirp = local_gl_buf.gl_pathv; *dirp != NULL; free( *dirp++ ) )
+	  ;
+	free( local_gl_buf.gl_pathv );
+	return GLOB_NOSPACE;
+      }
+    }
+  }
+  for( k = 0; k < count; k++ )
+  {
+    /* When there was a path name prefix, we must adjust to identify
+     * the effective pattern with its original prefix stripped away;
+     * (we also note the separator which the user preferred).
      */
-    if( glob_is_dirsep( pattern[1] ) || (strcmp( dir, "." ) != 0) )
+    const char *pattern = tail[k] = patterns[k];
+    preferred_dirsep[k] = GLOB_DIRSEP;
+    if( has_prefix )
     {
-      /* ...when the prefix is not reported as ".", or even if it is
-       * but the original pattern had "./" (or ".\\") as the prefix,
-       * then we must adjust to identify the effective pattern with
-       * its original prefix stripped away...
-       */
-      const char *tail = pattern + strlen( dir );
-      while( (tail > pattern) && ! glob_is_dirsep( *tail ) )
-	--tail;
-      while( glob_is_dirsep( *tail ) )
-	preferred_dirsep = *tail++;
-      pattern = tail;
+      const char *p = pattern + strlen( dir );
+      while( (p > pattern) && ! glob_is_dirsep( *p ) )
+	--p;
+      while( glob_is_dirsep( *p ) )
+	preferred_dirsep[k] = *p++;
+      tail[k] = p;
     }
-
-    else
-      /* ...otherwise, we simply note that there was no prefix.
-       */
-      dir = NULL;
-
-    /* We now have a globbed list of prefix directories, returned from
-     * recursive processing, in local_gl_buf.gl_pathv, and we also have
-     * a separate pattern which we may attempt to match in each of them;
-     * at the outset, we have yet to match this pattern to anything.
-     */
-    status = GLOB_NOMATCH;
+    program[k] = NULL;
 
     /* When the caller has enabled the GLOB_NOCHECK option, then in the
      * case of any pattern with no prefix, and which contains no explicit
      * globbing token...
      */
-    if( (dir == NULL) && accept_glob_nocheck_match( pattern, flags ) )
+    if( ! has_prefix && accept_glob_nocheck_match( tail[k], flags ) )
     {
       /* ...we prefer to store it as is, without any attempt to find
        * a glob match, (which could also induce a case transliteration
        * on MS-Windows' case-insensitive file system)...
        */
-      glob_store_entry( glob_strdup( pattern ), gl_buf );
-      status = GLOB_SUCCESS;
+      glob_store_entry( glob_strdup( tail[k] ), bucket[k] );
+      status = glob_status_merge( status, GLOB_SUCCESS );
     }
-    /* ...otherwise we initiate glob matching, to find all possible
-     * file system matches for the designated pattern, within each of
-     * the identified prefix directory paths.
+    /* ...otherwise we compile the pattern, in preparation for glob
+     * matching within each of the identified prefix directory paths.
+     */
+    else if( (program[k] = glob_compile( tail[k], flags )) != NULL )
+      scan = 1;
+
+    else
+      status = glob_status_merge( status, GLOB_NOSPACE );
+  }
+
+  for( dirp = local_gl_buf.gl_pathv; *dirp != NULL; free( *dirp++ ) )
+  {
+    /* Provided we have at least one pattern to match, and an earlier
+     * cycle hasn't scheduled an abort...
      */
-    else for( dirp = local_gl_buf.gl_pathv; *dirp != NULL; free( *dirp++ ) )
+    if( scan && (status != GLOB_ABORTED) )
     {
-      /* Provided an earlier cycle hasn't scheduled an abort...
+      /* ...take each candidate directory in turn, and prepare
+       * to collate any matched entities within it...
        */
-      if( status != GLOB_ABORTED )
-      {
-	/* ...take each candidate directory in turn, and prepare
-	 * to collate any matched entities within it...
-	 */
-	struct glob_collator *collator = NULL;
+      size_t first[count];
 
-	/* ...attempt to open the current candidate directory...
+      /* ...attempt to open the current candidate directory...
+       */
+      DIR *dp;
+      for( k = 0; k < count; k++ ) first[k] = bucket[k]->gl_pathc;
+      if( (dp = opendir( *dirp )) != NULL )
+      {
+	/* ...and when successful, instantiate a dirent structure...
 	 */
-	DIR *dp;
-	if( (dp = opendir( *dirp )) != NULL )
+	struct dirent *entry;
+	size_t dirlen = has_prefix ? strlen( *dirp ) : 0;
+	while( (entry = readdir( dp )) != NULL )
 	{
-	  /* ...and when successful, instantiate a dirent structure...
+	  /* ...into which we read each entry from the candidate
+	   * directory, in turn, then...
 	   */
-	  struct dirent *entry;
-	  size_t dirlen = (dir == NULL) ? 0 : strlen( *dirp );
-	  while( (entry = readdir( dp )) != NULL )
-	  {
-	    /* ...into which we read each entry from the candidate
-	     * directory, in turn, then...
+	  size_t matchlen = D_NAMLEN( entry );
+	  if( ((flags & GLOB_DIRONLY) != 0) && ! GLOB_ISDIR( entry ) )
+	    /*
+	     * ...unless we require it to be a subdirectory, and it
+	     * is not, we check it against each alternative pattern.
 	     */
-	    if( (((flags & GLOB_DIRONLY) == 0) || GLOB_ISDIR( entry ))
-	      /*
-	       * ...provided we don't require it to be a subdirectory,
-	       * or it actually is one...
-	       */
-	    && (glob_strcmp( pattern, entry->d_name, flags ) == 0)   )
+	    continue;
+
+	  for( k = 0; k < count; k++ )
+	    if( (program[k] != NULL)
+	    &&  (__mingw_fnmatch_exec( program[k], entry->d_name, matchlen ) == 0)  )
 	    {
-	      /* ...and it is a globbed match for the pattern, then
+	      /* When it is a globbed match for the pattern, then
 	       * we allocate a temporary local buffer of sufficient
 	       * size to assemble the matching path name...
 	       */
 	      char *found;
 	      size_t prefix;
-	      size_t matchlen = D_NAMLEN( entry );
 	      char matchpath[2 + dirlen + matchlen];
 	      if( (prefix = dirlen) > 0 )
 	      {
@@ -1190,89 +903,149 @@ glob_match( const char *pattern, int flags, int (*errfn)(), glob_t *gl_buf )
 		 */
 		memcpy( matchpath, *dirp, dirlen );
 		if( ! glob_is_dirsep( matchpath[prefix - 1] ) )
-		  matchpath[prefix++] = preferred_dirsep;
+		  matchpath[prefix++] = preferred_dirsep[k];
 	      }
 	      /* ...and append the matching dirent entry.
 	       */
 	      memcpy( matchpath + prefix, entry->d_name, matchlen + 1 );
 
 	      /* Duplicate the content of the temporary buffer to
-	       * the heap, for assignment into gl_buf->gl_pathv...
+	       * the heap, and add it to the appropriate result vector;
+	       * (if the results are to be sorted, we will do so when
+	       * the directory scan is complete)...
 	       */
-	      if( (found = glob_strdup( matchpath )) == NULL )
-		/*
-		 * ...setting the appropriate error code, in the
+	      if( ((found = glob_strdup( matchpath )) == NULL)
+	      ||  (glob_store_entry( found, bucket[k] ) != GLOB_SUCCESS)  )
+	      {
+		/* ...setting the appropriate error code, in the
 		 * event that the heap memory has been exhausted.
 		 */
-		status = GLOB_NOSPACE;
-
+		free( found );
+		status = glob_status_merge( status, GLOB_NOSPACE );
+	      }
 	      else
-	      { /* This glob match has been successfully recorded on
-		 * the heap, ready for assignment to gl_buf->gl_pathv;
-		 * if this is the first match assigned to this gl_buf,
-		 * and we haven't trapped any prior error...
+		/* This glob match has been successfully recorded.
 		 */
-		if( status == GLOB_NOMATCH )
-		  /*
-		   * ...then record this successful match.
-		   */
-		  status = GLOB_SUCCESS;
-
-		if( (flags & GLOB_NOSORT) == 0 )
-		{
-		  /* The results of this glob are to be sorted in
-		   * collating sequence order; divert the current
-		   * match into the collator.
-		   */
-		  collator = glob_collate_entry( collator, found, flags );
-		}
-		else
-		{ /* Sorting has been suppressed for this glob;
-		   * just add the current match directly into the
-		   * result vector at gl_buf->gl_pathv.
-		   */
-		  glob_store_entry( found, gl_buf );
-		}
-	      }
+		status = glob_status_merge( status, GLOB_SUCCESS );
 	    }
-	  }
-	  /* When we've processed all of the entries in the current
-	   * prefix directory, we may close it.
-	   */
-	  closedir( dp );
 	}
-	/* In the event of failure to open the candidate prefix directory...
+	/* When we've processed all of the entries in the current
+	 * prefix directory, we may close it.
 	 */
-	else if( (flags & GLOB_ERR) || ((errfn != NULL) && errfn(*dirp, errno)) )
-	  /*
-	   * ...and when the caller has set the GLOB_ERR flag, or has provided
-	   * an error handler which returns non-zero for the failure condition,
-	   * then we schedule an abort.
-	   */
-	  status = GLOB_ABORTED;
-
-	/* When we diverted the glob results for collation...
-	 */
-	if( collator != NULL )
-	  /*
-	   * ...then we redirect them to gl_buf->gl_pathv now, before we
-	   * begin a new cycle, to process any further prefix directories
-	   * which may have been identified; note that we do this even if
-	   * we scheduled an abort, so that we may return any results we
-	   * may have already collected before the error occurred.
-	   */
-	  glob_store_collated_entries( collator, gl_buf );
+	closedir( dp );
       }
+      /* In the event of failure to open the candidate prefix directory...
+       */
+      else if( (flags & GLOB_ERR) || ((errfn != NULL) && errfn(*dirp, errno)) )
+	/*
+	 * ...and when the caller has set the GLOB_ERR flag, or has provided
+	 * an error handler which returns non-zero for the failure condition,
+	 * then we schedule an abort.
+	 */
+	status = GLOB_ABORTED;
+
+      /* Unless sorting has been suppressed, collate the results which
+       * we have collected from this directory, before we begin a new
+       * cycle, to process any further prefix directories which may have
+       * been identified; note that we do this even if we scheduled an
+       * abort, so that we may return any results we may have already
+       * collected, in order, before the error occurred.
+       */
+      if( (flags & GLOB_NOSORT) == 0 )
+	for( k = 0; k < count; k++ )
+	  glob_collate_entries( bucket[k], first[k], flags );
+    }
+  }
+  /* Free the memory block allocated for the results vector in the
+   * internal glob buffer, to avoid leaking memory...
+   */
+  free( local_gl_buf.gl_pathv );
+
+  /* ...release the compiled patterns, and if the results were collected
+   * into separate buckets, transfer them to gl_buf, in order...
+   */
+  for( k = 0; k < count; k++ )
+  { free( program[k] );
+    if( bucket[k] != gl_buf )
+    { size_t i;
+      for( i = 0; i < bucket[k]->gl_pathc; i++ )
+	if( glob_store_entry( bucket[k]->gl_pathv[i], gl_buf ) != GLOB_SUCCESS )
+	{ free( bucket[k]->gl_pathv[i] );
+	  status = glob_status_merge( status, GLOB_NOSPACE );
+	}
+      free( bucket[k]->gl_pathv );
     }
-    /* Finally, free the memory block allocated for the results vector
-     * in the internal glob buffer, to avoid leaking memory, before we
-     * return the resultant status code.
+  }
+  /* ...before we return the resultant status code.
+   */
+  return status;
+}
+
+static int glob_match_list
+( const char **patterns, size_t count, int flags, int (*errfn)(), glob_t *gl_buf )
+{
+  /* Local helper function, to perform glob matching for each of a list
+   * of alternative patterns, (as furnished by GLOB_BRACE expansion), in
+   * turn; consecutive alternatives which share a common path name prefix
+   * are delegated, as a group, to glob_match_group(), so that any prefix
+   * directory is scanned only once, for all such alternatives.
+   */
+  int status = GLOB_NOMATCH;
+  size_t i, j;
+
+  for( i = 0; (i < count) && (status != GLOB_ABORTED); i = j )
+  {
+    /* Separate out the path prefix from the current glob pattern...
      */
-    free( local_gl_buf.gl_pathv );
+    char dirbuf[1 + strlen( patterns[i] )];
+    const char *dir = dirname( strcpy( dirbuf, patterns[i] ) );
+    int has_prefix = glob_has_prefix( patterns[i], dir );
+
+    /* ...and identify the following patterns which share it.
+     */
+    for( j = i + 1; j < count; j++ )
+    { char cmpbuf[1 + strlen( patterns[j] )];
+      const char *cmp = dirname( strcpy( cmpbuf, patterns[j] ) );
+      if( (strcmp( cmp, dir ) != 0)
+      ||  (glob_has_prefix( patterns[j], cmp ) != has_prefix) )
+	break;
+    }
+    status = glob_status_merge( status,
+	glob_match_group( dir, has_prefix, patterns + i, j - i, flags, errfn, gl_buf )
+      );
   }
   return status;
 }
 
+static int
+glob_match( const char *pattern, int flags, int (*errfn)(), glob_t *gl_buf )
+{
+  /* Local helper function, to collect the union of all possible matches
+   * to the pattern, in all possible matching directories; when GLOB_BRACE
+   * is specified, all expansions of any brace expressions are collected,
+   * before any glob matching is attempted.
+   */
+  int status;
+  if( (flags & GLOB_BRACE) == GLOB_BRACE )
+  {
+    glob_t alternatives;
+    alternatives.gl_offs = 0;
+    if( (status = glob_initialise( &alternatives )) == GLOB_SUCCESS )
+    {
+      char **altp;
+      if( (status = glob_brace_collect( pattern, flags, &alternatives )) == GLOB_SUCCESS )
+	status = glob_match_list( (const char **)(alternatives.gl_pathv),
+	    alternatives.gl_pathc, flags, errfn, gl_buf
+	  );
+      for( altp = alternatives.gl_pathv; *altp != NULL; free( *altp++ ) )
+	;
+      free( alternatives.gl_pathv );
+    }
+    return status;
+  }
+  return glob_match_list( &pattern, 1, flags, errfn, gl_buf );
+}
+
 #define GLOB_INIT	(1 << __GLOB_FLAG_OFFSET_HIGH_WATER_MARK)
 #define GLOB_FREE	(2 << __GLOB_FLAG_OFFSET_HIGH_WATER_MARK)
 
@@ -0,0 +1,805 @@
+/*
+ * heapcache.c
+ *
+ * Implementation of an opt-in, thread caching, small block allocator,
+ * furnishing __mingw_malloc() and __mingw_calloc(), and also serving the
+ * small, over-aligned, requests of __mingw_aligned_offset_malloc(); blocks
+ * which it has allocated may be released by __mingw_free(), resized by
+ * either of __mingw_realloc(), or __mingw_aligned_realloc(), or measured
+ * by malloc_usable_size().
+ *
+ * $Id$
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR THE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * Every call to MSVCRT.DLL's malloc(), or free(), must acquire the lock
+ * which serializes access to the process heap; in heavily multithreaded
+ * applications, contention for this lock may come to dominate.  For small
+ * blocks, (of up to HEAP_MAX_SMALL bytes), this allocator avoids it, in
+ * the manner of Google's TCMalloc, with three tiers:
+ *
+ *   - each thread maintains its own cache, comprising one free list for
+ *     each size class; most allocations, and most releases, are served
+ *     from, or to, these lists, without any locking whatsoever;
+ *
+ *   - when a thread's list is exhausted, or becomes overfull, objects are
+ *     transferred, a batch at a time, from, or to, the central free list
+ *     for the size class; each such central list has its own lock, and it
+ *     parks whole batches in a "transfer cache", so that a batch released
+ *     by one thread may be passed, intact, to another;
+ *
+ *   - the central lists carve objects from "spans", each of which is a
+ *     run of contiguous pages, dedicated to a single size class, and
+ *     obtained from a page level allocator, which manages one contiguous
+ *     address range, (the "arena"), reserved by VirtualAlloc().
+ *
+ * Since all small blocks lie within the arena, any pointer may be claimed
+ * by the allocator, (or not), by a simple address range check; this check
+ * is performed by __mingw_free(), and __mingw_realloc(), BEFORE they may
+ * attempt to identify an aligned heap block, by its "low water mark", (so
+ * that they will never inspect the memory preceding an arena block).  All
+ * larger blocks, and all requests which cannot be satisfied within the
+ * arena, are delegated to MSVCRT.DLL's malloc().
+ *
+ * Over-aligned requests, for any power of two alignment up to the page
+ * size, (and with no offset), are also served from the arena, by choosing
+ * a size class whose size is a multiple of the alignment; such blocks need
+ * no alignment header, and they may grow in place, up to their class size.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <errno.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include "heapcache.h"
+
+/* The page size is a property of the allocator, rather than of the host;
+ * (spans must begin on page boundaries, so the arena base address, which
+ * VirtualAlloc() aligns to a 64k allocation granularity boundary, is also
+ * suitably aligned).
+ */
+#define HEAP_PAGE_SHIFT 	13
+#define HEAP_PAGE_SIZE		(1 << HEAP_PAGE_SHIFT)
+
+/* The arena is reserved, but not committed, on first use; we attempt to
+ * reserve HEAP_ARENA_SIZE bytes, successively halving the request, down
+ * to HEAP_ARENA_MINSIZE, if the address space is congested.
+ */
+#ifdef _WIN64
+# define HEAP_ARENA_SIZE	((size_t)(1) << 30)
+#else
+# define HEAP_ARENA_SIZE	((size_t)(1) << 27)
+#endif
+#define HEAP_ARENA_MINSIZE	((size_t)(1) << 24)
+#define HEAP_ARENA_PAGES	(HEAP_ARENA_SIZE >> HEAP_PAGE_SHIFT)
+
+/* Blocks of up to HEAP_MAX_SMALL bytes are allocated from the arena; they
+ * are rounded up to one of HEAP_CLASSES size classes, which are spaced at
+ * 16 byte intervals up to 128 bytes, then four per power of two, (such
+ * that internal fragmentation never exceeds 25%), up to HEAP_MAX_SMALL.
+ */
+#define HEAP_MAX_SMALL		32768
+#define HEAP_CLASSES		40
+
+/* Spans comprise no more than HEAP_MAX_SPAN_PAGES pages; each central
+ * transfer cache may hold up to HEAP_TRANSFER_SLOTS batches.
+ */
+#define HEAP_MAX_SPAN_PAGES	64
+#define HEAP_TRANSFER_SLOTS	32
+
+typedef
+struct heap_span
+{ /* Descriptor for a span; the pointer links associate it with either
+   * a central free list, (while it has objects available), or with one
+   * of the page level allocator's free span lists, (when it is unused).
+   */
+  struct heap_span	*next;
+  struct heap_span	*prev;
+  void			*free;		/* objects returned to this span    */
+  char			*bump;		/* first object never yet allocated */
+  char			*limit; 	/* end of the span's last object    */
+  size_t		 page;		/* index of the span's first page   */
+  unsigned short	 sizeclass;	/* zero, when the span is unused    */
+  unsigned short	 npages;
+  unsigned int		 live;		/* objects currently allocated	    */
+} heap_span;
+
+typedef
+struct heap_central
+{ /* A central free list, for one size class.
+   */
+  volatile LONG 	 lock;
+  heap_span		*spans; 	/* spans with objects available     */
+  size_t		 objects;	/* capacity of all spans, combined  */
+  size_t		 live;		/* objects allocated from all spans */
+  unsigned int		 batches;
+  void			*batch[HEAP_TRANSFER_SLOTS];
+} heap_central;
+
+typedef
+struct heap_cache
+{ /* A thread's cache; each of its lists is a chain of free objects,
+   * linked through their first pointer sized words.
+   */
+  struct
+  { void		*head;
+    unsigned int	 count;
+  }			 list[1 + HEAP_CLASSES];
+} heap_cache;
+
+/* A thread's cache pointer is NULL, until the cache is created; after
+ * the cache has been released, at thread exit, it is set to this value,
+ * so that any subsequent requests, (from other thread exit handlers),
+ * are passed directly to the central free lists.
+ */
+#define HEAP_CACHE_DEFUNCT	((heap_cache *)(1))
+
+static __thread heap_cache *heap_thread_cache;
+
+static int heap_state;
+static DWORD heap_tls_key = TLS_OUT_OF_INDEXES;
+static unsigned int heap_cache_class;
+
+static unsigned int heap_class_size[1 + HEAP_CLASSES];
+static unsigned int heap_class_pages[1 + HEAP_CLASSES];
+static unsigned int heap_class_batch[1 + HEAP_CLASSES];
+
+static heap_central heap_central_list[1 + HEAP_CLASSES];
+
+static volatile LONG heap_page_lock;
+static size_t heap_arena_pages, heap_arena_top, heap_free_pages;
+static heap_span *heap_free_spans[1 + HEAP_MAX_SPAN_PAGES];
+static heap_span *heap_descriptors;
+static heap_span *heap_pagemap[HEAP_ARENA_PAGES];
+
+/* Cached objects are released, at thread exit, by a TLS key destructor,
+ * registered with the MinGW thread support API.
+ */
+int __mingwthr_key_dtor( DWORD, void (*)(void *) );
+
+static __inline__ void heap_lock( volatile LONG *lock )
+{ while( InterlockedCompareExchange( lock, 1, 0 ) != 0 ) Sleep( 0 ); }
+
+static __inline__ void heap_unlock( volatile LONG *lock )
+{ InterlockedExchange( lock, 0 ); }
+
+static __inline__ __attribute__((__always_inline__))
+unsigned int heap_size_class( size_t size )
+{
+  /* Map a request size, (which must be non-zero, and no greater than
+   * HEAP_MAX_SMALL), to the index of its size class.
+   */
+  unsigned int k;
+
+  if( size <= 128 ) return (size + 15) >> 4;
+  k = 31 - __builtin_clz( --size );
+  return 9 + ((k - 7) << 2) + ((size - (1 << k)) >> (k - 2));
+}
+
+static __inline__ __attribute__((__always_inline__))
+char *heap_page_address( size_t page )
+{ return (char *)(__mingw_heap_arena.base) + (page << HEAP_PAGE_SHIFT); }
+
+static __inline__ __attribute__((__always_inline__))
+heap_span *heap_span_of( void *ptr )
+{
+  return heap_pagemap[((uintptr_t)(ptr) - __mingw_heap_arena.base)
+    >> HEAP_PAGE_SHIFT];
+}
+
+static heap_span *heap_descriptor( void )
+{
+  /* Allocate a span descriptor; these are carved from arena pages, which
+   * are committed one at a time, as required.  Descriptors are recycled,
+   * but never released; the caller must hold the page lock.
+   */
+  heap_span *span;
+
+  if( heap_descriptors == NULL )
+  { char *page; size_t offset;
+
+    if( heap_arena_top >= heap_arena_pages ) return NULL;
+    page = heap_page_address( heap_arena_top );
+    if( VirtualAlloc( page, HEAP_PAGE_SIZE, MEM_COMMIT, PAGE_READWRITE ) == NULL )
+      return NULL;
+
+    ++heap_arena_top;
+    for( offset = 0; HEAP_PAGE_SIZE - offset >= sizeof( heap_span );
+	 offset += sizeof( heap_span ) )
+    { span = (heap_span *)(page + offset);
+      span->next = heap_descriptors; heap_descriptors = span;
+    }
+  }
+  span = heap_descriptors; heap_descriptors = span->next;
+  memset( span, 0, sizeof( heap_span ) );
+  return span;
+}
+
+static heap_span *heap_span_alloc( unsigned int npages )
+{
+  /* The page level allocator; it returns a descriptor for an unused span
+   * of "npages" committed pages, or NULL if no such span is available.
+   * The caller must hold the page lock.
+   */
+  heap_span *span, *rest;
+  unsigned int n;
+
+  /* Released spans are recycled, by preference, when an exact match for
+   * the requested size is available...
+   */
+  if( (span = heap_free_spans[npages]) != NULL )
+  { heap_free_spans[npages] = span->next;
+    heap_free_pages -= npages;
+    return span;
+  }
+  /* ...otherwise, we commit fresh pages from the top of the arena...
+   */
+  if( (span = heap_descriptor()) == NULL ) return NULL;
+  if( ((heap_arena_pages - heap_arena_top) >= npages)
+  &&  (VirtualAlloc( heap_page_address( heap_arena_top ),
+	npages << HEAP_PAGE_SHIFT, MEM_COMMIT, PAGE_READWRITE ) != NULL)  )
+  { span->page = heap_arena_top; span->npages = npages;
+    heap_arena_top += npages;
+    return span;
+  }
+  /* ...and only when the arena is full do we split a larger released
+   * span, using the descriptor which we've just allocated to return its
+   * excess pages to the appropriate free list.
+   */
+  for( n = npages + 1; n <= HEAP_MAX_SPAN_PAGES; n++ )
+    if( (rest = heap_free_spans[n]) != NULL )
+    { heap_free_spans[n] = rest->next;
+      span->page = rest->page + npages; span->npages = n - npages;
+      span->next = heap_free_spans[span->npages];
+      heap_free_spans[span->npages] = span;
+      heap_free_pages -= npages;
+      rest->npages = npages;
+      return rest;
+    }
+  span->next = heap_descriptors; heap_descriptors = span;
+  return NULL;
+}
+
+static void heap_span_release( heap_span *span )
+{
+  /* Return an entirely free span to the page level allocator; its pages
+   * remain committed, for prompt reuse.
+   */
+  span->sizeclass = 0;
+  heap_lock( &heap_page_lock );
+  span->next = heap_free_spans[span->npages];
+  heap_free_spans[span->npages] = span;
+  heap_free_pages += span->npages;
+  heap_unlock( &heap_page_lock );
+}
+
+static __inline__ __attribute__((__always_inline__))
+void heap_span_link( heap_central *central, heap_span *span )
+{
+  /* Add a span to a central list's chain of spans with objects available.
+   */
+  span->prev = NULL;
+  if( (span->next = central->spans) != NULL ) span->next->prev = span;
+  central->spans = span;
+}
+
+static __inline__ __attribute__((__always_inline__))
+void heap_span_unlink( heap_central *central, heap_span *span )
+{
+  /* Remove a span from a central list's chain of available spans.
+   */
+  if( span->next != NULL ) span->next->prev = span->prev;
+  if( span->prev != NULL ) span->prev->next = span->next;
+  else central->spans = span->next;
+}
+
+static __inline__ __attribute__((__always_inline__))
+int heap_span_exhausted( heap_span *span )
+{ return (span->free == NULL) && (span->bump == span->limit); }
+
+static heap_span *heap_central_grow( unsigned int c )
+{
+  /* Obtain a new span, from the page level allocator, and dedicate it to
+   * size class "c"; the caller must hold the central lock for "c".
+   */
+  heap_span *span;
+  unsigned int i;
+  char *base;
+
+  heap_lock( &heap_page_lock );
+  span = heap_span_alloc( heap_class_pages[c] );
+  heap_unlock( &heap_page_lock );
+  if( span == NULL ) return NULL;
+
+  /* Objects are carved from the span lazily, so that its pages are not
+   * touched, until they are actually needed.
+   */
+  base = heap_page_address( span->page );
+  span->sizeclass = c; span->live = 0; span->free = NULL; span->bump = base;
+  span->limit = base + ((span->npages << HEAP_PAGE_SHIFT) / heap_class_size[c])
+    * heap_class_size[c];
+  for( i = 0; i < span->npages; i++ ) heap_pagemap[span->page + i] = span;
+  heap_central_list[c].objects += (span->limit - base) / heap_class_size[c];
+  return span;
+}
+
+static unsigned int heap_central_fetch( unsigned int c, unsigned int want, void **chain )
+{
+  /* Fetch up to "want" objects, of size class "c", from the central free
+   * list, returning them as a NULL terminated "chain"; returns the number
+   * of objects actually fetched, which is zero if the arena is exhausted.
+   */
+  heap_central *central = heap_central_list + c;
+  unsigned int count = 0;
+  void *head = NULL;
+
+  heap_lock( &central->lock );
+  if( (want == heap_class_batch[c]) && (central->batches > 0) )
+  { /* A complete batch is available in the transfer cache; we may
+     * simply hand it over, without inspecting its content.
+     */
+    *chain = central->batch[--central->batches];
+    heap_unlock( &central->lock );
+    return want;
+  }
+  while( count < want )
+  { heap_span *span;
+
+    if( ((span = central->spans) == NULL)
+    &&  ((span = heap_central_grow( c )) != NULL)  )
+      heap_span_link( central, span );
+
+    if( span == NULL ) break;
+    while( count < want )
+    { void *obj;
+
+      if( (obj = span->free) != NULL ) span->free = *(void **)(obj);
+      else if( span->bump < span->limit )
+      { obj = span->bump; span->bump += heap_class_size[c];
+      }
+      else break;
+      *(void **)(obj) = head; head = obj;
+      ++span->live; ++count;
+    }
+    if( heap_span_exhausted( span ) ) heap_span_unlink( central, span );
+  }
+  central->live += count;
+  heap_unlock( &central->lock );
+  *chain = head;
+  return count;
+}
+
+static void heap_central_release( unsigned int c, void *chain, unsigned int count )
+{
+  /* Return a NULL terminated "chain" of "count" objects, of size class
+   * "c", to the central free list; a complete batch is parked intact, in
+   * the transfer cache, if there is room; otherwise each object is
+   * returned to its own span, and any span which thus becomes entirely
+   * free is returned to the page level allocator.
+   */
+  heap_central *central = heap_central_list + c;
+
+  heap_lock( &central->lock );
+  if( (count == heap_class_batch[c]) && (central->batches < HEAP_TRANSFER_SLOTS) )
+    central->batch[central->batches++] = chain;
+
+  else while( chain != NULL )
+  { void *next = *(void **)(chain);
+    heap_span *span = heap_span_of( chain );
+
+    if( heap_span_exhausted( span ) ) heap_span_link( central, span );
+    *(void **)(chain) = span->free; span->free = chain;
+    --central->live;
+    if( --span->live == 0 )
+    { central->objects -= (span->limit - heap_page_address( span->page ))
+	/ heap_class_size[c];
+      heap_span_unlink( central, span );
+      heap_span_release( span );
+    }
+    chain = next;
+  }
+  heap_unlock( &central->lock );
+}
+
+static void heap_cache_release( heap_cache *cache, unsigned int c, unsigned int count )
+{
+  /* Detach the leading "count" objects from a thread's list, for size
+   * class "c", and return them to the central free list.
+   */
+  void *chain = cache->list[c].head, **link = chain;
+  unsigned int n = count;
+
+  while( --n > 0 ) link = *link;
+  cache->list[c].head = *link; *link = NULL;
+  cache->list[c].count -= count;
+  heap_central_release( c, chain, count );
+}
+
+static void heap_thread_exit( void *cache )
+{
+  /* TLS key destructor; it returns all objects held in the exiting
+   * thread's cache, and the cache itself, to the central free lists.
+   */
+  heap_cache *tc = cache;
+  unsigned int c;
+
+  heap_thread_cache = HEAP_CACHE_DEFUNCT;
+  for( c = 1; c <= HEAP_CLASSES; c++ )
+    if( tc->list[c].count > 0 )
+      heap_cache_release( tc, c, tc->list[c].count );
+
+  *(void **)(tc) = NULL;
+  heap_central_release( heap_cache_class, tc, 1 );
+}
+
+static heap_cache *heap_cache_create( void )
+{
+  /* Create the calling thread's cache, (which is itself allocated from
+   * the arena), and register it for release at thread exit; returns NULL,
+   * without creating a cache, if either step would fail.
+   */
+  heap_cache *cache;
+  DWORD error;
+  void *chain;
+
+  if( (heap_tls_key == TLS_OUT_OF_INDEXES)
+  ||  (heap_central_fetch( heap_cache_class, 1, &chain ) == 0)  )
+    return NULL;
+
+  /* We must not allow TlsSetValue() to clobber the caller's view of
+   * GetLastError(), (which malloc() is not expected to modify).
+   */
+  error = GetLastError();
+  if( ! TlsSetValue( heap_tls_key, cache = chain ) )
+  { heap_central_release( heap_cache_class, chain, 1 );
+    cache = NULL;
+  }
+  else memset( cache, 0, sizeof( heap_cache ) );
+  SetLastError( error );
+  return heap_thread_cache = cache;
+}
+
+static void heap_free( void *ptr );
+static void *heap_realloc( void *ptr, size_t want, size_t align );
+static size_t heap_usable_size( void *ptr );
+static void heap_info( struct mallinfo2 *info );
+static void *heap_aligned_malloc( size_t want, size_t align );
+
+static int heap_init( void )
+{
+  /* Reserve the arena, and initialize the size class tables, on first
+   * use; returns non-zero if the allocator is available.
+   */
+  heap_lock( &heap_page_lock );
+  if( heap_state == 0 )
+  { size_t size = HEAP_ARENA_SIZE;
+    unsigned int c;
+    void *base;
+
+    while( ((base = VirtualAlloc( NULL, size, MEM_RESERVE, PAGE_NOACCESS )) == NULL)
+    &&  ((size >>= 1) >= HEAP_ARENA_MINSIZE) )
+      ;
+    if( base == NULL ) heap_state = -1;
+    else
+    { for( c = 1; c <= HEAP_CLASSES; c++ )
+      { /* Compute the size of each class, (inverting the mapping which
+	 * is performed by heap_size_class()), the size of each batch, in
+	 * which its objects are transferred, (targetting 32k bytes, but
+	 * within the bounds 2..32 objects), and the number of pages in
+	 * each of its spans, (such that the span accommodates at least
+	 * four objects, with no more than 12.5% left over).
+	 */
+	unsigned int size = 16 * c, batch, pages = 1;
+	if( c > 8 )
+	{ unsigned int k = 7 + ((c - 9) >> 2);
+	  size = (1 << k) + ((((c - 9) & 3) + 1) << (k - 2));
+	}
+	batch = HEAP_MAX_SMALL / size;
+	heap_class_batch[c] = (batch < 2) ? 2 : (batch > 32) ? 32 : batch;
+	while( ((pages << HEAP_PAGE_SHIFT) < (4 * size))
+	||  (((pages << HEAP_PAGE_SHIFT) % size) > ((pages << HEAP_PAGE_SHIFT) >> 3)) )
+	  ++pages;
+	heap_class_pages[c] = pages;
+	heap_class_size[c] = size;
+      }
+      heap_cache_class = heap_size_class( sizeof( heap_cache ) );
+
+      /* Per-thread caching is enabled only if we can arrange for each
+       * thread's cache to be released, when the thread exits.
+       */
+      if( ((heap_tls_key = TlsAlloc()) != TLS_OUT_OF_INDEXES)
+      &&  (__mingwthr_key_dtor( heap_tls_key, heap_thread_exit ) != 0)  )
+      { TlsFree( heap_tls_key );
+	heap_tls_key = TLS_OUT_OF_INDEXES;
+      }
+
+      /* Publish the arena; (no other thread can hold a pointer into it,
+       * before we return, so no further synchronization is required).
+       */
+      heap_arena_pages = size >> HEAP_PAGE_SHIFT;
+      __mingw_heap_arena.base = (uintptr_t)(base);
+      __mingw_heap_arena.free = heap_free;
+      __mingw_heap_arena.realloc = heap_realloc;
+      __mingw_heap_arena.usable_size = heap_usable_size;
+      __mingw_heap_arena.info = heap_info;
+      __mingw_heap_arena.aligned_malloc = heap_aligned_malloc;
+      __mingw_heap_arena.size = size;
+      heap_state = 1;
+    }
+  }
+  heap_unlock( &heap_page_lock );
+  return heap_state > 0;
+}
+
+static __inline__ __attribute__((__always_inline__))
+int heap_ready( void )
+{ return (heap_state > 0) || ((heap_state == 0) && heap_init()); }
+
+static void *heap_alloc( unsigned int c )
+{
+  /* Slow path for heap_class_alloc(); we get here when the calling thread
+   * has no cache, (or its cache is defunct), or when its list for size
+   * class "c" is empty.  Returns NULL, if the arena is unavailable, or
+   * if it is exhausted.
+   */
+  heap_cache *cache = heap_thread_cache;
+  void *chain;
+
+  if( cache == NULL )
+  { if( ! heap_ready() ) return NULL;
+    cache = heap_cache_create();
+  }
+  if( (uintptr_t)(cache) > (uintptr_t)(HEAP_CACHE_DEFUNCT) )
+  { /* Refill the thread's list with a complete batch, retaining all
+     * but the first object, which we return.
+     */
+    unsigned int count = heap_central_fetch( c, heap_class_batch[c], &chain );
+    if( count > 0 )
+    { cache->list[c].head = *(void **)(chain);
+      cache->list[c].count = count - 1;
+      return chain;
+    }
+  }
+  else if( heap_central_fetch( c, 1, &chain ) > 0 )
+    return chain;
+
+  return NULL;
+}
+
+static __inline__ __attribute__((__always_inline__))
+void *heap_class_alloc( unsigned int c )
+{
+  /* Allocate one object of size class "c"; in the common case, this is
+   * served from the calling thread's cache, without further function
+   * calls.
+   */
+  heap_cache *cache;
+  void *ptr;
+
+  if( ((uintptr_t)(cache = heap_thread_cache) > (uintptr_t)(HEAP_CACHE_DEFUNCT))
+  &&  ((ptr = cache->list[c].head) != NULL)  )
+  { cache->list[c].head = *(void **)(ptr);
+    --cache->list[c].count;
+    return ptr;
+  }
+  return heap_alloc( c );
+}
+
+static void *heap_malloc( size_t want )
+{
+  /* Uncounted equivalent of __mingw_malloc(); small requests are served
+   * from the arena, while larger requests, (or any which the arena cannot
+   * accommodate), are deferred to MSVCRT.DLL.
+   */
+  void *ptr;
+
+  if( (want > HEAP_MAX_SMALL)
+  ||  ((ptr = heap_class_alloc( heap_size_class( (want > 0) ? want : 1 ))) == NULL)  )
+    ptr = malloc( want );
+  return ptr;
+}
+
+void *__mingw_malloc( size_t want )
+{
+  /* Public entry point for the preceding; this is distinct from it, only
+   * so that the heap statistics counters may be updated, (when enabled),
+   * for requests which are not part of any reallocation.
+   */
+  return __mingw_heap_tally_alloc( heap_malloc( want ) );
+}
+
+static __inline__ __attribute__((__always_inline__))
+unsigned int heap_aligned_class( size_t want, size_t align )
+{
+  /* Identify the least size class which can accommodate "want" bytes,
+   * (which must not exceed HEAP_MAX_SMALL), and whose size is a multiple
+   * of "align", (a power of two, not exceeding the page size); the largest
+   * class size is a multiple of the page size, so there is always such a
+   * class.
+   */
+  unsigned int c = heap_size_class( (want > 0) ? want : 1 );
+  while( (heap_class_size[c] & (align - 1)) != 0 ) ++c;
+  return c;
+}
+
+static void *heap_aligned_malloc( size_t want, size_t align )
+{
+  /* Entry point, through the arena descriptor, for over-aligned requests
+   * to __mingw_aligned_offset_malloc(), with zero offset, (offered only
+   * after the arena has been reserved); since every span
+   * begins on a page boundary, every object in any size class, whose size
+   * is a multiple of a power of two "align", not exceeding the page size,
+   * is naturally aligned on an "align" boundary.  Thus, we may satisfy
+   * such requests, without any alignment header, from the least such
+   * class which can accommodate "want" bytes.  Returns NULL, without
+   * setting errno, for any request which we cannot satisfy, so that the
+   * caller may fall back to its own strategy.
+   */
+  if( (want > HEAP_MAX_SMALL) || (align > HEAP_PAGE_SIZE) || ! heap_ready() )
+    return NULL;
+
+  return heap_class_alloc( heap_aligned_class( want, align ) );
+}
+
+void *__mingw_calloc( size_t n, size_t size )
+{
+  /* Public entry point, equivalent to calloc(); note that recycled arena
+   * blocks are not zero filled, so we must clear them explicitly.
+   */
+  void *ptr;
+
+  if( (size > 0) && (n > (SIZE_MAX / size)) )
+  { errno = ENOMEM;
+    return NULL;
+  }
+  if( (size *= n) > HEAP_MAX_SMALL )
+    return __mingw_heap_tally_alloc( calloc( size, 1 ) );
+  if( (ptr = __mingw_malloc( size )) != NULL ) memset( ptr, 0, size );
+  return ptr;
+}
+
+static void heap_free( void *ptr )
+{
+  /* Release an arena block; this is called only by __mingw_free(), which
+   * will have verified that "ptr" lies within the arena.
+   */
+  heap_cache *cache = heap_thread_cache;
+  unsigned int c = heap_span_of( ptr )->sizeclass;
+
+  /* A thread which frees blocks, without having allocated any, must
+   * nonetheless have a cache, lest all such blocks contend for the lock
+   * on the central free list.
+   */
+  if( cache == NULL ) cache = heap_cache_create();
+  if( (uintptr_t)(cache) > (uintptr_t)(HEAP_CACHE_DEFUNCT) )
+  { *(void **)(ptr) = cache->list[c].head; cache->list[c].head = ptr;
+    if( ++cache->list[c].count > (heap_class_batch[c] << 1) )
+      heap_cache_release( cache, c, heap_class_batch[c] );
+  }
+  else
+  { *(void **)(ptr) = NULL;
+    heap_central_release( c, ptr, 1 );
+  }
+}
+
+static void *heap_realloc( void *ptr, size_t want, size_t align )
+{
+  /* Resize an arena block; this is called only by __mingw_realloc(), (or
+   * by __mingw_aligned_realloc()), with "ptr" lying within the arena.  The
+   * block is naturally aligned on the greatest power of two boundary, not
+   * exceeding the page size, which divides its class size; when "align"
+   * is non-zero, (in which case it must not exceed this), any resized
+   * block will preserve that alignment, but when "align" is zero, (as
+   * it is for __mingw_realloc()), the block is treated as if allocated
+   * by __mingw_malloc(), with no alignment constraint.
+   */
+  size_t size = heap_class_size[heap_span_of( ptr )->sizeclass];
+  size_t natural = size & -size;
+  void *retptr;
+
+  if( natural > HEAP_PAGE_SIZE ) natural = HEAP_PAGE_SIZE;
+  if( align > natural )
+  { errno = EINVAL;
+    return NULL;
+  }
+
+  /* As for MSVCRT.DLL's realloc(), a request for zero bytes frees the
+   * block; otherwise, a request which the block already accommodates,
+   * without gross waste, (or which no smaller class, of the required
+   * alignment, could accommodate), is satisfied in place; thus, an aligned
+   * block may grow, without copying, up to the size of its class.
+   */
+  if( want == 0 ) { heap_free( ptr ); return NULL; }
+  if( (want <= size) && ((size <= 128) || (want > (size >> 1))
+  ||  (heap_class_size[(align > 0) ? heap_aligned_class( want, align )
+	: heap_size_class( want )] >= size))  )
+    return ptr;
+
+  /* Otherwise, the block must move; when unconstrained, it may move to
+   * any size class, or to MSVCRT.DLL's heap, just as __mingw_malloc()
+   * would place it, (thus avoiding the padding of an alignment header,
+   * which would otherwise persist through every subsequent reallocation),
+   * but an aligned block must move to another aligned size class, if the
+   * new size permits, or else to the aligned heap; (since the data is
+   * always at the start of any block, a single copy suffices).
+   */
+  if( align == 0 ) retptr = heap_malloc( want );
+  else if( (retptr = heap_aligned_malloc( want, align )) == NULL )
+    retptr = __mingw_memalign_malloc( want, align, 0 );
+
+  if( retptr != NULL )
+  { memcpy( retptr, ptr, (want < size) ? want : size );
+    heap_free( ptr );
+  }
+  return retptr;
+}
+
+static size_t heap_usable_size( void *ptr )
+{
+  /* Return the usable size of an arena block, (which is simply the size
+   * of its class); this is called only by malloc_usable_size().
+   */
+  return heap_class_size[heap_span_of( ptr )->sizeclass];
+}
+
+static void heap_info( struct mallinfo2 *info )
+{
+  /* Add the arena's contribution to the mallinfo2() statistics; the
+   * arena is reported as a single directly mapped region, of which the
+   * committed size is given.  Objects which are held in any complete
+   * batch, within a central transfer cache, are reported as free small
+   * blocks, (as are all objects which have yet to be allocated from any
+   * active span), but, since thread caches may not be inspected, (other
+   * than by their owning threads), any objects within them are reported
+   * as being in use.  Committed pages, within released spans, are also
+   * reported as free space.
+   */
+  unsigned int c;
+
+  for( c = 1; c <= HEAP_CLASSES; c++ )
+  { heap_central *central = heap_central_list + c;
+    size_t cached, available;
+
+    heap_lock( &central->lock );
+    cached = central->batches * heap_class_batch[c];
+    available = central->objects - central->live + cached;
+    info->uordblks += (central->live - cached) * heap_class_size[c];
+    heap_unlock( &central->lock );
+
+    info->smblks += available;
+    info->fsmblks += available * heap_class_size[c];
+    info->fordblks += available * heap_class_size[c];
+  }
+  heap_lock( &heap_page_lock );
+  info->hblks += 1;
+  info->hblkhd += heap_arena_top << HEAP_PAGE_SHIFT;
+  info->fordblks += heap_free_pages << HEAP_PAGE_SHIFT;
+  heap_unlock( &heap_page_lock );
+}
+
+/* $RCSfile$: end of file */
@@ -0,0 +1,122 @@
+/*
+ * heapcache.h
+ *
+ * Private header, declaring the interface between the MinGW.org thread
+ * caching small block allocator, the aligned heap management API, and the
+ * optional heap statistics counters.
+ *
+ * $Id$
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+#include <stdint.h>
+#include <stddef.h>
+
+struct mallinfo2;
+
+struct __mingw_heap_arena
+{ /* Describes the single contiguous address range, which is reserved
+   * by the thread caching allocator, on its first use, together with the
+   * entry points through which any block within that range must be freed,
+   * or reallocated, (the latter subject to an alignment constraint, which
+   * is zero, for __mingw_realloc()), or its usable size determined, and
+   * through which the allocator's contribution to mallinfo2() may be
+   * collected; over-aligned requests may also be offered to it, through
+   * its "aligned_malloc" entry point, which returns NULL for any request
+   * which it cannot satisfy.  Until the range is reserved, its size is
+   * zero, so that no pointer can be identified as lying within it, and
+   * all entry points are NULL; thus, none of the heap management functions
+   * need ever refer to any part of the allocator itself, (nor cause it to
+   * reserve its arena), unless the application has used it.
+   */
+  uintptr_t	   base;
+  size_t	   size;
+  void		 (*free)( void * );
+  void		*(*realloc)( void *, size_t, size_t );
+  size_t	 (*usable_size)( void * );
+  void		 (*info)( struct mallinfo2 * );
+  void		*(*aligned_malloc)( size_t, size_t );
+};
+
+/* The storage for this descriptor is allocated alongside that for the
+ * aligned heap's "low water mark", within memalign.c
+ */
+extern struct __mingw_heap_arena __mingw_heap_arena;
+
+static __inline__ __attribute__((__always_inline__))
+int __mingw_heap_arena_block( const void *ptr )
+{
+  /* Identify a pointer to a block which was allocated from the arena;
+   * (note that, since the comparison is unsigned, this is achieved with
+   * just one subtraction, and one comparison).
+   */
+  return ((uintptr_t)(ptr) - __mingw_heap_arena.base) < __mingw_heap_arena.size;
+}
+
+/* Conversely, when the thread caching allocator must move an aligned
+ * block to the aligned heap, it uses this uncounted equivalent of the
+ * public __mingw_aligned_offset_malloc() function.
+ */
+void *__mingw_memalign_malloc( size_t, size_t, size_t );
+
+struct __mingw_heap_tally
+{ /* Entry points through which the heap statistics counters, (as
+   * implemented in heapstat.c), are notified of each block which is
+   * allocated, (identified by its address), and of each which is
+   * released, (identified by its usable size, since it may no longer
+   * be inspected); a reallocation is counted as one of each.
+   */
+  void		 (*alloc)( void * );
+  void		 (*release)( size_t );
+};
+
+/* This is NULL, (as initialized alongside the arena descriptor, within
+ * memalign.c), unless the counters have been enabled; thus, the cost to
+ * any application which does not use them is one test, on each call to
+ * any of the public allocation, or release, functions.
+ */
+extern const struct __mingw_heap_tally *volatile __mingw_heap_tally;
+
+size_t malloc_usable_size( void * );
+
+static __inline__ __attribute__((__always_inline__))
+void *__mingw_heap_tally_alloc( void *ptr )
+{
+  /* Count a newly allocated block, (if any), before returning it.
+   */
+  const struct __mingw_heap_tally *tally = __mingw_heap_tally;
+  if( (tally != NULL) && (ptr != NULL) ) tally->alloc( ptr );
+  return ptr;
+}
+
+static __inline__ __attribute__((__always_inline__))
+void __mingw_heap_tally_release( void *ptr )
+{
+  /* Count the release of a block, (if any), before it is freed.
+   */
+  const struct __mingw_heap_tally *tally = __mingw_heap_tally;
+  if( (tally != NULL) && (ptr != NULL) ) tally->release( malloc_usable_size( ptr ) );
+}
+
+/* $RCSfile$: end of file */
@@ -0,0 +1,340 @@
+/*
+ * heapstat.c
+ *
+ * Implementation of optional per-thread allocation counters, for the
+ * MinGW.org heap allocation functions; these count blocks allocated and
+ * released, the number of bytes in use, its peak value, and a histogram
+ * of block sizes, and may be reported on demand, or at exit.
+ *
+ * $Id$
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR THE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * Each thread is assigned its own record of counters, on its first heap
+ * operation after the counters are enabled; it is the only thread which
+ * ever updates that record, so no interlocked operation is required.  At
+ * thread exit, the record is merged into a common record, which then
+ * accumulates the counts for all threads which have exited, and it may
+ * then be reassigned to a new thread.  A single lock serializes record
+ * assignment, merging, and reporting, but it is never acquired for any
+ * individual heap operation, except by a thread which has already run
+ * its exit handler.
+ *
+ * The counters are attached to the heap allocation functions by a table
+ * of hooks, to which __mingw_heap_tally refers, only while the counters
+ * are enabled; thus, no part of this module is linked into, or has any
+ * run time cost for, an application which does not use it.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include "heapcache.h"
+
+typedef
+struct heap_tally
+{ /* A record of the counters, for one thread; note that, since blocks
+   * may be released by any thread, the number of bytes in use may be
+   * negative, for any individual thread.
+   */
+  struct heap_tally	*next;
+  int			 owned;
+  DWORD 		 thread;
+  size_t		 allocations;
+  size_t		 releases;
+  long long		 bytes;
+  long long		 peak;
+  size_t		 histogram[__MINGW_HEAP_STATS_BINS];
+} heap_tally;
+
+/* A thread's record pointer is NULL, until a record is assigned; after
+ * the thread's exit handler has run, (or if no record could be assigned),
+ * it is set to this value, so that its subsequent heap operations are
+ * counted directly in the common record.
+ */
+#define HEAP_TALLY_DEFUNCT	((heap_tally *)(1))
+
+static __thread heap_tally *heap_thread_tally;
+
+static heap_tally *heap_tally_list, heap_tally_retired;
+static volatile LONG heap_tally_lock;
+static DWORD heap_tally_key = TLS_OUT_OF_INDEXES;
+static unsigned int heap_stats_flags;
+
+/* Records are merged into the common record, at thread exit, by a TLS
+ * key destructor, registered with the MinGW thread support API.
+ */
+int __mingwthr_key_dtor( DWORD, void (*)(void *) );
+
+static __inline__ void heap_stats_lock( void )
+{ while( InterlockedCompareExchange( &heap_tally_lock, 1, 0 ) != 0 ) Sleep( 0 ); }
+
+static __inline__ void heap_stats_unlock( void )
+{ InterlockedExchange( &heap_tally_lock, 0 ); }
+
+static __inline__ __attribute__((__always_inline__))
+unsigned int heap_tally_bin( size_t size )
+{
+  /* Map a block size to its histogram bin; bin zero counts blocks of up
+   * to 16 bytes, and each subsequent bin counts blocks of up to double
+   * the size of the preceding bin, except that the last counts all that
+   * remain.
+   */
+  unsigned int bin = (size > 16) ? 60 - __builtin_clzll( size - 1 ) : 0;
+  return (bin < __MINGW_HEAP_STATS_BINS) ? bin : __MINGW_HEAP_STATS_BINS - 1;
+}
+
+static void heap_tally_update( heap_tally *tally, size_t size, int allocated )
+{
+  /* Update the counters, in a specified record, for one block of "size"
+   * bytes, which has been either "allocated", or released.
+   */
+  if( allocated )
+  { ++tally->allocations;
+    ++tally->histogram[heap_tally_bin( size )];
+    if( (tally->bytes += size) > tally->peak ) tally->peak = tally->bytes;
+  }
+  else
+  { ++tally->releases;
+    tally->bytes -= size;
+  }
+}
+
+static void heap_tally_merge( heap_tally *into, const heap_tally *from )
+{
+  /* Accumulate all counters, from one record, into another; peaks are
+   * summed, (since we cannot know when each occurred), to yield an upper
+   * bound on the combined peak.
+   */
+  unsigned int bin;
+
+  into->allocations += from->allocations;
+  into->releases += from->releases;
+  into->bytes += from->bytes;
+  into->peak += from->peak;
+  for( bin = 0; bin < __MINGW_HEAP_STATS_BINS; bin++ )
+    into->histogram[bin] += from->histogram[bin];
+}
+
+static void heap_tally_exit( void *record )
+{
+  /* TLS key destructor; it merges the exiting thread's counters into the
+   * common record, and releases the thread's record for reassignment.
+   */
+  heap_tally *tally = record;
+
+  heap_thread_tally = HEAP_TALLY_DEFUNCT;
+  heap_stats_lock();
+  heap_tally_merge( &heap_tally_retired, tally );
+  memset( &tally->allocations, 0,
+      sizeof( heap_tally ) - offsetof( heap_tally, allocations )
+    );
+  tally->owned = 0;
+  heap_stats_unlock();
+}
+
+static heap_tally *heap_tally_attach( void )
+{
+  /* Assign a record to the calling thread, preferring to reuse one which
+   * has been released by an exited thread, and register it for merging,
+   * when the thread exits; if this is not possible, the thread's record
+   * pointer is marked as defunct.
+   */
+  heap_tally *tally = NULL;
+  DWORD error;
+
+  if( heap_tally_key != TLS_OUT_OF_INDEXES )
+  { heap_stats_lock();
+    for( tally = heap_tally_list; (tally != NULL) && tally->owned; tally = tally->next )
+      ;
+    /* Note that this calloc() is MSVCRT.DLL's, so the allocation of the
+     * record is not itself counted.
+     */
+    if( (tally == NULL) && ((tally = calloc( 1, sizeof( heap_tally ) )) != NULL) )
+    { tally->next = heap_tally_list;
+      heap_tally_list = tally;
+    }
+    if( tally != NULL )
+    { tally->thread = GetCurrentThreadId();
+      tally->owned = 1;
+    }
+    heap_stats_unlock();
+  }
+  if( tally == NULL ) return heap_thread_tally = HEAP_TALLY_DEFUNCT;
+
+  /* As in the thread caching allocator, we must not allow TlsSetValue()
+   * to clobber the caller's view of GetLastError().
+   */
+  error = GetLastError();
+  if( ! TlsSetValue( heap_tally_key, tally ) )
+  { heap_stats_lock();
+    tally->owned = 0;
+    heap_stats_unlock();
+    tally = HEAP_TALLY_DEFUNCT;
+  }
+  SetLastError( error );
+  return heap_thread_tally = tally;
+}
+
+static void heap_tally_count( size_t size, int allocated )
+{
+  /* Count one heap operation, on behalf of the calling thread.
+   */
+  heap_tally *tally;
+
+  if( (tally = heap_thread_tally) == NULL ) tally = heap_tally_attach();
+  if( (uintptr_t)(tally) > (uintptr_t)(HEAP_TALLY_DEFUNCT) )
+    heap_tally_update( tally, size, allocated );
+
+  else
+  { heap_stats_lock();
+    heap_tally_update( &heap_tally_retired, size, allocated );
+    heap_stats_unlock();
+  }
+}
+
+static void heap_tally_alloc( void *ptr )
+{ heap_tally_count( malloc_usable_size( ptr ), 1 ); }
+
+static void heap_tally_release( size_t size )
+{ heap_tally_count( size, 0 ); }
+
+static const struct __mingw_heap_tally heap_tally_hooks =
+{ heap_tally_alloc, heap_tally_release };
+
+static void heap_stats_at_exit( void )
+{ if( (heap_stats_flags & __MINGW_HEAP_STATS_AT_EXIT) != 0 ) __mingw_heap_stats_dump(); }
+
+unsigned int __mingw_heap_stats_enable( unsigned int flags )
+{
+  /* Public entry point, to enable, or to suspend counting, and to select
+   * whether the counters are to be reported at exit; returns the flags
+   * which were previously in effect.
+   */
+  static int initialized = 0;
+  unsigned int previous;
+
+  heap_stats_lock();
+  if( ! initialized )
+  { /* On first use, we allocate the TLS key, (without which threads can
+     * have no individual records, and all counts are accumulated in the
+     * common record), and register the exit time report.
+     */
+    if( ((heap_tally_key = TlsAlloc()) != TLS_OUT_OF_INDEXES)
+    &&  (__mingwthr_key_dtor( heap_tally_key, heap_tally_exit ) != 0)  )
+    { TlsFree( heap_tally_key );
+      heap_tally_key = TLS_OUT_OF_INDEXES;
+    }
+    atexit( heap_stats_at_exit );
+    initialized = 1;
+  }
+  previous = heap_stats_flags;
+  heap_stats_flags = flags;
+  __mingw_heap_tally = (flags & __MINGW_HEAP_STATS_ENABLE) ? &heap_tally_hooks : NULL;
+  heap_stats_unlock();
+  return previous;
+}
+
+static void heap_stats_collect( heap_tally *total )
+{
+  /* Sum the counters for all threads, (including those which have exited);
+   * the caller must hold the lock.  Records of active threads are read
+   * while those threads may be updating them, so the result is a close
+   * approximation, rather than an exact snapshot.
+   */
+  heap_tally *tally;
+
+  *total = heap_tally_retired;
+  for( tally = heap_tally_list; tally != NULL; tally = tally->next )
+    if( tally->owned ) heap_tally_merge( total, tally );
+}
+
+void __mingw_heap_stats( struct __mingw_heap_stats *stats )
+{
+  /* Public entry point, to retrieve the aggregated counters; a negative
+   * number of bytes in use, (which may be reported when blocks which were
+   * allocated before the counters were enabled are subsequently released),
+   * is clamped at zero.
+   */
+  heap_tally total;
+
+  heap_stats_lock();
+  heap_stats_collect( &total );
+  heap_stats_unlock();
+
+  stats->allocations = total.allocations;
+  stats->releases = total.releases;
+  stats->bytes = (total.bytes > 0) ? total.bytes : 0;
+  stats->peak = total.peak;
+  memcpy( stats->histogram, total.histogram, sizeof( stats->histogram ) );
+}
+
+static void heap_stats_line( const char *label, DWORD thread, const heap_tally *tally )
+{
+  /* Helper, to write one line of the report.
+   */
+  if( label == NULL ) __mingw_fprintf( stderr, "%10lu", (unsigned long)(thread) );
+  else __mingw_fprintf( stderr, "%10s", label );
+  __mingw_fprintf( stderr, " %14zu %14zu %16lld %16lld\n",
+      tally->allocations, tally->releases, tally->bytes, tally->peak
+    );
+}
+
+void __mingw_heap_stats_dump( void )
+{
+  /* Public entry point, to report the counters, for each active thread,
+   * for all exited threads, and in aggregate, followed by the histogram
+   * of allocated block sizes, to stderr; (the lock is held throughout,
+   * so that the report is self consistent).
+   */
+  heap_tally *tally, total;
+  unsigned int bin;
+
+  heap_stats_lock();
+  __mingw_fprintf( stderr, "%10s %14s %14s %16s %16s\n",
+      "thread", "allocations", "releases", "bytes in use", "peak bytes"
+    );
+  for( tally = heap_tally_list; tally != NULL; tally = tally->next )
+    if( tally->owned ) heap_stats_line( NULL, tally->thread, tally );
+  heap_stats_line( "exited", 0, &heap_tally_retired );
+  heap_stats_collect( &total );
+  heap_stats_line( "total", 0, &total );
+
+  __mingw_fprintf( stderr, "\n%10s %14s\n", "size <=", "allocations" );
+  for( bin = 0; bin < __MINGW_HEAP_STATS_BINS; bin++ )
+    if( total.histogram[bin] > 0 )
+    { if( bin < __MINGW_HEAP_STATS_BINS - 1 )
+	__mingw_fprintf( stderr, "%10zu", (size_t)(16) << bin );
+      else __mingw_fprintf( stderr, "%10s", "larger" );
+      __mingw_fprintf( stderr, " %14zu\n", total.histogram[bin] );
+    }
+  heap_stats_unlock();
+}
+
+/* $RCSfile$: end of file */
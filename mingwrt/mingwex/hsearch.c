@@ -0,0 +1,182 @@
+/*
+ * hsearch.c
+ *
+ * Implementation of the POSIX hcreate(), hsearch(), and hdestroy() hash
+ * table management functions, together with their reentrant GNU style
+ * hcreate_r(), hsearch_r(), and hdestroy_r() counterparts.
+ *
+ * $Id$
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR THE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+#define _GNU_SOURCE
+#define _POSIX_C_SOURCE 200809L
+
+#include <search.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+
+/* Each hash table is an open-addressed array of slots, of which the
+ * number is always a power of two, and which is searched by linear
+ * probing; each slot records the full hash value of the key which it
+ * holds, so that strcmp() need be called only for a probable match,
+ * (and the hash need never be recomputed).  A slot is vacant when its
+ * key pointer is NULL.
+ */
+struct __hsearch_entry
+{ unsigned int	 hash;
+  ENTRY		 entry;
+};
+
+/* To keep probe sequences short, no table is ever permitted to become
+ * more than three quarters full; the table size is chosen, when it is
+ * created, such that this limit admits at least as many entries as the
+ * user requested, (and we also guarantee that at least one slot always
+ * remains vacant, to terminate any unsuccessful search).
+ */
+#define HSEARCH_MINSIZE		8
+#define HSEARCH_LIMIT(SIZE)	((SIZE) - ((SIZE) >> 2))
+
+static unsigned int hsearch_hash( const char *key )
+{
+  /* Compute the hash value for a NUL terminated string key; this uses
+   * the FNV-1a algorithm, to accumulate each byte of the key, followed
+   * by the MurmurHash3 finalization mix, to ensure that every bit of
+   * the key influences the low order bits of the result, which are
+   * those used to select the initial probe slot.
+   */
+  unsigned int hash = 2166136261U;
+  while( *key ) hash = (hash ^ (unsigned char)(*key++)) * 16777619U;
+
+  hash ^= hash >> 16; hash *= 0x85EBCA6BU;
+  hash ^= hash >> 13; hash *= 0xC2B2AE35U;
+  return hash ^ (hash >> 16);
+}
+
+int hcreate_r( size_t nel, struct hsearch_data *htab )
+{
+  /* Allocate the slot array for a new hash table, with capacity for
+   * at least "nel" entries; the table descriptor must not already be
+   * associated with any existing table.
+   */
+  size_t size = HSEARCH_MINSIZE;
+
+  if( (htab == NULL) || (htab->table != NULL) )
+  { errno = EINVAL; return 0; }
+
+  while( HSEARCH_LIMIT( size ) < nel )
+  { if( (size > (UINT_MAX >> 1))
+    ||  (size > (SIZE_MAX / (2 * sizeof (struct __hsearch_entry)))) )
+    { errno = ENOMEM; return 0; }
+    size <<= 1;
+  }
+  if( (htab->table = calloc( size, sizeof (struct __hsearch_entry) )) == NULL )
+    return 0;
+
+  htab->size = size;
+  htab->filled = 0;
+  return 1;
+}
+
+int hsearch_r
+( ENTRY item, ACTION action, ENTRY **retval, struct hsearch_data *htab )
+{
+  /* Search the hash table described by "htab", for an entry having a
+   * key which matches that of "item", (optionally adding "item" as a
+   * new entry, if no match is found); on success, a pointer to the
+   * matching, (or newly added), entry is stored in "*retval", and
+   * the function returns non-zero.
+   */
+  unsigned int hash, mask, slot;
+  struct __hsearch_entry *table;
+
+  if( retval != NULL ) *retval = NULL;
+  if( (htab == NULL) || ((table = htab->table) == NULL)
+  ||  (retval == NULL) || (item.key == NULL) )
+  { errno = EINVAL; return 0; }
+
+  /* Probe for the key, starting from the slot which is selected by
+   * its hash value, and proceeding linearly until either a matching
+   * entry, or a vacant slot, is found.
+   */
+  mask = htab->size - 1;
+  slot = (hash = hsearch_hash( item.key )) & mask;
+  while( table[slot].entry.key != NULL )
+  { if( (table[slot].hash == hash)
+    &&  (strcmp( table[slot].entry.key, item.key ) == 0) )
+    { *retval = &table[slot].entry; return 1; }
+    slot = (slot + 1) & mask;
+  }
+  /* There is no matching entry; if the caller did not request that
+   * one should be added, or if the table is already at its maximum
+   * permitted load, then the search has failed...
+   */
+  if( action != ENTER )
+  { errno = ESRCH; return 0; }
+
+  if( htab->filled >= HSEARCH_LIMIT( htab->size ) )
+  { errno = ENOMEM; return 0; }
+
+  /* ...otherwise, the vacant slot at which the search terminated is
+   * where the new entry belongs.
+   */
+  table[slot].hash = hash; table[slot].entry = item;
+  *retval = &table[slot].entry; ++htab->filled;
+  return 1;
+}
+
+void hdestroy_r( struct hsearch_data *htab )
+{
+  /* Release the slot array associated with a hash table; (note that
+   * we do NOT free the key, nor the data, associated with any entry,
+   * since these remain the property of the caller).
+   */
+  if( htab != NULL )
+  { free( htab->table );
+    htab->table = NULL; htab->size = htab->filled = 0;
+  }
+}
+
+/* The POSIX functions are simple wrappers around their reentrant
+ * counterparts, operating on a single, process global, hash table.
+ */
+static struct hsearch_data hsearch_table;
+
+int hcreate( size_t nel )
+{ return hcreate_r( nel, &hsearch_table ); }
+
+ENTRY *hsearch( ENTRY item, ACTION action )
+{
+  ENTRY *retval;
+  hsearch_r( item, action, &retval, &hsearch_table );
+  return retval;
+}
+
+void hdestroy( void )
+{ hdestroy_r( &hsearch_table ); }
+
+/* $RCSfile$: end of file */
@@ -0,0 +1,66 @@
+/*
+ * mallinfo.c
+ *
+ * Implementation of a GNU compatible mallinfo2() function, reporting the
+ * state of the MSVCRT.DLL heap, together with that of the MinGW.org thread
+ * caching allocator's arena, (if it has been used).
+ *
+ * $Id$
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR THE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+#include <malloc.h>
+#include <string.h>
+
+#include "heapcache.h"
+
+struct mallinfo2 mallinfo2( void )
+{
+  /* Walk the MSVCRT.DLL heap, accumulating the sizes of its allocated,
+   * and free, entries; (note that _heapwalk() holds the heap lock only
+   * for the duration of each step, so the result is not an atomic
+   * snapshot, if other threads are concurrently active).
+   */
+  struct mallinfo2 info;
+  _HEAPINFO entry;
+
+  memset( &info, 0, sizeof( info ) );
+  entry._pentry = NULL;
+  while( _heapwalk( &entry ) == _HEAPOK )
+  { info.arena += entry._size;
+    if( entry._useflag == _USEDENTRY ) info.uordblks += entry._size;
+    else
+    { info.fordblks += entry._size;
+      ++info.ordblks;
+    }
+  }
+  /* The thread caching allocator adds its own contribution, but only if
+   * its arena has been reserved; (until then, the size of the arena, as
+   * published in its descriptor, remains zero).
+   */
+  if( __mingw_heap_arena.size != 0 ) __mingw_heap_arena.info( &info );
+  return info;
+}
+
+/* $RCSfile$: end of file */
@@ -89,6 +89,15 @@ int __mingw_mbtowc_convert
   unsigned int flags = MB_ERR_INVALID_CHARS;
   if( n == 0 ) n = (size_t)(-1);
 
+  /* When the active codeset is CP_UTF8, we use our own transcoder,
+   * which is both faster than MultiByteToWideChar(), and reliable in
+   * its detection of ill-formed sequences...
+   */
+  if( codeset == CP_UTF8 )
+    return __mingw_utf8_to_utf16( s, n, wc, wmax );
+
+  /* ...otherwise, we delegate to the Windows API.
+   */
   do { SetLastError( 0 );
        st = MultiByteToWideChar( codeset, flags, s, n, wc, wmax );
      } while( (st == (flags = 0)) && (GetLastError() == ERROR_INVALID_FLAGS) );
@@ -9,7 +9,7 @@
  * $Id$
  *
  * Written by Keith Marshall <keith@users.osdn.me>
- * Copyright (C) 2018, 2019, MinGW.org Project
+ * Copyright (C) 2018, 2019, 2026, MinGW.org Project
  *
  * Derived (with extensive modification) from, and replacing, the original
  * mingw-aligned-malloc.c implementation:
@@ -49,6 +49,7 @@
  *   gcc -c -D__mingw_aligned_realloc_case -o aligned-realloc.o memalign.c
  *   gcc -c -D__mingw_realloc_case -o mingw-realloc.o memalign.c
  *   gcc -c -D__mingw_free_case -o mingw-free.o memalign.c
+ *   gcc -c -D__mingw_usable_size_case -o usable-size.o memalign.c
  *
  */
 #include <malloc.h>
@@ -56,6 +57,12 @@
 #include <stddef.h>
 #include <errno.h>
 
+/* Blocks allocated by the thread caching allocator, (as implemented in
+ * heapcache.c), must be identified, and excluded from consideration as
+ * aligned heap blocks; this private header declares the requisite API.
+ */
+#include "heapcache.h"
+
 /* Regardless of whatever may have been inherited from the preceding
  * headers, ensure that we can use "dllimport" semantics when referring
  * to specific MSVCRT.DLL functions.
@@ -231,6 +238,25 @@ __CRT_ALIAS void record_low_water_mark( void *ptr )
 DLL_IMPORT __cdecl __MINGW_NOTHROW  void  __msvcrt_free (void *);
 DLL_IMPORT __cdecl __MINGW_NOTHROW  void *__msvcrt_realloc (void *, size_t );
 
+__CRT_ALIAS void *memalign_tally_realloc
+( const struct __mingw_heap_tally *tally, void *ptr, size_t size,
+  void *retptr, size_t want
+)
+{ /* Helper to update the heap statistics counters, (when enabled), on
+   * completion of any reallocation request; "size" is the usable size
+   * of the original block at "ptr", as it was before the request, and
+   * "retptr" is the result of the request.  Nothing is counted if the
+   * request failed, (leaving the original block in place); otherwise,
+   * the original block, (if any), is counted as released, and the new
+   * block, (if any), as allocated.
+   */
+  if( (retptr != NULL) || (want == 0) )
+  { if( ptr != NULL ) tally->release( size );
+    if( retptr != NULL ) tally->alloc( retptr );
+  }
+  return retptr;
+}
+
 #if __mingw_memalign_lwm_case
 /* Reserve the "low water mark" tracking storage; initialize it to zero,
  * which is invalid as a heap block address, indicating that no block has
@@ -239,6 +265,18 @@ DLL_IMPORT __cdecl __MINGW_NOTHROW  void *__msvcrt_realloc (void *, size_t );
  */
 uintptr_t __mingw_memalign_lwm = 0;
 
+/* Similarly, reserve storage for the descriptor of the thread caching
+ * allocator's arena; until that allocator is used, this describes an
+ * empty address range, within which no pointer can lie.
+ */
+struct __mingw_heap_arena __mingw_heap_arena =
+{ 0, 0, NULL, NULL, NULL, NULL, NULL };
+
+/* Likewise, the heap statistics counters are inactive, until they are
+ * explicitly enabled.
+ */
+const struct __mingw_heap_tally *volatile __mingw_heap_tally = NULL;
+
 #elif __mingw_memalign_base_case
 /* A private API component, providing support for identification and
  * interpretation of alignment headers.
@@ -286,6 +324,13 @@ void *__mingw_memalign_base( void *ptr, struct memalign *base )
    */
   if( ptr == NULL ) return NULL;
 
+  /* Similarly, a block which was allocated by the thread caching
+   * allocator can never be associated with an alignment header; (it
+   * may, nonetheless, lie above the "low water mark", and we must not
+   * inspect the memory preceding it, which may not be accessible).
+   */
+  if( __mingw_heap_arena_block( ptr ) ) return ptr;
+
   /* In the normal case, when "ptr" is non-NULL, then it may represent
    * an over-aligned, or an offset-aligned allocation, only if the "low
    * water mark" address for such allocations has been established, and
@@ -337,9 +382,10 @@ void *__mingw_memalign_base( void *ptr, struct memalign *base )
 #elif __mingw_aligned_malloc_case
 /* The fundamental handler for all new aligned heap allocation requests;
  * all MinGW.org aligned allocators, (but not re-allocators), should call
- * this, to obtain a heap block which will fulfil the request.
+ * this, (through its public entry point, below), to obtain a heap block
+ * which will fulfil the request.
  */
-void *__mingw_aligned_offset_malloc( size_t want, size_t align, size_t offset )
+void *__mingw_memalign_malloc( size_t want, size_t align, size_t offset )
 {
   /* MinGW.org replacement for Microsoft's _aligned_offset_malloc(); if
    * called with an "offset" argument of zero, it may also be used as an
@@ -369,6 +415,19 @@ void *__mingw_aligned_offset_malloc( size_t want, size_t align, size_t offset )
    */
   if( base.flags == 0 ) return malloc( want );
 
+  /* Over-aligned requests, with no offset, are offered first to the thread
+   * caching allocator, which can serve them, without any alignment header,
+   * from naturally aligned size classes, (if they are not too large, and
+   * the alignment does not exceed its page size); however, we do this only
+   * if the application has already elected to use that allocator, (so that
+   * its arena has been reserved), lest we should impose it on applications
+   * which have not.
+   */
+  if( (base.flags == MEMALIGN_OVER_ALIGNED)
+  &&  (__mingw_heap_arena.aligned_malloc != NULL)
+  &&  ((retptr = __mingw_heap_arena.aligned_malloc( want, align )) != NULL)  )
+    return retptr;
+
   /* For requests which do need an alignment header, estimate the amount
    * by which the request must be padded, to accommodate the header.
    */
@@ -414,6 +473,15 @@ void *__mingw_aligned_offset_malloc( size_t want, size_t align, size_t offset )
   return retptr;
 }
 
+void *__mingw_aligned_offset_malloc( size_t want, size_t align, size_t offset )
+{
+  /* Public entry point for the preceding; this is distinct from it, only
+   * so that the heap statistics counters may be updated, (when enabled),
+   * for requests which are not part of any reallocation.
+   */
+  return __mingw_heap_tally_alloc( __mingw_memalign_malloc( want, align, offset ) );
+}
+
 #elif __mingw_aligned_realloc_case
 /* The first of two public entry points, for access to the MinGW.org
  * aligned heap memory reallocation API.  Most applications should use
@@ -421,7 +489,7 @@ void *__mingw_aligned_offset_malloc( size_t want, size_t align, size_t offset )
  * may be preferred when strict semantic compatibility with Microsoft's
  * aligned heap reallocation API is desired.
  */
-void *__mingw_aligned_offset_realloc
+static void *memalign_offset_realloc
 ( void *ptr, size_t want, size_t align, size_t offset )
 {
   /* MinGW.org replacement for Microsoft's _aligned_offset_realloc();
@@ -451,6 +519,19 @@ void *__mingw_aligned_offset_realloc
 	    * for any fundamental data type.
 	    */
 	   if( offset != 0 ) break;
+
+	   /* Blocks allocated by the thread caching allocator are
+	    * the exception; they carry no alignment header, but they
+	    * may be naturally aligned on any boundary, up to a page,
+	    * so we delegate them to that allocator, which enforces
+	    * the "align" constraint, (and which will resize them in
+	    * place, whenever possible).
+	    */
+	   if( __mingw_heap_arena_block( ptr ) )
+	     return __mingw_heap_arena.realloc( ptr, want,
+		 memalign_normalized( align )
+	       );
+
 	   if( memalign_normalized( align ) > memalign_min_alignment() )
 	     break;
 
@@ -492,9 +573,25 @@ void *__mingw_aligned_offset_realloc
     error_return( EINVAL, NULL );
   }
   /* When called with a NULL "ptr" argument, this becomes an effective
-   * equivalent for MinGW.org's __mingw_aligned_offset_realloc().
+   * equivalent for MinGW.org's __mingw_aligned_offset_malloc().
    */
-  return __mingw_aligned_offset_malloc( want, align, offset );
+  return __mingw_memalign_malloc( want, align, offset );
+}
+
+void *__mingw_aligned_offset_realloc
+( void *ptr, size_t want, size_t align, size_t offset )
+{
+  /* Public entry point for the preceding, which also updates the heap
+   * statistics counters, when they are enabled.
+   */
+  const struct __mingw_heap_tally *tally = __mingw_heap_tally;
+  size_t size;
+
+  if( tally == NULL ) return memalign_offset_realloc( ptr, want, align, offset );
+  size = malloc_usable_size( ptr );
+  return memalign_tally_realloc( tally, ptr, size,
+      memalign_offset_realloc( ptr, want, align, offset ), want
+    );
 }
 
 #elif __mingw_realloc_case
@@ -505,7 +602,7 @@ void *__mingw_aligned_offset_realloc
  * as returned directly by malloc(); thus, it offers a broader spectrum of
  * compatibility with non-Microsoft memory allocation stratagems.
  */
-void *__mingw_realloc( void *ptr, size_t want )
+static void *memalign_resize( void *ptr, size_t want )
 { /* An alternative to __mingw_aligned_offset_realloc(), (and implicitly
    * also to __mingw_aligned_realloc()), for resizing aligned heap memory
    * blocks; checks for the presence of a valid MinGW specific alignment
@@ -516,6 +613,13 @@ void *__mingw_realloc( void *ptr, size_t want )
    * call to Microsoft's realloc(), on "*ptr" directly, and thus also
    * supports resizing of blocks allocated by malloc(), or calloc().
    */
+  if( __mingw_heap_arena_block( ptr ) )
+    /*
+     * A block which was allocated by the thread caching allocator must
+     * also be reallocated by it, (with no alignment constraint).
+     */
+    return __mingw_heap_arena.realloc( ptr, want, 0 );
+
   if( ptr != NULL )
   { /* When passed a non-NULL pointer, an associated alignment header
      * will provide alignment specifications...
@@ -557,6 +661,21 @@ void *__mingw_realloc( void *ptr, size_t want )
   return __msvcrt_realloc( ptr, want );
 }
 
+void *__mingw_realloc( void *ptr, size_t want )
+{
+  /* Public entry point for the preceding, which also updates the heap
+   * statistics counters, when they are enabled.
+   */
+  const struct __mingw_heap_tally *tally = __mingw_heap_tally;
+  size_t size;
+
+  if( tally == NULL ) return memalign_resize( ptr, want );
+  size = malloc_usable_size( ptr );
+  return memalign_tally_realloc( tally, ptr, size,
+      memalign_resize( ptr, want ), want
+    );
+}
+
 #elif __mingw_memalign_realloc_case
 /* Core implementation for the MinGW.org aligned heap memory reallocator;
  * provides the common component of the reallocator, shared by each of the
@@ -640,9 +759,38 @@ void __mingw_aligned_free( void *ptr )
    * of __mingw_aligned_offset_malloc(); unlike Microsoft's free() API,
    * this checks for the presence of a MinGW specific alignment control
    * block, immediately preceding "*ptr", and promotes itself to become
-   * the MinGW equivalent of Microsoft's _aligned_free(), if necessary.
-   */
-  struct memalign base;__msvcrt_free(__mingw_memalign_base( ptr, &base ));
+   * the MinGW equivalent of Microsoft's _aligned_free(), if necessary;
+   * blocks which were allocated by the thread caching allocator, (which
+   * never have alignment headers), are identified first, and returned
+   * to that allocator.
+   */
+  struct memalign base;
+  __mingw_heap_tally_release( ptr );
+  if( __mingw_heap_arena_block( ptr ) ) __mingw_heap_arena.free( ptr );
+  else __msvcrt_free(__mingw_memalign_base( ptr, &base ));
+}
+
+#elif __mingw_usable_size_case
+/* The MinGW.org API for determining the usable size of any heap memory
+ * block, regardless of the original method of allocation.
+ */
+size_t malloc_usable_size( void *ptr )
+{ /* Return the number of bytes which may be stored in the block at "ptr",
+   * (which may exceed the size originally requested); unlike Microsoft's
+   * _msize() API, this recognizes both blocks which were allocated by the
+   * thread caching allocator, and blocks which have an alignment header.
+   * In the latter case, the usable size extends from "ptr" to the end of
+   * the underlying heap block, which begins at the header's base pointer;
+   * (in common with glibc, a NULL "ptr" is deemed to have a size of zero).
+   */
+  struct memalign base;
+
+  if( ptr == NULL ) return 0;
+  if( __mingw_heap_arena_block( ptr ) )
+    return __mingw_heap_arena.usable_size( ptr );
+
+  if( __mingw_memalign_base( ptr, &base ) == ptr ) return _msize( ptr );
+  return _msize( base.ptr ) - ((uintptr_t)(ptr) - base.ref);
 }
 #endif
 
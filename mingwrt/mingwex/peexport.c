@@ -0,0 +1,185 @@
+/*
+ * peexport.c
+ *
+ * Implementation of a direct look-up facility, for symbols exported by
+ * name, from any PE image, (i.e. DLL, or EXE), which has been mapped into
+ * memory by the MS-Windows loader; this supports the MinGW.org dlsym()
+ * implementation, in dlfcn.c
+ *
+ * $Id$
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR THE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * The PE/COFF specification requires that the export name pointer table,
+ * of any image, is sorted in ascending lexical order, (as strcmp() would
+ * determine), so that any name may be located within it by binary search;
+ * this is exactly how the loader itself resolves imports by name, but by
+ * reading the export directory directly, we avoid the overhead, (and the
+ * loader lock), which GetProcAddress() incurs.
+ *
+ * This module deliberately refers to no MS-Windows header, (it defines
+ * only those few PE structure offsets which it requires), so that it may
+ * be compiled on any little-endian host, and tested against PE images
+ * which have been mapped by a test harness, rather than by the loader.
+ *
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Signatures, and structure offsets, as specified by Microsoft's PE/COFF
+ * specification; all offsets are in bytes, relative to the start of the
+ * containing structure.
+ */
+#define PE_DOS_SIGNATURE		0x5A4D		/* "MZ"		*/
+#define PE_DOS_NT_HEADER_OFFSET 	0x3C		/* e_lfanew	*/
+
+#define PE_NT_SIGNATURE 		0x00004550	/* "PE\0\0"	*/
+#define PE_NT_OPTIONAL_HEADER		24
+
+#define PE32_MAGIC			0x010B
+#define PE32_NUMBER_OF_RVA_AND_SIZES	92
+#define PE32_DATA_DIRECTORY		96
+
+#define PE32_PLUS_MAGIC 		0x020B
+#define PE32_PLUS_NUMBER_OF_RVA_AND_SIZES 108
+#define PE32_PLUS_DATA_DIRECTORY	112
+
+#define PE_EXPORT_NUMBER_OF_FUNCTIONS	20
+#define PE_EXPORT_NUMBER_OF_NAMES	24
+#define PE_EXPORT_ADDRESS_OF_FUNCTIONS	28
+#define PE_EXPORT_ADDRESS_OF_NAMES	32
+#define PE_EXPORT_ADDRESS_OF_ORDINALS	36
+#define PE_EXPORT_DIRECTORY_SIZE	40
+
+/* Since the image may be mapped at any address, (and a test harness may
+ * not observe the alignment guarantees of the loader), we retrieve every
+ * multi-byte field by memcpy(); the compiler reduces this to a simple
+ * load, on any architecture which tolerates misalignment.
+ */
+static __inline__ __attribute__((__always_inline__))
+uint16_t pe_uint16( const unsigned char *image, uint32_t offset )
+{ uint16_t value; memcpy( &value, image + offset, sizeof( value ) ); return value; }
+
+static __inline__ __attribute__((__always_inline__))
+uint32_t pe_uint32( const unsigned char *image, uint32_t offset )
+{ uint32_t value; memcpy( &value, image + offset, sizeof( value ) ); return value; }
+
+static uint32_t pe_export_directory( const unsigned char *image, uint32_t *size )
+{
+  /* Locate the export directory, within a mapped PE image; returns its
+   * RVA, (also storing its size), or zero, if the image is not a valid
+   * PE image, or it has no export directory.
+   */
+  uint32_t nt, entries, directory;
+
+  if( pe_uint16( image, 0 ) != PE_DOS_SIGNATURE )
+    return 0;
+
+  nt = pe_uint32( image, PE_DOS_NT_HEADER_OFFSET );
+  if( pe_uint32( image, nt ) != PE_NT_SIGNATURE )
+    return 0;
+
+  /* The location of the data directory table, (and of the count of its
+   * entries), depends on whether the image is PE32, or PE32+; the export
+   * directory is always the first entry.
+   */
+  nt += PE_NT_OPTIONAL_HEADER;
+  switch( pe_uint16( image, nt ) )
+  { case PE32_MAGIC:
+      entries = pe_uint32( image, nt + PE32_NUMBER_OF_RVA_AND_SIZES );
+      directory = nt + PE32_DATA_DIRECTORY;
+      break;
+
+    case PE32_PLUS_MAGIC:
+      entries = pe_uint32( image, nt + PE32_PLUS_NUMBER_OF_RVA_AND_SIZES );
+      directory = nt + PE32_PLUS_DATA_DIRECTORY;
+      break;
+
+    default:
+      return 0;
+  }
+  if( (entries == 0)
+  ||  ((*size = pe_uint32( image, directory + 4 )) < PE_EXPORT_DIRECTORY_SIZE)  )
+    return 0;
+
+  return pe_uint32( image, directory );
+}
+
+void *__mingw_pe_export_lookup
+( const void *module, const char *name, const char **forwarder )
+{
+  /* Look up the address of the symbol, exported from the PE image which
+   * has been mapped at "module", with the specified "name"; returns that
+   * address, or NULL if the symbol is not exported.  When the symbol is
+   * exported as a forwarder, (i.e. it refers to a symbol exported from
+   * another module), the forwarder string, (of the form "DLL.symbol",
+   * or "DLL.#ordinal"), is stored in "forwarder", and NULL is returned;
+   * otherwise, NULL is stored in "forwarder".
+   */
+  const unsigned char *image = module;
+  uint32_t size, exports, names, lo, hi;
+
+  *forwarder = NULL;
+  if( (exports = pe_export_directory( image, &size )) == 0 )
+    return NULL;
+
+  /* Perform a binary search of the name pointer table...
+   */
+  names = pe_uint32( image, exports + PE_EXPORT_ADDRESS_OF_NAMES );
+  lo = 0; hi = pe_uint32( image, exports + PE_EXPORT_NUMBER_OF_NAMES );
+  while( lo < hi )
+  { uint32_t mid = lo + ((hi - lo) >> 1);
+    int cmp = strcmp( name,
+	(const char *)(image + pe_uint32( image, names + (mid << 2) ))
+      );
+    if( cmp > 0 ) lo = mid + 1;
+    else if( cmp < 0 ) hi = mid;
+    else
+    { /* ...and, having found the name, map it to the index, within
+       * the export address table, of the address to which it refers,
+       * using the ordinal table, which parallels the name table.
+       */
+      uint32_t ordinals = pe_uint32( image, exports + PE_EXPORT_ADDRESS_OF_ORDINALS );
+      uint32_t functions = pe_uint32( image, exports + PE_EXPORT_ADDRESS_OF_FUNCTIONS );
+      uint32_t index = pe_uint16( image, ordinals + (mid << 1) ), rva;
+
+      if( (index >= pe_uint32( image, exports + PE_EXPORT_NUMBER_OF_FUNCTIONS ))
+      ||  ((rva = pe_uint32( image, functions + (index << 2) )) == 0)  )
+	return NULL;
+
+      /* An address which lies within the export directory itself is
+       * not the address of the symbol, but that of a forwarder string.
+       */
+      if( (rva - exports) < size )
+      { *forwarder = (const char *)(image + rva);
+	return NULL;
+      }
+      return (void *)(image + rva);
+    }
+  }
+  return NULL;
+}
+
+/* $RCSfile$: end of file */
@@ -0,0 +1,455 @@
+/*
+ * qsort.c
+ *
+ * MinGW.org replacement for MSVCRT.DLL's qsort() function, implemented
+ * as a pattern-defeating quicksort; it also furnishes implementations of
+ * the context-aware qsort_r(), and (Microsoft style) qsort_s() variants.
+ *
+ * $Id$
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR THE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * The algorithm is that of Orson Peters' pattern-defeating quicksort,
+ * (pdqsort), adapted to sort an array of opaque elements of arbitrary
+ * size, by swapping, rather than by moving, elements.  Briefly:
+ *
+ *   - partitions are formed around a median of three pivot, (or, for
+ *     larger partitions, a pseudo-median of nine);
+ *
+ *   - partitions of fewer than QSORT_INSERTION_THRESHOLD elements are
+ *     completed by insertion sort;
+ *
+ *   - runs of elements equal to a preceding pivot are gathered into a
+ *     single partition, which need not be sorted further;
+ *
+ *   - when a partitioning pass moves no elements, an attempt is made
+ *     to complete each half by a bounded insertion sort, so that data
+ *     which is already sorted, (or nearly so), is sorted in linear time;
+ *
+ *   - highly unbalanced partitions prompt the shuffling of elements, to
+ *     break up patterns which may defeat pivot selection, and after too
+ *     many such partitions, a fall back to heapsort guarantees O(n log n)
+ *     worst case behaviour.
+ *
+ */
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+
+/* Thresholds, (in numbers of elements), below which partitions are
+ * sorted by insertion, and above which pivots are selected by Tukey's
+ * ninther, rather than as a simple median of three.
+ */
+#define QSORT_INSERTION_THRESHOLD	 24
+#define QSORT_NINTHER_THRESHOLD 	128
+
+/* The maximum number of element moves which a partial insertion sort
+ * will tolerate, before abandoning its attempt to complete a partition.
+ */
+#define QSORT_PARTIAL_INSERTION_LIMIT	  8
+
+typedef
+struct qsort_context
+{ /* Description of an individual sort operation; exactly one of the
+   * three comparator function references will be non-NULL, according
+   * to the API through which the sort was invoked.
+   */
+  int	(*compare)(const void *, const void *);
+  int	(*compare_r)(const void *, const void *, void *);
+  int	(*compare_s)(void *, const void *, const void *);
+  void	*context;
+  size_t size;
+} qsort_context;
+
+static __inline__ __attribute__((__always_inline__))
+int qsort_compare( qsort_context *q, const char *a, const char *b )
+{
+  /* Dispatch a comparison to the user specified comparator; (the choice
+   * of comparator is invariant for the entire sort, so these conditions
+   * are perfectly predictable, and cost little more than the indirect
+   * function call itself).
+   */
+  if( q->compare != NULL ) return q->compare( a, b );
+  if( q->compare_r != NULL ) return q->compare_r( a, b, q->context );
+  return q->compare_s( q->context, a, b );
+}
+
+/* Comparisons between elements are most readily expressed in terms
+ * of this convenient shorthand.
+ */
+#define LESS(A, B)	(qsort_compare( q, (A), (B) ) < 0)
+
+static __inline__ __attribute__((__always_inline__))
+void qsort_swap( const qsort_context *q, char *a, char *b )
+{
+  /* Exchange two elements; the common element sizes of four, eight,
+   * and sixteen bytes, (i.e. those of int, pointer, double, or small
+   * structure types), are handled by specialized swaps, which GCC will
+   * compile to simple register loads and stores; (using memcpy() here
+   * avoids any dependency on the alignment of the elements).  Other
+   * sizes are exchanged in machine word sized chunks, as far as may
+   * be possible, with any residual bytes exchanged individually.
+   */
+  size_t size = q->size;
+
+  if( size == 4 )
+  { uint32_t tmp; memcpy( &tmp, a, 4 ); memcpy( a, b, 4 ); memcpy( b, &tmp, 4 );
+  }
+  else if( size == 8 )
+  { uint64_t tmp; memcpy( &tmp, a, 8 ); memcpy( a, b, 8 ); memcpy( b, &tmp, 8 );
+  }
+  else if( size == 16 )
+  { uint64_t tmp[2];
+    memcpy( tmp, a, 16 ); memcpy( a, b, 16 ); memcpy( b, tmp, 16 );
+  }
+  else
+  { while( size >= sizeof (uintptr_t) )
+    { uintptr_t tmp;
+      memcpy( &tmp, a, sizeof tmp ); memcpy( a, b, sizeof tmp );
+      memcpy( b, &tmp, sizeof tmp );
+      a += sizeof tmp; b += sizeof tmp; size -= sizeof tmp;
+    }
+    while( size-- > 0 )
+    { char tmp = *a; *a++ = *b; *b++ = tmp;
+    }
+  }
+}
+
+static __inline__ __attribute__((__always_inline__))
+void qsort_sort2( qsort_context *q, char *a, char *b )
+{ if( LESS( b, a ) ) qsort_swap( q, a, b ); }
+
+static void qsort_sort3( qsort_context *q, char *a, char *b, char *c )
+{
+  /* Order three elements, such that the median comes to rest at "b".
+   */
+  qsort_sort2( q, a, b ); qsort_sort2( q, b, c ); qsort_sort2( q, a, b );
+}
+
+static void qsort_insertion( qsort_context *q, char *begin, char *end )
+{
+  /* Insertion sort, for small partitions which are bounded, on the
+   * left, by the beginning of the entire array.
+   */
+  size_t size = q->size;
+  char *cur, *sift;
+
+  for( cur = begin + size; cur < end; cur += size )
+    for( sift = cur; (sift > begin) && LESS( sift, sift - size ); sift -= size )
+      qsort_swap( q, sift - size, sift );
+}
+
+static void qsort_unguarded_insertion( qsort_context *q, char *begin, char *end )
+{
+  /* Insertion sort, for small partitions which are NOT the leftmost;
+   * in this case, the element immediately preceding the partition is
+   * known to compare as less than or equal to every element within it,
+   * so it serves as a sentinel, and no bounds check is required.
+   */
+  size_t size = q->size;
+  char *cur, *sift;
+
+  for( cur = begin + size; cur < end; cur += size )
+    for( sift = cur; LESS( sift, sift - size ); sift -= size )
+      qsort_swap( q, sift - size, sift );
+}
+
+static int qsort_partial_insertion( qsort_context *q, char *begin, char *end )
+{
+  /* Attempt an insertion sort, but abandon it, (returning zero), if it
+   * requires more than QSORT_PARTIAL_INSERTION_LIMIT element moves; the
+   * partition need not be leftmost, but it is always preceded by either
+   * the beginning of the array, or by an element which compares as less
+   * than or equal to any within the partition.
+   */
+  size_t size = q->size, moves = 0;
+  char *cur, *sift;
+
+  if( begin == end ) return 1;
+  for( cur = begin + size; cur < end; cur += size )
+  { for( sift = cur; (sift > begin) && LESS( sift, sift - size ); sift -= size )
+      qsort_swap( q, sift - size, sift );
+    if( (moves += (cur - sift) / size) > QSORT_PARTIAL_INSERTION_LIMIT )
+      return 0;
+  }
+  return 1;
+}
+
+static void qsort_sift_down
+( qsort_context *q, char *base, size_t root, size_t count )
+{
+  /* Heap maintenance helper, for the heapsort fall back.
+   */
+  size_t size = q->size, child;
+  while( (child = 2 * root + 1) < count )
+  { if( ((child + 1) < count)
+    &&  LESS( base + child * size, base + (child + 1) * size ) )
+      ++child;
+    if( ! LESS( base + root * size, base + child * size ) )
+      return;
+    qsort_swap( q, base + root * size, base + child * size );
+    root = child;
+  }
+}
+
+static void qsort_heapsort( qsort_context *q, char *begin, char *end )
+{
+  /* Fall back sort, guaranteeing O(n log n) behaviour for input which
+   * consistently defeats quicksort's pivot selection strategy.
+   */
+  size_t count = (end - begin) / q->size, index = count / 2;
+
+  while( index-- > 0 )
+    qsort_sift_down( q, begin, index, count );
+  while( count-- > 1 )
+  { qsort_swap( q, begin, begin + count * q->size );
+    qsort_sift_down( q, begin, 0, count );
+  }
+}
+
+static char *qsort_partition_right
+( qsort_context *q, char *begin, char *end, int *already_partitioned )
+{
+  /* Partition the elements in the range from "begin" to "end", around
+   * the pivot which has been placed at "begin", such that elements which
+   * compare as equal to the pivot are placed in the right hand partition;
+   * the pivot is then placed between the two partitions, and its final
+   * position is returned.
+   */
+  size_t size = q->size;
+  char *first = begin, *last = end;
+
+  /* Find the first element which is not less than the pivot; (there must
+   * be one, since the pivot was chosen as the median of three, of which
+   * the greatest was placed at the end of the range)...
+   */
+  do first += size; while( LESS( first, begin ) );
+
+  /* ...and the last element which is less than the pivot; if there was
+   * no element less than the pivot, to the left, then this search must
+   * be explicitly bounded.
+   */
+  if( first - size == begin )
+    do last -= size; while( (first < last) && ! LESS( last, begin ) );
+  else
+    do last -= size; while( ! LESS( last, begin ) );
+
+  /* If these two searches have crossed, then no element is out of place,
+   * and the partition may already be sorted.
+   */
+  *already_partitioned = (first >= last);
+
+  /* Otherwise, exchange out of place pairs, until the searches cross.
+   */
+  while( first < last )
+  { qsort_swap( q, first, last );
+    do first += size; while( LESS( first, begin ) );
+    do last -= size; while( ! LESS( last, begin ) );
+  }
+  /* Finally, move the pivot into its proper place.
+   */
+  if( (first -= size) != begin ) qsort_swap( q, begin, first );
+  return first;
+}
+
+static char *qsort_partition_left( qsort_context *q, char *begin, char *end )
+{
+  /* Partition the elements in the range from "begin" to "end", around
+   * the pivot which has been placed at "begin", such that elements which
+   * compare as equal to the pivot are placed in the left hand partition;
+   * this is used only when the pivot is known to compare equal to the
+   * element immediately preceding "begin", so the entire left hand
+   * partition then requires no further sorting.
+   */
+  size_t size = q->size;
+  char *first = begin, *last = end;
+
+  do last -= size; while( LESS( begin, last ) );
+
+  if( last + size == end )
+    do first += size; while( (first < last) && ! LESS( begin, first ) );
+  else
+    do first += size; while( ! LESS( begin, first ) );
+
+  while( first < last )
+  { qsort_swap( q, first, last );
+    do last -= size; while( LESS( begin, last ) );
+    do first += size; while( ! LESS( begin, first ) );
+  }
+  if( last != begin ) qsort_swap( q, begin, last );
+  return last;
+}
+
+static void qsort_loop
+( qsort_context *q, char *begin, char *end, int bad_allowed, int leftmost )
+{
+  size_t size = q->size;
+
+  while( 1 )
+  { size_t count = (end - begin) / size, half = count / 2;
+    size_t l_count, r_count;
+    int already_partitioned;
+    char *pivot;
+
+    /* Small partitions are completed by insertion sort.
+     */
+    if( count < QSORT_INSERTION_THRESHOLD )
+    { if( leftmost ) qsort_insertion( q, begin, end );
+      else qsort_unguarded_insertion( q, begin, end );
+      return;
+    }
+
+    /* Otherwise, choose a pivot, and place it at "begin".
+     */
+    if( count > QSORT_NINTHER_THRESHOLD )
+    { char *mid = begin + half * size, *tail = end - size;
+      qsort_sort3( q, begin, mid, tail );
+      qsort_sort3( q, begin + size, mid - size, tail - size );
+      qsort_sort3( q, begin + 2 * size, mid + size, tail - 2 * size );
+      qsort_sort3( q, mid - size, mid, mid + size );
+      qsort_swap( q, begin, mid );
+    }
+    else
+      qsort_sort3( q, begin + half * size, begin, end - size );
+
+    /* If the pivot compares equal to the element which precedes this
+     * partition, (which was itself a pivot, and is known to be less
+     * than or equal to every element within this partition), then we
+     * gather all elements equal to the pivot into a left hand partition,
+     * which needs no further sorting; only the right hand partition then
+     * remains to be processed.
+     */
+    if( ! leftmost && ! LESS( begin - size, begin ) )
+    { begin = qsort_partition_left( q, begin, end ) + size;
+      continue;
+    }
+
+    pivot = qsort_partition_right( q, begin, end, &already_partitioned );
+    l_count = (pivot - begin) / size;
+    r_count = (end - pivot) / size - 1;
+
+    if( (l_count < count / 8) || (r_count < count / 8) )
+    { /* The partitioning was highly unbalanced; if this has happened
+       * too often, then abandon quicksort in favour of heapsort...
+       */
+      if( --bad_allowed == 0 )
+      { qsort_heapsort( q, begin, end );
+	return;
+      }
+      /* ...otherwise, shuffle some elements within each partition, to
+       * break up any pattern which may have provoked this imbalance.
+       */
+      if( l_count >= QSORT_INSERTION_THRESHOLD )
+      { size_t k = l_count / 4;
+	qsort_swap( q, begin, begin + k * size );
+	qsort_swap( q, pivot - size, pivot - k * size );
+	if( l_count > QSORT_NINTHER_THRESHOLD )
+	{ qsort_swap( q, begin + size, begin + (k + 1) * size );
+	  qsort_swap( q, begin + 2 * size, begin + (k + 2) * size );
+	  qsort_swap( q, pivot - 2 * size, pivot - (k + 1) * size );
+	  qsort_swap( q, pivot - 3 * size, pivot - (k + 2) * size );
+	}
+      }
+      if( r_count >= QSORT_INSERTION_THRESHOLD )
+      { size_t k = r_count / 4;
+	qsort_swap( q, pivot + size, pivot + (1 + k) * size );
+	qsort_swap( q, end - size, end - k * size );
+	if( r_count > QSORT_NINTHER_THRESHOLD )
+	{ qsort_swap( q, pivot + 2 * size, pivot + (2 + k) * size );
+	  qsort_swap( q, pivot + 3 * size, pivot + (3 + k) * size );
+	  qsort_swap( q, end - 2 * size, end - (k + 1) * size );
+	  qsort_swap( q, end - 3 * size, end - (k + 2) * size );
+	}
+      }
+    }
+    else if( already_partitioned
+    &&  qsort_partial_insertion( q, begin, pivot )
+    &&  qsort_partial_insertion( q, pivot + size, end ) )
+      /* The partitioning moved no elements, and each of the partitions
+       * has been sorted by the ensuing (cheap) insertion sort.
+       */
+      return;
+
+    /* Recurse into the smaller of the two partitions, and iterate over
+     * the larger, so that the depth of recursion remains bounded by the
+     * logarithm of the number of elements.
+     */
+    if( l_count < r_count )
+    { qsort_loop( q, begin, pivot, bad_allowed, leftmost );
+      begin = pivot + size; leftmost = 0;
+    }
+    else
+    { qsort_loop( q, pivot + size, end, bad_allowed, 0 );
+      end = pivot;
+    }
+  }
+}
+
+static void qsort_start( qsort_context *q, void *base, size_t count )
+{
+  /* Common entry point for all sort variants; the number of highly
+   * unbalanced partitions which we will tolerate, before resorting to
+   * heapsort, is the base two logarithm of the element count.
+   */
+  int bad_allowed = 0;
+  size_t n = count;
+
+  if( (count < 2) || (q->size == 0) ) return;
+  while( n >>= 1 ) ++bad_allowed;
+  qsort_loop( q, base, (char *)(base) + count * q->size, bad_allowed, 1 );
+}
+
+void __mingw_qsort
+( void *base, size_t count, size_t size, int (*compare)(const void *, const void *) )
+{
+  qsort_context q = { compare, NULL, NULL, NULL, size };
+  qsort_start( &q, base, count );
+}
+
+void __mingw_qsort_r
+( void *base, size_t count, size_t size,
+  int (*compare)(const void *, const void *, void *), void *context
+)
+{ qsort_context q = { NULL, compare, NULL, context, size };
+  qsort_start( &q, base, count );
+}
+
+void __mingw_qsort_s
+( void *base, size_t count, size_t size,
+  int (*compare)(void *, const void *, const void *), void *context
+)
+{ /* Microsoft's qsort_s() validates its arguments; in the event of any
+   * violation, we follow the documented behaviour of MSVCRT.DLL, (but
+   * without invoking any invalid parameter handler), by setting errno,
+   * and returning without sorting.
+   */
+  qsort_context q = { NULL, NULL, compare, context, size };
+  if( (compare == NULL) || ((base == NULL) && (count > 0)) )
+  { errno = EINVAL; return; }
+  qsort_start( &q, base, count );
+}
+
+/* $RCSfile$: end of file */
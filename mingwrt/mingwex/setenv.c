@@ -8,7 +8,7 @@
  * $Id$
  *
  * Written by Keith Marshall <keith@users.osdn.me>
- * Copyright (C) 2016, 2021, MinGW.org Project
+ * Copyright (C) 2016, 2021, 2026, MinGW.org Project
  *
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
@@ -37,6 +37,12 @@
 #include <string.h>
 #include <errno.h>
 
+/* The multibyte conversion functions cache the codeset which they infer
+ * from the active locale, (which may, in turn, be inferred from the
+ * environment); any change to the environment must invalidate it.
+ */
+extern void __mb_codeset_invalidate( void );
+
 int __mingw_setenv( const char *var, const char *value, int overwrite )
 {
   /* Core implementation for both setenv() and unsetenv() functions;
@@ -60,30 +66,38 @@ int __mingw_setenv( const char *var, const char *value, int overwrite )
        * value into the appropriate form for use with putenv(),
        * (noting that we accept a NULL "value" as equivalent to
        * a zero-length string, which renders putenv() as the
-       * equivalent of unsetenv()).
+       * equivalent of unsetenv()); this is formatted in a single
+       * pass, into a heap buffer of sufficient size.
        */
-      const char *fmt = "%s=%s";
-      const char *val = value ? value : "";
-      char buf[1 + __mingw_snprintf( NULL, 0, fmt, var, val )];
-      __mingw_snprintf( buf, sizeof( buf ), fmt, var, val );
+      char *buf;
+      if( __mingw_asprintf( &buf, "%s=%s", var, value ? value : "" ) < 0 )
+	return -1;
 
       /* "buf" is now formatted as "var=value", in the form
-       * required by putenv(), but it exists only within our
-       * volatile stack-frame space.  POSIX.1 suggests that we
-       * should copy it to more persistent storage, before it
-       * is passed to putenv(), to associate an environment
-       * pointer with it.  However, we note that Microsoft's
-       * putenv() implementation appears to make such a copy
-       * in any case, so we do not do so; (in fact, if we did
-       * strdup() it (say), then we would leak memory).
+       * required by putenv(), but it exists only until we free
+       * it.  POSIX.1 suggests that we should copy it to more
+       * persistent storage, before it is passed to putenv(), to
+       * associate an environment pointer with it.  However, we
+       * note that Microsoft's putenv() implementation appears to
+       * make such a copy in any case, so we may simply release
+       * our copy, as soon as putenv() has returned.
        */
-      if( (retval = putenv( buf )) != 0 )
+      retval = putenv( buf );
+      free( buf );
+
+      if( retval != 0 )
 	/*
 	 * If putenv() returns non-zero, indicating failure, the
 	 * most probable explanation is that there wasn't enough
 	 * free memory; ensure that errno is set accordingly.
 	 */
         errno = ENOMEM;
+
+      else
+	/* The environment has changed; any cached locale dependent
+	 * codeset must be reevaluated.
+	 */
+	__mb_codeset_invalidate();
     }
     else
       /* The named variable already exists, and overwrite mode
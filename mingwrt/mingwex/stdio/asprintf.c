@@ -0,0 +1,78 @@
+/* asprintf.c
+ *
+ * $Id$
+ *
+ * Provides implementations of the GNU/BSD "asprintf", and "vasprintf"
+ * functions, which format their output, in a single pass, into a heap
+ * buffer of sufficient size to accommodate it, as allocated by malloc(),
+ * (and subsequently expanded by realloc(), as necessary).
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include "pformat.h"
+
+int __cdecl __vasprintf (char **, const char *, va_list) __MINGW_NOTHROW;
+int __cdecl __mingw_alias(vasprintf) (char **, const char *, va_list) __MINGW_NOTHROW;
+
+int __cdecl __asprintf (char **, const char *, ...) __MINGW_NOTHROW;
+int __cdecl __mingw_alias(asprintf) (char **, const char *, ...) __MINGW_NOTHROW;
+
+int __cdecl __vasprintf( char **buf, const char *fmt, va_list argv )
+{
+  /* Format the output directly into a heap buffer, which __pformat()
+   * allocates, and expands, as it proceeds; thus, unlike the common
+   * idiom of calling vsnprintf() once, to determine the buffer size,
+   * and then again, to fill the buffer, the format string, and its
+   * arguments, are interpreted only once.
+   */
+  __pformat_heap_t heap = { NULL, 0, 0, 0 };
+  int retval = __pformat( PFORMAT_TO_HEAP | PFORMAT_NOLIMIT, &heap, 0, fmt, argv );
+
+  if( heap.error )
+  { /* The buffer could not be expanded sufficiently; discard any partial
+     * output, and report the failure, leaving the caller with no buffer.
+     */
+    free( heap.buf );
+    *buf = NULL;
+    errno = ENOMEM;
+    return -1;
+  }
+  *buf = heap.buf;
+  return retval;
+}
+
+int __cdecl __asprintf( char **buf, const char *fmt, ... )
+{
+  va_list argv; va_start( argv, fmt );
+  register int retval = __vasprintf( buf, fmt, argv );
+  va_end( argv );
+  return retval;
+}
+
+/* $RCSfile$: end of file */
@@ -0,0 +1,145 @@
+/*
+ * fbuffer.c
+ *
+ * Implementation of the private helpers, declared in fbuffer.h, through
+ * which libmingwex.a's stdio replacement functions lock a FILE stream, and
+ * locate the content of its internal buffer within the underlying file.
+ *
+ * $Id$
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+#include "fbuffer.h"
+
+#include <io.h>
+#include <malloc.h>
+#include <stdint.h>
+
+#if __MSVCRT_VERSION__ < __MSVCR80_DLL
+/* We must resolve MSVCRT.DLL's undocumented stream locking functions,
+ * at run time.
+ */
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+static void __cdecl fbuffer_nolock( FILE *stream ){ (void)(stream); }
+
+static void (__cdecl *volatile fbuffer_lock_fn)( FILE * ) = NULL;
+static void (__cdecl *volatile fbuffer_unlock_fn)( FILE * ) = NULL;
+
+void __cdecl __mingw_stdio_lock( FILE *stream )
+{
+  if( fbuffer_lock_fn == NULL )
+  { /* This is the first call; resolve both entry points.  There is
+     * no harm if several threads race to do this, since all will find
+     * the same result; we assign the unlock function first, so that it
+     * is always available to any thread which sees the lock function.
+     */
+    HMODULE crt = GetModuleHandleA( "msvcrt.dll" );
+    FARPROC lock = (crt != NULL) ? GetProcAddress( crt, "_lock_file" ) : NULL;
+    FARPROC unlock = (crt != NULL) ? GetProcAddress( crt, "_unlock_file" ) : NULL;
+
+    if( (lock == NULL) || (unlock == NULL) )
+      fbuffer_unlock_fn = fbuffer_lock_fn = fbuffer_nolock;
+
+    else
+    { fbuffer_unlock_fn = (void (__cdecl *)(FILE *))(unlock);
+      fbuffer_lock_fn = (void (__cdecl *)(FILE *))(lock);
+    }
+  }
+  fbuffer_lock_fn( stream );
+}
+
+void __cdecl __mingw_stdio_unlock( FILE *stream )
+{
+  /* Any thread which holds the lock must already have resolved this.
+   */
+  fbuffer_unlock_fn( stream );
+}
+#endif
+
+/* MSVCRT.DLL records the attributes of each file descriptor, (including
+ * its text mode flag), in a table of "ioinfo" structures, organized as
+ * an array of pointers, (which it exports as __pioinfo), to blocks of
+ * 32 structures; the content of each structure is opaque, except that,
+ * in every known MSVCRT version, its first field is an intptr_t, which
+ * is immediately followed by the single byte of flags we require.
+ */
+extern char **_imp____pioinfo;
+
+#define FBUFFER_IOINFO_SHIFT	5
+#define FBUFFER_IOINFO_MASK	((1 << FBUFFER_IOINFO_SHIFT) - 1)
+#define FBUFFER_IOINFO_FTEXT	0x80
+
+static int fbuffer_is_binary( int fd )
+{
+  /* Determine whether "fd" is a binary mode file descriptor, by reading
+   * its flags from the ioinfo table, without modifying any state which
+   * is associated with it; returns non-zero only if it is certain that
+   * the descriptor is in binary mode.  Since the size of each ioinfo
+   * structure differs between MSVCRT versions, we deduce it, (once),
+   * from the size of the first block, which is always allocated.
+   */
+  static volatile size_t size = 0;
+  char *block;
+
+  if( size == 0 )
+  { size_t bytes = ((block = _imp____pioinfo[0]) != NULL) ? _msize( block ) : 0;
+    size = (bytes == (size_t)(-1)) ? 1 : (bytes >> FBUFFER_IOINFO_SHIFT);
+  }
+  if( (size <= sizeof( intptr_t ))
+  ||  ((block = _imp____pioinfo[fd >> FBUFFER_IOINFO_SHIFT]) == NULL)  )
+    return 0;
+
+  block += (fd & FBUFFER_IOINFO_MASK) * size + sizeof( intptr_t );
+  return (*block & FBUFFER_IOINFO_FTEXT) == 0;
+}
+
+__int64 __cdecl __mingw_fbuffer_end( FILE *stream )
+{
+  /* While a stream is reading, its buffer holds the data which has been
+   * most recently transferred from the underlying file, of which _cnt
+   * bytes, (starting at _ptr), have yet to be consumed, and the OS data
+   * stream pointer has been left immediately beyond the last of these;
+   * (when the stream is idle, _cnt is zero, so this remains true).  This
+   * correspondence is exact only for binary mode files, since MSVCRT's
+   * _read() function removes carriage returns from text mode data; nor
+   * may it be assumed for any stream which is writing, (for which _cnt
+   * represents free space, rather than data), or for any string stream,
+   * (which has no underlying file).
+   */
+  int fd;
+  if( ((stream->_flag & (_IOWRT | _IOSTRG)) != 0) || (stream->_cnt < 0)
+  ||  ((fd = _fileno( stream )) < 0) || ! fbuffer_is_binary( fd )  )
+    return -1LL;
+
+  /* For a binary mode descriptor, a zero displacement query returns the
+   * required offset, without transferring any data, (or it returns -1,
+   * if the descriptor refers to a device, such as a pipe, which does not
+   * support seeking).
+   */
+  return _lseeki64( fd, 0LL, SEEK_CUR );
+}
+
+/* $RCSfile$: end of file */
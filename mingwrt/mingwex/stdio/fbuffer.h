@@ -0,0 +1,65 @@
+#ifndef FBUFFER_H
+/*
+ * fbuffer.h
+ *
+ * $Id$
+ *
+ * A private header, declaring the helpers which libmingwex.a's stdio
+ * replacement functions use to lock a FILE stream, and to relate the
+ * content of its internal buffer to the underlying OS data stream.
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+#define FBUFFER_H
+#include <stdio.h>
+
+#if __MSVCRT_VERSION__ >= __MSVCR80_DLL
+/* Non-free runtime versions provide the _lock_file(), and _unlock_file()
+ * functions, to acquire and release the lock which guards each stream;
+ * we may call them directly.
+ */
+#define __mingw_stdio_lock(stream)    _lock_file( stream )
+#define __mingw_stdio_unlock(stream)  _unlock_file( stream )
+
+#else
+/* Although these functions are not documented for MSVCRT.DLL, they have
+ * been exported by it since Windows-2000; fbuffer.c looks them up, when
+ * first required, falling back to no-op substitutes, should they be
+ * missing.
+ */
+void __cdecl __mingw_stdio_lock( FILE * );
+void __cdecl __mingw_stdio_unlock( FILE * );
+#endif
+
+/* For a stream which is not currently writing, and which is attached to
+ * a binary mode file descriptor, __mingw_fbuffer_end() returns the offset,
+ * within the underlying file, of the byte immediately following the last
+ * byte which remains unread in the stream buffer, (i.e. the position of
+ * the OS data stream pointer); for any other stream, or if this position
+ * cannot be determined, it returns -1.  The caller must hold the stream
+ * lock, for as long as it continues to rely on the returned value.
+ */
+__int64 __cdecl __mingw_fbuffer_end( FILE * );
+
+#endif /* !defined FBUFFER_H: $RCSfile$: end of file */
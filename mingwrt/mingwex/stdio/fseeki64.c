@@ -9,7 +9,7 @@
  * $Id$
  *
  * Written by Keith Marshall <keith@users.osdn.me>
- * Copyright (C) 2018, MinGW.org Project
+ * Copyright (C) 2018, 2026, MinGW.org Project
  *
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
@@ -35,6 +35,8 @@
 #include <io.h>
 #include <stdio.h>
 
+#include "fbuffer.h"
+
 int __cdecl __mingw_fseeki64( FILE *stream, __int64 offset, int whence )
 {
   /* Emulate _fseeki64() on the basis of the underlying OS data stream
@@ -53,6 +55,40 @@ int __cdecl __mingw_fseeki64( FILE *stream, __int64 offset, int whence )
    * resulting from the _lseeki64() call).
    */
   fpos_t pos;
+  if( (stream != NULL) && ((whence == SEEK_SET) || (whence == SEEK_CUR)) )
+  { /* However, that discards any data which remains in the buffer of a
+     * stream which is reading, even when the new position lies within
+     * it; for a read-only stream, we may avoid this, and the subsequent
+     * refill, by simply advancing the FILE stream pointer, while any
+     * seek beyond the buffered data still adopts the preceding method.
+     * Note that we only ever move the FILE stream pointer forwards, and
+     * never by zero, since ungetc() may have overwritten buffered data
+     * at, or before, the current position, (and fseek() must discard any
+     * such pushed back character); nor do we move it within any stream
+     * which is open for update, because fseek() must then leave it free
+     * to start writing.
+     */
+    int moved = 0;
+    __mingw_stdio_lock( stream );
+    if( ((stream->_flag & (_IOREAD | _IORW)) == _IOREAD) && (stream->_cnt > 0) )
+    { __int64 step, end = __mingw_fbuffer_end( stream );
+      if( end >= 0LL )
+      { /* The buffer is locatable, within the underlying file, so
+	 * we may compute the displacement of the requested position,
+	 * relative to the current position; move to it, if possible.
+	 */
+	step = (whence == SEEK_SET) ? offset - (end - stream->_cnt) : offset;
+	if( (step > 0LL) && (step <= (__int64)(stream->_cnt)) )
+	{ stream->_ptr += (int)(step);
+	  stream->_cnt -= (int)(step);
+	  stream->_flag &= ~_IOEOF;
+	  moved = 1;
+	}
+      }
+    }
+    __mingw_stdio_unlock( stream );
+    if( moved ) return 0;
+  }
   return ((fgetpos( stream, &pos ) == 0) && (fsetpos( stream, &pos ) == 0))
     ? ((_lseeki64( _fileno( stream ), offset, whence ) == -1LL) ? -1 : 0)
     : -1;
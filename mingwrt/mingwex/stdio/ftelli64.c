@@ -9,7 +9,7 @@
  * $Id$
  *
  * Written by Keith Marshall <keith@users.osdn.me>
- * Copyright (C) 2018, MinGW.org Project
+ * Copyright (C) 2018, 2026, MinGW.org Project
  *
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
@@ -35,6 +35,8 @@
 #include <io.h>
 #include <stdio.h>
 
+#include "fbuffer.h"
+
 __int64 __cdecl __mingw_ftelli64( FILE *stream )
 {
   /* Emulate _ftelli64() on the basis of the underlying OS data stream
@@ -51,6 +53,19 @@ __int64 __cdecl __mingw_ftelli64( FILE *stream )
    * stream pointer, before reading the latter.
    */
   fpos_t pos;
+  if( stream != NULL )
+  { /* However, that discards any data which remains in the buffer of a
+     * stream which is reading, so that the next read must refill it; we
+     * may avoid this, whenever the buffer may be located relative to the
+     * OS data stream pointer, since the FILE stream pointer then lies
+     * just as many bytes before it as remain unread.
+     */
+    __int64 here;
+    __mingw_stdio_lock( stream );
+    if( (here = __mingw_fbuffer_end( stream )) >= 0LL ) here -= stream->_cnt;
+    __mingw_stdio_unlock( stream );
+    if( here >= 0LL ) return here;
+  }
   return ((fgetpos( stream, &pos ) == 0) && (fsetpos( stream, &pos ) == 0))
     ? _telli64( _fileno( stream )) : -1;
 }
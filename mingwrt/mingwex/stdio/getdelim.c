@@ -3,12 +3,13 @@
  *
  * Implementation of POSIX standard IEEE 1003.1-2008 getdelim() function;
  * also provides the core functionality to support an inline implementation
- * of the getline() function, within <stdio.h>
+ * of the getline() function, within <stdio.h>, together with non-locking
+ * getdelim_unlocked(), and getline_unlocked() variants.
  *
  * $Id$
  *
  * Written by Keith Marshall <keithmarshall@users.sourceforge.net>
- * Copyright (C) 2012, 2015, MinGW.org Project
+ * Copyright (C) 2012, 2015, 2026, MinGW.org Project
  *
  *
  * Permission is hereby granted, free of charge, to any person obtaining a
@@ -32,9 +33,13 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 #include <limits.h>
 #include <errno.h>
 
+#include "fbuffer.h"
+
 #ifndef EOVERFLOW
 /* This is one of the errno failure states specified by POSIX, for both
  * getdelim(), and for getline().  It is not normally available for use
@@ -44,6 +49,17 @@
 #define EOVERFLOW  ERANGE
 #endif
 
+#ifndef GETDELIM_BUFSIZ
+/* The minimum size of the buffer which we will allocate, when the caller
+ * provides none; thereafter, any buffer which proves to be too small will
+ * be expanded geometrically, (doubling in size at each expansion), so that
+ * the cost of successive realloc() calls, (each of which may copy all data
+ * collected so far), remains proportional to the record length, rather
+ * than to its square.
+ */
+#define GETDELIM_BUFSIZ  128
+#endif
+
 #undef  CRT_INLINE
 #define CRT_INLINE  static __inline__ __attribute__((__always_inline__))
 
@@ -55,23 +71,45 @@ CRT_INLINE ssize_t getline_abort( int error_code )
   return (ssize_t)(-1);
 }
 
+CRT_INLINE int getline_expand( char **linebuf, size_t *len, size_t want )
+{
+  /* A local helper, to ensure that the buffer at *linebuf can accommodate
+   * at least "want" bytes; returns zero on success, or -1 if the buffer
+   * cannot be expanded, (in which case the original buffer is retained).
+   */
+  if( want > *len )
+  { char *newbuf; size_t newlen = (*len > 0) ? *len : GETDELIM_BUFSIZ;
+    while( newlen < want )
+      newlen = (newlen > (SIZE_MAX / 2)) ? want : (newlen << 1);
+
+    if( (newbuf = realloc( *linebuf, newlen )) == NULL )
+      return -1;
+
+    *linebuf = newbuf;
+    *len = newlen;
+  }
+  return 0;
+}
+
 #define RESTRICT  __restrict__
 
-ssize_t getdelim
+ssize_t getdelim_unlocked
 ( char **RESTRICT linebuf, size_t *RESTRICT len, int brk, FILE *RESTRICT stream )
 {
   /* Capture a string of characters from the input stream,
    * up to and including the specified "brk" delimiter, or to EOF,
-   * storing the resultant string in the designated buffer.
+   * storing the resultant string in the designated buffer; the
+   * caller is responsible for any locking of the stream, which
+   * may be required for thread safety.
    *
-   * Also serves as getline(), via this inline wrapper in <stdio.h>:
+   * Also serves as getline_unlocked(), via this inline wrapper:
    *
-   *  static __inline__ __attribute__((__always_inline__)) ssize_t getline
+   *  static __inline__ __attribute__((__always_inline__)) ssize_t
+   *  getline_unlocked
    *  ( char **RESTRICT linebuf, size_t *RESTRICT len, FILE *RESTRICT stream )
-   *  { return getdelim( linebuf, len, '\n', stream ); }
+   *  { return getdelim_unlocked( linebuf, len, '\n', stream ); }
    *
    */
-  int nextchar = EOF;
   ssize_t count = (ssize_t)(0);
 
   /* Caller MUST pass us valid references to locations where the
@@ -116,21 +154,31 @@ ssize_t getdelim
      */
     *len = 0;
 
-  /* Okay to accept input...
-   * read character by character, until "brk" or EOF...
+  /* Okay to accept input; rather than reading character by character,
+   * we scan the stream's own buffer for "brk", and transfer each span of
+   * buffered data, up to and including "brk", or the entire content of
+   * the buffer if "brk" is not found, as a single block...
    */
-  while( (nextchar != brk) && ((nextchar = fgetc( stream )) != EOF) )
-  {
-    if( ferror( stream ) )
-      /* We caught an I/O error; bail out, assuming that fgetc() has
-       * already set errno appropriately, and returning nothing.
+  for(;;)
+  { char *span, *mark; size_t avail;
+
+    if( stream->_cnt <= 0 )
+    { /* ...replenishing the stream buffer whenever it is exhausted;
+       * _filbuf() returns the first character from the refilled buffer,
+       * having already consumed it, so we must immediately put it back,
+       * to retain it within the span which we are about to scan.
        */
-      return (ssize_t)(-1);
+      if( _filbuf( stream ) == EOF )
+	break;
+      ++stream->_cnt; --stream->_ptr;
+    }
+    span = stream->_ptr; avail = (size_t)(stream->_cnt);
+    if( (mark = memchr( span, brk, avail )) != NULL )
+      avail = (size_t)(mark - span) + 1;
 
-    if( count == SSIZE_MAX )
-      /* We've read another character, but we've already accumulated
-       * as many as we can account for in the return value; POSIX says
-       * that we MAY fail, in this case.
+    if( avail > (size_t)(SSIZE_MAX - count) )
+      /* We've read more characters, but we can't account for them all
+       * in the return value; POSIX says that we MAY fail, in this case.
        */
       return getline_abort( EOVERFLOW );
 
@@ -138,35 +186,80 @@ ssize_t getdelim
      * at the address pointed to by *linebuf; this MUST be a dynamically
      * allocated buffer of size as specified by *len, so we may increase
      * its size if necessary, (allowing space to accommodate the current
-     * input character, and a terminating NUL).
+     * span of input characters, and a terminating NUL).
      */
-    if( (count + 2) > *len )
-    { char *newbuf = realloc( *linebuf, *len + 64 );
-      if( newbuf == NULL )
-	/* Failed to expand the buffer; report insufficient memory.
-	 */
-	return getline_abort( ENOMEM );
-
-      /* Buffer expansion was successful; update reference data.
+    if( getline_expand( linebuf, len, (size_t)(count) + avail + 1 ) != 0 )
+      /* Failed to expand the buffer; report insufficient memory.
        */
-      *linebuf = newbuf;
-      *len += 64;
-    }
+      return getline_abort( ENOMEM );
 
-    /* We successfully read a character; append it to the buffer.
+    /* We successfully acquired a span of characters; append it to the
+     * buffer, and consume it from the stream.
      */
-    (*linebuf)[count++] = nextchar;
+    memcpy( *linebuf + count, span, avail );
+    stream->_ptr += avail; stream->_cnt -= (int)(avail);
+    count += avail;
+
+    if( mark != NULL )
+      /* We've transferred the delimiter; the record is complete.
+       */
+      break;
   }
 
-  /* Finished the current string capture; ensure that the buffer
-   * is properly terminated, by appending a NUL.
-   */
-  (*linebuf)[count] = '\0';
+  if( ferror( stream ) )
+    /* We caught an I/O error; bail out, assuming that _filbuf() has
+     * already set errno appropriately, and returning nothing.
+     */
+    return (ssize_t)(-1);
 
   /* If we've successfully read at least one character, then we
-   * return the count of characters read, else we return nothing.
+   * ensure that the buffer is properly terminated, by appending a
+   * NUL, and return the count of characters read...
    */
-  return (count > (ssize_t)(0)) ? count : (ssize_t)(-1);
+  if( count > (ssize_t)(0) )
+  { (*linebuf)[count] = '\0';
+    return count;
+  }
+  /* ...otherwise, we terminate any buffer which is available, but
+   * we return nothing.
+   */
+  if( *len > 0 ) **linebuf = '\0';
+  return (ssize_t)(-1);
+}
+
+/* The stream lock is acquired, and released, by means of the helpers
+ * which are shared with other stdio replacement functions.
+ */
+#define getdelim_lock(stream)    __mingw_stdio_lock( stream )
+#define getdelim_unlock(stream)  __mingw_stdio_unlock( stream )
+
+ssize_t getdelim
+( char **RESTRICT linebuf, size_t *RESTRICT len, int brk, FILE *RESTRICT stream )
+{
+  /* The thread safe POSIX getdelim() function; it simply wraps
+   * getdelim_unlocked(), holding the stream lock throughout, (so
+   * that each record is read atomically, with respect to any other
+   * thread reading from the same stream).
+   *
+   * Also serves as getline(), via this inline wrapper in <stdio.h>:
+   *
+   *  static __inline__ __attribute__((__always_inline__)) ssize_t getline
+   *  ( char **RESTRICT linebuf, size_t *RESTRICT len, FILE *RESTRICT stream )
+   *  { return getdelim( linebuf, len, '\n', stream ); }
+   *
+   */
+  ssize_t count;
+
+  if( stream == NULL )
+    /* There is no lock to acquire; let getdelim_unlocked() diagnose
+     * the invalid call.
+     */
+    return getdelim_unlocked( linebuf, len, brk, stream );
+
+  getdelim_lock( stream );
+  count = getdelim_unlocked( linebuf, len, brk, stream );
+  getdelim_unlock( stream );
+  return count;
 }
 
 /* $RCSfile$: end of file */
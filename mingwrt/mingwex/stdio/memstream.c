@@ -0,0 +1,198 @@
+/*
+ * memstream.c
+ *
+ * Implementation of the POSIX.1-2008 open_memstream(), and fmemopen()
+ * functions, which create FILE streams, the content of which is held in
+ * memory, together with the __mingw_fflush(), and __mingw_fclose() hooks,
+ * to which <stdio.h> redirects fflush(), and fclose(), so that they may
+ * synchronize, and release, such streams.
+ *
+ * $Id$
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+/* We must refer to MSVCRT's own fflush(), and fclose() functions, rather
+ * than to <stdio.h>'s POSIX.1-2008 redirections of them, to the functions
+ * which we implement here; thus, we must restrict <stdio.h> to POSIX.1-2001
+ * visibility, and declare our POSIX.1-2008 interfaces for ourselves.
+ */
+#define _POSIX_C_SOURCE 200112L
+
+#include "memstream.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+FILE *open_memstream( char **, size_t * );
+FILE *fmemopen( void *__restrict__, size_t, const char *__restrict__ );
+
+int __mingw_fflush( FILE * );
+int __mingw_fclose( FILE * );
+
+/* Furthermore, since libmingwex.a provides jump stubs, which redirect any
+ * external reference to fflush(), or to fclose(), back to the functions
+ * which we implement here, we must call MSVCRT's implementations directly,
+ * through their DLL import table entries.
+ */
+extern int (*_imp__fflush)( FILE * );
+extern int (*_imp__fclose)( FILE * );
+
+static struct __mingw_memstream *memstream_create( int mode )
+{
+  /* Helper to allocate, and initialize, the FILE structure, (with its
+   * _FILEX compatible lock), for a memory stream in the specified MSVCRT
+   * stream mode; all other fields are initially zero, or NULL, except for
+   * the (nonexistent) file descriptor, and the temporary file name pointer,
+   * which identifies the stream.
+   */
+  struct __mingw_memstream *ms = calloc( 1, sizeof( struct __mingw_memstream ) );
+  if( ms != NULL )
+  { InitializeCriticalSection( &ms->lock );
+    ms->file._flag = mode | _IOSTRG;
+    ms->file._tmpfname = (char *)(ms);
+    ms->file._file = -1;
+  }
+  else errno = ENOMEM;
+  return ms;
+}
+
+FILE *open_memstream( char **bufp, size_t *sizep )
+{
+  /* Create a write-only stream, with an initially empty buffer, which
+   * will be expanded, as required, by __pformat(); the buffer address,
+   * and the length of its content, are published via "bufp", and via
+   * "sizep", whenever the stream is flushed, or closed, (and also after
+   * each formatted write, by __pformat()).
+   */
+  struct __mingw_memstream *ms;
+
+  if( (bufp == NULL) || (sizep == NULL) )
+  { errno = EINVAL;
+    return NULL;
+  }
+  if( (ms = memstream_create( _IOWRT )) != NULL )
+  { if( (ms->heap.buf = malloc( ms->heap.size = BUFSIZ )) == NULL )
+    { DeleteCriticalSection( &ms->lock );
+      free( ms );
+      errno = ENOMEM;
+      return NULL;
+    }
+    ms->bufp = bufp;
+    ms->sizep = sizep;
+    __mingw_memstream_publish( ms );
+  }
+  return (FILE *)(ms);
+}
+
+FILE *fmemopen( void *__restrict__ buf, size_t size, const char *__restrict__ mode )
+{
+  /* Create a stream, with a fixed size buffer, which is either provided
+   * by the caller, or allocated here, (in which case, it is released when
+   * the stream is closed), for reading ("r" mode), for writing ("w" mode,
+   * which truncates the content to zero length), or for appending ("a"
+   * mode, which positions the stream at the first NUL in the buffer, or
+   * at its end); a "b" qualifier is accepted, but is of no consequence.
+   * Since MSVCRT's string streams are unable to switch between reading
+   * and writing, none of the "+" update modes are supported.
+   */
+  struct __mingw_memstream *ms;
+  size_t len = 0;
+
+  if( (size == 0) || (mode == NULL) || (*mode == '\0')
+  ||  (strchr( "rwa", *mode ) == NULL) || (mode[1 + (mode[1] == 'b')] != '\0')  )
+  { errno = EINVAL;
+    return NULL;
+  }
+  if( (ms = memstream_create( (*mode == 'r') ? _IOREAD : _IOWRT )) != NULL )
+  { if( (buf == NULL) && ((ms->owned = buf = calloc( 1, size )) == NULL) )
+    { DeleteCriticalSection( &ms->lock );
+      free( ms );
+      errno = ENOMEM;
+      return NULL;
+    }
+    if( *mode == 'w' ) *(char *)(buf) = '\0';
+    else if( *mode == 'a' ) while( (len < size) && (((char *)(buf))[len] != '\0') ) ++len;
+
+    ms->heap.buf = ms->file._base = buf;
+    ms->heap.size = ms->file._bufsiz = size;
+    ms->file._ptr = ms->file._base + len;
+    ms->file._cnt = size - len;
+  }
+  return (FILE *)(ms);
+}
+
+static void memstream_sync( struct __mingw_memstream *ms )
+{
+  /* Helper to synchronize a memory stream, on behalf of fflush(), or of
+   * fclose(); for a stream which was created by open_memstream(), this
+   * publishes its buffer, and content length, (terminating the content
+   * with a NUL), whereas, for a fmemopen() stream, which is writing, it
+   * writes a NUL at the current position, if there is room.
+   */
+  if( ms->bufp != NULL )
+  { __mingw_memstream_acquire( ms );
+    __mingw_memstream_release( ms );
+  }
+
+  else
+  { EnterCriticalSection( &ms->lock );
+    if( (ms->file._flag & _IOWRT) && (ms->file._cnt > 0) ) *ms->file._ptr = '\0';
+    LeaveCriticalSection( &ms->lock );
+  }
+}
+
+int __mingw_fflush( FILE *stream )
+{
+  /* Replacement for fflush(), which synchronizes any memory stream, but
+   * otherwise defers to MSVCRT; (note that this includes the case where
+   * "stream" is NULL, for which MSVCRT flushes all of its own streams,
+   * but there is no need to consider memory streams).
+   */
+  struct __mingw_memstream *ms;
+  if( (stream == NULL) || ((ms = __mingw_memstream( stream )) == NULL) )
+    return (*_imp__fflush)( stream );
+
+  memstream_sync( ms );
+  return 0;
+}
+
+int __mingw_fclose( FILE *stream )
+{
+  /* Replacement for fclose(), which synchronizes, and then releases any
+   * memory stream, (leaving the buffer of an open_memstream() stream in
+   * the caller's ownership), but otherwise defers to MSVCRT.
+   */
+  struct __mingw_memstream *ms;
+  if( (stream == NULL) || ((ms = __mingw_memstream( stream )) == NULL) )
+    return (*_imp__fclose)( stream );
+
+  memstream_sync( ms );
+  DeleteCriticalSection( &ms->lock );
+  free( ms->owned );
+  free( ms );
+  return 0;
+}
+
+/* $RCSfile$: end of file */
@@ -0,0 +1,127 @@
+#ifndef MEMSTREAM_H
+/*
+ * memstream.h
+ *
+ * $Id$
+ *
+ * A private header, describing the FILE streams which are created by the
+ * open_memstream(), and fmemopen() functions, as implemented in memstream.c,
+ * and providing the helpers through which __pformat() writes directly into
+ * the expanding buffer of any stream created by open_memstream().
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+#define MEMSTREAM_H
+#include <stdio.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#include "pformat.h"
+
+struct __mingw_memstream
+{ /* MSVCRT has no provision for user defined stream types, but it will
+   * operate on any FILE which is marked as a string stream, (as used by
+   * its own sprintf(), and sscanf() functions), within the bounds of its
+   * buffer, failing any attempt to refill, or to flush it; it will also
+   * lock any such stream, which it has not itself allocated, as if the
+   * FILE is the first member of an _FILEX structure, in which it will be
+   * followed by a CRITICAL_SECTION.  Thus, the first two members of this
+   * structure must remain exactly as they are.
+   */
+  FILE			 file;
+  CRITICAL_SECTION	 lock;
+
+  /* The stream buffer; for an open_memstream() stream, this expands as
+   * required, (but only when written by __pformat(), since MSVCRT can't
+   * expand it), and its address, and content length, are published via
+   * "bufp", and "sizep", each time it is synchronized.  For a fmemopen()
+   * stream, it has a fixed size, and "bufp" is NULL; "owned" is also
+   * NULL, unless the buffer was allocated by fmemopen().
+   */
+  __pformat_heap_t	 heap;
+  char		       **bufp;
+  size_t		*sizep;
+  void			*owned;
+};
+
+static __inline__ __attribute__((__always_inline__))
+struct __mingw_memstream *__mingw_memstream( FILE *stream )
+{
+  /* Identify a stream which was created by open_memstream(), or by
+   * fmemopen(); in each case, its (otherwise unused) temporary file
+   * name pointer refers to the stream itself.
+   */
+  return ((stream->_flag & _IOSTRG) && (stream->_tmpfname == (char *)(stream)))
+    ? (struct __mingw_memstream *)(stream) : NULL;
+}
+
+static __inline__ __attribute__((__always_inline__))
+struct __mingw_memstream *__mingw_memstream_growable( FILE *stream )
+{
+  /* Identify a stream which was created by open_memstream().
+   */
+  struct __mingw_memstream *ms = __mingw_memstream( stream );
+  return ((ms != NULL) && (ms->bufp != NULL)) ? ms : NULL;
+}
+
+static __inline__ __attribute__((__always_inline__))
+__pformat_heap_t *__mingw_memstream_acquire( struct __mingw_memstream *ms )
+{
+  /* Lock the stream, and adopt its current position, (which may have
+   * been advanced by MSVCRT functions), as the length of its content,
+   * in preparation for __pformat() to append to it.
+   */
+  EnterCriticalSection( &ms->lock );
+  ms->heap.len = ms->file._ptr - ms->file._base;
+  return &ms->heap;
+}
+
+static __inline__ __attribute__((__always_inline__))
+void __mingw_memstream_publish( struct __mingw_memstream *ms )
+{
+  /* Adjust the FILE stream pointers of an open_memstream() stream, to
+   * reflect the (possibly relocated) buffer, with the stream positioned
+   * at the end of its content, which is NUL terminated, and update the
+   * caller's references to the buffer.  The caller must hold the lock.
+   */
+  ms->file._base = ms->heap.buf;
+  ms->file._ptr = ms->heap.buf + ms->heap.len;
+  ms->file._cnt = ms->heap.size - ms->heap.len - 1;
+  ms->heap.buf[ms->heap.len] = '\0';
+  *ms->bufp = ms->heap.buf;
+  *ms->sizep = ms->heap.len;
+}
+
+static __inline__ __attribute__((__always_inline__))
+void __mingw_memstream_release( struct __mingw_memstream *ms )
+{
+  /* Complete the operation initiated by __mingw_memstream_acquire().
+   */
+  if( ms->heap.error ) ms->file._flag |= _IOERR;
+  __mingw_memstream_publish( ms );
+  LeaveCriticalSection( &ms->lock );
+}
+
+#endif /* !defined MEMSTREAM_H: $RCSfile$: end of file */
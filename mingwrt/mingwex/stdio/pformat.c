@@ -96,6 +96,10 @@
 
 #include "pformat.h"
 
+#ifdef _WIN32
+#include "memstream.h"
+#endif
+
 #ifndef NL_ARGMAX
 /* POSIX expects this to have been defined in <limits.h>, with a value
  * no less than 9; provide this slightly more generous definition, since
@@ -164,6 +168,23 @@
  */
 #define PFORMAT_INFNAN      -32768
 
+/* When output is directed to a FILE stream, it is staged in a local
+ * buffer, of the following size, and transferred to the stream in
+ * blocks, by fwrite(), rather than byte by byte.
+ */
+#ifndef PFORMAT_BUFSIZ
+#define PFORMAT_BUFSIZ      512
+#endif
+
+/* The minimum size of any heap buffer, which is allocated, (or expanded),
+ * to accommodate PFORMAT_TO_HEAP output; thereafter, it is expanded by
+ * doubling, so that the cost of any copying performed by realloc() remains
+ * proportional to the total length of the output.
+ */
+#ifndef PFORMAT_HEAP_MIN
+#define PFORMAT_HEAP_MIN    64
+#endif
+
 #ifdef _WIN32
 /* The Microsoft standard for printing `%e' format exponents is
  * with a minimum of three digits, unless explicitly set otherwise,
@@ -278,8 +299,87 @@ typedef struct
   int            tslen;
   wchar_t        tschr;
   char *         grouping;
+  char *         buf;
+  int            bufcount;
 } __pformat_t;
 
+static
+void __pformat_flush( __pformat_t *stream )
+{
+  /* Transfer any output which has been staged in the local buffer,
+   * (which is used only when output is directed to a FILE stream),
+   * to its ultimate destination, leaving the buffer empty.
+   */
+  if( stream->bufcount > 0 )
+    fwrite( stream->buf, 1, stream->bufcount, (FILE *)(stream->dest) );
+  stream->bufcount = 0;
+}
+
+static
+char *__pformat_heap_reserve( int len, __pformat_t *stream )
+{
+  /* Ensure that the heap buffer, to which PFORMAT_TO_HEAP output is
+   * directed, has space for `len' more characters, together with a NUL
+   * terminator, expanding it if necessary; return a pointer to the place
+   * at which the first of these characters is to be stored, or NULL, if
+   * the buffer cannot be expanded.
+   */
+  __pformat_heap_t *heap = (__pformat_heap_t *)(stream->dest);
+  size_t want = heap->len + stream->count + len + 1;
+
+  if( heap->error )
+    return NULL;
+
+  if( want > heap->size )
+  { size_t size = (heap->size < PFORMAT_HEAP_MIN) ? PFORMAT_HEAP_MIN : heap->size;
+    char *buf;
+
+    while( size < want )
+      size = ((size + size) > size) ? size + size : want;
+
+    if( (buf = realloc( heap->buf, size )) == NULL )
+    { heap->error = 1;
+      return NULL;
+    }
+    heap->buf = buf;
+    heap->size = size;
+  }
+  return heap->buf + heap->len + stream->count;
+}
+
+static __pformat_inline__
+char *__pformat_memory( int len, __pformat_t *stream )
+{
+  /* Helper to locate the place, within an internal memory buffer, at
+   * which `len' characters are to be stored, (expanding the buffer if
+   * it is a PFORMAT_TO_HEAP destination); returns NULL if there is no
+   * such place.
+   */
+  if( stream->flags & PFORMAT_TO_HEAP )
+    return __pformat_heap_reserve( len, stream );
+  return (char *)(stream->dest) + stream->count;
+}
+
+static __pformat_inline__
+int __pformat_avail( int count, __pformat_t *stream )
+{
+  /* Helper to determine how many of `count' characters, which are
+   * to be placed into the `__pformat()' output queue, will fit within
+   * any specified output quota.
+   */
+  if( (stream->flags & PFORMAT_NOLIMIT) == 0 )
+  {
+    /* A quota has been specified; we may place only as many of the
+     * characters as will fit within the residual quota...
+     */
+    int avail = stream->quota - stream->count;
+    return (avail < 0) ? 0 : (avail < count) ? avail : count;
+  }
+  /* ...otherwise, we may place all of them.
+   */
+  return count;
+}
+
 static
 void __pformat_putc( int c, __pformat_t *stream )
 {
@@ -292,19 +392,118 @@ void __pformat_putc( int c, __pformat_t *stream )
      * or the active quota has not yet been reached.
      */
     if( stream->flags & PFORMAT_TO_FILE )
-      /*
-       * This is single character output to a FILE stream...
+    {
+      /* This is output to a FILE stream; stage it in the local
+       * buffer, first flushing any buffered content if the buffer
+       * is already full...
        */
-      fputc( c, (FILE *)(stream->dest) );
-
+      if( stream->bufcount == PFORMAT_BUFSIZ )
+	__pformat_flush( stream );
+      stream->buf[stream->bufcount++] = c;
+    }
     else
-      /* Whereas, this is to an internal memory buffer...
+    { /* Whereas, this is to an internal memory buffer...
        */
-      ((char *)(stream->dest))[stream->count] = c;
+      char *dest = __pformat_memory( 1, stream );
+      if( dest != NULL ) *dest = c;
+    }
   }
   ++stream->count;
 }
 
+static
+void __pformat_putn( const char *s, int count, __pformat_t *stream )
+{
+  /* Place a block of `count' characters, copied from `s', into the
+   * `__pformat()' output queue, truncated as necessary to honour any
+   * specified output quota; this is equivalent to `count' successive
+   * calls of `__pformat_putc()', but copies the data en bloc.
+   */
+  int len;
+  if( (len = __pformat_avail( count, stream )) > 0 )
+  {
+    if( stream->flags & PFORMAT_TO_FILE )
+    {
+      /* When output is to a FILE stream, append the data to any
+       * which is already staged in the local buffer; if it will not
+       * all fit, flush the buffer first, and if it still will not
+       * fit, then write it directly, bypassing the buffer.
+       */
+      if( (stream->bufcount + len) > PFORMAT_BUFSIZ )
+      {
+	__pformat_flush( stream );
+	if( len >= PFORMAT_BUFSIZ )
+	{
+	  fwrite( s, 1, len, (FILE *)(stream->dest) );
+	  len = 0;
+	}
+      }
+      memcpy( stream->buf + stream->bufcount, s, len );
+      stream->bufcount += len;
+    }
+    else
+    { /* Output to an internal memory buffer is a simple copy.
+       */
+      char *dest = __pformat_memory( len, stream );
+      if( dest != NULL ) memcpy( dest, s, len );
+    }
+  }
+  stream->count += count;
+}
+
+static
+void __pformat_fill( int c, int count, __pformat_t *stream )
+{
+  /* Place a run of `count' repetitions of the character `c' into the
+   * `__pformat()' output queue, again honouring any quota, (typically
+   * to fill the padding space within an output field).
+   */
+  int len = __pformat_avail( count, stream );
+  if( stream->flags & PFORMAT_TO_FILE )
+    while( len > 0 )
+    {
+      /* For FILE stream output, we fill the local buffer, flushing
+       * it each time it becomes full, until the entire run has been
+       * queued.
+       */
+      int run = PFORMAT_BUFSIZ - stream->bufcount;
+      if( run == 0 )
+      {
+	__pformat_flush( stream );
+	run = PFORMAT_BUFSIZ;
+      }
+      if( run > len ) run = len;
+      memset( stream->buf + stream->bufcount, c, run );
+      stream->bufcount += run; len -= run;
+    }
+  else if( len > 0 )
+  { /* For output to a memory buffer, a single fill is sufficient.
+     */
+    char *dest = __pformat_memory( len, stream );
+    if( dest != NULL ) memset( dest, c, len );
+  }
+  stream->count += count;
+}
+
+static __pformat_inline__
+void __pformat_pad( int c, int *width, __pformat_t *stream )
+{
+  /* Emit any outstanding field padding, as specified by `*width',
+   * as a single run of `c' characters; the residual `*width' is left
+   * exactly as it would be after the customary idiom...
+   *
+   *   while( (*width)-- > 0 ) __pformat_putc( c, stream );
+   *
+   * (which this replaces).
+   */
+  if( *width > 0 )
+  {
+    __pformat_fill( c, *width, stream );
+    *width = 0;
+  }
+  --*width;
+}
+
 static
 void __pformat_putchars( const char *s, int count, __pformat_t *stream )
 {
@@ -316,7 +515,7 @@ void __pformat_putchars( const char *s, int count, __pformat_t *stream )
    * stopping after the number of characters specified for `precision',
    * to the `__pformat()' output stream.
    *
-   * Characters to be emitted are passed through `__pformat_putc()', to
+   * Characters to be emitted are passed through `__pformat_putn()', to
    * ensure that any specified output quota is honoured.
    */
   if( (stream->precision >= 0) && (count > stream->precision) )
@@ -346,23 +545,21 @@ void __pformat_putchars( const char *s, int count, __pformat_t *stream )
      * is not set), any residual unreserved field width must appear
      * as blank padding, to the left of the output string.
      */
-    while( stream->width-- )
-      __pformat_putc( '\x20', stream );
+    __pformat_pad( '\x20', &stream->width, stream );
 
   /* Emit the data...
    */
-  while( count-- )
+  if( count > 0 )
     /*
      * copying the requisite number of characters from the input.
      */
-    __pformat_putc( *s++, stream );
+    __pformat_putn( s, count, stream );
 
   /* If we still haven't consumed the entire specified field width,
    * we must be doing flush left justification; any residual width
    * must be filled with blanks, to the right of the output value.
    */
-  while( stream->width-- > 0 )
-    __pformat_putc( '\x20', stream );
+  __pformat_pad( '\x20', &stream->width, stream );
 }
 
 static __pformat_inline__
@@ -390,8 +587,8 @@ void __pformat_wputchars( const wchar_t *s, int count, __pformat_t *stream )
   /* Handler for `%C'(`%lc') and `%S'(`%ls') conversion specifications;
    * (this is a wide character variant of `__pformat_putchars()').
    *
-   * Each multibyte character sequence to be emitted is passed, byte
-   * by byte, through `__pformat_putc()', to ensure that any specified
+   * Each multibyte character sequence to be emitted is passed, as
+   * a block, through `__pformat_putn()', to ensure that any specified
    * output quota is honoured.
    */
   char buf[16]; mbstate_t state; int len = wcrtomb( buf, L'\0', &state );
@@ -423,25 +620,19 @@ void __pformat_wputchars( const wchar_t *s, int count, __pformat_t *stream )
      * is not set), any residual unreserved field width must appear
      * as blank padding, to the left of the output string.
      */
-    while( stream->width-- )
-      __pformat_putc( '\x20', stream );
+    __pformat_pad( '\x20', &stream->width, stream );
 
   /* Emit the data, converting each character from the wide
    * to the multibyte domain as we go...
    */
   while( (count-- > 0) && ((len = wcrtomb( buf, *s++, &state )) > 0) )
-  {
-    char *p = buf;
-    while( len-- > 0 )
-      __pformat_putc( *p++, stream );
-  }
+    __pformat_putn( buf, len, stream );
 
   /* If we still haven't consumed the entire specified field width,
    * we must be doing flush left justification; any residual width
    * must be filled with blanks, to the right of the output value.
    */
-  while( stream->width-- > 0 )
-    __pformat_putc( '\x20', stream );
+  __pformat_pad( '\x20', &stream->width, stream );
 }
 
 static __pformat_inline__
@@ -581,9 +772,7 @@ int __pformat_emit_punct( wchar_t code, int len, __pformat_t *stream )
     {
       /* ...and copy to the output destination, when valid.
        */
-      char *p = buf;
-      while( len-- > 0 )
-	__pformat_putc( *p++, stream );
+      __pformat_putn( buf, len, stream );
 
       /* The requested output has been completed; inform the caller
        * that no further fall back output is required.
@@ -788,8 +977,7 @@ void __pformat_int( __pformat_intarg_t value, __pformat_t *stream )
        * so we pad to the left of the displayed value with spaces, so that
        * the value appears right justified within the output field.
        */
-      while( stream->width-- > 0 )
-	__pformat_putc( '\x20', stream );
+      __pformat_pad( '\x20', &stream->width, stream );
   }
 
   if( stream->flags & PFORMAT_NEGATIVE )
@@ -817,14 +1005,13 @@ void __pformat_int( __pformat_intarg_t value, __pformat_t *stream )
      */
     __pformat_emit_digit( *--p, stream );
 
-  while( stream->width-- > 0 )
-    /* The specified output field has not yet been completely filled;
-     * the `-' flag must be in effect, resulting in a displayed value which
-     * appears left justified within the output field; we must pad the field
-     * to the right of the displayed value, by emitting additional spaces,
-     * until we reach the rightmost field boundary.
-     */
-    __pformat_putc( '\x20', stream );
+  /* If the specified output field has not yet been completely filled,
+   * the `-' flag must be in effect, resulting in a displayed value which
+   * appears left justified within the output field; we must pad the field
+   * to the right of the displayed value, by emitting additional spaces,
+   * until we reach the rightmost field boundary.
+   */
+  __pformat_pad( '\x20', &stream->width, stream );
 }
 
 static __pformat_inline__
@@ -947,8 +1134,7 @@ void __pformat_xint( int fmt, __pformat_intarg_t value, __pformat_t *stream )
      * is not set), any residual unreserved field width must appear
      * as blank padding, to the left of the output value.
      */
-    while( width-- > 0 )
-      __pformat_putc( '\x20', stream );
+    __pformat_pad( '\x20', &width, stream );
 
   while( p > buf )
     /*
@@ -961,8 +1147,7 @@ void __pformat_xint( int fmt, __pformat_intarg_t value, __pformat_t *stream )
    * we must be doing flush left justification; any residual width
    * must be filled with blanks, to the right of the output value.
    */
-  while( width-- > 0 )
-    __pformat_putc( '\x20', stream );
+  __pformat_pad( '\x20', &width, stream );
 }
 
 typedef union
@@ -980,12 +1165,200 @@ typedef union
   unsigned long          __pformat_fpreg_bits;
 } __pformat_fpreg_t;
 
+/* Fast path for the conversion of `double' values to decimal digits...
+ *
+ * Both of the `ecvt()' and `fcvt()' style conversions, as performed by
+ * `__gdtoa()', reduce to the computation of an integer, D, which is the
+ * value of the argument, scaled by an appropriate power of ten, and then
+ * rounded to nearest, (with ties to even).  For `double' arguments, when
+ * no more than PFORMAT_FASTCVT_DIGITS significant digits are required, we
+ * may compute D, without recourse to arbitrary precision arithmetic, by
+ * multiplying the 64-bit normalized mantissa by a 128-bit approximation
+ * to the requisite power of ten; the truncation error in this product is
+ * sufficiently small that the rounding decision is unambiguous, except
+ * when the scaled value lies extremely close to a rounding boundary, in
+ * which case we give up, and defer to `__gdtoa()'.
+ */
+#include "gdtoa.h"
+
+#define PFORMAT_FASTCVT_DIGITS  17
+#define PFORMAT_FASTCVT_BUFSIZ  24
+
+static __pformat_inline__
+unsigned long long __pformat_umul64
+( unsigned long long a, unsigned long long b, unsigned long long *hi )
+{
+  /* Helper to compute the full 128-bit product of two 64-bit unsigned
+   * integers, using only 32-bit by 32-bit partial products; the less
+   * significant half of the product is returned, while the more
+   * significant half is stored in "hi".
+   */
+  unsigned long long p00 = (a & 0xFFFFFFFFULL) * (b & 0xFFFFFFFFULL);
+  unsigned long long p01 = (a & 0xFFFFFFFFULL) * (b >> 32);
+  unsigned long long p10 = (a >> 32) * (b & 0xFFFFFFFFULL);
+  unsigned long long mid = (p00 >> 32) + (p01 & 0xFFFFFFFFULL)
+    + (p10 & 0xFFFFFFFFULL);
+  *hi = (a >> 32) * (b >> 32) + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+  return (mid << 32) | (p00 & 0xFFFFFFFFULL);
+}
+
+static
+int __pformat_scale( unsigned long long m, int e, int s, unsigned long long *d )
+{
+  /* Helper to compute "d" as the value of m * 2^e * 10^s, rounded to the
+   * nearest integer, (where the 64-bit mantissa, "m", is normalized, such
+   * that its most significant bit is set); returns zero, if the computed
+   * result is not guaranteed to be correctly rounded, or if it may not
+   * lie within the range which is representable in 60 bits.
+   */
+  const unsigned long long *t;
+  unsigned long long w1, w2, lh, g;
+  int sh = 127 - e - __mingw_pow10_log2( s );
+
+  if( (s < __MINGW_POW10_MIN) || (s > __MINGW_POW10_MAX) || (sh < 131) )
+    return 0;
+
+  if( sh > 192 )
+  { /* The product, P, computed below, is always less than 2^192, so the
+     * scaled value is less than one half; it rounds to zero.
+     */
+    *d = 0;
+    return 1;
+  }
+
+  /* Form the most significant 128 bits, w2:w1, of the 192-bit product,
+   * P, of the mantissa and the appropriate 128-bit power of ten, from the
+   * lookup table; (note that the true product exceeds P by less than m,
+   * and that we don't need the least significant 64 bits of P).
+   */
+  t = __mingw_pow10_128[s - __MINGW_POW10_MIN];
+  (void)(__pformat_umul64( m, t[1], &lh ));
+  w1 = __pformat_umul64( m, t[0], &w2 ) + lh;
+  if( w1 < lh ) ++w2;
+
+  if( sh == 192 )
+    /* The integer part is zero, and the fractional part is w2...
+     */
+    *d = 0, g = w2;
+
+  else
+  { /* ...otherwise, the integer part is the most significant 192 - sh
+     * bits of w2, and the fractional part is the residual low order bits
+     * of w2, continuing into w1.
+     */
+    *d = w2 >> (sh - 128);
+    g = (w2 << (192 - sh)) | (w1 >> (sh - 128));
+  }
+
+  /* Scaled to 2^64, the true fraction lies in the interval [g, g + 2);
+   * we may round it reliably, unless this interval includes 2^63.
+   */
+  if( (g == 0x7FFFFFFFFFFFFFFFULL) || (g == 0x8000000000000000ULL) )
+    return 0;
+
+  if( g > 0x8000000000000000ULL )
+    ++*d;
+  return 1;
+}
+
+static
+char *__pformat_fastcvt
+( int mode, double x, int nd, int *dp, int *sign, char *buf )
+{
+  /* Attempt the fast path conversion of "x", emulating `__gdtoa()' in
+   * either `ecvt()' style, (mode = 2), with "nd" significant digits, or
+   * in `fcvt()' style, (mode = 3), with "nd" digits after the radix point;
+   * the resultant digit string, (with trailing zeros removed), is stored
+   * in "buf", which is returned, or NULL is returned, when the fast path
+   * is not viable, and the caller must fall back to `__gdtoa()'.
+   */
+  __pformat_fpreg_t z; unsigned long long m, d, limit;
+  int e, k, i; char digits[PFORMAT_FASTCVT_BUFSIZ], *p, *end;
+
+  z.__pformat_fpreg_double_t = x;
+  m = z.__pformat_fpreg_mantissa;
+  *sign = (m >> 63) != 0;
+
+  if( (e = (int)((m >> 52) & 0x7FF)) == 0x7FF )
+    /* Infinities and NaNs are left to `__gdtoa()'.
+     */
+    return NULL;
+
+  if( (m &= 0xFFFFFFFFFFFFFULL) == 0 && e == 0 )
+  { /* For zero, `__gdtoa()' returns the single digit "0", with the
+     * radix point following it, regardless of mode.
+     */
+    *dp = 1; buf[0] = '0'; buf[1] = '\0';
+    return buf;
+  }
+
+  /* Extract the mantissa, and its associated binary exponent, such that
+   * x = m * 2^e, with "m" normalized to set its most significant bit...
+   */
+  if( e == 0 ) e = 1; else m |= 0x10000000000000ULL;
+  i = __builtin_clzll( m ); m <<= i; e -= 1075 + i;
+
+  if( mode == 3 )
+  { /* ...then, in `fcvt()' style, we want D = round(x * 10^nd), with
+     * the radix point positioned to precede the last "nd" digits...
+     */
+    if( (nd < 0) || !__pformat_scale( m, e, nd, &d ) )
+      return NULL;
+    k = -nd;
+  }
+  else
+  { /* ...or, in `ecvt()' style, we want D = round(x * 10^(nd - 1 - k)),
+     * where "k" is the decimal exponent of "x", such that D will comprise
+     * exactly "nd" digits; our initial estimate of "k" may be one less
+     * than the true value, in which case the resultant D will have one
+     * more digit than expected, and we must try again.
+     */
+    if( nd <= 0 ) nd = 1;
+    if( nd > PFORMAT_FASTCVT_DIGITS )
+      return NULL;
+
+    for( limit = 10, i = nd; --i > 0; ) limit *= 10;
+    k = ((e + 63) * 78913) >> 18;
+    if( !__pformat_scale( m, e, nd - 1 - k, &d ) )
+      return NULL;
+
+    /* Note that, when D is exactly equal to 10^nd, it doesn't matter
+     * whether this results from an underestimate of "k", or from the
+     * rounding of a value with "nd" nines; in either case, the result
+     * is to be reported as "1", with the same radix point position.
+     */
+    if( (d > limit) && !__pformat_scale( m, e, nd - 1 - ++k, &d ) )
+      return NULL;
+
+    /* The radix point follows the first of the "nd" digits; (in the
+     * event that rounding has carried into an additional digit, the
+     * digit string will be reduced to "1", with the radix point
+     * adjusted accordingly, as trailing zeros are removed).
+     */
+    k -= nd - 1;
+  }
+
+  /* Encode the digits of D, in reverse order, counting them into the
+   * position of the radix point...
+   */
+  p = end = digits + PFORMAT_FASTCVT_BUFSIZ;
+  while( d > 0 )
+  { *--p = '0' + (int)(d % 10);
+    d /= 10; ++k;
+  }
+
+  /* ...discard trailing zeros, and deliver the result.
+   */
+  while( (end > p) && (end[-1] == '0') ) --end;
+  memcpy( buf, p, end - p ); buf[end - p] = '\0';
+  *dp = k;
+  return buf;
+}
+
 #ifdef _WIN32
 /* TODO: maybe make this unconditional in final release...
  * (see note at head of associated `#else' block.
  */
-#include "gdtoa.h"
-
 static
 char *__pformat_cvt( int mode, __pformat_fpreg_t x, int nd, int *dp, int *sign )
 {
@@ -1040,41 +1413,63 @@ char *__pformat_cvt( int mode, __pformat_fpreg_t x, int nd, int *dp, int *sign )
 }
 
 static __pformat_inline__
-char *__pformat_ecvt( long double x, int precision, int *dp, int *sign )
+char *__pformat_ecvt
+( long double x, int precision, int *dp, int *sign, int flags, char *buf )
 {
   /* A convenience wrapper for the above...
-   * it emulates `ecvt()', but takes a `long double' argument.
+   * it emulates `ecvt()', but takes a `long double' argument; (when
+   * the argument was originally passed as a `double', we first try the
+   * fast path conversion, falling back to `__gdtoa()' only if that is
+   * not viable).
    */
-  __pformat_fpreg_t z; z.__pformat_fpreg_ldouble_t = x;
+  __pformat_fpreg_t z; char *retval;
+  if( ((flags & PFORMAT_LDOUBLE) == 0)
+  &&  ((retval = __pformat_fastcvt( 2, (double)(x), precision, dp, sign, buf )) != NULL)  )
+    return retval;
+  z.__pformat_fpreg_ldouble_t = x;
   return __pformat_cvt( 2, z, precision, dp, sign );
 }
 
 static __pformat_inline__
-char *__pformat_fcvt( long double x, int precision, int *dp, int *sign )
+char *__pformat_fcvt
+( long double x, int precision, int *dp, int *sign, int flags, char *buf )
 {
   /* A convenience wrapper for the above...
-   * it emulates `fcvt()', but takes a `long double' argument.
+   * it emulates `fcvt()', but takes a `long double' argument; (again,
+   * we try the fast path first, for an original `double' argument).
    */
-  __pformat_fpreg_t z; z.__pformat_fpreg_ldouble_t = x;
+  __pformat_fpreg_t z; char *retval;
+  if( ((flags & PFORMAT_LDOUBLE) == 0)
+  &&  ((retval = __pformat_fastcvt( 3, (double)(x), precision, dp, sign, buf )) != NULL)  )
+    return retval;
+  z.__pformat_fpreg_ldouble_t = x;
   return __pformat_cvt( 3, z, precision, dp, sign );
 }
 
 /* The following are required, to clean up the `__gdtoa()' memory pool,
- * after processing the data returned by the above.
+ * after processing the data returned by the above, (but not when it has
+ * been delivered by the fast path, into the caller's own buffer).
  */
-#define __pformat_ecvt_release( value ) __freedtoa( value )
-#define __pformat_fcvt_release( value ) __freedtoa( value )
+#define __pformat_ecvt_release( value, buf ) \
+  do { if( (value) != (buf) ) __freedtoa( value ); } while( 0 )
+#define __pformat_fcvt_release( value, buf ) \
+  do { if( (value) != (buf) ) __freedtoa( value ); } while( 0 )
 
 #else
 /* TODO: remove this before final release; it is included here as a
  * convenience for testing, without requiring a working `__gdtoa()'.
  */
 static __inline__
-char *__pformat_ecvt( long double x, int precision, int *dp, int *sign )
+char *__pformat_ecvt
+( long double x, int precision, int *dp, int *sign, int flags, char *buf )
 {
   /* Define in terms of `ecvt()'...
    */
-  char *retval = ecvt( (double)(x), precision, dp, sign );
+  char *retval;
+  if( ((flags & PFORMAT_LDOUBLE) == 0)
+  &&  ((retval = __pformat_fastcvt( 2, (double)(x), precision, dp, sign, buf )) != NULL)  )
+    return retval;
+  retval = ecvt( (double)(x), precision, dp, sign );
   if( isinf( x ) || isnan( x ) )
   {
     /* emulating `__gdtoa()' reporting for infinities and NaN.
@@ -1091,11 +1486,16 @@ char *__pformat_ecvt( long double x, int precision, int *dp, int *sign )
 }
 
 static __inline__
-char *__pformat_fcvt( long double x, int precision, int *dp, int *sign )
+char *__pformat_fcvt
+( long double x, int precision, int *dp, int *sign, int flags, char *buf )
 {
   /* Define in terms of `fcvt()'...
    */
-  char *retval = fcvt( (double)(x), precision, dp, sign );
+  char *retval;
+  if( ((flags & PFORMAT_LDOUBLE) == 0)
+  &&  ((retval = __pformat_fastcvt( 3, (double)(x), precision, dp, sign, buf )) != NULL)  )
+    return retval;
+  retval = fcvt( (double)(x), precision, dp, sign );
   if( isinf( x ) || isnan( x ) )
   {
     /* emulating `__gdtoa()' reporting for infinities and NaN.
@@ -1113,8 +1513,8 @@ char *__pformat_fcvt( long double x, int precision, int *dp, int *sign )
 
 /* No memory pool clean up needed, for these emulated cases...
  */
-#define __pformat_ecvt_release( value ) /* nothing to be done */
-#define __pformat_fcvt_release( value ) /* nothing to be done */
+#define __pformat_ecvt_release( value, buf ) /* nothing to be done */
+#define __pformat_fcvt_release( value, buf ) /* nothing to be done */
 
 /* TODO: end of conditional to be removed. */
 #endif
@@ -1286,8 +1686,7 @@ void __pformat_emit_float( int sign, char *value, int len, __pformat_t *stream )
    * the output within the alloted field width.
    */
   if( (stream->width > 0) && ((stream->flags & PFORMAT_JUSTIFY) == 0) )
-    while( stream->width-- > 0 )
-      __pformat_putc( '\x20', stream );
+    __pformat_pad( '\x20', &stream->width, stream );
 
   /* Emit the sign indicator, as appropriate...
    */
@@ -1314,8 +1713,7 @@ void __pformat_emit_float( int sign, char *value, int len, __pformat_t *stream )
    */
   if(  (stream->width > 0)
   &&  ((stream->flags & PFORMAT_JUSTIFY) == PFORMAT_ZEROFILL)  )
-    while( stream->width-- > 0 )
-      __pformat_putc( '0', stream );
+    __pformat_pad( '0', &stream->width, stream );
 
   /* Emit the digits of the encoded numeric value...
    */
@@ -1366,15 +1764,23 @@ void __pformat_emit_float( int sign, char *value, int len, __pformat_t *stream )
      * as are required.
      */
     stream->precision += len;
-    do __pformat_putc( '0', stream );
-       while( ++len < 0 );
+    __pformat_fill( '0', -len, stream );
   }
 
   /* Now we emit any remaining significant digits, or trailing zeros,
-   * until the required precision has been achieved.
+   * until the required precision has been achieved; the significant
+   * digits are copied en bloc, followed by a run of trailing zeros,
+   * leaving the residual precision exactly as it would have been if
+   * we had emitted them one at a time.
    */
-  while( stream->precision-- > 0 )
-    __pformat_putc( *value ? *value++ : '0', stream );
+  if( stream->precision > 0 )
+  {
+    char *end = memchr( value, '\0', stream->precision );
+    len = (end != NULL) ? end - value : stream->precision;
+    __pformat_putn( value, len, stream );
+    stream->precision -= len;
+  }
+  __pformat_pad( '0', &stream->precision, stream );
 }
 
 static
@@ -1456,7 +1862,7 @@ void __pformat_float( long double x, __pformat_t *stream )
    * and `__pformat_emit_inf_or_nan()', as appropriate, to achieve
    * output in fixed point format.
    */
-  int sign, intlen; char *value;
+  int sign, intlen; char *value, buf[PFORMAT_FASTCVT_BUFSIZ];
 
   /* Establish the precision for the displayed value, defaulting to six
    * digits following the decimal point, if not explicitly specified.
@@ -1466,7 +1872,8 @@ void __pformat_float( long double x, __pformat_t *stream )
 
   /* Encode the input value as ASCII, for display...
    */
-  value = __pformat_fcvt( x, stream->precision, &intlen, &sign );
+  value = __pformat_fcvt( x, stream->precision, &intlen, &sign,
+      stream->flags, buf );
 
   if( intlen == PFORMAT_INFNAN )
     /*
@@ -1483,13 +1890,12 @@ void __pformat_float( long double x, __pformat_t *stream )
      * then we must be doing flush left justification, so pad out to
      * the right hand field boundary.
      */
-    while( stream->width-- > 0 )
-      __pformat_putc( '\x20', stream );
+    __pformat_pad( '\x20', &stream->width, stream );
   }
 
   /* Clean up `__pformat_fcvt()' memory allocation for `value'...
    */
-  __pformat_fcvt_release( value );
+  __pformat_fcvt_release( value, buf );
 }
 
 static
@@ -1501,7 +1907,7 @@ void __pformat_efloat( long double x, __pformat_t *stream )
    * and `__pformat_emit_inf_or_nan()', as appropriate, to achieve
    * output in floating point format.
    */
-  int sign, intlen; char *value;
+  int sign, intlen; char *value, buf[PFORMAT_FASTCVT_BUFSIZ];
 
   /* Establish the precision for the displayed value, defaulting to six
    * digits following the decimal point, if not explicitly specified.
@@ -1511,7 +1917,8 @@ void __pformat_efloat( long double x, __pformat_t *stream )
 
   /* Encode the input value as ASCII, for display...
    */
-  value = __pformat_ecvt( x, stream->precision + 1, &intlen, &sign );
+  value = __pformat_ecvt( x, stream->precision + 1, &intlen, &sign,
+      stream->flags, buf );
 
   if( intlen == PFORMAT_INFNAN )
     /*
@@ -1526,7 +1933,7 @@ void __pformat_efloat( long double x, __pformat_t *stream )
 
   /* Clean up `__pformat_ecvt()' memory allocation for `value'...
    */
-  __pformat_ecvt_release( value );
+  __pformat_ecvt_release( value, buf );
 }
 
 static
@@ -1539,7 +1946,7 @@ void __pformat_gfloat( long double x, __pformat_t *stream )
    * appropriate, to achieve output in the more suitable of either
    * fixed or floating point format.
    */
-  int sign, intlen; char *value;
+  int sign, intlen; char *value, buf[PFORMAT_FASTCVT_BUFSIZ];
 
   /* Establish the precision for the displayed value, defaulting to
    * six significant digits, if not explicitly specified...
@@ -1554,7 +1961,8 @@ void __pformat_gfloat( long double x, __pformat_t *stream )
 
   /* Encode the input value as ASCII, for display.
    */
-  value = __pformat_ecvt( x, stream->precision, &intlen, &sign );
+  value = __pformat_ecvt( x, stream->precision, &intlen, &sign,
+      stream->flags, buf );
 
   if( intlen == PFORMAT_INFNAN )
     /*
@@ -1602,8 +2010,7 @@ void __pformat_gfloat( long double x, __pformat_t *stream )
      * we must be doing flush left justification, so pad out to the
      * right hand field boundary.
      */
-    while( stream->width-- > 0 )
-      __pformat_putc( '\x20', stream );
+    __pformat_pad( '\x20', &stream->width, stream );
   }
 
   else
@@ -1638,7 +2045,7 @@ void __pformat_gfloat( long double x, __pformat_t *stream )
 
   /* Clean up `__pformat_ecvt()' memory allocation for `value'.
    */
-  __pformat_ecvt_release( value );
+  __pformat_ecvt_release( value, buf );
 }
 
 static
@@ -1837,8 +2244,7 @@ void __pformat_emit_xfloat( __pformat_fpreg_t value, __pformat_t *stream )
       /* and then emit any required left side padding spaces.
        */
       if( (stream->flags & PFORMAT_JUSTIFY) == 0 )
-	while( stream->width-- > 0 )
-	  __pformat_putc( '\x20', stream );
+	__pformat_pad( '\x20', &stream->width, stream );
     }
 
     else
@@ -1878,8 +2284,7 @@ void __pformat_emit_xfloat( __pformat_fpreg_t value, __pformat_t *stream )
    */
   if(  (stream->width > 0)
   &&  ((stream->flags & PFORMAT_JUSTIFY) == PFORMAT_ZEROFILL)  )
-    while( stream->width-- > 0 )
-      __pformat_putc( '0', stream );
+    __pformat_pad( '0', &stream->width, stream );
 
   /* Next, we emit the encoded value, without its exponent...
    */
@@ -1889,8 +2294,7 @@ void __pformat_emit_xfloat( __pformat_fpreg_t value, __pformat_t *stream )
   /* followed by any additional zeros needed to satisfy the
    * precision specification...
    */
-  while( stream->precision-- > 0 )
-    __pformat_putc( '0', stream );
+  __pformat_pad( '0', &stream->precision, stream );
 
   /* then the exponent prefix, (C99 and POSIX specify `p'),
    * in the case appropriate to the format specification...
@@ -2664,728 +3068,917 @@ int __pformat_argmap( int argc, const char *fmt, __pformat_argmap_t *map )
   return argc;
 }
 
-int __pformat( int flags, void *dest, int max, const char *fmt, va_list args )
+/* Compiled format plans...
+ * The format string interpreter, below, is split into two phases: the
+ * analysis of each element of the format string, (whether that be a run
+ * of literal text, or a complete conversion specification), and the
+ * subsequent execution of the resultant element description, against
+ * the argument vector.  Normally, these are interleaved, as we scan the
+ * format string, but the analysis phase may also be performed once, in
+ * advance, to construct a reusable "plan", from which any number of
+ * subsequent output requests may be executed, without repeating it.
+ *
+ * Since the analysis must remain independent of any run time state, we
+ * cannot resolve Microsoft's 'l' modifier for 'long double' at that time;
+ * we use an otherwise unused bit in the flags, to defer the decision...
+ */
+#define PFORMAT_ALTLDBL     0x0002
+
+/* ...and, within the description of each element, we use the following
+ * pseudo index, to identify any '*' width, or precision specification,
+ * which is to be satisfied from the next sequentially accessed argument.
+ */
+#define PFORMAT_ARGNEXT     0xFF
+
+typedef struct
+{ /* Description of a single format string element; "conv" is zero,
+   * for a run of literal text, or it is the conversion specifier.
+   */
+  const char *   text;
+  int            len;
+  int            flags;
+  int            width;
+  int            precision;
+  unsigned char  conv;
+  unsigned char  length;
+  unsigned char  arg_index;
+  unsigned char  width_arg;
+  unsigned char  precision_arg;
+  unsigned char  pdefault;
+} __pformat_spec_t;
+
+struct __pformat_plan
+{ /* Representation of a compiled format string; the "spec" array
+   * is followed, in the same memory block, by the argument map for
+   * positional arguments, if any, and by a private copy of the text
+   * of the format string, to which all literal "text" refers.
+   */
+  const char *         key;
+  const char *         fmt;
+  int                  argc;
+  int                  count;
+  __pformat_argmap_t * argmap;
+  __pformat_spec_t     spec[];
+};
+
+static
+const char *__pformat_parse( const char *fmt, int argc, __pformat_spec_t *spec )
 {
-  int c, argc;
+  /* Analyse one element of the format string, starting at "fmt", and
+   * store its description in "spec"; return a pointer to the start of
+   * the next element.
+   */
+  int c; int *width_spec;
+  __pformat_state_t state = PFORMAT_INIT;
+  const char *backtrack;
 
-  __pformat_t stream =
-  { /* Create and initialise a format control block
-     * for this output request.
+  /* Establish the initial state for flags, width and precision specs,
+   * together with the default argument length, (all of which are also
+   * required to be neutral, when the element represents literal text).
+   */
+  spec->conv = spec->pdefault = 0;
+  spec->arg_index = spec->width_arg = spec->precision_arg = 0;
+  spec->flags = 0;
+  spec->width = spec->precision = PFORMAT_IGNORE;
+  spec->length = PFORMAT_LENGTH_INT;
+
+  spec->text = fmt;
+  if( *fmt++ != '%' )
+  { /* We have found a character which is not included within any format
+     * specification; we treat it as literal text, together with any of
+     * the immediately following characters which are similarly not part
+     * of any format specification, as a single block.
      */
-    dest,					/* output goes to here        */
-    flags &= PFORMAT_TO_FILE | PFORMAT_NOLIMIT,	/* only these valid initially */
-    PFORMAT_IGNORE,				/* no field width yet         */
-    PFORMAT_IGNORE,				/* nor any precision spec     */
-    PFORMAT_RPINIT,				/* radix point uninitialised  */
-    (wchar_t)(0),				/* leave it unspecified       */
-    0,						/* zero output char count     */
-    max,					/* establish output limit     */
-    PFORMAT_MINEXP,				/* exponent chars preferred   */
-    PFORMAT_RPINIT,				/* thou' sep uninitialised    */
-    (wchar_t)(0),				/* leave it unspecified ...   */
-    NULL					/* with no grouping counts    */
-  };
+    fmt += strcspn( fmt, "%" );
+    spec->len = fmt - spec->text;
+    return fmt;
+  }
 
-  /* Establish a variant argument resource pool, to support processing of
-   * the passed-in argument vector in either sequential or random order.
+  /* Initiate parsing of a `conversion specification'; save the current
+   * format scan position, so that we can backtrack in the event of our
+   * encountering an invalid format specification...
    */
-  va_list argv, argv_indexed[argc = __pformat_indexed_argc( fmt )];
-  if( argc > 0 )
-  { /* All argument references, within the format string, are specified in
-     * the "%n$" or "*m$" positionally indexed style; construct an argument
-     * classification table, verify continuity of the index sequence...
-     */
-    __pformat_argmap_t specs[argc];
-    if( (argc = __pformat_argmap( argc, fmt, specs )) > 0 )
-    {
-      /* ...and, on successful classification with no discontinuities, set
-       * up a temporary local copy of the passed-in argument vector, which
-       * we may then prescan...
-       */
-      va_copy( argv, args );
-      for( c = 0; c < argc; c++ )
-      { /* ...storing an indexed reference to the starting boundary of each
-	 * argument, before advancing to the next argument boundary...
-	 */
-	va_copy( argv_indexed[c], argv );
-	switch( specs[c].ref[PFORMAT_CONVERSION_TYPE] )
-	{
-	  /* ...noting that, regardless of conversion type, we don't need
-	   * the argument values at this prescan phase, (so we may simply
-	   * discard them), but we do need to adjust the va_list reference
-	   * pointer as appropriate to the conversion type; thus...
-	   */
-	  case PFORMAT_TYPE_DOUBLE:
-	    /* ...for floating point types, we must discriminate between
-	     * 'double' and 'long double', (but not 'float', because that
-	     * is always promoted to 'double')...
-	     */
-	    if( __pformat_is_ldouble( specs[c].ref[PFORMAT_LENGTH_MODIFIER] ) )
-	      (void)(va_arg( argv, long double ));
-	    else (void)(va_arg( argv, double ));
-	    break;
+  backtrack = fmt;
 
-	  case PFORMAT_TYPE_POINTER:
-	    /* ...all pointer types need identically the same adjustment
-	     * as the generic 'void *' pointer...
-	     */
-	    (void)(va_arg( argv, void * ));
-	    break;
+  /* ...and, if random order processing of arguments is specified by the
+   * current format string, retrieve the index associated with the current
+   * conversion specification.
+   */
+  spec->arg_index = (argc > 0) ? __pformat_arg_index( &fmt ) : 0;
 
-	  case PFORMAT_TYPE_INTEGER: default:
-	    /* ...and all other types may be effectively be considered to
-	     * be represented as integer types, for which...
-	     */
-	    switch( specs[c].ref[PFORMAT_LENGTH_MODIFIER] )
-	    { case PFORMAT_LENGTH_LONG: (void)(va_arg( argv, long )); break;
-	      case PFORMAT_LENGTH_LLONG: (void)(va_arg( argv, long long ));
-		break;
-	      default: (void)(va_arg( argv, int ));
-	    }
-	}
-      }
-      /* Terminate processing of the temporary copy of the argument vector,
-       * in preparation for its immediate reinitialisation.
-       */
-      va_end( argv );
-    }
-  }
-  /* Initialise (or reinitialise) a local copy of the passed-in argument
-   * vector, such that it will be suitable for sequential processing of the
-   * arguments, while still allowing for it to be reinitialised, as may be
-   * required for processing the arguments in indexed random order.
+  /* Begin capture for static field width and precision specs...
    */
-  va_copy( argv, args );
+  width_spec = &spec->width;
 
-  format_scan: while( (c = *fmt++) != 0 )
-  {
-    /* Format string parsing loop...
-     * The entry point is labelled, so that we can return to the start state
-     * from within the inner `conversion specification' interpretation loop,
-     * as soon as a conversion specification has been resolved.
-     */
-    if( c == '%' )
+  while( *fmt )
+  { switch( c = *fmt++ )
     {
-      /* Initiate parsing of a `conversion specification'...
+      /* Data type specifiers...
+       * All are terminal, so once we have recorded the specifier, we are
+       * done with the analysis of this element.
        */
-      __pformat_intarg_t argval;
-      __pformat_state_t  state = PFORMAT_INIT;
-      __pformat_length_t length = PFORMAT_LENGTH_INT;
+      case 'p':
+	/* The pointer conversion may require default formatting attributes,
+	 * but only if the user didn't specify any; (the final decision will
+	 * be deferred until we know the effect of any '*' specification).
+	 */
+	spec->pdefault = (state == PFORMAT_INIT) && (spec->flags == 0);
+
+      case 'c': case 'C': case 's': case 'S': case 'n':
+      case 'o': case 'u': case 'x': case 'X': case 'd': case 'i':
+      case 'e': case 'E': case 'f': case 'F': case 'g': case 'G':
+      case 'a': case 'A':
+	spec->conv = c;
+	return fmt;
+
+      case '%':
+	/* Not strictly a data type specifier...
+	 * it simply converts as a literal `%' character.
+	 *
+	 * FIXME: should we require this to IMMEDIATELY follow the
+	 * initial `%' of the "conversion spec"?  (glibc `printf()'
+	 * on GNU/Linux does NOT appear to require this, but POSIX
+	 * and SUSv3 do seem to demand it).
+	 */
+	spec->text = "%";
+	spec->len = 1;
+	return fmt;
 
-      /* Save the current format scan position, so that we can backtrack
-       * in the event of encountering an invalid format specification...
+      /* Argument length modifiers...
+       * These are non-terminal; each sets the format parser
+       * into the PFORMAT_END state, and ends with a `break'.
        */
-      const char *backtrack = fmt;
+      case 'h': case 'j': case 'l': case 't': case 'z':
+#     ifdef _WIN32
+	/* While the preceding five are ISO-C standards, not
+	 * all are supported by Microsoft's implementation of
+	 * printf(); we will generally favour the semantics as
+	 * specified by ISO-C, but except in case of conflict,
+	 * we also attempt to support Microsoft alternatives.
+	 * Thus, we also recognise their 'I' modifier...
+	 */
+      case 'I':
+	/* ...interpreting all six appropriately...
+	 */
+	spec->length = __pformat_length_modifier( &fmt );
+	/*
+	 * ...while further noting that they accept 'l' as an
+	 * alternative to 'L', as a qualifier for 'long double';
+	 * this DOES conflict with ISO-C usage, so we offer it as
+	 * an optional user choice, whether the Microsoft usage is
+	 * to be supported, or (by default) to ignore such usage
+	 * entirely, as required by ISO-C; since this choice may
+	 * be changed at any time, we simply mark the possibility
+	 * here, and defer the decision until execution time.
+	 */
+	if( (c == 'l') && (spec->length == PFORMAT_LENGTH_LONG) )
+	  spec->flags |= PFORMAT_ALTLDBL;
+#     else
+	/* ...whereas, if building for any non-windows platform,
+	 * we simply analyse each of the five standard modifiers,
+	 * and end the case analysis immediately.
+	 */
+	spec->length = __pformat_length_modifier( &fmt );
+#     endif
+	state = PFORMAT_END;
+	break;
 
-      /* If random order processing of arguments is specified by the
-       * current format string, retrieve the index associated with the
-       * current conversion specification.
-       */
-      int arg_index;
-      if( (argc > 0) && ((arg_index = __pformat_arg_index( &fmt )) > 0) )
-      {
-	/* Having established the appropriate index value, we may clear
-	 * the current assignment for the active argv reference, and then
-	 * reassign it to refer to the corresponding indexed argument.
+      case 'L':
+	/* Identify the appropriate argument as a `long double',
+	 * when associated with `%a', `%A', `%e', `%E', `%f', `%F',
+	 * `%g' or `%G' format specifications.
 	 */
-	va_end( argv );
-	va_copy( argv, argv_indexed[zero_adjusted(arg_index)] );
-      }
+	spec->flags |= PFORMAT_LDOUBLE;
+	state = PFORMAT_END;
+	break;
 
-      /* Restart capture for dynamic field width and precision specs...
+      /* Precision indicator...
+       * May appear once only; it must precede any modifier
+       * for argument length, or any data type specifier.
        */
-      int *width_spec = &stream.width;
+      case '.':
+	if( state < PFORMAT_GET_PRECISION )
+	{
+	  /* We haven't seen a precision specification yet,
+	   * so initialise it to zero, (in case no digits follow),
+	   * and accept any following digits as the precision.
+	   */
+	  spec->precision = 0;
+	  width_spec = &spec->precision;
+	  state = PFORMAT_GET_PRECISION;
+	}
+	else
+	  /* We've already seen a precision specification,
+	   * so this is just junk; proceed to end game.
+	   */
+	  state = PFORMAT_END;
 
-      /* Reset initial state for flags, width and precision specs...
-       */
-      stream.flags = flags;
-      stream.width = stream.precision = PFORMAT_IGNORE;
+	/* Either way, we must not fall through here.
+	 */
+	break;
 
-      while( *fmt )
-      { switch( c = *fmt++ )
+      /* Variable field width, or precision specification,
+       * derived from the argument list...
+       */
+      case '*':
+	/* When this appears...
+	 */
+	if(   width_spec
+	&&  ((state == PFORMAT_INIT) || (state == PFORMAT_GET_PRECISION)) )
 	{
-	  /* Data type specifiers...
-	   * All are terminal, so exit the conversion spec parsing loop
-	   * with a `goto format_scan', thus resuming at the outer level
-	   * in the regular format string parser.
+	  /* ...in proper context; record the source of the field width
+	   * or precision, as appropriate, either as the specified indexed
+	   * argument, when processing arguments in indexed order, or as
+	   * the next available sequentially accessed argument.
 	   */
-	  case '%':
-	    /* Not strictly a data type specifier...
-	     * it simply converts as a literal `%' character.
-	     *
-	     * FIXME: should we require this to IMMEDIATELY follow the
-	     * initial `%' of the "conversion spec"?  (glibc `printf()'
-	     * on GNU/Linux does NOT appear to require this, but POSIX
-	     * and SUSv3 do seem to demand it).
-	     */
-	    __pformat_putc( c, &stream );
-	    goto format_scan;
+	  int arg_index = (argc > 0) ? __pformat_arg_index( &fmt ) : 0;
+	  if( arg_index == 0 ) arg_index = PFORMAT_ARGNEXT;
+	  if( state == PFORMAT_INIT ) spec->width_arg = arg_index;
+	  else spec->precision_arg = arg_index;
+	}
+	else
+	  /* out of context; give up on width and precision
+	   * specifications for this conversion.
+	   */
+	  state = PFORMAT_END;
 
-	  case 'C':
-	    /* Equivalent to `%lc'; set `length' accordingly,
-	     * and simply fall through.
-	     */
-	    length = PFORMAT_LENGTH_LONG;
-
-	  case 'c':
-	    /* Single, (or single multibyte), character output...
-	     *
-	     * We handle these by copying the argument into our local
-	     * `argval' buffer, and then we pass the address of that to
-	     * either `__pformat_putchars()' or `__pformat_wputchars()',
-	     * as appropriate, effectively formatting it as a string of
-	     * the appropriate type, with a length of one.
-	     *
-	     * A side effect of this method of handling character data
-	     * is that, if the user sets a precision of zero, then no
-	     * character is actually emitted; we don't want that, so we
-	     * forcibly override any user specified precision.
-	     */
-	    stream.precision = PFORMAT_IGNORE;
+	/* Mark as processed...
+	 * we must not see `*' again, in this context.
+	 */
+	width_spec = NULL;
+	break;
 
-	    /* Now we invoke the appropriate format handler...
-	     */
-	    if( (length == PFORMAT_LENGTH_LONG)
-	    ||  (length == PFORMAT_LENGTH_LLONG)  )
-	    {
-	      /* considering any `long' type modifier as a reference to
-	       * `wchar_t' data, (which is promoted to an `int' argument)...
-	       */
-	      wchar_t argval = (wchar_t)(va_arg( argv, int ));
-	      __pformat_wputchars( &argval, 1, &stream );
-	    }
-
-	    else
-	    { /* while anything else is simply taken as `char', (which
-	       * is also promoted to an `int' argument)...
-	       */
-	      argval.__pformat_uchar_t = (unsigned char)(va_arg( argv, int ));
-	      __pformat_putchars( (char *)(&argval), 1, &stream );
-	    }
-	    goto format_scan;
-
-	  case 'S':
-	    /* Equivalent to `%ls'; set `length' accordingly,
-	     * and simply fall through.
-	     */
-	    length = PFORMAT_LENGTH_LONG;
-
-	  case 's':
-	    if( (length == PFORMAT_LENGTH_LONG)
-	    ||  (length == PFORMAT_LENGTH_LLONG)  )
-	    {
-	      /* considering any `long' type modifier as a reference to
-	       * a `wchar_t' string...
-	       */
-	      __pformat_wcputs( va_arg( argv, wchar_t * ), &stream );
-	    }
-	    else
-	      /* This is normal string output;
-	       * we simply invoke the appropriate handler...
-	       */
-	      __pformat_puts( va_arg( argv, char * ), &stream );
-
-	    goto format_scan;
-
-	  case 'o': case 'u': case 'x': case 'X':
-	    /* Unsigned integer values; octal, decimal or hexadecimal format...
-	     */
-	    if( length == PFORMAT_LENGTH_LLONG )
-	      /*
-	       * with an `unsigned long long' argument, which we
-	       * process `as is'...
-	       */
-	      argval.__pformat_ullong_t = va_arg( argv, unsigned long long );
-
-	    else if( length == PFORMAT_LENGTH_LONG )
-	      /*
-	       * or with an `unsigned long', which we promote to
-	       * `unsigned long long'...
-	       */
-	      argval.__pformat_ullong_t = va_arg( argv, unsigned long );
-
-	    else
-	    { /* or for any other size, which will have been promoted
-	       * to `unsigned int', we select only the appropriately sized
-	       * least significant segment, and again promote to the same
-	       * size as `unsigned long long'...
-	       */
-	      argval.__pformat_ullong_t = va_arg( argv, unsigned int );
-	      if( length == PFORMAT_LENGTH_SHORT )
-		/*
-		 * from `unsigned short'...
-		 */
-		argval.__pformat_ullong_t = argval.__pformat_ushort_t;
-
-	      else if( length == PFORMAT_LENGTH_CHAR )
-		/*
-		 * or even from `unsigned char'...
-		 */
-		argval.__pformat_ullong_t = argval.__pformat_uchar_t;
-	    }
-
-	    /* so we can pass any size of argument to either of two
-	     * common format handlers...
-	     */
-	    if( c == 'u' )
-	      /* depending on whether output is to be encoded in
-	       * decimal format...
-	       */
-	      __pformat_int( argval, &stream );
-
-	    else
-	      /* or in octal or hexadecimal format...
-	       */
-	      __pformat_xint( c, argval, &stream );
-
-	    goto format_scan;
-
-	  case 'd': case 'i':
-	    /* Signed integer values; decimal format...
-	     * This is similar to `u', but must process `argval' as signed,
-	     * and be prepared to handle negative numbers.
-	     */
-	    stream.flags |= PFORMAT_NEGATIVE;
-
-	    if( length == PFORMAT_LENGTH_LLONG )
-	      /*
-	       * The argument is a `long long' type...
-	       */
-	      argval.__pformat_llong_t = va_arg( argv, long long );
-
-	    else if( length == PFORMAT_LENGTH_LONG )
-	      /*
-	       * or here, a `long' type...
-	       */
-	      argval.__pformat_llong_t = va_arg( argv, long );
-
-	    else
-	    { /* otherwise, it's an `int' type...
-	       */
-	      argval.__pformat_llong_t = va_arg( argv, int );
-	      if( length == PFORMAT_LENGTH_SHORT )
-		/*
-		 * but it was promoted from a `short' type...
-		 */
-		argval.__pformat_llong_t = argval.__pformat_short_t;
-	      else if( length == PFORMAT_LENGTH_CHAR )
-		/*
-		 * or even from a `char' type...
-		 */
-		argval.__pformat_llong_t = argval.__pformat_char_t;
-	    }
-
-	    /* In any case, all share a common handler...
-	     */
-	    __pformat_int( argval, &stream );
-	    goto format_scan;
+      /* Formatting flags...
+       * Must appear while in the PFORMAT_INIT state,
+       * and are non-terminal, so again, end with `break'.
+       */
+      case '#':
+	/* Select alternate PFORMAT_HASHED output style.
+	 */
+	if( state == PFORMAT_INIT )
+	  spec->flags |= PFORMAT_HASHED;
+	break;
 
-	  case 'p':
-	    /* Pointer argument; format as hexadecimal, subject to...
-	     */
-	    if( (state == PFORMAT_INIT) && (stream.flags == flags) )
-	    {
-	      /* Here, the user didn't specify any particular
-	       * formatting attributes.  We must choose a default
-	       * which will be compatible with Microsoft's (broken)
-	       * scanf() implementation, (i.e. matching the default
-	       * used by MSVCRT's printf(), which appears to resemble
-	       * "%0.8X" for 32-bit pointers); in particular, we MUST
-	       * NOT adopt a GNU-like format resembling "%#x", because
-	       * Microsoft's scanf() will choke on the "0x" prefix.
-	       */
-	      stream.flags |= PFORMAT_ZEROFILL;
-	      stream.precision = 2 * sizeof( uintptr_t );
-	    }
-	    argval.__pformat_ullong_t = va_arg( argv, uintptr_t );
-	    __pformat_xint( 'x', argval, &stream );
-	    goto format_scan;
-
-	  case 'e':
-	    /* Floating point format, with lower case exponent indicator
-	     * and lower case `inf' or `nan' representation when required;
-	     * select lower case mode, and simply fall through...
-	     */
-	    stream.flags |= PFORMAT_XCASE;
+      case '+':
+	/* Print a leading sign with numeric output,
+	 * for both positive and negative values.
+	 */
+	if( state == PFORMAT_INIT )
+	  spec->flags |= PFORMAT_POSITIVE;
+	break;
 
-	  case 'E':
-	    /* Floating point format, with upper case exponent indicator
-	     * and upper case `INF' or `NAN' representation when required,
-	     * (or lower case for all of these, on fall through from above);
-	     * select lower case mode, and simply fall through...
-	     */
-	    if( stream.flags & PFORMAT_LDOUBLE )
-	      /*
-	       * for a `long double' argument...
-	       */
-	      __pformat_efloat( va_arg( argv, long double ), &stream );
-
-	    else
-	      /* or just a `double', which we promote to `long double',
-	       * so the two may share a common format handler.
-	       */
-	      __pformat_efloat( (long double)(va_arg( argv, double )), &stream );
-
-	    goto format_scan;
-
-	  case 'f':
-	    /* Fixed point format, using lower case for `inf' and
-	     * `nan', when appropriate; select lower case mode, and
-	     * simply fall through...
-	     */
-	    stream.flags |= PFORMAT_XCASE;
+      case '-':
+	/* Select left justification of displayed output
+	 * data, within the output field width, instead of
+	 * the default flush right justification.
+	 */
+	if( state == PFORMAT_INIT )
+	  spec->flags |= PFORMAT_LJUSTIFY;
+	break;
 
-	  case 'F':
-	    /* Fixed case format using upper case, or lower case on
-	     * fall through from above, for `INF' and `NAN'...
-	     */
-	    if( stream.flags & PFORMAT_LDOUBLE )
-	      /*
-	       * for a `long double' argument...
-	       */
-	      __pformat_float( va_arg( argv, long double ), &stream );
-
-	    else
-	      /* or just a `double', which we promote to `long double',
-	       * so the two may share a common format handler.
-	       */
-	      __pformat_float( (long double)(va_arg( argv, double )), &stream );
-
-	    goto format_scan;
-
-	  case 'g':
-	    /* Generalised floating point format, with lower case
-	     * exponent indicator when required; select lower case
-	     * mode, and simply fall through...
-	     */
-	    stream.flags |= PFORMAT_XCASE;
+      case '\'':
+	/* Formerly an XSI extension to the POSIX standard,
+	 * but fully supported as of POSIX.1-2008, this flag
+	 * causes grouping of digits according to the rules
+	 * defined for the LC_NUMERIC category within the
+	 * current locale.
+	 */
+	if( state == PFORMAT_INIT )
+	  spec->flags |= PFORMAT_GROUPED;
+	break;
+
+      case '\x20':
+	/* Reserve a single space, within the output field,
+	 * for display of the sign of signed data; this will
+	 * be occupied by the minus sign, if the data value
+	 * is negative, or by a plus sign if the data value
+	 * is positive AND the `+' flag is also present, or
+	 * by a space otherwise.  (Technically, this flag
+	 * is redundant, if the `+' flag is present).
+	 */
+	if( state == PFORMAT_INIT )
+	  spec->flags |= PFORMAT_ADDSPACE;
+	break;
+
+      case '0':
+	/* May represent a flag, to activate the `pad with zeros'
+	 * option, or it may simply be a digit in a width or in a
+	 * precision specification...
+	 */
+	if( state == PFORMAT_INIT )
+	{
+	  /* This is the flag usage...
+	   */
+	  spec->flags |= PFORMAT_ZEROFILL;
+	  break;
+	}
 
-	  case 'G':
-	    /* Generalised floating point format, with upper case,
-	     * or on fall through from above, with lower case exponent
-	     * indicator when required...
+      default:
+	/* If we didn't match anything above, then we will check
+	 * for digits, which we may accumulate to generate field
+	 * width or precision specifications...
+	 */
+	if( (state < PFORMAT_END) && isdigit( c ) )
+	{
+	  if( state == PFORMAT_INIT )
+	    /* Initial digits explicitly relate to field width...
 	     */
-	    if( stream.flags & PFORMAT_LDOUBLE )
-	      /*
-	       * for a `long double' argument...
-	       */
-	      __pformat_gfloat( va_arg( argv, long double ), &stream );
-
-	    else
-	      /* or just a `double', which we promote to `long double',
-	       * so the two may share a common format handler.
-	       */
-	      __pformat_gfloat( (long double)(va_arg( argv, double )), &stream );
-
-	    goto format_scan;
-
-	  case 'a':
-	    /* Hexadecimal floating point format, with lower case radix
-	     * and exponent indicators; select the lower case mode, and
-	     * fall through...
+	    state = PFORMAT_SET_WIDTH;
+
+	  else if( state == PFORMAT_GET_PRECISION )
+	    /* while those following a precision indicator
+	     * explicitly relate to precision.
 	     */
-	    stream.flags |= PFORMAT_XCASE;
+	    state = PFORMAT_SET_PRECISION;
 
-	  case 'A':
-	    /* Hexadecimal floating point format; handles radix and
-	     * exponent indicators in either upper or lower case...
+	  if( width_spec )
+	  { /* We are accepting a width or precision specification;
+	     * add the units value represented by the current digit,
+	     * to ten times the value accumulated so far.
 	     */
-	    if( stream.flags & PFORMAT_LDOUBLE )
-	      /*
-	       * with a `long double' argument...
-	       */
-	      __pformat_xldouble( va_arg( argv, long double ), &stream );
+	    *width_spec = __pformat_imul10plus( *width_spec, c - '0' );
+	  }
+	}
+	else
+	{ /* We found a digit out of context, or some other character
+	   * with no designated meaning; reject this format specification,
+	   * backtrack, and emit its introductory `%' as literal text...
+	   */
+	  spec->len = 1;
+	  return backtrack;
+	}
+    }
+  }
+  /* If we get to here, the format string ended in the midst of an
+   * incomplete conversion specification; this emits nothing at all.
+   */
+  spec->len = 0;
+  return fmt;
+}
 
-	    else
-	      /* or just a `double'.
-	       */
-	      __pformat_xldouble( (long double)(va_arg( argv, double )), &stream );
+static
+int __pformat_dynamic_arg( int arg_index, va_list *argv, va_list *argv_indexed )
+{
+  /* Retrieve the value of a '*' field width, or precision specification,
+   * from the next sequentially accessed argument...
+   */
+  if( arg_index == PFORMAT_ARGNEXT )
+    return va_arg( *argv, int );
 
-	    goto format_scan;
+  else
+  { /* ...or from the specified indexed argument, when processing
+     * arguments in indexed order.
+     */
+    int value; va_list argp;
+    va_copy( argp, argv_indexed[zero_adjusted(arg_index)] );
+    value = va_arg( argp, int );
+    va_end( argp );
+    return value;
+  }
+}
 
-	  case 'n':
-	    /* Save current output character count...
-	     */
-	    if( length == PFORMAT_LENGTH_CHAR )
-	      /*
-	       * to a signed `char' destination...
-	       */
-	      *va_arg( argv, char * ) = stream.count;
-
-	    else if( length == PFORMAT_LENGTH_SHORT )
-	      /*
-	       * or to a signed `short'...
-	       */
-	      *va_arg( argv, short * ) = stream.count;
-
-	    else if( length == PFORMAT_LENGTH_LONG )
-	      /*
-	       * or to a signed `long'...
-	       */
-	      *va_arg( argv, long * ) = stream.count;
-
-	    else if( length == PFORMAT_LENGTH_LLONG )
-	      /*
-	       * or to a signed `long long'...
-	       */
-	      *va_arg( argv, long long * ) = stream.count;
-
-	    else
-	      /*
-	       * or, by default, to a signed `int'.
-	       */
-	      *va_arg( argv, int * ) = stream.count;
-
-	    goto format_scan;
-
-	  /* Argument length modifiers...
-	   * These are non-terminal; each sets the format parser
-	   * into the PFORMAT_END state, and ends with a `break'.
-	   */
-	  case 'h': case 'j': case 'l': case 't': case 'z':
-#	  ifdef _WIN32
-	    /* While the preceding five are ISO-C standards, not
-	     * all are supported by Microsoft's implementation of
-	     * printf(); we will generally favour the semantics as
-	     * specified by ISO-C, but except in case of conflict,
-	     * we also attempt to support Microsoft alternatives.
-	     * Thus, we also recognise their 'I' modifier...
-	     */
-	  case 'I':
-	    /* ...interpreting all six appropriately...
-	     */
-	    length = __pformat_length_modifier( &fmt );
-	    /*
-	     * ...while further noting that they accept 'l' as an
-	     * alternative to 'L', as a qualifier for 'long double';
-	     * this DOES conflict with ISO-C usage, so we offer it as
-	     * an optional user choice, whether the Microsoft usage is
-	     * to be supported, or (by default) to ignore such usage
-	     * entirely, as required by ISO-C.
-	     */
-	    if( (c != 'l') || !__pformat_is_alt_ldouble_modifier( length ) )
-	    {
-	      /* In the case where the Microsoft usage is to be ignored,
-	       * we mark the end of conversion specification analysis,
-	       * (as in the case of any modifier other than 'l')...
-	       */
-	      state = PFORMAT_END;
-	      break;
-	    }
-	    /* ...or, if the Microsoft usage option is enabled, simply
-	     * fall through to the next case, and handle 'l' as if it
-	     * were 'L'...
-	     */
-#	  else
-	    /* ...whereas, if building for any non-windows platform,
-	     * we simply analyse each of the five standard modifiers,
-	     * and end the case analysis immediately.
-	     */
-	    length = __pformat_length_modifier( &fmt );
-	    state = PFORMAT_END;
-	    break;
-#	  endif
+static
+void __pformat_convert
+( const __pformat_spec_t *spec, int flags, __pformat_t *stream,
+  va_list *argv, va_list *argv_indexed
+)
+{
+  /* Execute a single format string element, as described by "spec",
+   * emitting its output to "stream".
+   */
+  __pformat_intarg_t argval;
+  __pformat_length_t length = spec->length;
+  int c = spec->conv;
 
-	  case 'L':
-	    /* Identify the appropriate argument as a `long double',
-	     * when associated with `%a', `%A', `%e', `%E', `%f', `%F',
-	     * `%g' or `%G' format specifications.
-	     */
-	    stream.flags |= PFORMAT_LDOUBLE;
-	    state = PFORMAT_END;
-	    break;
+  if( spec->arg_index > 0 )
+  {
+    /* Processing arguments in random order; clear the current
+     * assignment for the active argv reference, and then reassign
+     * it to refer to the specified indexed argument.
+     */
+    va_end( *argv );
+    va_copy( *argv, argv_indexed[spec->arg_index - 1] );
+  }
+
+  /* Establish the flags, width and precision specs, as analysed...
+   */
+  stream->flags = flags | (spec->flags & ~PFORMAT_ALTLDBL);
+  stream->width = spec->width;
+  stream->precision = spec->precision;
+
+  /* ...resolving any possible Microsoft style use of 'l' as a
+   * qualifier for 'long double', according to the currently
+   * active user preference...
+   */
+  if( (spec->flags & PFORMAT_ALTLDBL)
+  &&  __pformat_is_alt_ldouble_modifier( length )  )
+    stream->flags |= PFORMAT_LDOUBLE;
+
+  if( spec->width_arg )
+  { /* ...and retrieving any field width, which is to be
+     * dynamically assigned from the argument list...
+     */
+    if( (stream->width = __pformat_dynamic_arg( spec->width_arg, argv,
+	    argv_indexed )) < 0 )
+    {
+      /* ...noting that, when the assigned value is negative, it
+       * is equivalent to a positive value with the `-' flag...
+       */
+      stream->flags |= PFORMAT_LJUSTIFY;
+      stream->width = -stream->width;
+    }
+  }
+  if( spec->precision_arg )
+  { /* ...and similarly, for the precision, but when it is negative,
+     * it should simply be ignored.
+     */
+    if( (stream->precision = __pformat_dynamic_arg( spec->precision_arg,
+	    argv, argv_indexed )) < 0 )
+      stream->precision = PFORMAT_IGNORE;
+  }
+
+  switch( c )
+  {
+    case 0:
+      /* This element represents literal text, which we simply copy to
+       * the output stream, as a single block; (note that this may be the
+       * residual from a rejected conversion specification, in which case
+       * any '*' arguments have been consumed, exactly as they would have
+       * been, had the specification been valid).
+       */
+      __pformat_putn( spec->text, spec->len, stream );
+      break;
+
+    case 'C':
+      /* Equivalent to `%lc'; set `length' accordingly,
+       * and simply fall through.
+       */
+      length = PFORMAT_LENGTH_LONG;
+
+    case 'c':
+      /* Single, (or single multibyte), character output...
+       *
+       * We handle these by copying the argument into our local
+       * `argval' buffer, and then we pass the address of that to
+       * either `__pformat_putchars()' or `__pformat_wputchars()',
+       * as appropriate, effectively formatting it as a string of
+       * the appropriate type, with a length of one.
+       *
+       * A side effect of this method of handling character data
+       * is that, if the user sets a precision of zero, then no
+       * character is actually emitted; we don't want that, so we
+       * forcibly override any user specified precision.
+       */
+      stream->precision = PFORMAT_IGNORE;
+
+      /* Now we invoke the appropriate format handler...
+       */
+      if( (length == PFORMAT_LENGTH_LONG)
+      ||  (length == PFORMAT_LENGTH_LLONG)  )
+      {
+	/* considering any `long' type modifier as a reference to
+	 * `wchar_t' data, (which is promoted to an `int' argument)...
+	 */
+	wchar_t argval = (wchar_t)(va_arg( *argv, int ));
+	__pformat_wputchars( &argval, 1, stream );
+      }
+
+      else
+      { /* while anything else is simply taken as `char', (which
+	 * is also promoted to an `int' argument)...
+	 */
+	argval.__pformat_uchar_t = (unsigned char)(va_arg( *argv, int ));
+	__pformat_putchars( (char *)(&argval), 1, stream );
+      }
+      break;
+
+    case 'S':
+      /* Equivalent to `%ls'; set `length' accordingly,
+       * and simply fall through.
+       */
+      length = PFORMAT_LENGTH_LONG;
 
-	  /* Precision indicator...
-	   * May appear once only; it must precede any modifier
-	   * for argument length, or any data type specifier.
+    case 's':
+      if( (length == PFORMAT_LENGTH_LONG)
+      ||  (length == PFORMAT_LENGTH_LLONG)  )
+      {
+	/* considering any `long' type modifier as a reference to
+	 * a `wchar_t' string...
+	 */
+	__pformat_wcputs( va_arg( *argv, wchar_t * ), stream );
+      }
+      else
+	/* This is normal string output;
+	 * we simply invoke the appropriate handler...
+	 */
+	__pformat_puts( va_arg( *argv, char * ), stream );
+
+      break;
+
+    case 'o': case 'u': case 'x': case 'X':
+      /* Unsigned integer values; octal, decimal or hexadecimal format...
+       */
+      if( length == PFORMAT_LENGTH_LLONG )
+	/*
+	 * with an `unsigned long long' argument, which we
+	 * process `as is'...
+	 */
+	argval.__pformat_ullong_t = va_arg( *argv, unsigned long long );
+
+      else if( length == PFORMAT_LENGTH_LONG )
+	/*
+	 * or with an `unsigned long', which we promote to
+	 * `unsigned long long'...
+	 */
+	argval.__pformat_ullong_t = va_arg( *argv, unsigned long );
+
+      else
+      { /* or for any other size, which will have been promoted
+	 * to `unsigned int', we select only the appropriately sized
+	 * least significant segment, and again promote to the same
+	 * size as `unsigned long long'...
+	 */
+	argval.__pformat_ullong_t = va_arg( *argv, unsigned int );
+	if( length == PFORMAT_LENGTH_SHORT )
+	  /*
+	   * from `unsigned short'...
 	   */
-	  case '.':
-	    if( state < PFORMAT_GET_PRECISION )
-	    {
-	      /* We haven't seen a precision specification yet,
-	       * so initialise it to zero, (in case no digits follow),
-	       * and accept any following digits as the precision.
-	       */
-	      stream.precision = 0;
-	      width_spec = &stream.precision;
-	      state = PFORMAT_GET_PRECISION;
-	    }
-	    else
-	      /* We've already seen a precision specification,
-	       * so this is just junk; proceed to end game.
-	       */
-	      state = PFORMAT_END;
-
-	    /* Either way, we must not fall through here.
-	     */
-	    break;
+	  argval.__pformat_ullong_t = argval.__pformat_ushort_t;
 
-	  /* Variable field width, or precision specification,
-	   * derived from the argument list...
+	else if( length == PFORMAT_LENGTH_CHAR )
+	  /*
+	   * or even from `unsigned char'...
 	   */
-	  case '*':
-	    /* When this appears...
-	     */
-	    if(   width_spec
-	    &&  ((state == PFORMAT_INIT) || (state == PFORMAT_GET_PRECISION)) )
-	    {
-	      /* ...in proper context; assign to field width
-	       * or precision, as appropriate...
-	       */
-	      if( (argc > 0) && ((arg_index = __pformat_arg_index( &fmt )) > 0) )
-	      {
-		/* ...from the specified indexed argument, when
-		 * processing arguments in indexed order...
-		 */
-		va_list argv;
-		va_copy( argv, argv_indexed[zero_adjusted(arg_index)] );
-		*width_spec = va_arg( argv, int );
-		va_end( argv );
-	      }
-	      /* ...or otherwise, from the next available
-	       * sequentially accessed argument.
-	       */
-	      else *width_spec = va_arg( argv, int );
-	      if( *width_spec < 0 )
-	      {
-		/* Assigned value was negative...
-		 */
-		if( state == PFORMAT_INIT )
-		{
-		  /* For field width, this is equivalent to
-		   * a positive value with the `-' flag...
-		   */
-		  stream.flags |= PFORMAT_LJUSTIFY;
-		  stream.width = -stream.width;
-		}
-		else
-		  /* while as a precision specification,
-		   * it should simply be ignored.
-		   */
-		  stream.precision = PFORMAT_IGNORE;
-	      }
-	    }
-	    else
-	      /* out of context; give up on width and precision
-	       * specifications for this conversion.
-	       */
-	      state = PFORMAT_END;
-
-	    /* Mark as processed...
-	     * we must not see `*' again, in this context.
-	     */
-	    width_spec = NULL;
-	    break;
+	  argval.__pformat_ullong_t = argval.__pformat_uchar_t;
+      }
+
+      /* so we can pass any size of argument to either of two
+       * common format handlers...
+       */
+      if( c == 'u' )
+	/* depending on whether output is to be encoded in
+	 * decimal format...
+	 */
+	__pformat_int( argval, stream );
+
+      else
+	/* or in octal or hexadecimal format...
+	 */
+	__pformat_xint( c, argval, stream );
+
+      break;
+
+    case 'd': case 'i':
+      /* Signed integer values; decimal format...
+       * This is similar to `u', but must process `argval' as signed,
+       * and be prepared to handle negative numbers.
+       */
+      stream->flags |= PFORMAT_NEGATIVE;
+
+      if( length == PFORMAT_LENGTH_LLONG )
+	/*
+	 * The argument is a `long long' type...
+	 */
+	argval.__pformat_llong_t = va_arg( *argv, long long );
 
-	  /* Formatting flags...
-	   * Must appear while in the PFORMAT_INIT state,
-	   * and are non-terminal, so again, end with `break'.
+      else if( length == PFORMAT_LENGTH_LONG )
+	/*
+	 * or here, a `long' type...
+	 */
+	argval.__pformat_llong_t = va_arg( *argv, long );
+
+      else
+      { /* otherwise, it's an `int' type...
+	 */
+	argval.__pformat_llong_t = va_arg( *argv, int );
+	if( length == PFORMAT_LENGTH_SHORT )
+	  /*
+	   * but it was promoted from a `short' type...
 	   */
-	  case '#':
-	    /* Select alternate PFORMAT_HASHED output style.
-	     */
-	    if( state == PFORMAT_INIT )
-	      stream.flags |= PFORMAT_HASHED;
-	    break;
+	  argval.__pformat_llong_t = argval.__pformat_short_t;
+	else if( length == PFORMAT_LENGTH_CHAR )
+	  /*
+	   * or even from a `char' type...
+	   */
+	  argval.__pformat_llong_t = argval.__pformat_char_t;
+      }
 
-	  case '+':
-	    /* Print a leading sign with numeric output,
-	     * for both positive and negative values.
-	     */
-	    if( state == PFORMAT_INIT )
-	      stream.flags |= PFORMAT_POSITIVE;
-	    break;
+      /* In any case, all share a common handler...
+       */
+      __pformat_int( argval, stream );
+      break;
 
-	  case '-':
-	    /* Select left justification of displayed output
-	     * data, within the output field width, instead of
-	     * the default flush right justification.
-	     */
-	    if( state == PFORMAT_INIT )
-	      stream.flags |= PFORMAT_LJUSTIFY;
-	    break;
+    case 'p':
+      /* Pointer argument; format as hexadecimal, subject to...
+       */
+      if( spec->pdefault && (stream->flags == flags) )
+      {
+	/* Here, the user didn't specify any particular
+	 * formatting attributes.  We must choose a default
+	 * which will be compatible with Microsoft's (broken)
+	 * scanf() implementation, (i.e. matching the default
+	 * used by MSVCRT's printf(), which appears to resemble
+	 * "%0.8X" for 32-bit pointers); in particular, we MUST
+	 * NOT adopt a GNU-like format resembling "%#x", because
+	 * Microsoft's scanf() will choke on the "0x" prefix.
+	 */
+	stream->flags |= PFORMAT_ZEROFILL;
+	stream->precision = 2 * sizeof( uintptr_t );
+      }
+      argval.__pformat_ullong_t = va_arg( *argv, uintptr_t );
+      __pformat_xint( 'x', argval, stream );
+      break;
 
-	  case '\'':
-	    /* Formerly an XSI extension to the POSIX standard,
-	     * but fully supported as of POSIX.1-2008, this flag
-	     * causes grouping of digits according to the rules
-	     * defined for the LC_NUMERIC category within the
-	     * current locale.
-	     */
-	    if( state == PFORMAT_INIT )
-	      stream.flags |= PFORMAT_GROUPED;
-	    break;
+    case 'e':
+      /* Floating point format, with lower case exponent indicator
+       * and lower case `inf' or `nan' representation when required;
+       * select lower case mode, and simply fall through...
+       */
+      stream->flags |= PFORMAT_XCASE;
 
-	  case '\x20':
-	    /* Reserve a single space, within the output field,
-	     * for display of the sign of signed data; this will
-	     * be occupied by the minus sign, if the data value
-	     * is negative, or by a plus sign if the data value
-	     * is positive AND the `+' flag is also present, or
-	     * by a space otherwise.  (Technically, this flag
-	     * is redundant, if the `+' flag is present).
-	     */
-	    if( state == PFORMAT_INIT )
-	      stream.flags |= PFORMAT_ADDSPACE;
-	    break;
+    case 'E':
+      /* Floating point format, with upper case exponent indicator
+       * and upper case `INF' or `NAN' representation when required,
+       * (or lower case for all of these, on fall through from above);
+       * select lower case mode, and simply fall through...
+       */
+      if( stream->flags & PFORMAT_LDOUBLE )
+	/*
+	 * for a `long double' argument...
+	 */
+	__pformat_efloat( va_arg( *argv, long double ), stream );
 
-	  case '0':
-	    /* May represent a flag, to activate the `pad with zeros'
-	     * option, or it may simply be a digit in a width or in a
-	     * precision specification...
-	     */
-	    if( state == PFORMAT_INIT )
-	    {
-	      /* This is the flag usage...
-	       */
-	      stream.flags |= PFORMAT_ZEROFILL;
-	      break;
-	    }
-
-	  default:
-	    /* If we didn't match anything above, then we will check
-	     * for digits, which we may accumulate to generate field
-	     * width or precision specifications...
-	     */
-	    if( (state < PFORMAT_END) && isdigit( c ) )
-	    {
-	      if( state == PFORMAT_INIT )
-		/* Initial digits explicitly relate to field width...
-		 */
-		state = PFORMAT_SET_WIDTH;
-
-	      else if( state == PFORMAT_GET_PRECISION )
-		/* while those following a precision indicator
-		 * explicitly relate to precision.
-		 */
-		state = PFORMAT_SET_PRECISION;
-
-	      if( width_spec )
-	      { /* We are accepting a width or precision specification;
-		 * add the units value represented by the current digit,
-		 * to ten times the value accumulated so far.
-		 */
-		*width_spec = __pformat_imul10plus( *width_spec, c - '0' );
-	      }
-	    }
-	    else
-	    { /* We found a digit out of context, or some other character
-	       * with no designated meaning; reject this format specification,
-	       * backtrack, and emit it as literal text...
-	       */
-	      fmt = backtrack;
-	      __pformat_putc( '%', &stream );
-	      goto format_scan;
-	    }
+      else
+	/* or just a `double', which we promote to `long double',
+	 * so the two may share a common format handler.
+	 */
+	__pformat_efloat( (long double)(va_arg( *argv, double )), stream );
+
+      break;
+
+    case 'f':
+      /* Fixed point format, using lower case for `inf' and
+       * `nan', when appropriate; select lower case mode, and
+       * simply fall through...
+       */
+      stream->flags |= PFORMAT_XCASE;
+
+    case 'F':
+      /* Fixed case format using upper case, or lower case on
+       * fall through from above, for `INF' and `NAN'...
+       */
+      if( stream->flags & PFORMAT_LDOUBLE )
+	/*
+	 * for a `long double' argument...
+	 */
+	__pformat_float( va_arg( *argv, long double ), stream );
+
+      else
+	/* or just a `double', which we promote to `long double',
+	 * so the two may share a common format handler.
+	 */
+	__pformat_float( (long double)(va_arg( *argv, double )), stream );
+
+      break;
+
+    case 'g':
+      /* Generalised floating point format, with lower case
+       * exponent indicator when required; select lower case
+       * mode, and simply fall through...
+       */
+      stream->flags |= PFORMAT_XCASE;
+
+    case 'G':
+      /* Generalised floating point format, with upper case,
+       * or on fall through from above, with lower case exponent
+       * indicator when required...
+       */
+      if( stream->flags & PFORMAT_LDOUBLE )
+	/*
+	 * for a `long double' argument...
+	 */
+	__pformat_gfloat( va_arg( *argv, long double ), stream );
+
+      else
+	/* or just a `double', which we promote to `long double',
+	 * so the two may share a common format handler.
+	 */
+	__pformat_gfloat( (long double)(va_arg( *argv, double )), stream );
+
+      break;
+
+    case 'a':
+      /* Hexadecimal floating point format, with lower case radix
+       * and exponent indicators; select the lower case mode, and
+       * fall through...
+       */
+      stream->flags |= PFORMAT_XCASE;
+
+    case 'A':
+      /* Hexadecimal floating point format; handles radix and
+       * exponent indicators in either upper or lower case...
+       */
+      if( stream->flags & PFORMAT_LDOUBLE )
+	/*
+	 * with a `long double' argument...
+	 */
+	__pformat_xldouble( va_arg( *argv, long double ), stream );
+
+      else
+	/* or just a `double'.
+	 */
+	__pformat_xldouble( (long double)(va_arg( *argv, double )), stream );
+
+      break;
+
+    case 'n':
+      /* Save current output character count...
+       */
+      if( length == PFORMAT_LENGTH_CHAR )
+	/*
+	 * to a signed `char' destination...
+	 */
+	*va_arg( *argv, char * ) = stream->count;
+
+      else if( length == PFORMAT_LENGTH_SHORT )
+	/*
+	 * or to a signed `short'...
+	 */
+	*va_arg( *argv, short * ) = stream->count;
+
+      else if( length == PFORMAT_LENGTH_LONG )
+	/*
+	 * or to a signed `long'...
+	 */
+	*va_arg( *argv, long * ) = stream->count;
+
+      else if( length == PFORMAT_LENGTH_LLONG )
+	/*
+	 * or to a signed `long long'...
+	 */
+	*va_arg( *argv, long long * ) = stream->count;
+
+      else
+	/*
+	 * or, by default, to a signed `int'.
+	 */
+	*va_arg( *argv, int * ) = stream->count;
+  }
+}
+
+static
+void __pformat_index_args
+( int argc, const __pformat_argmap_t *specs, va_list args, va_list *argv_indexed )
+{
+  /* Given a successfully classified set of positionally indexed arguments,
+   * set up a temporary local copy of the passed-in argument vector, which
+   * we may then prescan...
+   */
+  int c; va_list argv;
+  va_copy( argv, args );
+  for( c = 0; c < argc; c++ )
+  { /* ...storing an indexed reference to the starting boundary of each
+     * argument, before advancing to the next argument boundary...
+     */
+    va_copy( argv_indexed[c], argv );
+    switch( specs[c].ref[PFORMAT_CONVERSION_TYPE] )
+    {
+      /* ...noting that, regardless of conversion type, we don't need
+       * the argument values at this prescan phase, (so we may simply
+       * discard them), but we do need to adjust the va_list reference
+       * pointer as appropriate to the conversion type; thus...
+       */
+      case PFORMAT_TYPE_DOUBLE:
+	/* ...for floating point types, we must discriminate between
+	 * 'double' and 'long double', (but not 'float', because that
+	 * is always promoted to 'double')...
+	 */
+	if( __pformat_is_ldouble( specs[c].ref[PFORMAT_LENGTH_MODIFIER] ) )
+	  (void)(va_arg( argv, long double ));
+	else (void)(va_arg( argv, double ));
+	break;
+
+      case PFORMAT_TYPE_POINTER:
+	/* ...all pointer types need identically the same adjustment
+	 * as the generic 'void *' pointer...
+	 */
+	(void)(va_arg( argv, void * ));
+	break;
+
+      case PFORMAT_TYPE_INTEGER: default:
+	/* ...and all other types may be effectively be considered to
+	 * be represented as integer types, for which...
+	 */
+	switch( specs[c].ref[PFORMAT_LENGTH_MODIFIER] )
+	{ case PFORMAT_LENGTH_LONG: (void)(va_arg( argv, long )); break;
+	  case PFORMAT_LENGTH_LLONG: (void)(va_arg( argv, long long ));
+	    break;
+	  default: (void)(va_arg( argv, int ));
 	}
-      }
     }
+  }
+  /* Terminate processing of the temporary copy of the argument vector.
+   */
+  va_end( argv );
+}
+
+static
+int __pformat_run
+( int flags, void *dest, int max, const char *fmt,
+  const __pformat_plan_t *plan, va_list args
+)
+{
+  /* Common back-end for __pformat() and __pformat_exec(); exactly one
+   * of "fmt" or "plan" is expected to be specified, (as non-NULL); the
+   * former is interpreted, element by element, as it is scanned, while
+   * the latter represents a format string which has been analysed in
+   * advance, by __pformat_compile().
+   */
+  int argc; char buf[PFORMAT_BUFSIZ];
+
+#ifdef _WIN32
+  /* When the output is directed to a memory stream, as created by the
+   * open_memstream() function, fwrite() cannot expand its buffer, so we
+   * must write directly into it, as a PFORMAT_TO_HEAP destination.
+   */
+  struct __mingw_memstream *memstream = (flags & PFORMAT_TO_FILE)
+    ? __mingw_memstream_growable( (FILE *)(dest) ) : NULL;
+
+  if( memstream != NULL )
+  { flags ^= PFORMAT_TO_FILE | PFORMAT_TO_HEAP;
+    dest = __mingw_memstream_acquire( memstream );
+  }
+#endif
+
+  __pformat_t stream =
+  { /* Create and initialise a format control block
+     * for this output request.
+     */
+    dest,					/* output goes to here        */
+    flags &= PFORMAT_TO_FILE | PFORMAT_TO_HEAP	/* only these valid initially */
+	   | PFORMAT_NOLIMIT,
+    PFORMAT_IGNORE,				/* no field width yet         */
+    PFORMAT_IGNORE,				/* nor any precision spec     */
+    PFORMAT_RPINIT,				/* radix point uninitialised  */
+    (wchar_t)(0),				/* leave it unspecified       */
+    0,						/* zero output char count     */
+    max,					/* establish output limit     */
+    PFORMAT_MINEXP,				/* exponent chars preferred   */
+    PFORMAT_RPINIT,				/* thou' sep uninitialised    */
+    (wchar_t)(0),				/* leave it unspecified ...   */
+    NULL,					/* with no grouping counts    */
+    buf,					/* FILE output staging buffer */
+    0						/* which is initially empty   */
+  };
+
+  /* Establish a variant argument resource pool, to support processing of
+   * the passed-in argument vector in either sequential or random order.
+   */
+  va_list argv, argv_indexed[argc = (plan != NULL) ? plan->argc
+					: __pformat_indexed_argc( fmt )];
+  if( argc > 0 )
+  { /* All argument references, within the format string, are specified in
+     * the "%n$" or "*m$" positionally indexed style; a compiled plan will
+     * already have a verified argument classification table, so we may
+     * immediately locate the starting boundary of each argument...
+     */
+    if( plan != NULL )
+      __pformat_index_args( argc, plan->argmap, args, argv_indexed );
+
     else
-      /* We just parsed a character which is not included within any format
-       * specification; we simply emit it as a literal.
+    { /* ...otherwise we must construct the argument classification table,
+       * and verify continuity of the index sequence, before we do so.
        */
-      __pformat_putc( c, &stream );
+      __pformat_argmap_t specs[argc];
+      if( (argc = __pformat_argmap( argc, fmt, specs )) > 0 )
+	__pformat_index_args( argc, specs, args, argv_indexed );
+    }
   }
+  /* Initialise a local copy of the passed-in argument vector, such that
+   * it will be suitable for sequential processing of the arguments, while
+   * still allowing for it to be reinitialised, as may be required for
+   * processing the arguments in indexed random order.
+   */
+  va_copy( argv, args );
+
+  if( plan != NULL )
+  { /* Output is to be generated from a compiled plan; simply execute
+     * each of its component elements, in turn...
+     */
+    const __pformat_spec_t *spec = plan->spec;
+    const __pformat_spec_t *end = spec + plan->count;
+    while( spec < end )
+      __pformat_convert( spec++, flags, &stream, &argv, argv_indexed );
+  }
+  else while( *fmt )
+  { /* ...otherwise, we enter the format string parsing loop, analysing,
+     * and then immediately executing, each element as it is scanned.
+     */
+    __pformat_spec_t spec;
+    fmt = __pformat_parse( fmt, argc, &spec );
+    __pformat_convert( &spec, flags, &stream, &argv, argv_indexed );
+  }
+
   /* Clean up the resource pool, which was allocated for local processing of
    * the passed-in argument vector in either sequential or random order.
    */
@@ -3397,10 +3990,107 @@ int __pformat( int flags, void *dest, int max, const char *fmt, va_list args )
    */
   free( stream.grouping );
 
+  /* Transfer any residual output, which remains staged in the local
+   * buffer, to its ultimate FILE stream destination.
+   */
+  if( flags & PFORMAT_TO_FILE )
+    __pformat_flush( &stream );
+
+  /* Similarly, output which has been placed in a heap buffer must be NUL
+   * terminated, and appended to any content which it previously held.
+   */
+  else if( flags & PFORMAT_TO_HEAP )
+  { char *end = __pformat_heap_reserve( 0, &stream );
+    __pformat_heap_t *heap = (__pformat_heap_t *)(dest);
+    if( end != NULL )
+    { *end = '\0';
+      heap->len += stream.count;
+    }
+#ifdef _WIN32
+    if( memstream != NULL )
+    { /* For a memory stream, we must also synchronize the FILE stream
+       * with its buffer, before we release it; any failure to expand
+       * the buffer is to be reported as an output error.
+       */
+      if( heap->error ) stream.count = -1;
+      __mingw_memstream_release( memstream );
+    }
+#endif
+  }
+
   /* When we have fully dispatched the format string, the return value is the
    * total number of bytes we transferred to the output destination.
    */
   return stream.count;
 }
 
+int __pformat( int flags, void *dest, int max, const char *fmt, va_list args )
+{ return __pformat_run( flags, dest, max, fmt, NULL, args ); }
+
+int __pformat_exec
+( int flags, void *dest, int max, const __pformat_plan_t *plan, va_list args )
+{ return __pformat_run( flags, dest, max, NULL, plan, args ); }
+
+__pformat_plan_t *__pformat_compile( const char *fmt )
+{
+  /* Analyse the format string "fmt", returning a plan which may then be
+   * executed, any number of times, by __pformat_exec(); the plan is held
+   * in a single block of heap memory, which is to be released by calling
+   * __pformat_release(); returns NULL, if the memory is unavailable.
+   */
+  __pformat_plan_t *plan; __pformat_spec_t spec, *next;
+  const char *scan; char *copy; size_t len = 1 + strlen( fmt );
+  int count = 0, argc = __pformat_indexed_argc( fmt );
+
+  /* When positionally indexed arguments are specified, we must classify
+   * them now, (thus verifying the index sequence), so that the plan need
+   * not repeat this at execution time...
+   */
+  __pformat_argmap_t map[(argc > 0) ? argc : 1];
+  if( argc > 0 ) argc = __pformat_argmap( argc, fmt, map );
+
+  /* ...then, to determine how much memory is required, we make a first
+   * pass over the format string, simply counting its elements.
+   */
+  for( scan = fmt; *scan; ++count )
+    scan = __pformat_parse( scan, argc, &spec );
+
+  if( (plan = malloc( sizeof( __pformat_plan_t ) + count * sizeof( spec )
+	  + argc * sizeof( __pformat_argmap_t ) + len )) != NULL )
+  {
+    /* We have the memory; lay out the argument map, and the private copy
+     * of the format string, immediately following the element array...
+     */
+    plan->key = fmt; plan->argc = argc;
+    plan->argmap = (__pformat_argmap_t *)(plan->spec + count);
+    memcpy( plan->argmap, map, argc * sizeof( __pformat_argmap_t ) );
+    plan->fmt = copy = memcpy( plan->argmap + argc, fmt, len );
+
+    /* ...then make a second pass, over the copy, to record descriptions
+     * of all elements which may produce output; (those which result from
+     * a truncated conversion specification, at the end of the format
+     * string, may be discarded).
+     */
+    for( next = plan->spec, scan = copy; *scan; )
+    { scan = __pformat_parse( scan, argc, next );
+      if( (next->conv != 0) || (next->len > 0) ) ++next;
+    }
+    plan->count = next - plan->spec;
+  }
+  return plan;
+}
+
+int __pformat_plan_match( const __pformat_plan_t *plan, const char *fmt )
+{
+  /* Helper for those clients which cache compiled plans, keyed on the
+   * address of the format string; confirm that the plan was compiled
+   * from "fmt", at its current address, AND that the content of "fmt"
+   * has not changed since then.
+   */
+  return (plan->key == fmt) && (strcmp( plan->fmt, fmt ) == 0);
+}
+
+void __pformat_release( __pformat_plan_t *plan )
+{ free( plan ); }
+
 /* $RCSfile$$Revision$: end of file */
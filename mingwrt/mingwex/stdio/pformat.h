@@ -65,6 +65,21 @@
  */
 #define PFORMAT_TO_FILE     0x1000
 #define PFORMAT_NOLIMIT     0x2000
+#define PFORMAT_TO_HEAP     0x4000
+
+/* When PFORMAT_TO_HEAP is specified, (together with PFORMAT_NOLIMIT),
+ * `dest' refers to a descriptor for a heap buffer, (initially empty, and
+ * with a NULL `buf', if preferred), which `__pformat()' will expand, as
+ * necessary, by `realloc()'; output is appended at offset `len', which is
+ * advanced to follow it, and is NUL terminated.  If the buffer cannot be
+ * expanded, `error' is set, and `len' is left unchanged.
+ */
+typedef struct
+{ char *	buf;
+  size_t	len;
+  size_t	size;
+  int		error;
+} __pformat_heap_t;
 
 #ifdef __MINGW32__
  /*
@@ -73,6 +88,12 @@
   */
 # define __pformat        __mingw_pformat
 
+# define __pformat_plan          __mingw_pformat_plan
+# define __pformat_compile       __mingw_pformat_compile
+# define __pformat_exec          __mingw_pformat_exec
+# define __pformat_plan_match    __mingw_pformat_plan_match
+# define __pformat_release       __mingw_pformat_release
+
 # define __printf         __mingw_printf
 # define __fprintf        __mingw_fprintf
 # define __sprintf        __mingw_sprintf
@@ -83,8 +104,25 @@
 # define __vsprintf       __mingw_vsprintf
 # define __vsnprintf      __mingw_vsnprintf
 
+# define __asprintf       __mingw_asprintf
+# define __vasprintf      __mingw_vasprintf
+
+# define __vfprintf_plan  __mingw_vfprintf_plan
+# define __vsnprintf_plan __mingw_vsnprintf_plan
+
 #endif
 
 int __cdecl __pformat( int, void *, int, const char *, va_list ) __MINGW_NOTHROW;
 
+/* A format string may also be analysed once, in advance, to produce
+ * an opaque "plan", which may then be executed repeatedly, without the
+ * overhead of reinterpreting the format string on each invocation.
+ */
+typedef struct __pformat_plan __pformat_plan_t;
+
+__pformat_plan_t *__cdecl __pformat_compile( const char * ) __MINGW_NOTHROW;
+int __cdecl __pformat_exec( int, void *, int, const __pformat_plan_t *, va_list ) __MINGW_NOTHROW;
+int __cdecl __pformat_plan_match( const __pformat_plan_t *, const char * ) __MINGW_NOTHROW;
+void __cdecl __pformat_release( __pformat_plan_t * ) __MINGW_NOTHROW;
+
 #endif /* !defined PFORMAT_H: $RCSfile$$Revision$: end of file */
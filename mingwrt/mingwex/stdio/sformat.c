@@ -0,0 +1,739 @@
+/* sformat.c
+ *
+ * $Id$
+ *
+ * Provides a core implementation of the formatted input conversion
+ * capabilities common to the entire `scanf()' family of functions; it
+ * conforms generally to C99 and SUSv3/POSIX specifications, and it is
+ * the input counterpart of the `__pformat()' output engine.
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice, this permission notice, and the following
+ * disclaimer shall be included in all copies or substantial portions of
+ * the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OF OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <locale.h>
+#include <wchar.h>
+
+#include "sformat.h"
+
+/* Floating point conversions are delegated to the gdtoa based string
+ * to binary converters, which are also furnished by libmingwex.a; (we
+ * declare them explicitly, since <stdlib.h> may not expose them all).
+ */
+double __strtod( const char *, char ** );
+float strtof( const char *, char ** );
+long double strtold( const char *, char ** );
+
+#if __GNUC__ && ! defined __NO_INLINE__
+# define __sformat_inline__  __inline__ __attribute__((__always_inline__))
+#else
+# define __sformat_inline__
+#endif
+
+/* Type size modifiers, as specified in conversion specifications;
+ * these are the same as those which the `pformat' engine uses, but
+ * they are internal to each engine.
+ */
+#define SFORMAT_INT         0
+#define SFORMAT_CHAR        1
+#define SFORMAT_SHORT       2
+#define SFORMAT_LONG        3
+#define SFORMAT_LLONG       4
+#define SFORMAT_INTMAX      SFORMAT_LLONG
+#define SFORMAT_SIZE        5
+#define SFORMAT_PTRDIFF     6
+#define SFORMAT_LDOUBLE     7
+
+/* A place holder for the single character of look-ahead, which we
+ * may need to return to the input source; it must be distinct from
+ * any valid character code, and from EOF.
+ */
+#define SFORMAT_NO_PUSHBACK (EOF - 1)
+
+/* Floating point input sequences are collected into a local buffer,
+ * before interpretation by the gdtoa converters; this is of fixed size
+ * initially, but it will be replaced by a heap allocated buffer, should
+ * any input sequence prove to be too long to fit.
+ */
+#ifndef SFORMAT_BUFSIZ
+#define SFORMAT_BUFSIZ      64
+#endif
+
+typedef struct
+{
+  /* Common state information, which is to be shared by all of the
+   * input conversion helper functions.
+   */
+  int           flags;
+  FILE         *fp;
+  const char   *sp;
+  int           count;
+  int           pushback;
+  char         *buf;
+  size_t        bufsiz;
+} __sformat_t;
+
+static __sformat_inline__
+int __sformat_getc( __sformat_t *stream )
+{
+  /* Helper to retrieve the next available input character, if any,
+   * from the input source; when the source is a FILE stream, we take
+   * the character directly from the stream buffer, (as the in-line
+   * getc() implementation does), calling _filbuf() only when the
+   * buffer has been exhausted.
+   */
+  int c;
+  if( stream->pushback != SFORMAT_NO_PUSHBACK )
+  { c = stream->pushback; stream->pushback = SFORMAT_NO_PUSHBACK; }
+
+  else if( (stream->flags & SFORMAT_FROM_FILE) != 0 )
+  { FILE *fp = stream->fp;
+    c = (--fp->_cnt >= 0) ? (unsigned char)(*fp->_ptr++) : _filbuf( fp );
+  }
+  else if( (c = (unsigned char)(*stream->sp)) != '\0' ) ++stream->sp;
+  else c = EOF;
+
+  /* Keep track of the number of characters consumed, as must be
+   * reported by any `%n' conversion.
+   */
+  if( c != EOF ) ++stream->count;
+  return c;
+}
+
+static __sformat_inline__
+void __sformat_ungetc( int c, __sformat_t *stream )
+{
+  /* Helper to return one character of look-ahead to the input source;
+   * it is held locally, until we either read it again, or we return
+   * it to the underlying FILE stream, when __sformat() completes.
+   */
+  if( c != EOF )
+  { stream->pushback = c; --stream->count; }
+}
+
+static
+int __sformat_skip_space( __sformat_t *stream )
+{
+  /* Helper to discard leading white space, before interpretation of
+   * any input field, returning the first following character, (which
+   * is also retained as look-ahead), or EOF.
+   */
+  int c;
+  while( isspace( c = __sformat_getc( stream ) ) )
+    ;
+  __sformat_ungetc( c, stream );
+  return c;
+}
+
+static __sformat_inline__
+unsigned int __sformat_digit( int c )
+{
+  /* Helper to evaluate a digit, in any base up to 36, without the
+   * cost of multiple comparisons; any non-digit yields a value which
+   * is not less than 36, and so is invalid in any supported base.
+   */
+  unsigned int digit = (unsigned int)(c - '0');
+  if( digit > 9 ) digit = (unsigned int)((c | 0x20) - 'a') + 10;
+  return digit;
+}
+
+static
+int __sformat_integer
+( __sformat_t *stream, int width, unsigned base, int is_signed,
+  unsigned long long *result )
+{
+  /* Helper to interpret an integer input field, in the specified base,
+   * (or in a base inferred from the field prefix, if base is zero), of
+   * no more than width characters; returns non-zero on success, while
+   * storing the value, clamped to the range of the largest supported
+   * signed or unsigned type, as appropriate, in *result.
+   */
+  unsigned long long value = 0ULL, cutoff;
+  unsigned int digit, cutlim;
+  int c, matched = 0, negative = 0, overflow = 0;
+
+  c = __sformat_getc( stream );
+  if( (c == '-' || c == '+') && width > 0 )
+  { negative = (c == '-'); c = __sformat_getc( stream ); --width; }
+
+  if( ((base == 0) || (base == 16)) && (c == '0') && (width > 0) )
+  {
+    /* A leading zero may introduce either a hexadecimal, or an octal
+     * value; in either case, it is itself a valid matching sequence.
+     */
+    matched = 1; c = __sformat_getc( stream );
+    if( (--width > 0) && ((c | 0x20) == 'x') )
+    { c = __sformat_getc( stream ); --width; base = 16; }
+    else if( base == 0 ) base = 8;
+  }
+  else if( base == 0 ) base = 10;
+
+  /* Accumulate the value of the digit sequence, noting, but otherwise
+   * ignoring, any overflow of the accumulator.
+   */
+  cutoff = ULLONG_MAX / base; cutlim = (unsigned int)(ULLONG_MAX % base);
+  while( (width-- > 0) && ((digit = __sformat_digit( c )) < base) )
+  {
+    if( (value >= cutoff) && ((value > cutoff) || (digit > cutlim)) )
+      overflow = 1;
+    value = value * base + digit;
+    matched = 1; c = __sformat_getc( stream );
+  }
+  __sformat_ungetc( c, stream );
+
+  /* Apply any sign, clamping the result to the representable range,
+   * in the same manner as strtoll() or strtoull() would.
+   */
+  if( is_signed )
+  {
+    if( overflow || (value > (unsigned long long)(LLONG_MAX) + negative) )
+      value = negative ? (unsigned long long)(LLONG_MIN) : LLONG_MAX;
+    else if( negative ) value = -value;
+  }
+  else if( overflow ) value = ULLONG_MAX;
+  else if( negative ) value = -value;
+
+  *result = value;
+  return matched;
+}
+
+static
+int __sformat_putbuf( __sformat_t *stream, size_t len, int c )
+{
+  /* Helper to append one character to the floating point input field
+   * collection buffer, expanding it as required; returns zero, if the
+   * buffer cannot be expanded.
+   */
+  if( len + 1 >= stream->bufsiz )
+  { char *buf = (stream->bufsiz > SFORMAT_BUFSIZ) ? stream->buf : NULL;
+    if( (buf = realloc( buf, stream->bufsiz << 1 )) == NULL )
+      return 0;
+    if( stream->bufsiz == SFORMAT_BUFSIZ )
+      memcpy( buf, stream->buf, len );
+    stream->buf = buf; stream->bufsiz <<= 1;
+  }
+  stream->buf[len] = c;
+  return 1;
+}
+
+static
+size_t __sformat_match_word( __sformat_t *stream, size_t len, int *width, const char *word )
+{
+  /* Helper to match a case-insensitive alphabetic word, such as
+   * "inf", or "nan", within a floating point input field; returns
+   * the updated field length, after collecting as much of the word
+   * as matches.
+   */
+  int c;
+  while( (*word != '\0') && (*width > 0) )
+  { if( ((c = __sformat_getc( stream )) | 0x20) != *word )
+    { __sformat_ungetc( c, stream ); break; }
+    if( ! __sformat_putbuf( stream, len++, c ) ) return 0;
+    ++word; --*width;
+  }
+  return (*word == '\0') ? len : 0;
+}
+
+static
+size_t __sformat_float( __sformat_t *stream, int width )
+{
+  /* Helper to collect the longest sequence of characters, up to the
+   * specified width, which may form a floating point input field, in
+   * any of the forms acceptable to strtod(); returns the length of the
+   * collected sequence, or zero if it is not a valid matching sequence.
+   */
+  size_t len = 0, digits = 0;
+  int c, radix, expchar = 'e', hex = 0;
+
+  radix = (unsigned char)(*localeconv()->decimal_point);
+  if( radix == '\0' ) radix = '.';
+
+  c = __sformat_getc( stream );
+  if( (c == '-' || c == '+') && (width > 0) )
+  { if( ! __sformat_putbuf( stream, len++, c ) ) return 0;
+    c = __sformat_getc( stream ); --width;
+  }
+  if( width > 0 ) switch( c )
+  {
+    case 'i': case 'I':
+      /* The field may represent an infinity, as either "inf", or
+       * "infinity", (with case ignored)...
+       */
+      __sformat_ungetc( c, stream );
+      if( (len = __sformat_match_word( stream, len, &width, "inf" )) > 0 )
+      { if( width > 0 )
+	{ /* ...but if the longer form is partially matched, then
+	   * the field doesn't match either.
+	   */
+	  c = __sformat_getc( stream ); __sformat_ungetc( c, stream );
+	  if( (c | 0x20) == 'i' )
+	    len = __sformat_match_word( stream, len, &width, "inity" );
+	}
+      }
+      return len;
+
+    case 'n': case 'N':
+      /* ...or it may represent a NaN, optionally qualified by an
+       * n-char-sequence, enclosed in parentheses.
+       */
+      __sformat_ungetc( c, stream );
+      if( ((len = __sformat_match_word( stream, len, &width, "nan" )) > 0)
+      &&  (width > 0)  )
+      { if( (c = __sformat_getc( stream )) == '(' )
+	{ do { if( ! __sformat_putbuf( stream, len++, c ) ) return 0;
+	       c = __sformat_getc( stream );
+	     } while( (--width > 0) && (isalnum( c ) || (c == '_')) );
+	  if( (width == 0) || (c != ')') )
+	  { __sformat_ungetc( c, stream ); return 0; }
+	  if( ! __sformat_putbuf( stream, len++, c ) ) return 0;
+	}
+	else __sformat_ungetc( c, stream );
+      }
+      return len;
+
+    case '0':
+      /* A leading zero may introduce a hexadecimal representation,
+       * (in which case, at least one hexadecimal digit must follow),
+       * or otherwise, it is simply the first significant digit.
+       */
+      if( ! __sformat_putbuf( stream, len++, c ) ) return 0;
+      ++digits; c = __sformat_getc( stream );
+      if( (--width > 0) && ((c | 0x20) == 'x') )
+      { if( ! __sformat_putbuf( stream, len++, c ) ) return 0;
+	c = __sformat_getc( stream ); --width;
+	hex = 1; expchar = 'p'; digits = 0;
+      }
+  }
+  /* Collect the digits of the significand, including any radix point.
+   */
+  while( width > 0 )
+  { if( (c == radix) && (radix > 0) )
+      radix = -radix;
+    else if( __sformat_digit( c ) < (hex ? 16U : 10U) )
+      ++digits;
+    else break;
+    if( ! __sformat_putbuf( stream, len++, c ) ) return 0;
+    c = __sformat_getc( stream ); --width;
+  }
+  if( digits == 0 )
+  { __sformat_ungetc( c, stream ); return 0; }
+
+  /* Collect any following exponent; if this is introduced, then it
+   * must include at least one digit, to form a valid field.
+   */
+  if( (width > 0) && ((c | 0x20) == expchar) )
+  { if( ! __sformat_putbuf( stream, len++, c ) ) return 0;
+    c = __sformat_getc( stream );
+    if( (--width > 0) && (c == '-' || c == '+') )
+    { if( ! __sformat_putbuf( stream, len++, c ) ) return 0;
+      c = __sformat_getc( stream ); --width;
+    }
+    for( digits = 0; (width > 0) && (__sformat_digit( c ) < 10); --width )
+    { if( ! __sformat_putbuf( stream, len++, c ) ) return 0;
+      c = __sformat_getc( stream ); ++digits;
+    }
+    if( digits == 0 )
+    { __sformat_ungetc( c, stream ); return 0; }
+  }
+  __sformat_ungetc( c, stream );
+  return len;
+}
+
+static
+const char *__sformat_scanset( const char *fmt, unsigned int *set )
+{
+  /* Helper to interpret the scanlist, within a `%[...]' conversion
+   * specification, into a 256-bit bitmap, with one bit per possible
+   * character code; returns a pointer to the closing bracket, or NULL
+   * if the scanlist is incomplete.
+   */
+  int c, invert = 0;
+  memset( set, 0, 256 / CHAR_BIT );
+
+  if( *fmt == '^' ) { invert = 1; ++fmt; }
+  if( *fmt == ']' ) { set[']' >> 5] |= 1U << (']' & 31); ++fmt; }
+  while( (c = (unsigned char)(*fmt)) != ']' )
+  {
+    if( c == '\0' ) return NULL;
+    if( (fmt[1] == '-') && (fmt[2] != ']') && (fmt[2] != '\0')
+    &&  (c <= (unsigned char)(fmt[2]))  )
+    {
+      /* An ascending range of characters, e.g. "a-z"; (this is not
+       * specified by ISO-C, but it is a common extension).
+       */
+      int last = (unsigned char)(fmt[2]);
+      do { set[c >> 5] |= 1U << (c & 31); } while( c++ < last );
+      fmt += 3;
+    }
+    else
+    { set[c >> 5] |= 1U << (c & 31); ++fmt; }
+  }
+  if( invert )
+  { for( c = 0; c < 8; c++ ) set[c] = ~set[c];
+    set[0] &= ~1U;
+  }
+  return fmt;
+}
+
+static
+int __sformat_store_wide
+( wchar_t **wp, int c, mbstate_t *state, int assign )
+{
+  /* Helper for `%lc', `%ls', and `%l[...]' conversions, to convert
+   * the multibyte input sequence to wide characters, one byte at a
+   * time; returns one, when a wide character has been completed, zero
+   * while a multibyte sequence remains incomplete, or -1 if the input
+   * is not a valid multibyte sequence.
+   */
+  wchar_t wc; char byte = (char)(c);
+  switch( mbrtowc( &wc, &byte, 1, state ) )
+  { case (size_t)(-1): return -1;
+    case (size_t)(-2): return 0;
+  }
+  if( assign ) *(*wp)++ = wc;
+  return 1;
+}
+
+static
+void __sformat_store_integer( void *p, int length, unsigned long long value )
+{
+  /* Helper to store the result of an integer conversion, truncated
+   * to the size of the object which is referenced by the argument.
+   */
+  switch( length )
+  { case SFORMAT_CHAR:    *(char *)(p) = (char)(value); break;
+    case SFORMAT_SHORT:   *(short *)(p) = (short)(value); break;
+    case SFORMAT_LONG:    *(long *)(p) = (long)(value); break;
+    case SFORMAT_LLONG:
+    case SFORMAT_LDOUBLE: *(long long *)(p) = (long long)(value); break;
+    case SFORMAT_SIZE:    *(size_t *)(p) = (size_t)(value); break;
+    case SFORMAT_PTRDIFF: *(ptrdiff_t *)(p) = (ptrdiff_t)(value); break;
+    default:              *(int *)(p) = (int)(value);
+  }
+}
+
+int __sformat( int flags, void *src, const char *fmt, va_list argv )
+{
+  /* Core implementation of the scanf() family input conversions; the
+   * input is taken from src, which may be either a FILE stream, or a
+   * NUL terminated string, as specified by flags.
+   */
+  int c, assigned = 0, converted = 0;
+  char local_buf[SFORMAT_BUFSIZ];
+  va_list argv_base;
+
+  __sformat_t stream =
+  {
+    /* Input stream state, shared by all helper functions.
+     */
+    flags,				/* input source selector flags */
+    NULL,				/* FILE stream, if selected */
+    NULL,				/* string, if FILE not selected */
+    0,					/* count of characters consumed */
+    SFORMAT_NO_PUSHBACK,		/* no look-ahead, initially */
+    local_buf,				/* floating point field buffer */
+    SFORMAT_BUFSIZ			/* and its initial size */
+  };
+  if( (flags & SFORMAT_FROM_FILE) != 0 ) stream.fp = (FILE *)(src);
+  else stream.sp = (const char *)(src);
+  va_copy( argv_base, argv );
+
+  while( (c = (unsigned char)(*fmt++)) != '\0' )
+  {
+    int width, length, assign, conv, start;
+    void *arg = NULL;
+
+    if( isspace( c ) )
+    {
+      /* White space in the format matches any amount of white space,
+       * (including none), in the input.
+       */
+      while( isspace( (unsigned char)(*fmt) ) ) ++fmt;
+      __sformat_skip_space( &stream );
+      continue;
+    }
+    if( (c != '%') || (*fmt == '%') )
+    {
+      /* Any other ordinary character must match exactly; (note that
+       * "%%" matches a single `%', after skipping white space).
+       */
+      if( c == '%' )
+      { ++fmt; __sformat_skip_space( &stream ); }
+      if( (conv = __sformat_getc( &stream )) == c ) continue;
+      if( conv == EOF ) goto input_failure;
+      __sformat_ungetc( conv, &stream );
+      goto done;
+    }
+
+    /* We have a conversion specification; interpret any POSIX style
+     * "%n$" argument reference, or the `*' assignment suppression flag,
+     * and any field width specification.
+     */
+    assign = 1; width = 0;
+    if( *fmt == '*' ) { assign = 0; ++fmt; }
+    while( isdigit( (unsigned char)(*fmt) ) )
+      width = width * 10 + *fmt++ - '0';
+    if( (*fmt == '$') && (width > 0) && assign )
+    {
+      /* Every argument is a pointer, so we may locate the referenced
+       * argument simply by skipping over those which precede it.
+       */
+      va_list argv_ref;
+      va_copy( argv_ref, argv_base );
+      while( --width > 0 ) (void)(va_arg( argv_ref, void * ));
+      arg = va_arg( argv_ref, void * );
+      va_end( argv_ref );
+      while( isdigit( (unsigned char)(*++fmt) ) )
+	width = width * 10 + *fmt - '0';
+    }
+
+    /* Interpret any type length modifier, (including Microsoft's
+     * `I64', `I32', and `I' extensions).
+     */
+    length = SFORMAT_INT;
+    switch( *fmt )
+    { case 'h':
+	length = (*++fmt == 'h') ? (++fmt, SFORMAT_CHAR) : SFORMAT_SHORT;
+	break;
+
+      case 'l':
+	length = (*++fmt == 'l') ? (++fmt, SFORMAT_LLONG) : SFORMAT_LONG;
+	break;
+
+      case 'q': case 'j':
+	++fmt; length = SFORMAT_INTMAX;
+	break;
+
+      case 'z':
+	++fmt; length = SFORMAT_SIZE;
+	break;
+
+      case 't':
+	++fmt; length = SFORMAT_PTRDIFF;
+	break;
+
+      case 'L':
+	++fmt; length = SFORMAT_LDOUBLE;
+	break;
+
+      case 'I':
+	if( (fmt[1] == '6') && (fmt[2] == '4') )
+	{ fmt += 3; length = SFORMAT_LLONG; }
+	else if( (fmt[1] == '3') && (fmt[2] == '2') )
+	{ fmt += 3; length = SFORMAT_LONG; }
+	else
+	{ ++fmt; length = (sizeof( size_t ) > sizeof( long ))
+	    ? SFORMAT_LLONG : SFORMAT_LONG;
+	}
+    }
+
+    /* Microsoft's `%C' and `%S' are equivalent to ISO-C's `%lc' and
+     * `%ls' respectively.
+     */
+    if( ((conv = *fmt++) == 'C') || (conv == 'S') )
+    { conv |= 0x20; length = SFORMAT_LONG; }
+
+    /* Unless otherwise specified by a "%n$" reference, assignments are
+     * directed to the next argument in sequence.
+     */
+    if( assign && (arg == NULL) && (conv != '\0') )
+      arg = va_arg( argv, void * );
+
+    /* All conversions, other than `%c', `%[...]', and `%n', discard
+     * any leading white space, before interpretation of input.
+     */
+    if( (conv != 'c') && (conv != '[') && (conv != 'n')
+    &&  (__sformat_skip_space( &stream ) == EOF) && (conv != '\0')  )
+      goto input_failure;
+    start = stream.count;
+
+    switch( conv )
+    {
+      unsigned long long value;
+      unsigned int base, set[256 / 32];
+      mbstate_t state;
+      wchar_t *wp;
+      size_t len;
+      char *p;
+
+      case 'n':
+	/* Report the number of characters consumed, so far; this does
+	 * not count as a conversion, for the purpose of the return value.
+	 */
+	if( assign ) __sformat_store_integer( arg, length, stream.count );
+	continue;
+
+      case 'd': base = 10; goto signed_integer;
+      case 'i': base = 0;
+      signed_integer:
+	if( ! __sformat_integer( &stream, width ? width : INT_MAX,
+	      base, 1, &value )  )
+	  goto conversion_failure;
+	if( assign ) __sformat_store_integer( arg, length, value );
+	break;
+
+      case 'o': base = 8; goto unsigned_integer;
+      case 'u': base = 10; goto unsigned_integer;
+      case 'p': length = (sizeof( void * ) > sizeof( long ))
+		  ? SFORMAT_LLONG : SFORMAT_LONG;
+      case 'x': case 'X': base = 16;
+      unsigned_integer:
+	if( ! __sformat_integer( &stream, width ? width : INT_MAX,
+	      base, 0, &value )  )
+	  goto conversion_failure;
+	if( assign ) __sformat_store_integer( arg, length, value );
+	break;
+
+      case 'a': case 'A': case 'e': case 'E':
+      case 'f': case 'F': case 'g': case 'G':
+	/* Collect the floating point input field, then delegate its
+	 * interpretation to the appropriate gdtoa converter.
+	 */
+	if( (len = __sformat_float( &stream, width ? width : INT_MAX )) == 0 )
+	  goto conversion_failure;
+	stream.buf[len] = '\0';
+	if( assign ) switch( length )
+	{ case SFORMAT_LDOUBLE:
+	    *(long double *)(arg) = strtold( stream.buf, NULL );
+	    break;
+	  case SFORMAT_LONG:
+	    *(double *)(arg) = __strtod( stream.buf, NULL );
+	    break;
+	  default:
+	    *(float *)(arg) = strtof( stream.buf, NULL );
+	}
+	break;
+
+      case 'c':
+	/* Match exactly the specified number of characters, (default
+	 * one), without appending any terminating NUL; (for `%lc', the
+	 * width counts complete multibyte characters).
+	 */
+	if( width == 0 ) width = 1;
+	memset( &state, 0, sizeof( state ) );
+	wp = (wchar_t *)(arg); p = (char *)(arg);
+	while( width > 0 )
+	{ if( (c = __sformat_getc( &stream )) == EOF )
+	    goto conversion_failure;
+	  if( length == SFORMAT_LONG )
+	  { switch( __sformat_store_wide( &wp, c, &state, assign ) )
+	    { case -1: goto done;
+	      case  0: continue;
+	    }
+	  }
+	  else if( assign ) *p++ = c;
+	  --width;
+	}
+	break;
+
+      case 's':
+	/* Match a sequence of non-white-space characters; (note that
+	 * leading white space has already been discarded).
+	 */
+	goto match_scanset;
+
+      case '[':
+	/* Match a sequence of characters from the specified scanset,
+	 * which we represent as a 256-bit bitmap.
+	 */
+	if( (fmt = __sformat_scanset( fmt, set )) == NULL )
+	  goto done;
+	++fmt;
+
+      match_scanset:
+	/* Common code for `%s' and `%[...]'; the field is delimited
+	 * by white space, or by a character which is not a member
+	 * of the scanset, respectively.
+	 */
+	if( width == 0 ) width = INT_MAX;
+	memset( &state, 0, sizeof( state ) );
+	wp = (wchar_t *)(arg); p = (char *)(arg); len = 0;
+	while( (width > 0) && ((c = __sformat_getc( &stream )) != EOF) )
+	{ if( (conv == 's') ? isspace( c ) : ((set[c >> 5] & (1U << (c & 31))) == 0) )
+	  { __sformat_ungetc( c, &stream ); break; }
+	  if( length == SFORMAT_LONG )
+	  { switch( __sformat_store_wide( &wp, c, &state, assign ) )
+	    { case -1: goto done;
+	      case  0: continue;
+	    }
+	  }
+	  else if( assign ) *p++ = c;
+	  --width; ++len;
+	}
+	if( len == 0 ) goto conversion_failure;
+	if( assign )
+	{ if( length == SFORMAT_LONG ) *wp = L'\0';
+	  else *p = '\0';
+	}
+	break;
+
+      default:
+	/* Any other conversion specifier is invalid.
+	 */
+	goto done;
+    }
+    /* When we get to here, the conversion has been successfully
+     * completed; count it, and any consequent assignment.
+     */
+    ++converted;
+    if( assign ) ++assigned;
+    continue;
+
+  conversion_failure:
+    /* A conversion which cannot be completed; this represents an input
+     * failure, if the input was exhausted before any character could be
+     * matched, otherwise it is a matching failure.
+     */
+    if( stream.count == start )
+    { if( (c = __sformat_getc( &stream )) == EOF ) goto input_failure;
+      __sformat_ungetc( c, &stream );
+    }
+    goto done;
+  }
+  goto done;
+
+input_failure:
+  /* When input is exhausted, before completion of the first conversion,
+   * we must report EOF, rather than a count of assignments.
+   */
+  if( converted == 0 ) assigned = EOF;
+
+done:
+  /* Return any look-ahead character to the FILE stream, from which it
+   * was read, and release any heap memory which we may have allocated.
+   */
+  if( (stream.pushback != SFORMAT_NO_PUSHBACK) && (stream.fp != NULL) )
+    ungetc( stream.pushback, stream.fp );
+  if( stream.buf != local_buf ) free( stream.buf );
+  va_end( argv_base );
+  return assigned;
+}
+
+/* $RCSfile$: end of file */
@@ -0,0 +1,48 @@
+#ifndef SFORMAT_H
+/*
+ * sformat.h
+ *
+ * $Id$
+ *
+ * A private header, defining the `sformat' API; it is to be included
+ * in each compilation unit implementing any of the `scanf' family of
+ * functions, but serves no useful purpose elsewhere.
+ *
+ * This is free software.  You may redistribute and/or modify it as you
+ * see fit, without restriction of copyright.
+ *
+ * This software is provided "as is", in the hope that it may be useful,
+ * but WITHOUT WARRANTY OF ANY KIND, not even any implied warranty of
+ * MERCHANTABILITY, nor of FITNESS FOR ANY PARTICULAR PURPOSE.  At no
+ * time will the author accept any form of liability for any damages,
+ * however caused, resulting from the use of this software.
+ */
+#define SFORMAT_H
+
+/* We share the compiler compatibility, and function aliasing, macros
+ * which are defined for the complementary `pformat' API.
+ */
+#include "pformat.h"
+
+/* Select the input source; when SFORMAT_FROM_FILE is specified, the
+ * source argument to __sformat() is a FILE stream, otherwise it is a
+ * NUL terminated string.
+ */
+#define SFORMAT_FROM_FILE   0x1000
+
+#ifdef __MINGW32__
+ /*
+  * Map MinGW specific function names, for use in place of the generic
+  * implementation defined equivalent function names.
+  */
+# define __sformat        __mingw_sformat
+
+# define __vscanf         __mingw_vscanf
+# define __vfscanf        __mingw_vfscanf
+# define __vsscanf        __mingw_vsscanf
+
+#endif
+
+int __cdecl __sformat( int, void *, const char *, va_list ) __MINGW_NOTHROW;
+
+#endif /* !defined SFORMAT_H: $RCSfile$$Revision$: end of file */
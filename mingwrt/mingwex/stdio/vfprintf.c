@@ -45,6 +45,7 @@
 #include "pformat.h"
 
 int __cdecl __vfprintf (FILE *, const char *, va_list) __MINGW_NOTHROW;
+int __cdecl __vfprintf_plan (FILE *, const __pformat_plan_t *, va_list) __MINGW_NOTHROW;
 
 #ifdef INSTALL_AS_DEFAULT
 /*
@@ -61,4 +62,9 @@ int __cdecl __vfprintf( FILE *stream, const char *fmt, va_list argv )
   return __pformat( PFORMAT_TO_FILE | PFORMAT_NOLIMIT, stream, 0, fmt, argv );
 }
 
+int __cdecl __vfprintf_plan( FILE *stream, const __pformat_plan_t *plan, va_list argv )
+{
+  return __pformat_exec( PFORMAT_TO_FILE | PFORMAT_NOLIMIT, stream, 0, plan, argv );
+}
+
 /* $RCSfile$$Revision$: end of file */
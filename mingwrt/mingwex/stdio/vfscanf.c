@@ -1,40 +1,35 @@
-//  By aaronwl 2003-01-28 for mingw-msvcrt
-//  Public domain: all copyrights disclaimed, absolutely no warranties */
-
-#include <stdarg.h>
+/* vfscanf.c
+ *
+ * $Id$
+ *
+ * Provides an implementation of the "vfscanf" function, conforming
+ * generally to C99 and SUSv3/POSIX specifications.  This is included
+ * in libmingwex.a, as "__mingw_vfscanf()"; since MSVCRT.DLL does not
+ * provide any implementation of "vfscanf()", it is also exported under
+ * that name, as an alias for the "__mingw_vfscanf()" implementation.
+ *
+ *
+ * This is free software.  You may redistribute and/or modify it as you
+ * see fit, without restriction of copyright.
+ *
+ * This software is provided "as is", in the hope that it may be useful,
+ * but WITHOUT WARRANTY OF ANY KIND, not even any implied warranty of
+ * MERCHANTABILITY, nor of FITNESS FOR ANY PARTICULAR PURPOSE.  At no
+ * time will the author accept any form of liability for any damages,
+ * however caused, resulting from the use of this software.
+ *
+ */
 #include <stdio.h>
+#include <stdarg.h>
 
-int vfscanf(FILE * __restrict__ stream, const char * __restrict__ format, va_list arg) {
-  int ret;
-
-  __asm__(
-
-    /* allocate stack (esp += frame - arg3 - (8[arg1,2] + 12)) */
-    "movl	%%esp, %%ebx\n\t"
-    "lea	0xFFFFFFEC(%%esp, %6), %%esp\n\t"
-    "subl	%5, %%esp\n\t"
-
-    // set up stack
-    "movl	%1, 0xC(%%esp)\n\t"  // stream
-    "movl	%2, 0x10(%%esp)\n\t"  // format
-    "lea	0x14(%%esp), %%edi\n\t"
-    "movl	%%edi, (%%esp)\n\t"  // memcpy dest
-    "movl	%5, 0x4(%%esp)\n\t"  // memcpy src
-    "movl	%5, 0x8(%%esp)\n\t"
-    "subl	%6, 0x8(%%esp)\n\t"  // memcpy len
-    "call	_memcpy\n\t"
-    "addl	$12, %%esp\n\t"
-
-    // call fscanf
-    "call	_fscanf\n\t"
-
-    // restore stack
-    "movl	%%ebx, %%esp\n\t"
+#include "sformat.h"
 
-    : "=a"(ret), "=c"(stream), "=d"(format)
-    : "1"(stream), "2"(format), "S"(arg),
-      "a"(&ret)
-    : "ebx", "edi");
+int __cdecl __vfscanf (FILE *, const char *, va_list) __MINGW_NOTHROW;
+int __cdecl __mingw_alias(vfscanf) (FILE *, const char *, va_list) __MINGW_NOTHROW;
 
-  return ret;
+int __cdecl __vfscanf( FILE *stream, const char *fmt, va_list argv )
+{
+  return __sformat( SFORMAT_FROM_FILE, stream, fmt, argv );
 }
+
+/* $RCSfile$$Revision$: end of file */
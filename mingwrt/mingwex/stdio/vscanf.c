@@ -1,9 +1,35 @@
-//  By aaronwl 2003-01-28 for mingw-msvcrt
-//  Public domain: all copyrights disclaimed, absolutely no warranties
-
-#include <stdarg.h>
+/* vscanf.c
+ *
+ * $Id$
+ *
+ * Provides an implementation of the "vscanf" function, conforming
+ * generally to C99 and SUSv3/POSIX specifications.  This is included
+ * in libmingwex.a, as "__mingw_vscanf()"; since MSVCRT.DLL does not
+ * provide any implementation of "vscanf()", it is also exported under
+ * that name, as an alias for the "__mingw_vscanf()" implementation.
+ *
+ *
+ * This is free software.  You may redistribute and/or modify it as you
+ * see fit, without restriction of copyright.
+ *
+ * This software is provided "as is", in the hope that it may be useful,
+ * but WITHOUT WARRANTY OF ANY KIND, not even any implied warranty of
+ * MERCHANTABILITY, nor of FITNESS FOR ANY PARTICULAR PURPOSE.  At no
+ * time will the author accept any form of liability for any damages,
+ * however caused, resulting from the use of this software.
+ *
+ */
 #include <stdio.h>
+#include <stdarg.h>
 
-int vscanf(const char * __restrict__ format, va_list arg) {
-  return vfscanf(stdin, format, arg);
+#include "sformat.h"
+
+int __cdecl __vscanf (const char *, va_list) __MINGW_NOTHROW;
+int __cdecl __mingw_alias(vscanf) (const char *, va_list) __MINGW_NOTHROW;
+
+int __cdecl __vscanf( const char *fmt, va_list argv )
+{
+  return __sformat( SFORMAT_FROM_FILE, stdin, fmt, argv );
 }
+
+/* $RCSfile$$Revision$: end of file */
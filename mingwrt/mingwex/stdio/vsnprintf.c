@@ -43,13 +43,103 @@
  */
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #include "pformat.h"
 
 int __cdecl __vsnprintf (char *, size_t, const char *fmt, va_list) __MINGW_NOTHROW;
 int __cdecl __mingw_alias(vsnprintf) (char *, size_t, const char *, va_list) __MINGW_NOTHROW;
 
-int __cdecl __vsnprintf( char *buf, size_t length, const char *fmt, va_list argv )
+int __cdecl __vsnprintf_plan
+(char *, size_t, const __pformat_plan_t *, va_list) __MINGW_NOTHROW;
+
+#ifdef _WIN32
+/* Programs commonly call vsnprintf(), (or any of its wrappers), many
+ * times over, with one invariant format string; to avoid interpreting
+ * such format strings afresh, on every call, we maintain a small cache
+ * of compiled format plans, keyed on the address of the format string.
+ */
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#define PFORMAT_CACHE_SLOTS   256
+#define PFORMAT_CACHE_PROBES    4
+
+/* Entries are only ever added to the cache, (they are never evicted),
+ * so we may publish them without locking; to avoid filling it with the
+ * plans for format strings which are used only once, a plan is compiled
+ * only when the format string address is seen for the second time, at
+ * any one slot.
+ */
+static const char *volatile __pformat_cache_seen[PFORMAT_CACHE_SLOTS];
+static __pformat_plan_t *volatile __pformat_cache[PFORMAT_CACHE_SLOTS];
+
+static
+const __pformat_plan_t *__pformat_cached_plan( const char *fmt )
+{
+  /* Retrieve the plan for "fmt", from the cache, compiling and storing it
+   * if appropriate; returns NULL, if no plan is available, in which case
+   * the caller should fall back to direct interpretation of "fmt".
+   */
+  int probe; unsigned int slot;
+  slot = (unsigned int)((uintptr_t)(fmt) * 2654435761U) >> 24;
+  for( probe = 0; probe < PFORMAT_CACHE_PROBES; probe++ )
+  { unsigned int index = (slot + probe) & (PFORMAT_CACHE_SLOTS - 1);
+    __pformat_plan_t *plan = __pformat_cache[index];
+    if( plan == NULL )
+    { /* This slot remains unoccupied; (it follows that no plan for "fmt"
+       * can exist in any subsequent slot).  If this is the first sighting
+       * of "fmt" here, simply note it...
+       */
+      if( __pformat_cache_seen[index] != fmt )
+      { __pformat_cache_seen[index] = fmt;
+	return NULL;
+      }
+      /* ...otherwise, compile a plan, and attempt to store it; another
+       * thread may have beaten us to it, in which case we discard ours,
+       * and consider the winner's plan instead.
+       */
+      if( (plan = __pformat_compile( fmt )) == NULL )
+	return NULL;
+
+      if( InterlockedCompareExchangePointer( (PVOID *)(&__pformat_cache[index]),
+	    plan, NULL ) == NULL ) return plan;
+
+      __pformat_release( plan );
+      plan = __pformat_cache[index];
+    }
+    /* The slot is occupied; its plan is usable only if it represents the
+     * current content of the format string, at the given address.
+     */
+    if( __pformat_plan_match( plan, fmt ) )
+      return plan;
+  }
+  return NULL;
+}
+
+#else
+/* Without the requisite support for atomic publication of plans, we do
+ * not provide any cache; all format strings are interpreted directly.
+ */
+#define __pformat_cached_plan( fmt )  NULL
+#endif
+
+static __inline__
+int __pformat_dispatch
+( int max, char *buf, const char *fmt, const __pformat_plan_t *plan, va_list argv )
+{
+  /* Helper to invoke __pformat(), or __pformat_exec(), as appropriate,
+   * depending on whether a compiled plan is available, or not.
+   */
+  return (plan != NULL) ? __pformat_exec( 0, buf, max, plan, argv )
+    : __pformat( 0, buf, max, fmt, argv );
+}
+
+static
+int __pformat_vsnprintf
+( char *buf, size_t length, const char *fmt, const __pformat_plan_t *plan,
+  va_list argv
+)
 {
   register int retval;
 
@@ -58,16 +148,23 @@ int __cdecl __vsnprintf( char *buf, size_t length, const char *fmt, va_list argv
      * No buffer; simply compute and return the size required,
      * without actually emitting any data.
      */
-    return __pformat( 0, buf, 0, fmt, argv );
+    return __pformat_dispatch( 0, buf, fmt, plan, argv );
 
   /* If we get to here, then we have a buffer...
    * Emit data up to the limit of buffer length less one,
    * then add the requisite NUL terminator.
    */
-  retval = __pformat( 0, buf, --length, fmt, argv );
+  retval = __pformat_dispatch( --length, buf, fmt, plan, argv );
   buf[retval < length ? retval : length] = '\0';
 
   return retval;
 }
 
+int __cdecl __vsnprintf( char *buf, size_t length, const char *fmt, va_list argv )
+{ return __pformat_vsnprintf( buf, length, fmt, __pformat_cached_plan( fmt ), argv ); }
+
+int __cdecl __vsnprintf_plan
+( char *buf, size_t length, const __pformat_plan_t *plan, va_list argv )
+{ return __pformat_vsnprintf( buf, length, NULL, plan, argv ); }
+
 /* $RCSfile$: end of file */
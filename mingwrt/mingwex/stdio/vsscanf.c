@@ -1,41 +1,35 @@
-//  By aaronwl 2003-01-28 for mingw-msvcrt.
-//  Public domain: all copyrights disclaimed, absolutely no warranties.
-
-#include <stdarg.h>
+/* vsscanf.c
+ *
+ * $Id$
+ *
+ * Provides an implementation of the "vsscanf" function, conforming
+ * generally to C99 and SUSv3/POSIX specifications.  This is included
+ * in libmingwex.a, as "__mingw_vsscanf()"; since MSVCRT.DLL does not
+ * provide any implementation of "vsscanf()", it is also exported under
+ * that name, as an alias for the "__mingw_vsscanf()" implementation.
+ *
+ *
+ * This is free software.  You may redistribute and/or modify it as you
+ * see fit, without restriction of copyright.
+ *
+ * This software is provided "as is", in the hope that it may be useful,
+ * but WITHOUT WARRANTY OF ANY KIND, not even any implied warranty of
+ * MERCHANTABILITY, nor of FITNESS FOR ANY PARTICULAR PURPOSE.  At no
+ * time will the author accept any form of liability for any damages,
+ * however caused, resulting from the use of this software.
+ *
+ */
 #include <stdio.h>
+#include <stdarg.h>
 
+#include "sformat.h"
 
-int vsscanf(const char * __restrict__ s, const char * __restrict__ format, va_list arg) {
-  int ret;
-
-  __asm__(
-
-    // allocate stack (esp += frame - arg3 - (8[arg1,2] + 12))
-    "movl	%%esp, %%ebx\n\t"
-    "lea	0xFFFFFFEC(%%esp, %6), %%esp\n\t"
-    "subl	%5, %%esp\n\t"
-
-    // set up stack
-    "movl	%1, 0xC(%%esp)\n\t"  // s
-    "movl	%2, 0x10(%%esp)\n\t"  // format
-    "lea	0x14(%%esp), %%edi\n\t"
-    "movl	%%edi, (%%esp)\n\t"  // memcpy dest
-    "movl	%5, 0x4(%%esp)\n\t"  // memcpy src
-    "movl	%5, 0x8(%%esp)\n\t"
-    "subl	%6, 0x8(%%esp)\n\t"  // memcpy len
-    "call	_memcpy\n\t"
-    "addl	$12, %%esp\n\t"
-
-    // call sscanf
-    "call	_sscanf\n\t"
-
-    // restore stack
-    "movl	%%ebx, %%esp\n\t"
-
-    : "=a"(ret), "=c"(s), "=d"(format)
-    : "1"(s), "2"(format), "S"(arg),
-      "a"(&ret)
-    : "ebx", "edi");
+int __cdecl __vsscanf (const char *, const char *, va_list) __MINGW_NOTHROW;
+int __cdecl __mingw_alias(vsscanf) (const char *, const char *, va_list) __MINGW_NOTHROW;
 
-  return ret;
+int __cdecl __vsscanf( const char *buf, const char *fmt, va_list argv )
+{
+  return __sformat( 0, (void *)(buf), fmt, argv );
 }
+
+/* $RCSfile$$Revision$: end of file */
@@ -0,0 +1,113 @@
+/*
+ * tbalance.c
+ *
+ * Private helper, for use by the tsearch() and tdelete() functions, to
+ * maintain AVL balance within the binary trees which they manipulate.
+ *
+ * $Id$
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR THE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+#define _SEARCH_PRIVATE
+#include <search.h>
+#include <stdlib.h>
+
+static __inline__ __attribute__((__always_inline__))
+int theight (const node_t *node)
+{
+  /* Helper to retrieve the height of any subtree, (which may be empty,
+   * in which case its height is zero).
+   */
+  return (node == NULL) ? 0 : node->height;
+}
+
+static __inline__ __attribute__((__always_inline__))
+void tresize (node_t *node)
+{
+  /* Helper to recompute the height of a subtree, from the heights of
+   * its immediate left and right subtrees.
+   */
+  int lh = theight (node->llink), rh = theight (node->rlink);
+  node->height = 1 + ((lh > rh) ? lh : rh);
+}
+
+static node_t *trotate_right (node_t *node)
+{
+  /* Promote the left child of "node" to become the root of the subtree
+   * which is currently rooted at "node", returning the new root.
+   */
+  node_t *pivot = node->llink;
+  node->llink = pivot->rlink; tresize (node);
+  pivot->rlink = node; tresize (pivot);
+  return pivot;
+}
+
+static node_t *trotate_left (node_t *node)
+{
+  /* Promote the right child of "node" to become the root of the subtree
+   * which is currently rooted at "node", returning the new root.
+   */
+  node_t *pivot = node->rlink;
+  node->rlink = pivot->llink; tresize (node);
+  pivot->llink = node; tresize (pivot);
+  return pivot;
+}
+
+int __mingw_tbalance (node_t **rootp)
+{
+  /* Restore AVL balance to the subtree rooted at *rootp, (in which the
+   * left and right subtrees are assumed to be balanced already, and to
+   * differ in height by no more than two), returning non-zero if the
+   * height of the subtree has changed, as a result of any insertion or
+   * deletion which prompted this rebalancing.
+   */
+  node_t *root = *rootp;
+  int height = root->height;
+  int lh = theight (root->llink), rh = theight (root->rlink);
+
+  if( lh > (rh + 1) )
+  { /* The left subtree is too tall; if its own taller subtree is on
+     * its right, a double rotation is required...
+     */
+    if( theight (root->llink->llink) < theight (root->llink->rlink) )
+      root->llink = trotate_left (root->llink);
+    *rootp = root = trotate_right (root);
+  }
+  else if( rh > (lh + 1) )
+  { /* ...and similarly, when the right subtree is too tall.
+     */
+    if( theight (root->rlink->rlink) < theight (root->rlink->llink) )
+      root->rlink = trotate_right (root->rlink);
+    *rootp = root = trotate_left (root);
+  }
+  else
+    /* The subtree is already balanced; its height may have changed,
+     * but no rotation is required.
+     */
+    tresize (root);
+
+  return root->height != height;
+}
+
+/* $RCSfile$: end of file */
@@ -22,14 +22,20 @@ __CRT_ALIAS void *__tdelete
    * when _SEARCH_PRIVATE is enabled; for public consumption, it becomes
    * an alias for "void", (assuming _SEARCH_PRIVATE is NOT enabled).
    */
-  int cmp;
-  node_t *p, *q, *r;
+  int cmp, depth = 0, node;
+  node_t *p, *q, *r, **path[__MINGW_TSEARCH_MAXHEIGHT + 1];
 
   if( (rootp == NULL) || ((p = *rootp) == NULL) || (compar == NULL) )
     return NULL;
 
+  /* When the node to be deleted is the root of the tree, there is no
+   * parent to return; POSIX then requires an unspecified, but non-NULL
+   * pointer, so we return the (unchanged) tree reference pointer.
+   */
+  p = (node_t *)(rootp);
   while( (cmp = (*compar)(key, (*rootp)->key)) != 0 )
   {
+    path[depth++] = rootp;		/* remember the way back */
     rootp = (cmp < 0)
       ? &(p = *rootp)->llink		/* follow llink branch */
       : &(p = *rootp)->rlink;		/* follow rlink branch */
@@ -37,25 +43,46 @@ __CRT_ALIAS void *__tdelete
     if (*rootp == NULL)
       return NULL;			/* key not found */
   }
-  r = (*rootp)->rlink;			/* D1: */
+  path[node = depth] = rootp;		/* D1: */
+  r = (*rootp)->rlink;
   if( (q = (*rootp)->llink) == NULL )	/* Left NULL? */
     q = r;
   else if( r != NULL ) 			/* Right link is NULL? */
-  { if( r->llink == NULL ) 		/* D2: Find successor */
-    { r->llink = q;
-      q = r;
-    }
-    else				/* D3: Find NULL link */
-    {
-      for( q = r->llink; q->llink != NULL; q = r->llink )
-	r = q;
-      r->llink = q->rlink;
-      q->llink = (*rootp)->llink;
-      q->rlink = (*rootp)->rlink;
+  { /* The node has two children; we must replace it by its successor,
+     * which is the leftmost node in its right subtree...
+     */
+    path[++depth] = &(*rootp)->rlink;
+    while( r->llink != NULL )		/* D2, D3: Find successor */
+    { path[++depth] = &r->llink;
+      r = r->llink;
     }
+    /* ...which we detach from its present parent, (retaining its
+     * right subtree in its place), before promoting it to take the
+     * place of the node which is to be deleted.
+     */
+    *path[depth] = r->rlink;
+    r->llink = q;
+    r->rlink = (*rootp)->rlink;
+    r->height = (*rootp)->height;
+    q = r;
+
+    /* The link, within the path, which previously referred to the
+     * right subtree of the deleted node, must now refer to that of
+     * its replacement.
+     */
+    path[node + 1] = &q->rlink;
   }
   free(*rootp);				/* D4: Free node */
   *rootp = q;				/* link parent to new node */
+
+  /* Retrace the path back towards the root, restoring balance as
+   * required, until we reach a subtree of which the height has not
+   * changed; (when the deleted node was replaced by its successor,
+   * this begins at the successor's original parent, and includes
+   * the successor itself, in its new position).
+   */
+  while( (depth > 0) && __mingw_tbalance( path[--depth] ) )
+    ;
   return p;
 }
 
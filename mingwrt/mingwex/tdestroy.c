@@ -0,0 +1,64 @@
+/*
+ * tdestroy.c
+ *
+ * Implementation of the GNU tdestroy() extension function, complementing
+ * the POSIX tsearch(), tfind(), tdelete(), and twalk() functions.
+ *
+ * $Id$
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR THE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ */
+#define _SEARCH_PRIVATE
+#include <search.h>
+#include <stdlib.h>
+
+static __MINGW_ATTRIB_NONNULL(1) __MINGW_ATTRIB_NONNULL(2)
+void tdestroy_r (node_t *, void (*)(void *));
+
+static void tdestroy_r (node_t *root, void (*free_node)(void *))
+{
+  /* Recursively release the nodes of a tree, (or subtree); since the
+   * tree is AVL balanced, the depth of recursion cannot exceed about
+   * 1.44 times the number of bits in a pointer.
+   */
+  if( root->llink != NULL )
+    tdestroy_r (root->llink, free_node);
+  if( root->rlink != NULL )
+    tdestroy_r (root->rlink, free_node);
+  (*free_node) ((void *)(root->key));
+  free (root);
+}
+
+void tdestroy (void *root, void (*free_node)(void *))
+{
+  /* Release every node of the tree rooted at "root", after first passing
+   * the key associated with each, to the user specified "free_node"
+   * function, (which is responsible for releasing any storage which the
+   * key may represent).
+   */
+  if( (root != NULL) && (free_node != NULL) )
+    tdestroy_r (root, free_node);
+}
+
+/* $RCSfile$: end of file */
@@ -23,7 +23,8 @@ __CRT_ALIAS void *__tsearch
    * when _SEARCH_PRIVATE is enabled; for public consumption, it becomes
    * an alias for "void", (assuming _SEARCH_PRIVATE is NOT enabled).
    */
-  node_t *q;
+  node_t *q, **path[__MINGW_TSEARCH_MAXHEIGHT];
+  int depth = 0;
 
   /* Cannot search from an invalid tree reference pointer, or without a
    * valid comparator function reference.
@@ -37,6 +38,7 @@ __CRT_ALIAS void *__tsearch
     if( (cmp = (*compar)(key, (*rootp)->key)) == 0 )
       return *rootp;			/* we found it! */
 
+    path[depth++] = rootp;		/* remember the way back */
     rootp = (cmp < 0)
       ? &(*rootp)->llink		/* T3: follow left branch */
       : &(*rootp)->rlink;		/* T4: follow right branch */
@@ -48,6 +50,14 @@ __CRT_ALIAS void *__tsearch
     *rootp = q;				/* link new node to old */
     q->key = key;			/* initialize new node */
     q->llink = q->rlink = NULL;
+    q->height = 1;
+
+    /* Retrace the path from the new node back towards the root,
+     * restoring balance as required, until we reach a subtree of
+     * which the height has not changed.
+     */
+    while( (depth > 0) && __mingw_tbalance( path[--depth] ) )
+      ;
   }
   return q;
 }
@@ -0,0 +1,311 @@
+/*
+ * utf8conv.c
+ *
+ * Implementation of validating UTF-8 to UTF-16, and UTF-16 to UTF-8
+ * transcoders, for use by the MinGW.org multibyte character conversion
+ * functions, when the codeset associated with the active locale is
+ * CP_UTF8, in preference to MultiByteToWideChar(), and to
+ * WideCharToMultiByte() respectively.
+ *
+ * $Id$
+ *
+ * Copyright (C) 2026, MinGW.org Project
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR THE COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ *
+ * Neither of these transcoders depends on any locale state, nor on any
+ * Windows API; both reject, exactly, every ill-formed sequence, (i.e.
+ * overlong encodings, encoded surrogates, code points beyond U+10FFFF,
+ * truncated sequences, and unpaired UTF-16 surrogates), in a single pass.
+ * On any CPU which supports SSE2, runs of ASCII characters are processed
+ * sixteen bytes at a time.
+ *
+ */
+#include "wcharmap.h"
+#include "cpu_features.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <emmintrin.h>
+
+/* The SSE2 fast path functions are compiled for an SSE2 capable target,
+ * regardless of the target selected for the library as a whole; they
+ * are called only when __cpu_features indicates that the CPU supports
+ * SSE2, (and never, if __cpu_features has not been initialized).
+ */
+#define __sse2__  __attribute__((__target__("sse2")))
+
+static __sse2__ size_t utf8_ascii_run
+( const unsigned char *src, size_t limit, boolean nul_terminated, wchar_t *dst )
+{
+  /* Count, and optionally store as UTF-16, the leading run of ASCII
+   * characters in "src", in complete blocks of sixteen, examining no
+   * more than "limit" bytes; when scanning a NUL terminated string, the
+   * length of which is unknown, we require 16-byte aligned blocks, (so
+   * that no block may straddle a page boundary), and the run is also
+   * terminated by any block which includes the NUL terminator.
+   */
+  size_t count = 0;
+  const __m128i zero = _mm_setzero_si128();
+
+  if( nul_terminated && (((uintptr_t)(src) & 15) != 0) )
+    return 0;
+
+  while( (limit - count) >= 16 )
+  { __m128i v = nul_terminated
+      ? _mm_load_si128( (const __m128i *)(src + count) )
+      : _mm_loadu_si128( (const __m128i *)(src + count) );
+    int mask = _mm_movemask_epi8( v );
+    if( nul_terminated ) mask |= _mm_movemask_epi8( _mm_cmpeq_epi8( v, zero ) );
+    if( mask != 0 ) break;
+
+    if( dst != NULL )
+    { _mm_storeu_si128( (__m128i *)(dst + count), _mm_unpacklo_epi8( v, zero ) );
+      _mm_storeu_si128( (__m128i *)(dst + count + 8), _mm_unpackhi_epi8( v, zero ) );
+    }
+    count += 16;
+  }
+  return count;
+}
+
+static __sse2__ size_t utf16_ascii_run
+( const wchar_t *src, size_t limit, boolean nul_terminated, char *dst )
+{
+  /* The complementary fast path, for UTF-16 input, processing blocks
+   * of eight wchar_t entities; the same alignment, and termination,
+   * criteria are applicable.
+   */
+  size_t count = 0;
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i high = _mm_set1_epi16( (short)(0xFF80) );
+
+  if( nul_terminated && (((uintptr_t)(src) & 15) != 0) )
+    return 0;
+
+  while( (limit - count) >= 8 )
+  { __m128i v = nul_terminated
+      ? _mm_load_si128( (const __m128i *)(src + count) )
+      : _mm_loadu_si128( (const __m128i *)(src + count) );
+    __m128i bad = _mm_cmpeq_epi16( _mm_and_si128( v, high ), zero );
+    if( nul_terminated ) bad = _mm_andnot_si128( _mm_cmpeq_epi16( v, zero ), bad );
+    if( _mm_movemask_epi8( bad ) != 0xFFFF ) break;
+
+    if( dst != NULL )
+      _mm_storel_epi64( (__m128i *)(dst + count), _mm_packus_epi16( v, v ) );
+    count += 8;
+  }
+  return count;
+}
+
+int __mingw_utf8_to_utf16( const char *src, size_t n, wchar_t *dst, size_t wmax )
+{
+  /* Convert the UTF-8 sequence of "n" bytes at "src", (or, if "n" is
+   * (size_t)(-1), the NUL terminated sequence, including its NUL), to
+   * UTF-16, storing the result in "dst", unless "wmax" is zero; this
+   * is interface compatible with MultiByteToWideChar(), when called
+   * with the MB_ERR_INVALID_CHARS flag, returning the number of wchar_t
+   * entities which are (or would be) stored, or zero, if the input is
+   * ill-formed, or the result would exceed "wmax" wchar_t entities.
+   */
+  const unsigned char *s = (const unsigned char *)(src);
+  boolean nul_terminated = (n == (size_t)(-1));
+  boolean sse2 = (__cpu_features & _CRT_SSE2) != 0;
+  size_t count = 0;
+
+  if( (wmax > 0) && (dst == NULL) ) wmax = 0;
+  while( nul_terminated || (n > 0) )
+  { unsigned int c = *s, cp;
+    size_t len;
+
+    if( c < 0x80 )
+    { /* This is an ASCII character; when SSE2 is available, try to
+       * process a run of such characters, in sixteen byte blocks...
+       */
+      if( sse2 )
+      { size_t limit = nul_terminated ? (size_t)(-1) : n;
+	if( (wmax > 0) && ((wmax - count) < limit) ) limit = wmax - count;
+	if( (len = utf8_ascii_run( s, limit, nul_terminated, wmax ? dst + count : NULL )) > 0 )
+	{ s += len; count += len; if( ! nul_terminated ) n -= len;
+	  continue;
+	}
+      }
+      /* ...otherwise, simply process this one character.
+       */
+      if( wmax > 0 )
+      { if( count >= wmax ) return 0;
+	dst[count] = c;
+      }
+      ++count; ++s;
+      if( nul_terminated ) { if( c == 0 ) break; } else --n;
+      continue;
+    }
+
+    /* Any other character must introduce a multibyte sequence; decode
+     * it, checking that every continuation byte lies within the range
+     * permitted in its position, (as tabulated in the Unicode Standard,
+     * "Well-Formed UTF-8 Byte Sequences"); note that, in the case of a
+     * NUL terminated string, the NUL terminator can never satisfy this
+     * check, so we never read beyond it.
+     */
+#   define UTF8_BYTE(I, LO, HI) \
+      if( (! nul_terminated && (n <= (I))) || (s[I] < (LO)) || (s[I] > (HI)) ) \
+	return 0; \
+      cp = (cp << 6) | (s[I] & 0x3F)
+
+    if( c < 0xC2 )
+      /* A stray continuation byte, or the lead byte of an overlong two
+       * byte encoding.
+       */
+      return 0;
+
+    else if( c < 0xE0 )
+    { cp = c & 0x1F; len = 2;
+      UTF8_BYTE( 1, 0x80, 0xBF );
+    }
+    else if( c < 0xF0 )
+    { /* Three byte sequences exclude overlong encodings, (E0 80..9F),
+       * and encoded surrogates, (ED A0..BF).
+       */
+      cp = c & 0x0F; len = 3;
+      UTF8_BYTE( 1, (c == 0xE0) ? 0xA0 : 0x80, (c == 0xED) ? 0x9F : 0xBF );
+      UTF8_BYTE( 2, 0x80, 0xBF );
+    }
+    else if( c < 0xF5 )
+    { /* Four byte sequences exclude overlong encodings, (F0 80..8F),
+       * and code points beyond U+10FFFF, (F4 90..BF).
+       */
+      cp = c & 0x07; len = 4;
+      UTF8_BYTE( 1, (c == 0xF0) ? 0x90 : 0x80, (c == 0xF4) ? 0x8F : 0xBF );
+      UTF8_BYTE( 2, 0x80, 0xBF );
+      UTF8_BYTE( 3, 0x80, 0xBF );
+    }
+    else
+      /* F5..FF can never appear in well-formed UTF-8.
+       */
+      return 0;
+
+#   undef UTF8_BYTE
+
+    s += len; if( ! nul_terminated ) n -= len;
+    if( cp < 0x10000 )
+    { if( wmax > 0 )
+      { if( count >= wmax ) return 0;
+	dst[count] = cp;
+      }
+      ++count;
+    }
+    else
+    { /* Code points beyond the BMP are represented as surrogate pairs.
+       */
+      if( wmax > 0 )
+      { if( (wmax - count) < 2 ) return 0;
+	cp -= 0x10000;
+	dst[count] = 0xD800 | (cp >> 10);
+	dst[count + 1] = 0xDC00 | (cp & 0x3FF);
+      }
+      count += 2;
+    }
+  }
+  return (int)(count);
+}
+
+size_t __mingw_utf16_to_utf8( char *dst, int mblen, const wchar_t *src, int wclen )
+{
+  /* Convert the UTF-16 sequence of "wclen" wchar_t entities at "src",
+   * (or, if "wclen" is -1, the NUL terminated sequence, including its
+   * NUL), to UTF-8, storing the result in "dst", unless "dst" is NULL,
+   * or "mblen" is zero; this is interface compatible with the CP_UTF8
+   * case of __mingw_wctomb_convert(), returning the number of bytes
+   * which are (or would be) stored, or (size_t)(-1), with errno set to
+   * EILSEQ, if the input includes any unpaired surrogate, or to ENOMEM,
+   * if the result would exceed "mblen" bytes.
+   */
+  boolean nul_terminated = (wclen == -1);
+  boolean sse2 = (__cpu_features & _CRT_SSE2) != 0;
+  size_t count = 0, room = ((dst != NULL) && (mblen > 0)) ? (size_t)(mblen) : 0;
+  size_t n = nul_terminated ? 0 : (size_t)(wclen);
+
+  while( nul_terminated || (n > 0) )
+  { unsigned int c = *src, cp;
+    unsigned char buf[4];
+    size_t len;
+
+    if( c < 0x80 )
+    { /* As in the complementary case, try the SSE2 fast path first,
+       * for runs of ASCII characters...
+       */
+      if( sse2 )
+      { size_t limit = nul_terminated ? (size_t)(-1) : n;
+	if( (room > 0) && ((room - count) < limit) ) limit = room - count;
+	if( (len = utf16_ascii_run( src, limit, nul_terminated, room ? dst + count : NULL )) > 0 )
+	{ src += len; count += len; if( ! nul_terminated ) n -= len;
+	  continue;
+	}
+      }
+      /* ...falling back to processing one character at a time.
+       */
+      if( room > 0 )
+      { if( count >= room ) return errout( ENOMEM, (size_t)(-1) );
+	dst[count] = c;
+      }
+      ++count; ++src;
+      if( nul_terminated ) { if( c == 0 ) break; } else --n;
+      continue;
+    }
+
+    ++src; if( ! nul_terminated ) --n;
+    if( c < 0x800 )
+    { buf[0] = 0xC0 | (c >> 6); buf[1] = 0x80 | (c & 0x3F); len = 2;
+    }
+    else if( (c & 0xFC00) == 0xD800 )
+    { /* A high surrogate must be immediately followed by a low
+       * surrogate; (a NUL terminator cannot satisfy this check).
+       */
+      if( (! nul_terminated && (n == 0)) || ((*src & 0xFC00) != 0xDC00) )
+	return errout( EILSEQ, (size_t)(-1) );
+
+      cp = 0x10000 + ((c & 0x3FF) << 10) + (*src++ & 0x3FF);
+      if( ! nul_terminated ) --n;
+      buf[0] = 0xF0 | (cp >> 18); buf[1] = 0x80 | ((cp >> 12) & 0x3F);
+      buf[2] = 0x80 | ((cp >> 6) & 0x3F); buf[3] = 0x80 | (cp & 0x3F);
+      len = 4;
+    }
+    else if( (c & 0xFC00) == 0xDC00 )
+      /* A low surrogate, without a preceding high surrogate.
+       */
+      return errout( EILSEQ, (size_t)(-1) );
+
+    else
+    { buf[0] = 0xE0 | (c >> 12); buf[1] = 0x80 | ((c >> 6) & 0x3F);
+      buf[2] = 0x80 | (c & 0x3F); len = 3;
+    }
+
+    if( room > 0 )
+    { if( (room - count) < len ) return errout( ENOMEM, (size_t)(-1) );
+      memcpy( dst + count, buf, len );
+    }
+    count += len;
+  }
+  return count;
+}
+
+/* $RCSfile$: end of file */
@@ -172,7 +172,13 @@ size_t __mingw_wctomb_convert
     return retval;
   }
 
-  /* For any code page other than zero, we delegate both encoding
+  /* For CP_UTF8, we use our own transcoder, which detects unpaired
+   * surrogates in the same pass as it encodes...
+   */
+  if( codeset == CP_UTF8 )
+    return __mingw_utf16_to_utf8( mbs, mblen, wcs, wclen );
+
+  /* ...while, for any other code page, we delegate both encoding
    * and byte counting to the Windows API; note that for code pages
    * other than CP_UTF7 or CP_UTF8, (and CP_UTF8 is the only code
    * page with an identifier greater than that for CP_UTF7), there
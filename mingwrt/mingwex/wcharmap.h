@@ -69,6 +69,7 @@ size_t errout (int errcode, size_t status){ errno = errcode; return status; }
  */
 unsigned int __mb_codeset_for_locale (void);
 unsigned int __mb_cur_max_for_codeset (unsigned int);
+void __mb_codeset_invalidate (void);
 
 /* Codeset initializers, and internal helper functions for
  * multi-byte sequence to wide character conversions.
@@ -94,6 +95,12 @@ unsigned int __mingw_wctomb_cur_max_init (unsigned int);
 size_t __mingw_wctomb_convert (char *, int, const wchar_t *, int);
 unsigned int __mingw_wctomb_cur_max (void);
 
+/* Built-in UTF-8 to UTF-16, and UTF-16 to UTF-8 transcoders, which are
+ * used in place of the Windows API, when the active codeset is CP_UTF8.
+ */
+int __mingw_utf8_to_utf16 (const char *, size_t, wchar_t *, size_t);
+size_t __mingw_utf16_to_utf8 (char *, int, const wchar_t *, int);
+
 /* The legacy MinGW implementation used a get_codepage() function,
  * which was effectively the same as our __mb_codeset_for_locale();
  * this alias may, eventually, become redundant.
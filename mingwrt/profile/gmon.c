@@ -59,6 +59,8 @@ static char rcsid[] = "$OpenBSD: gmon.c,v 1.8 1997/07/23 21:11:27 kstailey Exp $
 #ifdef __MINGW32__
 #include <string.h>
 #define bzero(ptr,size) memset (ptr, 0, size);
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
 #endif
 
 struct gmonparam _gmonparam = { GMON_PROF_OFF };
@@ -103,6 +105,26 @@ monstartup(lowpc, highpc)
 		p->tolimit = MAXARCS;
 	p->tossize = p->tolimit * sizeof(struct tostruct);
 
+#ifdef __MINGW32__
+	/*
+	 * arc tables are allocated per-thread, by mcount(), and are
+	 * expanded on demand; here, we need only the histogram, and a
+	 * TLS slot to locate each thread's arc table.
+	 */
+	if ((p->tlsindex = TlsAlloc()) == TLS_OUT_OF_INDEXES) {
+		ERR("monstartup: no TLS index\n");
+		return;
+	}
+	p->threads = NULL;
+	if ((cp = fake_sbrk(p->kcountsize)) == NULL) {
+		ERR("monstartup: out of memory\n");
+		return;
+	}
+	bzero(cp, p->kcountsize);
+	p->kcount = (u_short *)cp;
+	p->froms = NULL;
+	p->tos = NULL;
+#else
 	cp = fake_sbrk(p->kcountsize + p->fromssize + p->tossize);
 	if (cp == (char *)-1) {
 		ERR("monstartup: out of memory\n");
@@ -121,6 +143,7 @@ monstartup(lowpc, highpc)
         /* XXX minbrk needed? */
 	//minbrk = fake_sbrk(0);
 	p->tos[0].link = 0;
+#endif
 
 	o = p->highpc - p->lowpc;
 	if (p->kcountsize < o) {
@@ -149,14 +172,21 @@ _mcleanup()
 {
 	int fd;
 	int hz;
+#ifndef __MINGW32__
 	int fromindex;
 	int endfrom;
 	u_long frompc;
 	int toindex;
+#endif
 	struct rawarc rawarc;
 	struct gmonparam *p = &_gmonparam;
 	struct gmonhdr gmonhdr, *hdr;
 	char *proffile;
+#ifdef __MINGW32__
+	struct gmonthread *t;
+	struct gmonarcs *arcs;
+	u_long i;
+#endif
 #ifdef DEBUG
 	int log, len;
 	char dbuf[200];
@@ -164,6 +194,13 @@ _mcleanup()
 
 	if (p->state == GMON_PROF_ERROR)
 		ERR("_mcleanup: tos overflow\n");
+#ifdef __MINGW32__
+	for (t = p->threads; t != NULL; t = t->next)
+		if (t->state == GMON_PROF_ERROR) {
+			ERR("_mcleanup: tos overflow\n");
+			break;
+		}
+#endif
 
         hz = PROF_HZ;
 	moncontrol(0);
@@ -240,6 +277,35 @@ _mcleanup()
 	hdr->profrate = hz;
 	write(fd, (char *)hdr, sizeof *hdr);
 	write(fd, p->kcount, p->kcountsize);
+#ifdef __MINGW32__
+	/*
+	 * write the arcs recorded by each thread in turn; any arc which
+	 * was traversed by more than one thread appears once for each,
+	 * and gprof sums the counts for such duplicates.  A thread may
+	 * still be within mcount(), replacing its table as we read it; the
+	 * table pointer is read just once, so that we walk one consistent
+	 * table, and its own size bounds the walk.
+	 */
+	for (t = p->threads; t != NULL; t = t->next) {
+		if ((arcs = t->arcs) == NULL)
+			continue;
+		for (i = 0; i <= arcs->mask; i++) {
+			if (arcs->arc[i].selfpc == 0)
+				continue;
+#ifdef DEBUG
+			len = sprintf(dbuf,
+			"[mcleanup2] frompc 0x%x selfpc 0x%x count %d\n" ,
+				arcs->arc[i].frompc, arcs->arc[i].selfpc,
+				arcs->arc[i].count);
+			write(log, dbuf, len);
+#endif
+			rawarc.raw_frompc = arcs->arc[i].frompc;
+			rawarc.raw_selfpc = arcs->arc[i].selfpc;
+			rawarc.raw_count = arcs->arc[i].count;
+			write(fd, &rawarc, sizeof rawarc);
+		}
+	}
+#else
 	endfrom = p->fromssize / sizeof(*p->froms);
 	for (fromindex = 0; fromindex < endfrom; fromindex++) {
 		if (p->froms[fromindex] == 0)
@@ -262,6 +328,7 @@ _mcleanup()
 			write(fd, &rawarc, sizeof rawarc);
 		}
 	}
+#endif
 	close(fd);
 }
 
@@ -137,6 +137,49 @@ struct rawarc {
 #define ROUNDDOWN(x,y)	(((x)/(y))*(y))
 #define ROUNDUP(x,y)	((((x)+(y)-1)/(y))*(y))
 
+#ifdef __MINGW32__
+/*
+ * In the MinGW implementation, each thread which executes profiled code
+ * records the call graph arcs which it traverses in its own arc table,
+ * which is allocated on its first call to mcount(); thus, concurrently
+ * executing threads neither contend for a shared table, nor lose arcs
+ * which they traverse while another thread is within mcount().  All
+ * such tables are linked into a list, from which they are retrieved
+ * when _mcleanup() writes the profile; (they are never released,
+ * even when their owning threads terminate).
+ *
+ * Each table is an open-addressed hash of gmonarc entries, keyed on
+ * the (frompc, selfpc) pair; it initially accommodates GMONARCS_INITIAL
+ * entries, (which must be a power of two), and it is doubled in size
+ * whenever it becomes three quarters full.  The size is recorded with
+ * the entries, so that the replacement of a table, (which may happen
+ * while _mcleanup() is reading it), is published by a single pointer
+ * store, and a reader can never see a size which mismatches the array.
+ */
+#define GMONARCS_INITIAL	256
+
+struct gmonarc {
+	u_long	frompc;
+	u_long	selfpc;			/* zero, for a vacant entry */
+	long	count;
+};
+
+struct gmonarcs {
+	u_long		mask;		/* table size, less one */
+	struct gmonarc	arc[1];		/* actually, mask + 1 entries */
+};
+
+#define GMONARCS_SIZE(mask) \
+	(sizeof(struct gmonarcs) + (mask) * sizeof(struct gmonarc))
+
+struct gmonthread {
+	struct gmonthread *next;	/* link to next thread's table */
+	int		state;		/* this thread's profiling state */
+	struct gmonarcs	*volatile arcs;	/* the hash table of arcs */
+	u_long		used;		/* number of entries in use */
+};
+#endif /* __MINGW32__ */
+
 /*
  * The profiling data structures are housed in this structure.
  */
@@ -153,6 +196,10 @@ struct gmonparam {
 	u_long		highpc;
 	u_long		textsize;
 	u_long		hashfraction;
+#ifdef __MINGW32__
+	struct gmonthread *volatile threads;	/* list of arc tables */
+	u_long		tlsindex;	/* TLS slot for thread's table */
+#endif /* __MINGW32__ */
 };
 extern struct gmonparam _gmonparam;
 
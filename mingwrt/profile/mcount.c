@@ -52,6 +52,131 @@ static char rcsid[] = "$OpenBSD: mcount.c,v 1.6 1997/07/23 21:11:27 kstailey Exp
 #include <sys/types.h>
 #include <gmon.h>
 
+#ifdef __MINGW32__
+#include <stdlib.h>
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+/*
+ * Retrieve the calling thread's arc table, from its TLS slot.  For the
+ * first TLS_MINIMUM_AVAILABLE slots, we read the slot directly from the
+ * thread environment block, (as TlsGetValue() does); this is faster than
+ * calling TlsGetValue(), and it avoids TlsGetValue()'s side effect of
+ * clearing the thread's last error code, which we must not disturb.
+ */
+static __inline__ struct gmonthread *
+_mcount_thread(struct gmonparam *p)
+{
+	struct gmonthread *t;
+	DWORD error;
+
+	if (p->tlsindex < TLS_MINIMUM_AVAILABLE) {
+		__asm__ ("movl %%fs:0xE10(,%1,4),%0"
+		    : "=r" (t) : "r" (p->tlsindex));
+		return t;
+	}
+	error = GetLastError();
+	t = (struct gmonthread *)TlsGetValue(p->tlsindex);
+	SetLastError(error);
+	return t;
+}
+
+/*
+ * Allocate an arc table for a thread which has no table yet, and link
+ * it into the list of all thread tables; the link is established by
+ * compare-and-swap, so no lock is required.  If allocation fails, the
+ * thread is assigned a shared dummy table, in the GMON_PROF_ERROR state,
+ * so that it neither retries the allocation, nor records any arcs.
+ */
+static struct gmonthread _mcount_nomem = { NULL, GMON_PROF_ERROR };
+
+static struct gmonthread *
+_mcount_newthread(struct gmonparam *p)
+{
+	struct gmonthread *t, *head;
+	DWORD error;
+
+	error = GetLastError();
+	t = (struct gmonthread *)calloc(1, sizeof(*t));
+	if (t != NULL && (t->arcs = (struct gmonarcs *)
+	    calloc(1, GMONARCS_SIZE(GMONARCS_INITIAL - 1))) == NULL) {
+		free(t);
+		t = NULL;
+	}
+	if (t == NULL)
+		t = &_mcount_nomem;
+	else {
+		t->arcs->mask = GMONARCS_INITIAL - 1;
+		t->state = GMON_PROF_ON;
+		do {
+			t->next = head = p->threads;
+		} while (InterlockedCompareExchangePointer(
+		    (PVOID *)&p->threads, t, head) != head);
+	}
+	TlsSetValue(p->tlsindex, t);
+	SetLastError(error);
+	return t;
+}
+
+/*
+ * Each thread's arcs are held in an open-addressed hash table, keyed
+ * on the (frompc, selfpc) pair, and searched by linear probing; most
+ * lookups are resolved by inspection of just one entry, regardless of
+ * how many distinct targets are called from any one call site.  Since
+ * a selfpc value is never zero, a zero selfpc identifies a vacant entry.
+ *
+ * The table index is taken from the low order bits of the hash; the
+ * final avalanche step ensures that these depend on every bit of both
+ * frompc and selfpc, (which a bare multiplication would not do).
+ */
+static __inline__ u_long
+_mcount_hash(u_long frompc, u_long selfpc)
+{
+	u_long h = (frompc * 0x9E3779B1UL) ^ selfpc;
+
+	h ^= h >> 16;
+	h *= 0x85EBCA6BUL;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35UL;
+	return h ^ (h >> 16);
+}
+#define GMONARC_HASH(frompc, selfpc) _mcount_hash((frompc), (selfpc))
+
+/*
+ * When a table becomes three quarters full, it is replaced by one of
+ * twice the size; (the original table is abandoned, rather than freed,
+ * since _mcleanup() may be reading it concurrently).  The replacement
+ * is fully populated before it is published, by an interlocked store,
+ * so _mcleanup() always sees one complete table, or the other.  Only
+ * if this allocation fails is recording of arcs, for this thread, halted.
+ */
+static struct gmonarcs *
+_mcount_grow(struct gmonthread *t)
+{
+	struct gmonarcs *arcs, *old = t->arcs;
+	u_long i, j, mask = (old->mask << 1) | 1;
+	DWORD error;
+
+	error = GetLastError();
+	arcs = (struct gmonarcs *)calloc(1, GMONARCS_SIZE(mask));
+	SetLastError(error);
+	if (arcs == NULL)
+		return NULL;
+
+	arcs->mask = mask;
+	for (i = 0; i <= old->mask; i++) {
+		if (old->arc[i].selfpc == 0)
+			continue;
+		j = GMONARC_HASH(old->arc[i].frompc, old->arc[i].selfpc) & mask;
+		while (arcs->arc[j].selfpc != 0)
+			j = (j + 1) & mask;
+		arcs->arc[j] = old->arc[i];
+	}
+	InterlockedExchangePointer((PVOID *)&t->arcs, arcs);
+	return arcs;
+}
+#endif /* __MINGW32__ */
+
 /*
  * mcount is called on entry to each function compiled with the profiling
  * switch set.  _mcount(), which is declared in a machine-dependent way
@@ -69,6 +194,68 @@ static char rcsid[] = "$OpenBSD: mcount.c,v 1.6 1997/07/23 21:11:27 kstailey Exp
  */
 /* _mcount; may be static, inline, etc */
 _MCOUNT_DECL (u_long frompc, u_long selfpc)
+#ifdef __MINGW32__
+{
+	register struct gmonparam *p;
+	register struct gmonthread *t;
+	register struct gmonarcs *arcs;
+	register struct gmonarc *arc;
+	register u_long i;
+
+	p = &_gmonparam;
+	/*
+	 * check that we are profiling
+	 * and that this thread isn't recursively invoked.
+	 */
+	if (p->state != GMON_PROF_ON)
+		return;
+	if ((t = _mcount_thread(p)) == NULL)
+		t = _mcount_newthread(p);
+	if (t->state != GMON_PROF_ON)
+		return;
+	t->state = GMON_PROF_BUSY;
+	/*
+	 * check that frompc is a reasonable pc value.
+	 */
+	if (frompc - p->lowpc > p->textsize)
+		goto done;
+
+	arcs = t->arcs;
+	for (i = GMONARC_HASH(frompc, selfpc); ; i++) {
+		arc = &arcs->arc[i & arcs->mask];
+		if (arc->selfpc == selfpc && arc->frompc == frompc) {
+			/*
+			 * usual case: an arc which we have seen before.
+			 */
+			arc->count++;
+			goto done;
+		}
+		if (arc->selfpc == 0)
+			break;
+	}
+	/*
+	 * first time traversing this arc; make room for it, if
+	 * necessary, (in which case we must find a new vacant
+	 * entry), then record it.
+	 */
+	if (++t->used > arcs->mask - (arcs->mask >> 2)) {
+		if ((arcs = _mcount_grow(t)) == NULL) {
+			t->state = GMON_PROF_ERROR;
+			return;
+		}
+		for (i = GMONARC_HASH(frompc, selfpc); ; i++) {
+			arc = &arcs->arc[i & arcs->mask];
+			if (arc->selfpc == 0)
+				break;
+		}
+	}
+	arc->frompc = frompc;
+	arc->count = 1;
+	arc->selfpc = selfpc;
+done:
+	t->state = GMON_PROF_ON;
+}
+#else
 {
 	register u_short *frompcindex;
 	register struct tostruct *top, *prevtop;
@@ -176,6 +363,7 @@ overflow:
 	p->state = GMON_PROF_ERROR;
 	return;
 }
+#endif /* __MINGW32__ */
 
 /*
  * Actual definition of mcount function.  Defined in <machine/profile.h>,
@@ -14,6 +14,10 @@
  */
 
 #include <windows.h>
+#ifdef __MINGW32__
+#include <tlhelp32.h>
+#include <stdlib.h>
+#endif
 #include <stdio.h>
 #include <sys/types.h>
 #include <errno.h>
@@ -58,6 +62,160 @@ print_prof (struct profinfo *p)
 }
 #endif
 
+#ifdef __MINGW32__
+/* Rather than sampling only the thread which started profiling, we
+   sample every thread in the process; the set of threads is refreshed
+   from a Toolhelp snapshot once per second, and we keep a handle open
+   for each thread while it remains in the set.  The Toolhelp and
+   OpenThread() APIs are not available on all Windows versions, so we
+   look them up at run time; when they are missing, we fall back to
+   sampling only the thread which started profiling.  */
+
+typedef HANDLE (WINAPI *snapshot_fn) (DWORD, DWORD);
+typedef BOOL (WINAPI *thread32_fn) (HANDLE, LPTHREADENTRY32);
+typedef HANDLE (WINAPI *openthread_fn) (DWORD, BOOL, DWORD);
+
+static struct profthread
+{
+  DWORD id;
+  HANDLE handle;
+  int seen;
+} *profthreads;
+static int profthreads_count, profthreads_max;
+static volatile LONG profthr_stop;
+
+static void
+close_profthreads (void)
+{
+  int i;
+  for (i = 0; i < profthreads_count; i++)
+    CloseHandle (profthreads[i].handle);
+  free (profthreads);
+  profthreads = NULL;
+  profthreads_count = profthreads_max = 0;
+}
+
+static int
+refresh_profthreads (void)
+{
+  static snapshot_fn snapshot;
+  static thread32_fn thread32_first, thread32_next;
+  static openthread_fn open_thread;
+  DWORD pid = GetCurrentProcessId (), self = GetCurrentThreadId ();
+  THREADENTRY32 te;
+  HANDLE snap;
+  int i;
+
+  if (snapshot == NULL)
+    {
+      HMODULE k32 = GetModuleHandleA ("kernel32.dll");
+      thread32_first = (thread32_fn) GetProcAddress (k32, "Thread32First");
+      thread32_next = (thread32_fn) GetProcAddress (k32, "Thread32Next");
+      open_thread = (openthread_fn) GetProcAddress (k32, "OpenThread");
+      snapshot = (snapshot_fn) GetProcAddress (k32,
+					       "CreateToolhelp32Snapshot");
+    }
+  if (snapshot == NULL || thread32_first == NULL || thread32_next == NULL
+      || open_thread == NULL)
+    return -1;
+
+  snap = snapshot (TH32CS_SNAPTHREAD, 0);
+  if (snap == INVALID_HANDLE_VALUE)
+    return -1;
+
+  for (i = 0; i < profthreads_count; i++)
+    profthreads[i].seen = 0;
+
+  te.dwSize = sizeof te;
+  if (thread32_first (snap, &te))
+    do
+      {
+	if (te.th32OwnerProcessID != pid || te.th32ThreadID == self)
+	  continue;
+	for (i = 0; i < profthreads_count; i++)
+	  if (profthreads[i].id == te.th32ThreadID)
+	    break;
+	if (i < profthreads_count)
+	  profthreads[i].seen = 1;
+	else
+	  {
+	    HANDLE thr = open_thread (THREAD_SUSPEND_RESUME
+				      | THREAD_GET_CONTEXT, FALSE,
+				      te.th32ThreadID);
+	    if (thr == NULL)
+	      continue;
+	    if (profthreads_count == profthreads_max)
+	      {
+		int max = profthreads_max ? profthreads_max * 2 : 16;
+		struct profthread *tmp
+		  = realloc (profthreads, max * sizeof *profthreads);
+		if (tmp == NULL)
+		  {
+		    CloseHandle (thr);
+		    continue;
+		  }
+		profthreads = tmp;
+		profthreads_max = max;
+	      }
+	    profthreads[profthreads_count].id = te.th32ThreadID;
+	    profthreads[profthreads_count].handle = thr;
+	    profthreads[profthreads_count++].seen = 1;
+	  }
+	te.dwSize = sizeof te;
+      }
+    while (thread32_next (snap, &te));
+  CloseHandle (snap);
+
+  /* Forget threads which have terminated since the last refresh.  */
+  for (i = 0; i < profthreads_count; )
+    if (profthreads[i].seen)
+      i++;
+    else
+      {
+	CloseHandle (profthreads[i].handle);
+	profthreads[i] = profthreads[--profthreads_count];
+      }
+  return 0;
+}
+
+static void
+sample_thread (struct profinfo *p, HANDLE thr)
+{
+  u_long pc, idx;
+
+  pc = (u_long) get_thrpc (thr);
+  if (pc >= p->lowpc && pc < p->highpc)
+    {
+      idx = PROFIDX (pc, p->lowpc, p->scale);
+      p->counter[idx]++;
+    }
+}
+
+/* Everytime we wake up, sample the pc of every thread in the process,
+   (or only that of the main thread, if we cannot enumerate threads),
+   hashing each into the cell in the profile buffer ARG. */
+
+static DWORD CALLBACK
+profthr_func (LPVOID arg)
+{
+  struct profinfo *p = (struct profinfo *) arg;
+  int i, tick, all = 0;
+
+  for (tick = 0; !profthr_stop; tick++)
+    {
+      if ((tick % PROF_HZ) == 0)
+	all = (refresh_profthreads () == 0);
+      if (all)
+	for (i = 0; i < profthreads_count; i++)
+	  sample_thread (p, profthreads[i].handle);
+      else
+	sample_thread (p, p->targthr);
+      Sleep (SLEEPTIME);
+    }
+  close_profthreads ();
+  return 0;
+}
+#else
 /* Everytime we wake up use the main thread pc to hash into the cell in the
    profile buffer ARG. */
 
@@ -82,6 +240,7 @@ profthr_func (LPVOID arg)
     }
   return 0;
 }
+#endif
 
 /* Stop profiling to the profiling buffer pointed to by P. */
 
@@ -90,8 +249,18 @@ profile_off (struct profinfo *p)
 {
   if (p->profthr)
     {
+#ifdef __MINGW32__
+      /* Ask the profiling thread to stop, so that it doesn't leave any
+	 thread suspended; terminate it only if it fails to respond.  */
+      profthr_stop = 1;
+      if (WaitForSingleObject (p->profthr, 10 * SLEEPTIME) != WAIT_OBJECT_0)
+	TerminateThread (p->profthr, 0);
+      CloseHandle (p->profthr);
+      p->profthr = 0;
+#else
       TerminateThread (p->profthr, 0);
       CloseHandle (p->profthr);
+#endif
     }
   if (p->targthr)
     CloseHandle (p->targthr);
@@ -114,6 +283,9 @@ profile_on (struct profinfo *p)
       return -1;
     }
 
+#ifdef __MINGW32__
+  profthr_stop = 0;
+#endif
   p->profthr = CreateThread (0, 0, profthr_func, (void *) p, 0, &thrid);
 
   /* Set profiler thread priority to highest to be sure that it gets the
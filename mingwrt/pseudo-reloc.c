@@ -174,6 +174,11 @@ __report_error (const char *msg, ...)
  * slower, too.  However, on cygwin as of binutils 2.20 the
  * .text section is still marked writable, and the .rdata section
  * is folded into the (writable) .data when --enable-auto-import.
+ *
+ * Since it costs one VirtualQuery, and two VirtualProtect calls,
+ * for each write, it is now used only as a fall back, when the
+ * target of a relocation has not been unprotected in advance, by
+ * __mark_writable (see below).
  */
 static void
 __write_memory (void *addr, const void *src, size_t len)
@@ -201,11 +206,129 @@ __write_memory (void *addr, const void *src, size_t len)
     VirtualProtect (b.BaseAddress, b.RegionSize, oldprot, &oldprot);
 }
 
+/* Rather than adjusting page protection around each individual
+ * write, the relocator walks the relocation list twice: in the
+ * first pass, it merely gathers the memory regions, (as reported
+ * by VirtualQuery), which contain relocation targets, making each
+ * writable, if necessary, as it is first encountered; the second
+ * pass then applies all fixups, by direct memory writes, after
+ * which the original protection of each region is restored.  Thus,
+ * protection is adjusted only twice per region, (i.e. typically
+ * per image section), rather than twice per relocation.
+ */
+#ifndef PSEUDO_RELOC_REGIONS_MAX
+/* The number of regions which we track; this need not be large,
+ * since relocation targets are confined to the image sections, but
+ * should the limit be exceeded, any relocation which targets an
+ * untracked region is applied by __write_memory, as a fall back.
+ */
+#define PSEUDO_RELOC_REGIONS_MAX 32
+#endif
+
+typedef struct {
+  char *base_address;
+  SIZE_T region_size;
+  DWORD old_protect;
+  BOOL restore;
+} pseudo_reloc_region;
+
+typedef struct {
+  int count;
+  pseudo_reloc_region region[PSEUDO_RELOC_REGIONS_MAX];
+} pseudo_reloc_regions;
+
+/* Each pass of the relocation list walk delegates handling of the
+ * computed fixups to a function of this type, which is called with
+ * the same arguments as __write_memory, preceded by a reference to
+ * a data structure which is passed through by the walker.
+ */
+typedef void (*pseudo_reloc_handler) (void *, void *, const void *, size_t);
+
+static pseudo_reloc_region *
+__find_region (pseudo_reloc_regions *regions, void *addr, size_t len)
+{
+  /* Locate the tracked region, if any, which wholly contains the
+   * len bytes at addr.
+   */
+  int i;
+  for (i = 0; i < regions->count; i++)
+    {
+      pseudo_reloc_region *r = &regions->region[i];
+      if ((char *) addr >= r->base_address
+	  && (size_t) ((char *) addr - r->base_address) + len <= r->region_size)
+	return r;
+    }
+  return NULL;
+}
+
+static void
+__mark_writable (void *data, void *addr, const void *src, size_t len)
+{
+  /* First pass handler: ensure that the region containing addr is
+   * writable, recording its original protection, if we change it.
+   */
+  pseudo_reloc_regions *regions = (pseudo_reloc_regions *) data;
+  MEMORY_BASIC_INFORMATION b;
+  pseudo_reloc_region *r;
+
+  (void) src;
+  if (!len || __find_region (regions, addr, len) != NULL
+      || regions->count >= PSEUDO_RELOC_REGIONS_MAX)
+    return;
+
+  if (!VirtualQuery (addr, &b, sizeof(b)))
+    {
+      __report_error ("  VirtualQuery failed for %d bytes at address %p",
+		      (int) sizeof(b), addr);
+    }
+
+  r = &regions->region[regions->count++];
+  r->base_address = (char *) b.BaseAddress;
+  r->region_size = b.RegionSize;
+  r->restore = FALSE;
+
+  /* Allow write access to read-only protected memory, until all
+   * relocations have been applied.
+   */
+  if (b.Protect != PAGE_EXECUTE_READWRITE && b.Protect != PAGE_READWRITE)
+    r->restore = VirtualProtect (b.BaseAddress, b.RegionSize,
+				 PAGE_EXECUTE_READWRITE, &r->old_protect);
+}
+
+static void
+__write_marked (void *data, void *addr, const void *src, size_t len)
+{
+  /* Second pass handler: write the data directly, if its target lies
+   * within a region which was made writable in the first pass, else
+   * fall back to the slower, but self-contained, __write_memory.
+   */
+  if (__find_region ((pseudo_reloc_regions *) data, addr, len) != NULL)
+    memcpy (addr, src, len);
+  else
+    __write_memory (addr, src, len);
+}
+
+static void
+__restore_protection (pseudo_reloc_regions *regions)
+{
+  /* After the second pass: restore the original protection, for
+   * each region which was made writable in the first pass.
+   */
+  int i;
+  DWORD oldprot;
+  for (i = 0; i < regions->count; i++)
+    if (regions->region[i].restore)
+      VirtualProtect (regions->region[i].base_address,
+		      regions->region[i].region_size,
+		      regions->region[i].old_protect, &oldprot);
+}
+
 #define RP_VERSION_V1 0
 #define RP_VERSION_V2 1
 
 static void
-do_pseudo_reloc (void * start, void * end, void * base)
+do_pseudo_reloc (void * start, void * end, void * base,
+		 pseudo_reloc_handler handler, void * data)
 {
   ptrdiff_t addr_imp, reldata;
   ptrdiff_t reloc_target = (ptrdiff_t) ((char *)end - (char*)start);
@@ -266,7 +389,7 @@ do_pseudo_reloc (void * start, void * end, void * base)
 	  DWORD newval;
 	  reloc_target = (ptrdiff_t) base + o->target;
 	  newval = (*((DWORD*) reloc_target)) + o->addend;
-	  __write_memory ((void *) reloc_target, &newval, sizeof(DWORD));
+	  handler (data, (void *) reloc_target, &newval, sizeof(DWORD));
 	}
       return;
     }
@@ -344,17 +467,17 @@ do_pseudo_reloc (void * start, void * end, void * base)
       switch ((r->flags & 0xff))
 	{
 	  case 8:
-	    __write_memory ((void *) reloc_target, &reldata, 1);
+	    handler (data, (void *) reloc_target, &reldata, 1);
 	    break;
 	  case 16:
-	    __write_memory ((void *) reloc_target, &reldata, 2);
+	    handler (data, (void *) reloc_target, &reldata, 2);
 	    break;
 	  case 32:
-	    __write_memory ((void *) reloc_target, &reldata, 4);
+	    handler (data, (void *) reloc_target, &reldata, 4);
 	    break;
 #	  ifdef _WIN64
 	  case 64:
-	    __write_memory ((void *) reloc_target, &reldata, 8);
+	    handler (data, (void *) reloc_target, &reldata, 8);
 	    break;
 #	  endif
 	}
@@ -365,10 +488,18 @@ void
 _pei386_runtime_relocator (void)
 {
   static NO_COPY int was_init = 0;
+  pseudo_reloc_regions regions;
   if (was_init)
     return;
   ++was_init;
+  regions.count = 0;
+  do_pseudo_reloc (&__RUNTIME_PSEUDO_RELOC_LIST__,
+		   &__RUNTIME_PSEUDO_RELOC_LIST_END__,
+		   &__MINGW_LSYMBOL(_image_base__),
+		   __mark_writable, &regions);
   do_pseudo_reloc (&__RUNTIME_PSEUDO_RELOC_LIST__,
 		   &__RUNTIME_PSEUDO_RELOC_LIST_END__,
-		   &__MINGW_LSYMBOL(_image_base__));
+		   &__MINGW_LSYMBOL(_image_base__),
+		   __write_marked, &regions);
+  __restore_protection (&regions);
 }